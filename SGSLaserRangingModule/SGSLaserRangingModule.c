@@ -1,7 +1,18 @@
 ﻿//#define _SGS_LRM_EXPORT
 
 #include "SGSLaserRangingModule.h"
-#include <windows.h>
+#include "SGSLrmPlatform.h"
+#include "SGSLrmTransport.h"
+#include "SGSLrmFrameParser.h"
+#include "SGSLrmReactor.h"
+#include "SGSLrmSampleRing.h"
+#include "SGSLrmDispatcher.h"
+#include "SGSLrmLatency.h"
+#include "SGSLrmSlab.h"
+#include "SGSLrmDecode.h"
+#include "SGSLrmTiming.h"
+#include "SGSLrmFilter.h"
+#include "SGSLrmTracker.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,7 +20,9 @@
 #include <ctype.h>
 #include <math.h>
 
+#if defined(_MSC_VER)
 #pragma comment(lib, "kernel32.lib")
+#endif
 
 // Default device address
 #define DEFAULT_DEVICE_ADDRESS  0x80 // Default device address
@@ -53,44 +66,238 @@
 #define SGS_LRM_ERR_STRONG_LIGHT        -118    // ERR-18: Strong ambient light
 #define SGS_LRM_ERR_DISPLAY_RANGE       -126    // ERR-26: Display range exceeded
 
-// Maximum number of devices that can be managed simultaneously
-#define MAX_DEVICES 16
+// Longest response wait; also the read timeout programmed into the port
+#define RESPONSE_TIMEOUT_MS     1000
+#define MAX_COMMAND_TIMEOUT_MS  60000
+#define ADAPTIVE_MIN_SAMPLES    16      // Responses timed before an adaptive deadline replaces the table value
+
+// Line pacing. A byte is 10 bits on the wire (8N1); after a command the port
+// stays quiet for its wire time plus the turnaround the module needs before
+// it accepts the next command. A response ends the quiet period early.
+#define LINE_BAUD_RATE          9600
+#define CONFIG_TURNAROUND_MS    5       // Writes go out back to back; let the module store each and send its ack first
+
+// Broadcast trigger to cache readout in SGSLrm_SyncAcquire: one measurement
+// at the module's slowest streaming rate (5 Hz)
+#define SYNC_WINDOW_DEFAULT_MS  200
+
+// Upper bound on SGSLrm_ProbeComPorts' deadline, like the sync window's
+#define MAX_PROBE_DEADLINE_MS   60000
+
+// Config acks (FA 04 8X CS, 4 bytes) are sent once the write is stored
+#define CONFIG_ACK_TIMEOUT_MS   100
+#define CONFIG_REGISTER_COUNT   7
+#define RX_DRAIN_MAX_BYTES      1024    // A transaction prologue reads at most this much stale input
+
+// SGSLrm_ReadSamples*: ring records widened into the caller's buffer this many at a time
+#define SAMPLE_BATCH            64
+
+// SGSLrm_DiscoverAddresses: a cache read and its 11-byte answer take ~16 ms
+// on the wire, so 30 ms leaves the module its turnaround
+#define DISCOVERY_PROBE_DEFAULT_MS  30
+#define DISCOVERY_PROBE_MAX_MS      1000
+#define DISCOVERY_CACHE_LINE        8192    // Key plus 255 "ADDR=ID" entries
+
+// Default response deadlines, indexed by SGSLrmCommand. Each covers the
+// command and response wire time at 9600 baud plus the module's own work.
+static const unsigned int g_defaultCommandTimeoutMs[SGS_LRM_COMMAND_COUNT] = {
+    RESPONSE_TIMEOUT_MS,    // Single measurement: a weak-signal 80 m reading takes most of a second
+    RESPONSE_TIMEOUT_MS,    // Continuous: gap between frames before a TIMEOUT sample (5 Hz = 200 ms)
+    50,                     // Read cache: answered from memory, 13-byte response
+    80,                     // Device ID: FA 06 84 + 16 ASCII bytes + CS, ~21 ms on the wire
+    50,                     // Shutdown: 4-byte ack
+};
+
+// Handles one bus can carry: one per ADDR byte, broadcast 0xFA excluded
+#define MAX_BUS_MODULES 255
 
 // Internal data structures
+
+// Seqlock around the published measurement snapshot. Writers hold device->lock;
+// readers take no lock and retry if sequence changed (or was odd) while copying.
 typedef struct {
-    HANDLE hSerial;
-    char comPort[16];
+    volatile LONG sequence;     // Odd while a write is in progress
+    SGSLrmSnapshot data;
+} SGSLrmSnapshotCell;
+
+typedef struct SGSLrmBus SGSLrmBus;
+
+typedef struct SGSLrmDevice {
+    SGSLrmBus* bus;             // Serial line this handle talks over; NULL while disconnected
+    struct SGSLrmDevice* nextOnBus;  // Next handle attached to the same bus
+    char comPort[128];
     bool isConnected;
-    bool inUse;  // Flag to indicate if this slot is in use
+    SGSLrmHandle self;          // Tagged handle given out for this slot (pool lock)
     int deviceAddress;
+    SGSLrmResolution resolution;        // Last resolution written; seeds the parser of a private bus
     SGSLrm_MeasurementCallback callback;
+    SGSLrm_MeasurementCallbackTenthMm callbackTenthMm;  // At most one of the three is set
+    SGSLrm_MeasurementCallbackEx callbackEx;
     void* userdata;
-    HANDLE continuousThread;
+    SGSLrmCallbackMode callbackMode;    // INLINE: call from the reactor thread; QUEUED: post to dispatch
+    SGSLrmDispatchQueue dispatch;       // Pending callbacks for the worker pool in QUEUED mode
     bool continuousMeasurement;
-    double lastDistance;
+    unsigned int streamTimeoutMs;       // CONTINUOUS deadline captured when streaming started (lock)
+    unsigned long long lastFrameMs;     // Last streamed frame or TIMEOUT sample (lock)
+    unsigned int commandTimeoutMs[SGS_LRM_COMMAND_COUNT];  // Response deadlines (lock)
+    SGSLrmAdaptiveTimeout adaptive[SGS_LRM_COMMAND_COUNT];  // Learned-deadline settings (lock)
+    SGSLrmLatencyTracker latency[SGS_LRM_COMMAND_COUNT];    // Observed response times (lock)
+    int lastDistanceTenthMm;    // Last successful reading, 0.1 mm units, filtered
+    int lastRawTenthMm;         // The same reading before the filter
+    SGSLrmResolution lastResolution;  // Resolution it was reported at
+    unsigned long long frameFirstByteNs;  // RX stamps of the last measurement frame parsed
+    unsigned long long frameLastByteNs;
+    SGSLrmTimingTracker timing;   // Arrival of streamed frames, since streaming started (lock)
+    SGSLrmFilter filter;          // SGSLrm_SetFilter pipeline, run as readings are parsed (lock)
+    SGSLrmTracker tracker;        // SGSLrm_SetTracker state, run as readings are published (lock)
     bool laserOn; // Track laser status
     int lastErrorCode;          // Store last measurement error code (e.g., 16)
     char lastErrorAscii[8];     // Store raw "ERR-XX" (e.g., "ERR-16"), NUL-terminated
-    CRITICAL_SECTION lock;  // Per-device lock for thread safety
+    SGSLrmSnapshotCell snapshot;  // Lock-free copy of the fields above for pollers
+    SGSLrmSampleRing samples;     // Every published measurement, drained by SGSLrm_ReadSamples
+    SGSLrmRxStats rxStats;        // Stale input drained before this handle's transactions (lock)
+    // Locking: ioLock serialises this handle's transactions and is held across
+    // blocking reads; the bus's wireLock then arbitrates between handles that
+    // share a port. lock guards the cached state and is only ever held
+    // briefly, so status getters never wait on the UART. Fields changed by I/O
+    // paths (isConnected, deviceAddress, laserOn, continuousMeasurement) are
+    // written with both held.
+    // Order: streamLock -> ioLock -> bus streamLock -> bus wireLock -> bus lock -> lock.
+    CRITICAL_SECTION lock;  // Per-device lock for cached state
+    CRITICAL_SECTION ioLock;  // Per-handle transaction serializer
+    CRITICAL_SECTION streamLock;  // Serialises start/stop of streaming
 } SGSLrmDevice;
 
-// Global device pool
-static SGSLrmDevice g_devicePool[MAX_DEVICES];
+// One serial port and the modules on it. SGSLrm_Connect gives a handle a
+// private bus; SGSLrm_OpenBus opens one that several handles (one module
+// address each) share. The bus owns the port, the RX parser and the single
+// reactor registration, so a line has one reader however many modules it has.
+struct SGSLrmBus {
+    SGSLrmTransport transport;          // Serial backend (Win32 COM / POSIX termios)
+    SGSLrmFrameParser parser;           // Incremental RX frame parser for every address on the line
+    SGSLrmReactorSource reactorSource;  // Registered while any attached handle streams
+    char comPort[128];
+    SGSLrmBusHandle self;               // Tagged handle given out for this slot (pool lock)
+    bool multiDrop;                     // Opened by SGSLrm_OpenBus rather than SGSLrm_Connect
+    bool ownerOpen;                     // SGSLrm_CloseBus not called yet; holds a reference
+    int refCount;                       // Attached handles + ownerOpen (pool lock)
+    SGSLrmDevice* devices;              // Attached handles, for routing streamed frames by ADDR
+    int streamingCount;                 // Attached handles streaming
+    unsigned long long txQuietUntilMs;  // Earliest time the next command may start (wireLock)
+    unsigned int syncWindowMs;          // SGSLrm_SyncAcquire: trigger to first cache read (wireLock)
+    SGSLrmSweepStats sweepStats;        // Cache sweep timing (lock)
+    SGSLrmConfig configShadow;          // Registers the modules acknowledged; fields = those known (wireLock + lock)
+    SGSLrmConfig configQueued;          // Writes sent while streaming; fields = those awaiting their ack (lock)
+    unsigned long long configAckDeadlineMs[CONFIG_REGISTER_COUNT]; // Per queued register, by bit index (lock)
+    unsigned int configFailed;          // Registers whose last write was rejected or never acknowledged (lock)
+    // wireLock is the request arbiter: held from a command's first byte to its
+    // response, so one transaction is on the line at a time. lock guards the
+    // parser and routing while streaming and is held briefly. devices and
+    // streamingCount change with both held; streamLock serialises reactor
+    // registration between handles starting and stopping.
+    CRITICAL_SECTION streamLock;
+    CRITICAL_SECTION wireLock;
+    CRITICAL_SECTION lock;
+};
+
+// Global device pool: grows a chunk at a time, records never move (see SGSLrmSlab.h)
+static SGSLrmSlab g_busPool;        // One bus per connected handle, plus open multi-drop buses
+static SGSLrmSlab g_devicePool;
 static volatile LONG g_initOnceFlag = 0;
 static CRITICAL_SECTION g_poolLock;  // Lock for pool management
 static bool g_poolInitialized = false;
 
 // Internal function declarations
-static SGSLrmStatus ValidateHandle(SGSLrmHandle handle);
+static SGSLrmStatus ValidateHandle(SGSLrmHandle handle, SGSLrmDevice** device);
+static SGSLrmStatus ValidateBusHandle(SGSLrmBusHandle handle, SGSLrmBus** bus);
+static SGSLrmStatus OpenBus(const char* comPort, bool multiDrop, SGSLrmResolution resolution, SGSLrmBus** bus);
+static bool RetainBus(SGSLrmBus* bus, SGSLrmBusHandle handle);
+static void ReleaseBus(SGSLrmBus* bus);
+static SGSLrmStatus AttachToBus(SGSLrmDevice* device, SGSLrmBus* bus, int address);
+static void DetachFromBus(SGSLrmDevice* device);
+static SGSLrmStatus BeginTransaction(SGSLrmDevice* device);
+static void EndTransaction(SGSLrmDevice* device);
 static SGSLrmStatus SendCommand(SGSLrmDevice* device, const unsigned char* command, int commandLength);
-static SGSLrmStatus ReceiveResponse(SGSLrmDevice* device, unsigned char* response, int maxLength, int* receivedLength);
+static SGSLrmStatus WriteCommand(SGSLrmBus* bus, const unsigned char* command, int commandLength);
+static SGSLrmStatus ReceiveResponse(SGSLrmBus* bus, unsigned char* response, int maxLength, unsigned int timeoutMs, int* receivedLength);
+static SGSLrmStatus ReceiveFrame(SGSLrmDevice* device, int address, unsigned char command, unsigned char responseCode, SGSLrmCommand timeoutId, SGSLrmFrame* frame);
+static SGSLrmStatus ReceiveFrameBefore(SGSLrmBus* bus, int address, unsigned char command, unsigned char responseCode, unsigned long long deadline, SGSLrmFrame* frame);
+typedef bool (*SGSLrmFrameMatcher)(const SGSLrmFrame* frame, void* context);
+static SGSLrmStatus ReceiveMatchingFrameBefore(SGSLrmBus* bus, SGSLrmFrameMatcher match, void* context, unsigned long long deadline, SGSLrmFrame* frame);
+static SGSLrmStatus WriteConfig(SGSLrmHandle handle, const SGSLrmConfig* config, bool onlyChanged);
+static bool SettleQueuedConfigAck(SGSLrmBus* bus, const SGSLrmFrame* frame);
+static void ExpireQueuedConfigAcks(SGSLrmBus* bus, unsigned long long now);
+static unsigned int CommandTimeoutMs(SGSLrmDevice* device, SGSLrmCommand command);
+static unsigned int CommandTimeoutMsLocked(SGSLrmDevice* device, SGSLrmCommand command);
 static unsigned char CalculateChecksum(const unsigned char* data, int length);
-static SGSLrmStatus ParseMeasurementResponse(SGSLrmDevice* device, const unsigned char* response, int length, double* distance);
-static DWORD WINAPI ContinuousMeasurementThread(LPVOID lpParam);
+static unsigned int CommandTurnaroundMs(const unsigned char* command);
+static SGSLrmStatus ParseMeasurementResponse(SGSLrmDevice* device, const SGSLrmFrame* frame);
+static void PublishMeasurement(SGSLrmDevice* device, SGSLrmStatus status);
+static void ReadSnapshot(SGSLrmDevice* device, SGSLrmSnapshot* snapshot);
+static void DeliverMeasurement(SGSLrmDevice* device, SGSLrmCallbackMode mode, const SGSLrmDispatchItem* item);
+static void ContinuousOnData(void* context, const unsigned char* data, int length, unsigned long long arrivalNs);
+static void ContinuousOnIdle(void* context);
+static void StopStreaming(SGSLrmDevice* device);
 static const char* GetCommandDescription(unsigned char cmd1, unsigned char cmd2);
 static void InitializeDevicePool();
 static void CleanupDevicePool();
 
+// 每個 slot 初始化處：chunk 加入 pool 時各呼叫一次，lock 之後重複使用
+static void ConstructDevice(void* record)
+{
+    SGSLrmDevice* dev = (SGSLrmDevice*)record;
+
+    ZeroMemory(dev, sizeof(*dev));
+    dev->isConnected = false;
+    dev->deviceAddress = DEFAULT_DEVICE_ADDRESS; // 統一用常數
+    dev->continuousMeasurement = false;
+    dev->lastDistanceTenthMm = 0;
+    dev->lastResolution = SGS_LRM_RESOLUTION_1MM;
+    dev->laserOn = false;
+    dev->lastErrorCode = 0;
+    dev->lastErrorAscii[0] = '\0'; // ★ 清空 ASCII 錯誤字串
+    InitializeCriticalSection(&dev->lock);
+    InitializeCriticalSection(&dev->ioLock);
+    InitializeCriticalSection(&dev->streamLock);
+}
+
+static void DestructDevice(void* record)
+{
+    SGSLrmDevice* dev = (SGSLrmDevice*)record;
+
+    DeleteCriticalSection(&dev->lock);
+    DeleteCriticalSection(&dev->ioLock);
+    DeleteCriticalSection(&dev->streamLock);
+}
+
+static void ConstructBus(void* record)
+{
+    SGSLrmBus* bus = (SGSLrmBus*)record;
+
+    ZeroMemory(bus, sizeof(*bus));
+    SGSLrmTransport_Init(&bus->transport, SGSLrmTransport_Default());
+    InitializeCriticalSection(&bus->streamLock);
+    InitializeCriticalSection(&bus->wireLock);
+    InitializeCriticalSection(&bus->lock);
+}
+
+// Stops the reader and closes the port of a bus still open
+static void DestructBus(void* record)
+{
+    SGSLrmBus* bus = (SGSLrmBus*)record;
+
+    if (SGSLrmTransport_IsOpen(&bus->transport)) {
+        if (bus->streamingCount > 0) {
+            SGSLrmReactor_Unregister(&bus->reactorSource);
+        }
+        bus->transport.ops->close(&bus->transport);
+    }
+
+    DeleteCriticalSection(&bus->streamLock);
+    DeleteCriticalSection(&bus->wireLock);
+    DeleteCriticalSection(&bus->lock);
+}
+
 // Initialize device pool on first use
 static void InitializeDevicePool()
 {
@@ -103,22 +310,9 @@ static void InitializeDevicePool()
 
     InitializeCriticalSection(&g_poolLock);
 
-    // 初始化所有 slot（每個 slot 初始化處）
-    for (int i = 0; i < MAX_DEVICES; ++i) {
-        SGSLrmDevice* dev = &g_devicePool[i];
-
-        ZeroMemory(dev, sizeof(*dev));
-        dev->hSerial = INVALID_HANDLE_VALUE;
-        dev->inUse = false;
-        dev->isConnected = false;
-        dev->deviceAddress = DEFAULT_DEVICE_ADDRESS; // 統一用常數
-        dev->continuousMeasurement = false;
-        dev->lastDistance = 0.0;
-        dev->laserOn = false;
-        dev->lastErrorCode = 0;
-        dev->lastErrorAscii[0] = '\0'; // ★ 清空 ASCII 錯誤字串
-        InitializeCriticalSection(&dev->lock);
-    }
+    // Slots are added on demand by the first CreateHandle / OpenBus that finds none free
+    SGSLrmSlab_Init(&g_devicePool, sizeof(SGSLrmDevice), ConstructDevice, DestructDevice);
+    SGSLrmSlab_Init(&g_busPool, sizeof(SGSLrmBus), ConstructBus, DestructBus);
 
     g_poolInitialized = true;
 }
@@ -157,34 +351,9 @@ static void CleanupDevicePool()
     if (g_poolInitialized) {
         EnterCriticalSection(&g_poolLock);
         
-        // Clean up all devices
-        for (int i = 0; i < MAX_DEVICES; i++) {
-            if (g_devicePool[i].inUse) {
-                // Disconnect if connected
-                if (g_devicePool[i].isConnected) {
-                    // Stop continuous measurement if running
-                    if (g_devicePool[i].continuousMeasurement) {
-                        g_devicePool[i].continuousMeasurement = false;
-                        if (g_devicePool[i].continuousThread != NULL) {
-                            WaitForSingleObject(g_devicePool[i].continuousThread, INFINITE);
-                            CloseHandle(g_devicePool[i].continuousThread);
-                            g_devicePool[i].continuousThread = NULL;
-                        }
-                    }
-                    
-                    // Close serial port
-                    if (g_devicePool[i].hSerial != INVALID_HANDLE_VALUE) {
-                        CloseHandle(g_devicePool[i].hSerial);
-                        g_devicePool[i].hSerial = INVALID_HANDLE_VALUE;
-                    }
-                }
-                
-                // Mark as not in use
-                g_devicePool[i].inUse = false;
-            }
-            
-            DeleteCriticalSection(&g_devicePool[i].lock);
-        }
+        // Clean up all devices, then stop the reader and close every port still open
+        SGSLrmSlab_Destroy(&g_devicePool);
+        SGSLrmSlab_Destroy(&g_busPool);
         
         LeaveCriticalSection(&g_poolLock);
         DeleteCriticalSection(&g_poolLock);
@@ -217,37 +386,48 @@ SGS_LRM_API SGSLrmStatus SGSLrm_CreateHandle(SGSLrmHandle* handle)
 
     EnterCriticalSection(&g_poolLock);
 
-    SGSLrmDevice* device = NULL;
-
-    // 找可用 slot
-    for (int i = 0; i < MAX_DEVICES; ++i) {
-        if (!g_devicePool[i].inUse) {
-            device = &g_devicePool[i];
-
-            // 重置該 slot 的運作狀態（不重建 lock）
-            device->hSerial = INVALID_HANDLE_VALUE;
-            device->isConnected = false;
-            device->deviceAddress = DEFAULT_DEVICE_ADDRESS; // ★ 統一常數
-            device->continuousMeasurement = false;
-            device->lastDistance = 0.0;
-            device->laserOn = false;
-            device->lastErrorCode = 0;
-            device->lastErrorAscii[0] = '\0'; // ★ 清空 ASCII 錯誤字串
-            device->callback = NULL;
-            device->userdata = NULL;
-            device->continuousThread = NULL;
-            memset(device->comPort, 0, sizeof(device->comPort));
-
-            device->inUse = true; // 借出這個 slot
-            break;
-        }
+    // 取最近釋放的 slot；沒有空的就加一個 chunk
+    uintptr_t token = 0;
+    SGSLrmDevice* device = (SGSLrmDevice*)SGSLrmSlab_Alloc(&g_devicePool, &token);
+
+    if (device) {
+        device->self = (SGSLrmHandle)token;
+        // 重置該 slot 的運作狀態（不重建 lock）
+        device->bus = NULL;
+        device->nextOnBus = NULL;
+        device->isConnected = false;
+        device->deviceAddress = DEFAULT_DEVICE_ADDRESS; // ★ 統一常數
+        device->resolution = SGS_LRM_RESOLUTION_1MM;
+        device->continuousMeasurement = false;
+        memcpy(device->commandTimeoutMs, g_defaultCommandTimeoutMs, sizeof(device->commandTimeoutMs));
+        memset(device->adaptive, 0, sizeof(device->adaptive));
+        for (int c = 0; c < SGS_LRM_COMMAND_COUNT; ++c) SGSLrmLatency_Init(&device->latency[c]);
+        device->lastDistanceTenthMm = 0;
+        device->lastRawTenthMm = 0;
+        device->lastResolution = SGS_LRM_RESOLUTION_1MM;
+        SGSLrmFilter_Init(&device->filter, NULL);
+        SGSLrmTracker_Init(&device->tracker, NULL);
+        device->laserOn = false;
+        device->lastErrorCode = 0;
+        device->lastErrorAscii[0] = '\0'; // ★ 清空 ASCII 錯誤字串
+        device->callback = NULL;
+        device->callbackTenthMm = NULL;
+        device->callbackEx = NULL;
+        device->userdata = NULL;
+        device->callbackMode = SGS_LRM_CALLBACK_INLINE;
+        SGSLrmDispatchQueue_Init(&device->dispatch, device->self);
+        memset(&device->snapshot, 0, sizeof(device->snapshot)); // 尚未借出，無讀者
+        SGSLrmSampleRing_Init(&device->samples);
+        memset(&device->rxStats, 0, sizeof(device->rxStats));
+        SGSLrmTiming_Init(&device->timing);
+        memset(device->comPort, 0, sizeof(device->comPort));
     }
 
     LeaveCriticalSection(&g_poolLock);
 
-    if (!device) return SGS_LRM_OUT_OF_MEMORY; // 無可用 slot
+    if (!device) return SGS_LRM_OUT_OF_MEMORY; // chunk 配置失敗
 
-    *handle = (SGSLrmHandle)device;
+    *handle = device->self; // 借出這個 slot
     return SGS_LRM_SUCCESS;
 }
 
@@ -307,31 +487,36 @@ SGS_LRM_API SGSLrmStatus SGSLrm_CreateHandle(SGSLrmHandle* handle)
 */
 SGS_LRM_API SGSLrmStatus SGSLrm_DestroyHandle(SGSLrmHandle handle)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
     // Disconnect if still connected
     if (device->isConnected) {
         SGSLrm_Disconnect(handle);
     }
 
+    // Release the worker pool if this handle was its last user
+    SGSLrmDispatcher_Detach(&device->dispatch);
+
     EnterCriticalSection(&g_poolLock);
     
-    // Mark slot as available
-    device->inUse = false;
+    // Retire the handle and mark the slot as available
+    if (!SGSLrmSlab_Free(&g_devicePool, (uintptr_t)handle)) {
+        status = SGS_LRM_INVALID_HANDLE; // Destroyed by another thread meanwhile
+    }
     
     LeaveCriticalSection(&g_poolLock);
     
-    return SGS_LRM_SUCCESS;
+    return status;
 }
 
 SGS_LRM_API SGSLrmStatus SGSLrm_Connect(SGSLrmHandle handle, const char* comPort)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
@@ -339,120 +524,148 @@ SGS_LRM_API SGSLrmStatus SGSLrm_Connect(SGSLrmHandle handle, const char* comPort
     if (!comPort) {
         return SGS_LRM_INVALID_PARAMETER;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->ioLock);
 
     if (device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
         return SGS_LRM_INVALID_PARAMETER;
     }
 
-    // Open COM port
-    device->hSerial = CreateFileA(comPort,
-        GENERIC_READ | GENERIC_WRITE,
-        0,
-        NULL,
-        OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
-        NULL);
-
-    if (device->hSerial == INVALID_HANDLE_VALUE) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
+    // A private bus: this handle is the only one on the port
+    SGSLrmBus* bus = NULL;
+    status = OpenBus(comPort, false, device->resolution, &bus);
+    if (status != SGS_LRM_SUCCESS) {
+        LeaveCriticalSection(&device->ioLock);
+        return status;
     }
 
-    // Configure COM port (9600, 8, N, 1)
-    DCB dcb = { 0 };
-    dcb.DCBlength = sizeof(DCB);
-    if (!GetCommState(device->hSerial, &dcb)) {
-        CloseHandle(device->hSerial);
-        device->hSerial = INVALID_HANDLE_VALUE;
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
+    status = AttachToBus(device, bus, device->deviceAddress);
+    if (status != SGS_LRM_SUCCESS) {
+        ReleaseBus(bus);
     }
 
-    dcb.BaudRate = CBR_9600;
-    dcb.ByteSize = 8;
-    dcb.Parity = NOPARITY;
-    dcb.StopBits = ONESTOPBIT;
-    dcb.fBinary = TRUE;  // Binary mode is required
-    dcb.fParity = FALSE;  // No parity checking
+    LeaveCriticalSection(&device->ioLock);
+    return status;
+}
 
-    if (!SetCommState(device->hSerial, &dcb)) {
-        CloseHandle(device->hSerial);
-        device->hSerial = INVALID_HANDLE_VALUE;
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
+SGS_LRM_API SGSLrmStatus SGSLrm_OpenBus(const char* comPort, SGSLrmBusHandle* bus)
+{
+    if (!comPort || !bus) {
+        return SGS_LRM_INVALID_PARAMETER;
     }
 
-    // Set timeouts
-    COMMTIMEOUTS timeouts = { 0 };
-    timeouts.ReadIntervalTimeout = 50;
-    timeouts.ReadTotalTimeoutConstant = 1000;
-    timeouts.ReadTotalTimeoutMultiplier = 10;
-    timeouts.WriteTotalTimeoutConstant = 1000;
-    timeouts.WriteTotalTimeoutMultiplier = 10;
+    SGSLrmBus* opened = NULL;
+    SGSLrmStatus status = OpenBus(comPort, true, SGS_LRM_RESOLUTION_1MM, &opened);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
 
-    if (!SetCommTimeouts(device->hSerial, &timeouts)) {
-        CloseHandle(device->hSerial);
-        device->hSerial = INVALID_HANDLE_VALUE;
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
+    *bus = opened->self;
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_CloseBus(SGSLrmBusHandle handle)
+{
+    SGSLrmBus* bus = NULL;
+    SGSLrmStatus status = ValidateBusHandle(handle, &bus);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
     }
 
-    strncpy_s(device->comPort, sizeof(device->comPort), comPort, _TRUNCATE);
-    device->isConnected = true;
+    EnterCriticalSection(&g_poolLock);
+    bool owned = SGSLrmSlab_Resolve(&g_busPool, (uintptr_t)handle) == bus && bus->ownerOpen;
+    if (owned) bus->ownerOpen = false;
+    LeaveCriticalSection(&g_poolLock);
 
-    LeaveCriticalSection(&device->lock);
+    if (!owned) {
+        return SGS_LRM_INVALID_HANDLE; // Closed by another thread meanwhile
+    }
+
+    // Attached handles keep the port open until they disconnect
+    ReleaseBus(bus);
     return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_Disconnect(SGSLrmHandle handle)
+SGS_LRM_API SGSLrmStatus SGSLrm_ConnectBus(SGSLrmHandle handle, SGSLrmBusHandle busHandle, int address)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    SGSLrmBus* bus = NULL;
+    status = ValidateBusHandle(busHandle, &bus);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
+    if (address < 0 || address > 255 || address == ADDR_BROADCAST) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->ioLock);
+
+    if (device->isConnected) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    if (!RetainBus(bus, busHandle)) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_HANDLE;
+    }
+
+    // The module keeps its programmed address; the handle just talks to it
+    status = AttachToBus(device, bus, address);
+    if (status != SGS_LRM_SUCCESS) {
+        ReleaseBus(bus);
+    }
+
+    LeaveCriticalSection(&device->ioLock);
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_Disconnect(SGSLrmHandle handle)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->streamLock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
+        LeaveCriticalSection(&device->streamLock);
         return SGS_LRM_SUCCESS;
     }
 
     // Stop continuous measurement if running
     if (device->continuousMeasurement) {
-        device->continuousMeasurement = false;
-        if (device->continuousThread != NULL) {
-            LeaveCriticalSection(&device->lock);
-            WaitForSingleObject(device->continuousThread, INFINITE);
-            CloseHandle(device->continuousThread);
-            EnterCriticalSection(&device->lock);
-            device->continuousThread = NULL;
-        }
+        StopStreaming(device);
     }
 
-    if (device->hSerial != INVALID_HANDLE_VALUE) {
-        CloseHandle(device->hSerial);
-        device->hSerial = INVALID_HANDLE_VALUE;
-    }
+    // The port closes with the bus's last reference
+    SGSLrmBus* bus = device->bus;
+    DetachFromBus(device);
+    ReleaseBus(bus);
 
-    device->isConnected = false;
-    device->comPort[0] = '\0';
-    device->laserOn = false; // Reset laser status on disconnect
+    LeaveCriticalSection(&device->ioLock);
 
-    LeaveCriticalSection(&device->lock);
+    // Queued callbacks may issue transactions, so wait for them without ioLock
+    SGSLrmDispatcher_Cancel(&device->dispatch);
+    LeaveCriticalSection(&device->streamLock);
     return SGS_LRM_SUCCESS;
 }
 
 SGS_LRM_API SGSLrmStatus SGSLrm_IsConnected(SGSLrmHandle handle, bool* connected)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
@@ -460,8 +673,6 @@ SGS_LRM_API SGSLrmStatus SGSLrm_IsConnected(SGSLrmHandle handle, bool* connected
     if (!connected) {
         return SGS_LRM_INVALID_PARAMETER;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
     EnterCriticalSection(&device->lock);
     *connected = device->isConnected;
@@ -471,179 +682,683 @@ SGS_LRM_API SGSLrmStatus SGSLrm_IsConnected(SGSLrmHandle handle, bool* connected
 }
 
 // Internal helper functions
-static SGSLrmStatus ValidateHandle(SGSLrmHandle handle)
+// Handles are slab tokens (slot index + generation), not addresses: a handle
+// stops resolving when it is destroyed, even once its slot is reused.
+static SGSLrmStatus ValidateHandle(SGSLrmHandle handle, SGSLrmDevice** device)
 {
     if (!handle) {
         return SGS_LRM_INVALID_HANDLE;
     }
 
-    // Check if handle points to a valid device in the pool
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    if (device < &g_devicePool[0] || device >= &g_devicePool[MAX_DEVICES]) {
+    // One indexed load and a generation compare
+    *device = (SGSLrmDevice*)SGSLrmSlab_Resolve(&g_devicePool, (uintptr_t)handle);
+    if (!*device) {
         return SGS_LRM_INVALID_HANDLE;
     }
 
-    // Check if the device slot is in use
-    if (!device->inUse) {
+    return SGS_LRM_SUCCESS;
+}
+
+static SGSLrmStatus ValidateBusHandle(SGSLrmBusHandle handle, SGSLrmBus** bus)
+{
+    if (!handle) {
         return SGS_LRM_INVALID_HANDLE;
     }
 
-    return SGS_LRM_SUCCESS;
-}
+    *bus = (SGSLrmBus*)SGSLrmSlab_Resolve(&g_busPool, (uintptr_t)handle);
+    if (!*bus) {
+        return SGS_LRM_INVALID_HANDLE;
+    }
 
+    // A closed bus only lingers for the handles still attached to it
+    if (!(*bus)->ownerOpen) {
+        return SGS_LRM_INVALID_HANDLE;
+    }
 
-// Checksum calculation function
-static unsigned char CalculateChecksum(const unsigned char* data, int length)
-{
-    unsigned int sum = 0;
-    for (int i = 0; i < length; ++i) sum += data[i];
-    return (unsigned char)(0x100 - (sum & 0xFF));
+    return SGS_LRM_SUCCESS;
 }
 
-//static unsigned char CalculateChecksum(const unsigned char* data, int length)
-//{
-//    unsigned char sum = 0;
-//    for (int i = 0; i < length; i++) {
-//        sum += data[i];
-//    }
-//    return (~sum) + 1; // Two's complement
-//}
-
-static SGSLrmStatus SendCommand(SGSLrmDevice* device, const unsigned char* command, int commandLength)
+// Claims a bus slot and opens comPort on it. The caller owns the one
+// reference the new bus starts with.
+static SGSLrmStatus OpenBus(const char* comPort, bool multiDrop, SGSLrmResolution resolution, SGSLrmBus** out)
 {
-    if (!device || !command || commandLength <= 0) {
-        return SGS_LRM_INVALID_PARAMETER;
+    if (!g_poolInitialized) {
+        InitializeDevicePool();
     }
 
-    if (!device->isConnected || device->hSerial == INVALID_HANDLE_VALUE) {
-        return SGS_LRM_NOT_CONNECTED;
-    }
+    EnterCriticalSection(&g_poolLock);
 
-    DWORD bytesWritten;
-    if (!WriteFile(device->hSerial, command, commandLength, &bytesWritten, NULL)) {
-        return SGS_LRM_COMMUNICATION_ERROR;
+    uintptr_t token = 0;
+    SGSLrmBus* bus = (SGSLrmBus*)SGSLrmSlab_Alloc(&g_busPool, &token);
+    if (bus) {
+        bus->self = (SGSLrmBusHandle)token;
+        bus->multiDrop = multiDrop;
+        bus->ownerOpen = multiDrop;
+        bus->refCount = 1;
     }
 
-    if (bytesWritten != (DWORD)commandLength) {
-        return SGS_LRM_COMMUNICATION_ERROR;
-    }
+    LeaveCriticalSection(&g_poolLock);
 
-    // Add 10ms delay after sending command
-    Sleep(10);
+    if (!bus) return SGS_LRM_OUT_OF_MEMORY;
 
-    return SGS_LRM_SUCCESS;
-}
+    // Open serial port (9600, 8, N, 1) outside the pool lock
+    EnterCriticalSection(&bus->wireLock);
 
-static SGSLrmStatus ReceiveResponse(SGSLrmDevice* device, unsigned char* response, int maxLength, int* receivedLength)
-{
-    if (!device || !response || maxLength <= 0 || !receivedLength) {
-        return SGS_LRM_INVALID_PARAMETER;
+    SGSLrmTransport_Init(&bus->transport, SGSLrmTransport_Default());
+    const SGSLrmTransportOps* ops = bus->transport.ops;
+    SGSLrmStatus status = ops->open(&bus->transport, comPort);
+    if (status == SGS_LRM_SUCCESS) {
+        // Set timeouts: reads return as soon as bytes arrive, frame boundaries
+        // come from the parser rather than from an inter-byte gap
+        SGSLrmTransportTimeouts timeouts = { 0 };
+        timeouts.readIntervalMs = SGS_LRM_READ_RETURN_ON_DATA;
+        timeouts.readTotalConstantMs = RESPONSE_TIMEOUT_MS;
+        timeouts.readTotalMultiplierMs = 0;
+        timeouts.writeTotalConstantMs = 1000;
+        timeouts.writeTotalMultiplierMs = 10;
+
+        if (ops->setTimeouts(&bus->transport, &timeouts) != SGS_LRM_SUCCESS) {
+            ops->close(&bus->transport);
+            status = SGS_LRM_COMMUNICATION_ERROR;
+        }
     }
 
-    if (!device->isConnected || device->hSerial == INVALID_HANDLE_VALUE) {
-        return SGS_LRM_NOT_CONNECTED;
+    if (status == SGS_LRM_SUCCESS) {
+        SGSLrmFrameParser_Init(&bus->parser, resolution);
+        memset(&bus->reactorSource, 0, sizeof(bus->reactorSource));
+        bus->reactorSource.transport = &bus->transport;
+        bus->reactorSource.onData = ContinuousOnData;
+        bus->reactorSource.onIdle = ContinuousOnIdle;
+        bus->reactorSource.context = bus;
+        strncpy_s(bus->comPort, sizeof(bus->comPort), comPort, _TRUNCATE);
+        bus->devices = NULL;
+        bus->streamingCount = 0;
+        bus->txQuietUntilMs = 0;
+        bus->syncWindowMs = SYNC_WINDOW_DEFAULT_MS;
+        memset(&bus->configShadow, 0, sizeof(bus->configShadow));
+        memset(&bus->configQueued, 0, sizeof(bus->configQueued));
+        bus->configFailed = 0;
+        memset(&bus->sweepStats, 0, sizeof(bus->sweepStats));
     }
 
-    DWORD bytesRead;
-    if (!ReadFile(device->hSerial, response, maxLength, &bytesRead, NULL)) {
-        return SGS_LRM_COMMUNICATION_ERROR;
-    }
+    LeaveCriticalSection(&bus->wireLock);
 
-    *receivedLength = (int)bytesRead;
-    
-    if (bytesRead == 0) {
-        return SGS_LRM_TIMEOUT;
+    if (status != SGS_LRM_SUCCESS) {
+        EnterCriticalSection(&g_poolLock);
+        SGSLrmSlab_Free(&g_busPool, (uintptr_t)bus->self);
+        LeaveCriticalSection(&g_poolLock);
+        return status;
     }
 
+    *out = bus;
     return SGS_LRM_SUCCESS;
 }
 
-
-static SGSLrmStatus ParseMeasurementResponse(SGSLrmDevice* device,
-    const unsigned char* response,
-    int length,
-    double* distance)
+// Takes a reference for a handle joining a multi-drop bus; only possible
+// while the bus is open (SGSLrm_CloseBus not yet called). handle is
+// re-resolved under the pool lock in case the slot was closed and reused.
+static bool RetainBus(SGSLrmBus* bus, SGSLrmBusHandle handle)
 {
-    if (!device || !response || !distance) return SGS_LRM_INVALID_PARAMETER;
-    if (length < 4) return SGS_LRM_COMMUNICATION_ERROR;
+    EnterCriticalSection(&g_poolLock);
+    bool alive = SGSLrmSlab_Resolve(&g_busPool, (uintptr_t)handle) == bus && bus->ownerOpen;
+    if (alive) bus->refCount++;
+    LeaveCriticalSection(&g_poolLock);
+    return alive;
+}
 
-    // 基本頭碼
-    if (response[0] != (unsigned char)device->deviceAddress) return SGS_LRM_COMMUNICATION_ERROR;
-    if (response[1] != CMD_MEASURE) return SGS_LRM_COMMUNICATION_ERROR;
+// Drops a reference; the last one closes the port and frees the slot.
+static void ReleaseBus(SGSLrmBus* bus)
+{
+    EnterCriticalSection(&g_poolLock);
+    bool last = --bus->refCount == 0;
+    LeaveCriticalSection(&g_poolLock);
 
-    // === 錯誤回覆：固定 10 bytes（ADDR 06 8X 'E' 'R' 'R' '-' d d CS）===
-    if (length == 10 &&
-        response[3] == 'E' && response[4] == 'R' && response[5] == 'R' && response[6] == '-' &&
-        isdigit((unsigned char)response[7]) && isdigit((unsigned char)response[8])) {
+    if (!last) return;
 
-        // 存數字碼
-        int code = (response[7] - '0') * 10 + (response[8] - '0');
-        device->lastErrorCode = code;
+    EnterCriticalSection(&bus->wireLock);
+    if (SGSLrmTransport_IsOpen(&bus->transport)) {
+        bus->transport.ops->close(&bus->transport);
+    }
+    bus->comPort[0] = '\0';
+    LeaveCriticalSection(&bus->wireLock);
 
-        // 存 ASCII 原字串（含終止符）
-        memcpy(device->lastErrorAscii, &response[3], 6); // "ERR-XX"
-        device->lastErrorAscii[6] = '\0';
+    EnterCriticalSection(&g_poolLock);
+    SGSLrmSlab_Free(&g_busPool, (uintptr_t)bus->self);
+    LeaveCriticalSection(&g_poolLock);
+}
 
-        return SGS_LRM_MEASUREMENT_ERROR; // 通用錯誤狀態，細節由 Get* API 取
+// Links a handle to the bus under address, which must be free on it.
+// Caller holds the device's ioLock and a bus reference for the handle.
+static SGSLrmStatus AttachToBus(SGSLrmDevice* device, SGSLrmBus* bus, int address)
+{
+    EnterCriticalSection(&bus->wireLock);
+    EnterCriticalSection(&bus->lock);
+
+    for (SGSLrmDevice* d = bus->devices; d; d = d->nextOnBus) {
+        if (d->deviceAddress == address) {
+            LeaveCriticalSection(&bus->lock);
+            LeaveCriticalSection(&bus->wireLock);
+            return SGS_LRM_INVALID_PARAMETER; // Two handles would both claim its responses
+        }
     }
 
-    // === 成功回覆：允許 0x82/0x83/0x87 ===
-    if (!(response[2] == RESP_SINGLE_MEASURE ||
-        response[2] == RESP_CONTINUOUS ||
-        response[2] == RESP_READ_CACHE)) {
-        return SGS_LRM_COMMUNICATION_ERROR;
-    }
+    device->nextOnBus = bus->devices;
+    bus->devices = device;
+
+    EnterCriticalSection(&device->lock);
+    device->bus = bus;
+    device->deviceAddress = address;
+    strncpy_s(device->comPort, sizeof(device->comPort), bus->comPort, _TRUNCATE);
+    device->isConnected = true;
+    LeaveCriticalSection(&device->lock);
 
-    // 成功時清空上一筆錯誤
-    device->lastErrorCode = 0;
-    device->lastErrorAscii[0] = '\0';
+    LeaveCriticalSection(&bus->lock);
+    LeaveCriticalSection(&bus->wireLock);
+    return SGS_LRM_SUCCESS;
+}
 
-    // （以下沿用你原本的距離 ASCII 嚴格驗證與 strtod 轉換）
-    // 最小長度、安全檢查...
-    int dataLength = length - 4;
-    if (dataLength < 3 || dataLength > 12) return SGS_LRM_COMMUNICATION_ERROR;
+// Unlinks a handle that is no longer streaming. Caller holds its ioLock and
+// releases the handle's bus reference afterwards.
+static void DetachFromBus(SGSLrmDevice* device)
+{
+    SGSLrmBus* bus = device->bus;
 
-    char distanceStr[16] = { 0 };
-    memcpy(distanceStr, &response[3], dataLength);
-    distanceStr[dataLength] = '\0';
+    EnterCriticalSection(&bus->wireLock);
+    EnterCriticalSection(&bus->lock);
 
-    // 僅允許 [0-9] 與單一 '.'，不得首尾為 '.'
-    int dotCount = 0; bool hasDigit = false;
-    for (int i = 0; i < dataLength; ++i) {
-        unsigned char c = (unsigned char)distanceStr[i];
-        if (c == '.') { if (++dotCount > 1) return SGS_LRM_COMMUNICATION_ERROR; }
-        else if (isdigit(c)) { hasDigit = true; }
-        else { return SGS_LRM_COMMUNICATION_ERROR; }
+    for (SGSLrmDevice** link = &bus->devices; *link; link = &(*link)->nextOnBus) {
+        if (*link == device) {
+            *link = device->nextOnBus;
+            break;
+        }
     }
-    if (!hasDigit || distanceStr[0] == '.' || distanceStr[dataLength - 1] == '.') return SGS_LRM_COMMUNICATION_ERROR;
+    device->nextOnBus = NULL;
 
-    char* endp = NULL;
-    double val = strtod(distanceStr, &endp);
-    if (!endp || *endp != '\0' || isnan(val) || isinf(val) || val < 0.0 || val > 9999.9999)
-        return SGS_LRM_COMMUNICATION_ERROR;
+    EnterCriticalSection(&device->lock);
+    device->bus = NULL;
+    device->isConnected = false;
+    device->comPort[0] = '\0';
+    device->laserOn = false; // Reset laser status on disconnect
+    LeaveCriticalSection(&device->lock);
 
-    *distance = val;
-    return SGS_LRM_SUCCESS;
+    LeaveCriticalSection(&bus->lock);
+    LeaveCriticalSection(&bus->wireLock);
 }
 
 
-/*
-static SGSLrmStatus ParseMeasurementResponse(SGSLrmDevice* device, const unsigned char* response, int length, double* distance)
+// Checksum calculation function
+static unsigned char CalculateChecksum(const unsigned char* data, int length)
 {
-    if (!device || !response || !distance || length < 4) {
-        return SGS_LRM_INVALID_PARAMETER;
-    }
+    unsigned int sum = 0;
+    for (int i = 0; i < length; ++i) sum += data[i];
+    return (unsigned char)(0x100 - (sum & 0xFF));
+}
 
-    // Protocol response formats:
-    // Single measurement (1mm):     ADDR 06 82 "XXX.XXX" CS
-    // Single measurement (0.1mm):   ADDR 06 82 "XXX.XXXX" CS  
-    // Continuous measurement (1mm):  ADDR 06 83 "XXX.XXX" CS
-    // Continuous measurement (0.1mm): ADDR 06 83 "XXX.XXXX" CS
-    // Error response:                ADDR 06 8X "ERR-XX" CS
+//static unsigned char CalculateChecksum(const unsigned char* data, int length)
+//{
+//    unsigned char sum = 0;
+//    for (int i = 0; i < length; i++) {
+//        sum += data[i];
+//    }
+//    return (~sum) + 1; // Two's complement
+//}
 
-    // Verify device address
-    if (response[0] != (unsigned char)device->deviceAddress) {
-        return SGS_LRM_COMMUNICATION_ERROR; // Wrong address
+// Publishes the cached measurement state to the snapshot and queues it as a
+// sample. Called with device->lock held, which keeps writers serialised (the
+// sample ring's single producer).
+static void PublishMeasurement(SGSLrmDevice* device, SGSLrmStatus status)
+{
+    SGSLrmSnapshot* data = &device->snapshot.data;
+
+    device->snapshot.sequence++; // odd: readers retry
+    SGSLrmFence_Release();
+
+    data->distance = (double)device->lastDistanceTenthMm / SGS_LRM_UNITS_PER_METRE;
+    data->distanceTenthMm = device->lastDistanceTenthMm;
+    data->rawDistanceTenthMm = device->lastRawTenthMm;
+    data->resolution = device->lastResolution;
+    // Only answers carry a frame; a TIMEOUT has nothing to stamp
+    bool framed = status == SGS_LRM_SUCCESS || status == SGS_LRM_MEASUREMENT_ERROR;
+    data->firstByteNs = framed ? device->frameFirstByteNs : 0;
+    data->lastByteNs = framed ? device->frameLastByteNs : 0;
+    data->status = status;
+    data->errorCode = device->lastErrorCode;
+    memcpy(data->errorAscii, device->lastErrorAscii, sizeof(data->errorAscii));
+    data->sequence++;
+    data->timestampMs = SGSLrmClock_NowMs();
+
+    SGSLrmFence_Release();
+    device->snapshot.sequence++; // even: stable
+
+    if (device->tracker.enabled) {
+        // A reading without an RX stamp (connect probe) has no place in time
+        if (status == SGS_LRM_SUCCESS && data->lastByteNs != 0) {
+            SGSLrmTracker_Update(&device->tracker, data->distance, data->lastByteNs, data->sequence);
+        } else if (status == SGS_LRM_MEASUREMENT_ERROR || status == SGS_LRM_TIMEOUT || status == SGS_LRM_COMMUNICATION_ERROR) {
+            SGSLrmTracker_Dropout(&device->tracker, SGSLrmClock_NowNs());
+        }
+    }
+
+    SGSLrmSampleRecord sample;
+    sample.sequence = data->sequence;
+    sample.timestampMs = data->timestampMs;
+    sample.distanceTenthMm = data->distanceTenthMm;
+    sample.status = (signed char)status;
+    sample.errorCode = (unsigned char)data->errorCode;
+    sample.resolution = (unsigned char)data->resolution;
+    SGSLrmSampleRing_Push(&device->samples, &sample);
+}
+
+// Copies the snapshot without locking; retries while a write overlaps.
+static void ReadSnapshot(SGSLrmDevice* device, SGSLrmSnapshot* snapshot)
+{
+    for (;;) {
+        LONG begin = device->snapshot.sequence;
+        SGSLrmFence_Acquire();
+        if ((begin & 1) == 0) {
+            memcpy(snapshot, (const void*)&device->snapshot.data, sizeof(*snapshot));
+            SGSLrmFence_Acquire();
+            if (device->snapshot.sequence == begin) {
+                return;
+            }
+        }
+    }
+}
+
+// A measurement frame found in stale input is still a reading: publish it to
+// the handle it is addressed to, if the line has one. Called with wireLock held.
+static bool SalvageStaleFrame(SGSLrmBus* bus, const SGSLrmFrame* frame)
+{
+    if ((frame->type != SGS_LRM_FRAME_MEASUREMENT && frame->type != SGS_LRM_FRAME_HW_ERROR) ||
+        frame->data[1] != CMD_MEASURE) {
+        return false;
+    }
+
+    bool salvaged = false;
+    EnterCriticalSection(&bus->lock);
+    for (SGSLrmDevice* device = bus->devices; device; device = device->nextOnBus) {
+        if (frame->data[0] != (unsigned char)device->deviceAddress) {
+            continue;
+        }
+
+        EnterCriticalSection(&device->lock);
+        SGSLrmStatus status = ParseMeasurementResponse(device, frame);
+        if (status == SGS_LRM_SUCCESS || status == SGS_LRM_MEASUREMENT_ERROR) {
+            PublishMeasurement(device, status);
+            salvaged = true;
+        }
+        LeaveCriticalSection(&device->lock);
+        break;
+    }
+    LeaveCriticalSection(&bus->lock);
+    return salvaged;
+}
+
+// Transaction prologue: whatever is already on the line or buffered in the
+// parser predates the command about to go out (answers to reads that timed
+// out, frames from a stream just stopped, stray acks) and must not be taken
+// for its answer. Reads without waiting, settles queued config acks, salvages
+// measurement frames and discards the rest, counting it against device
+// (NULL for bus-wide operations: nobody is charged). Called with wireLock held.
+static void DrainStaleInput(SGSLrmBus* bus, SGSLrmDevice* device)
+{
+    unsigned long staleBytes = (unsigned long)bus->parser.length;
+    unsigned long keptBytes = 0;
+    unsigned long discardedFrames = 0;
+    unsigned long salvagedFrames = 0;
+
+    unsigned char chunk[64];
+    int chunkLength = 0;
+    int offset = 0;
+    unsigned long long arrivalNs = 0;
+    bool lineEmpty = false;
+    for (;;) {
+        int consumed = 0;
+        SGSLrmFrame frame;
+        bool emitted = SGSLrmFrameParser_Feed(&bus->parser, chunk + offset, chunkLength - offset, arrivalNs, &consumed, &frame);
+        offset += consumed;
+        if (!emitted && lineEmpty) {
+            // Held back in case it was the head of a 0.1 mm frame; nothing more is coming for it
+            if (!SGSLrmFrameParser_Flush(&bus->parser, &frame)) break;
+            emitted = true;
+        }
+
+        if (emitted) {
+            if (SettleQueuedConfigAck(bus, &frame)) {
+                keptBytes += (unsigned long)frame.length;
+            } else if (SalvageStaleFrame(bus, &frame)) {
+                keptBytes += (unsigned long)frame.length;
+                salvagedFrames++;
+            } else {
+                discardedFrames++;
+            }
+            continue;
+        }
+
+        chunkLength = 0;
+        offset = 0;
+        if (staleBytes >= RX_DRAIN_MAX_BYTES ||
+            bus->transport.ops->readWithin(&bus->transport, chunk, sizeof(chunk), 0, &chunkLength) != SGS_LRM_SUCCESS ||
+            chunkLength == 0) {
+            lineEmpty = true;
+            continue;
+        }
+        arrivalNs = SGSLrmClock_NowNs();
+        staleBytes += (unsigned long)chunkLength;
+    }
+
+    // A partial frame left over is stale too
+    SGSLrmFrameParser_Reset(&bus->parser);
+
+    if (staleBytes == 0 || !device) {
+        return;
+    }
+
+    EnterCriticalSection(&device->lock);
+    device->rxStats.drains++;
+    device->rxStats.discardedBytes += staleBytes - keptBytes;
+    device->rxStats.discardedFrames += discardedFrames;
+    device->rxStats.salvagedFrames += salvagedFrames;
+    LeaveCriticalSection(&device->lock);
+}
+
+// Takes the line (wireLock) for commands whose answers this thread reads.
+// Stale input is drained first so the next frame read answers what goes out
+// now; while a handle streams the reactor owns RX and nothing is drained.
+// Every path that reads answers off the line starts here. Release with
+// LeaveCriticalSection(&bus->wireLock).
+static void AcquireLine(SGSLrmBus* bus, SGSLrmDevice* device)
+{
+    EnterCriticalSection(&bus->wireLock);
+    if (bus->streamingCount == 0) {
+        DrainStaleInput(bus, device);
+    }
+}
+
+// Takes the line for a command/response pair; the reply is read by this
+// thread, so the transaction fails while any handle on the bus streams (the
+// reactor owns RX then). Caller holds the device's ioLock.
+static SGSLrmStatus BeginTransaction(SGSLrmDevice* device)
+{
+    SGSLrmBus* bus = device->bus;
+    AcquireLine(bus, device);
+    if (bus->streamingCount > 0) {
+        LeaveCriticalSection(&bus->wireLock);
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+    return SGS_LRM_SUCCESS;
+}
+
+static void EndTransaction(SGSLrmDevice* device)
+{
+    LeaveCriticalSection(&device->bus->wireLock);
+}
+
+// Writes a command on the device's bus. Commands whose answer is not read
+// call this on its own; a transaction calls it between BeginTransaction and EndTransaction.
+static SGSLrmStatus SendCommand(SGSLrmDevice* device, const unsigned char* command, int commandLength)
+{
+    if (!device || !command || commandLength <= 0) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    if (!device->isConnected) {
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    return WriteCommand(device->bus, command, commandLength);
+}
+
+// Paced write of one command on the line
+static SGSLrmStatus WriteCommand(SGSLrmBus* bus, const unsigned char* command, int commandLength)
+{
+    EnterCriticalSection(&bus->wireLock);
+
+    SGSLrmStatus status = SGS_LRM_SUCCESS;
+    if (!SGSLrmTransport_IsOpen(&bus->transport)) {
+        status = SGS_LRM_NOT_CONNECTED;
+        goto cleanup;
+    }
+
+    // Wait out whatever remains of the previous command's quiet period
+    unsigned long long now = SGSLrmClock_NowMs();
+    if (now < bus->txQuietUntilMs) {
+        Sleep((DWORD)(bus->txQuietUntilMs - now));
+        now = SGSLrmClock_NowMs();
+    }
+
+    int bytesWritten = 0;
+    if (bus->transport.ops->write(&bus->transport, command, commandLength, &bytesWritten) != SGS_LRM_SUCCESS ||
+        bytesWritten != commandLength) {
+        status = SGS_LRM_COMMUNICATION_ERROR;
+        goto cleanup;
+    }
+
+    // No sleep here: a transaction goes straight on to read its response
+    unsigned int wireMs = (unsigned int)((commandLength * 10 * 1000 + LINE_BAUD_RATE - 1) / LINE_BAUD_RATE);
+    bus->txQuietUntilMs = now + wireMs + CommandTurnaroundMs(command);
+
+cleanup:
+    LeaveCriticalSection(&bus->wireLock);
+    return status;
+}
+
+// Quiet time a command needs after its last byte, before the next command.
+// Commands answered with a response need none beyond the response itself.
+static unsigned int CommandTurnaroundMs(const unsigned char* command)
+{
+    switch (command[1]) {
+    case CMD_CONFIG:  return CONFIG_TURNAROUND_MS;
+    default:          return 0;
+    }
+}
+
+static unsigned int CommandTimeoutMs(SGSLrmDevice* device, SGSLrmCommand command)
+{
+    EnterCriticalSection(&device->lock);
+    unsigned int timeoutMs = CommandTimeoutMsLocked(device, command);
+    LeaveCriticalSection(&device->lock);
+    return timeoutMs;
+}
+
+// Table value, or multiplier x p99 once adaptation has enough data. Caller holds lock.
+static unsigned int CommandTimeoutMsLocked(SGSLrmDevice* device, SGSLrmCommand command)
+{
+    const SGSLrmAdaptiveTimeout* adaptive = &device->adaptive[command];
+    const SGSLrmLatencyTracker* latency = &device->latency[command];
+    if (!adaptive->enabled || latency->samples + latency->timeouts < ADAPTIVE_MIN_SAMPLES) {
+        return device->commandTimeoutMs[command];
+    }
+
+    double learned = adaptive->multiplier * latency->p99Ms;
+    if (learned < adaptive->floorMs) learned = adaptive->floorMs;
+    if (learned > adaptive->ceilingMs) learned = adaptive->ceilingMs;
+    return (unsigned int)ceil(learned);
+}
+
+static SGSLrmStatus ReceiveResponse(SGSLrmBus* bus, unsigned char* response, int maxLength, unsigned int timeoutMs, int* receivedLength)
+{
+    if (!bus || !response || maxLength <= 0 || !receivedLength) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    if (!SGSLrmTransport_IsOpen(&bus->transport)) {
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    int bytesRead = 0;
+    if (bus->transport.ops->readWithin(&bus->transport, response, maxLength, timeoutMs, &bytesRead) != SGS_LRM_SUCCESS) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    *receivedLength = bytesRead;
+    
+    if (bytesRead == 0) {
+        return SGS_LRM_TIMEOUT;
+    }
+
+    return SGS_LRM_SUCCESS;
+}
+
+// Reads until a frame ADDR <command> <responseCode> ... completes or the
+// deadline for timeoutId expires; returns as soon as the frame is parsed.
+// Error frames (ADDR 06 8X "ERR-XX") match the response code they answer.
+// Unrelated frames (late continuous samples, stray acks) are consumed and
+// dropped, among them answers from other modules on a multi-drop bus; bytes
+// after the match stay buffered in the parser for the next call. Called
+// between BeginTransaction and EndTransaction.
+static SGSLrmStatus ReceiveFrame(SGSLrmDevice* device, int address, unsigned char command, unsigned char responseCode, SGSLrmCommand timeoutId, SGSLrmFrame* frame)
+{
+    unsigned long long start = SGSLrmClock_NowMs();
+    unsigned int timeoutMs = CommandTimeoutMs(device, timeoutId);
+    SGSLrmStatus status = ReceiveFrameBefore(device->bus, address, command, responseCode, start + timeoutMs, frame);
+
+    // Feed the latency tracker behind adaptive deadlines
+    EnterCriticalSection(&device->lock);
+    if (status == SGS_LRM_SUCCESS) {
+        SGSLrmLatency_Record(&device->latency[timeoutId], (unsigned int)(SGSLrmClock_NowMs() - start));
+    } else if (status == SGS_LRM_TIMEOUT) {
+        SGSLrmLatency_RecordTimeout(&device->latency[timeoutId], timeoutMs);
+    }
+    LeaveCriticalSection(&device->lock);
+    return status;
+}
+
+typedef struct {
+    unsigned char address;
+    unsigned char command;
+    unsigned char responseCode;
+} SGSLrmExpectedFrame;
+
+static bool IsExpectedFrame(const SGSLrmFrame* frame, void* context)
+{
+    const SGSLrmExpectedFrame* expected = (const SGSLrmExpectedFrame*)context;
+    return frame->data[0] == expected->address && frame->data[1] == expected->command && frame->data[2] == expected->responseCode;
+}
+
+// ReceiveFrame's read loop, against an absolute deadline.
+static SGSLrmStatus ReceiveFrameBefore(SGSLrmBus* bus, int address, unsigned char command, unsigned char responseCode, unsigned long long deadline, SGSLrmFrame* frame)
+{
+    SGSLrmExpectedFrame expected = { (unsigned char)address, command, responseCode };
+    return ReceiveMatchingFrameBefore(bus, IsExpectedFrame, &expected, deadline, frame);
+}
+
+// Reads frames until match accepts one; frames it turns down are skipped.
+static SGSLrmStatus ReceiveMatchingFrameBefore(SGSLrmBus* bus, SGSLrmFrameMatcher match, void* context, unsigned long long deadline, SGSLrmFrame* frame)
+{
+    unsigned char chunk[64];
+    int chunkLength = 0;
+    int offset = 0;
+    unsigned long long arrivalNs = 0;
+
+    for (;;) {
+        int consumed = 0;
+        bool emitted = SGSLrmFrameParser_Feed(&bus->parser, chunk + offset, chunkLength - offset, arrivalNs, &consumed, frame);
+        offset += consumed;
+
+        if (emitted) {
+            if (!SettleQueuedConfigAck(bus, frame) && match(frame, context)) {
+                bus->txQuietUntilMs = 0; // The module has answered, so it is ready for the next command
+                return SGS_LRM_SUCCESS;
+            }
+            continue;
+        }
+
+        unsigned long long now = SGSLrmClock_NowMs();
+        if (now >= deadline) {
+            return SGS_LRM_TIMEOUT;
+        }
+
+        SGSLrmStatus status = ReceiveResponse(bus, chunk, sizeof(chunk), (unsigned int)(deadline - now), &chunkLength);
+        arrivalNs = SGSLrmClock_NowNs();
+        offset = 0;
+        if (status == SGS_LRM_TIMEOUT) {
+            // Line went idle: a held-back 1 mm frame is complete after all
+            chunkLength = 0;
+            if (SGSLrmFrameParser_Flush(&bus->parser, frame) && !SettleQueuedConfigAck(bus, frame) && match(frame, context)) {
+                bus->txQuietUntilMs = 0;
+                return SGS_LRM_SUCCESS;
+            }
+            continue;
+        }
+        if (status != SGS_LRM_SUCCESS) {
+            return status;
+        }
+    }
+}
+
+
+// Decodes a measurement frame from address without touching any handle, so
+// bus-wide sweeps can decode modules nobody has a handle for. *errorCode
+// receives the module's ERR-XX number for error frames.
+static SGSLrmStatus DecodeMeasurementFrame(const unsigned char* response, int length, int address,
+    int* distanceTenthMm, SGSLrmResolution* resolution, int* errorCode)
+{
+    if (!response || !distanceTenthMm || !resolution || !errorCode) return SGS_LRM_INVALID_PARAMETER;
+    if (length < 4) return SGS_LRM_COMMUNICATION_ERROR;
+
+    // 基本頭碼
+    if (response[0] != (unsigned char)address) return SGS_LRM_COMMUNICATION_ERROR;
+    if (response[1] != CMD_MEASURE) return SGS_LRM_COMMUNICATION_ERROR;
+
+    // 單次掃描：驗證並直接轉成 0.1 mm 整數，不經 strtod
+    return SGSLrmDecode_Measurement(response, length, distanceTenthMm, resolution, errorCode);
+}
+
+// Decodes a frame from device's module; a valid reading becomes its last
+// measurement. Called with device->lock held.
+static SGSLrmStatus ParseMeasurementResponse(SGSLrmDevice* device, const SGSLrmFrame* frame)
+{
+    if (!device) return SGS_LRM_INVALID_PARAMETER;
+
+    int code = 0;
+    int distanceTenthMm = 0;
+    SGSLrmResolution resolution = SGS_LRM_RESOLUTION_1MM;
+    SGSLrmStatus status = DecodeMeasurementFrame(frame->data, frame->length, device->deviceAddress, &distanceTenthMm, &resolution, &code);
+    if (status == SGS_LRM_SUCCESS || status == SGS_LRM_MEASUREMENT_ERROR) {
+        device->frameFirstByteNs = frame->firstByteNs;
+        device->frameLastByteNs = frame->lastByteNs;
+    }
+    if (status == SGS_LRM_MEASUREMENT_ERROR) {
+        device->lastErrorCode = code;
+
+        // 存 ASCII 字串（含終止符），統一為 "ERR-XX"
+        memcpy(device->lastErrorAscii, "ERR-", 4);
+        device->lastErrorAscii[4] = (char)('0' + code / 10);
+        device->lastErrorAscii[5] = (char)('0' + code % 10);
+        device->lastErrorAscii[6] = '\0';
+    } else if (status == SGS_LRM_SUCCESS) {
+        // 成功時清空上一筆錯誤
+        device->lastErrorCode = 0;
+        device->lastErrorAscii[0] = '\0';
+        device->lastRawTenthMm = distanceTenthMm;
+        if (SGSLrmFilter_IsEnabled(&device->filter)) {
+            distanceTenthMm = SGSLrmFilter_Apply(&device->filter, distanceTenthMm);
+        }
+        device->lastDistanceTenthMm = distanceTenthMm;
+        device->lastResolution = resolution;
+    }
+    return status;
+}
+
+
+/*
+static SGSLrmStatus ParseMeasurementResponse(SGSLrmDevice* device, const unsigned char* response, int length, double* distance)
+{
+    if (!device || !response || !distance || length < 4) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    // Protocol response formats:
+    // Single measurement (1mm):     ADDR 06 82 "XXX.XXX" CS
+    // Single measurement (0.1mm):   ADDR 06 82 "XXX.XXXX" CS  
+    // Continuous measurement (1mm):  ADDR 06 83 "XXX.XXX" CS
+    // Continuous measurement (0.1mm): ADDR 06 83 "XXX.XXXX" CS
+    // Error response:                ADDR 06 8X "ERR-XX" CS
+
+    // Verify device address
+    if (response[0] != (unsigned char)device->deviceAddress) {
+        return SGS_LRM_COMMUNICATION_ERROR; // Wrong address
     }
 
     // Verify command type
@@ -779,47 +1494,75 @@ static SGSLrmStatus ParseMeasurementResponse(SGSLrmDevice* device, const unsigne
 }
 
 */
-SGS_LRM_API SGSLrmStatus SGSLrm_SingleMeasurement(SGSLrmHandle handle, double* distance)
+// Shared by the double and integer entry points. The reading is copied out
+// under the state lock, before a salvaged frame could replace it.
+static SGSLrmStatus SingleMeasurement(SGSLrmDevice* device, int* distanceTenthMm, SGSLrmResolution* resolution)
 {
-    enum { MIN_RESP_LEN = 11 };
-    SGSLrmStatus status = ValidateHandle(handle);
-    if (status != SGS_LRM_SUCCESS) return status;
-    if (!distance) return SGS_LRM_INVALID_PARAMETER;
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    EnterCriticalSection(&device->lock);
+    SGSLrmStatus status;
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) { status = SGS_LRM_NOT_CONNECTED; goto cleanup; }
+    // 連續量測期間 RX 由 reactor 讀取，不能同時等待回應
+    if (device->continuousMeasurement) { status = SGS_LRM_INVALID_PARAMETER; goto cleanup; }
 
     unsigned char command[4] = {
         (unsigned char)device->deviceAddress, CMD_MEASURE, SUBCMD_SINGLE_MEASURE, 0
     };
     command[3] = CalculateChecksum(command, 3);
 
-    status = SendCommand(device, command, sizeof(command));
+    // 同一條 bus 上的其他 handle 在串流時也不能送
+    status = BeginTransaction(device);
     if (status != SGS_LRM_SUCCESS) goto cleanup;
 
-    unsigned char response[64];
-    int receivedLength = 0;
-    status = ReceiveResponse(device, response, sizeof(response), &receivedLength);
-    if (status != SGS_LRM_SUCCESS) goto cleanup;
+    status = SendCommand(device, command, sizeof(command));
+    if (status != SGS_LRM_SUCCESS) { EndTransaction(device); goto cleanup; }
 
-    if (receivedLength < MIN_RESP_LEN) { status = SGS_LRM_COMMUNICATION_ERROR; goto cleanup; }
+    // 由 parser 切出完整 frame（CS 已驗過），ERR frame 也在此一併回傳
+    SGSLrmFrame frame;
+    status = ReceiveFrame(device, device->deviceAddress, CMD_MEASURE, RESP_SINGLE_MEASURE, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &frame);
+    EndTransaction(device);
 
-    if (response[0] != (unsigned char)device->deviceAddress ||
-        response[1] != CMD_MEASURE || response[2] != RESP_SINGLE_MEASURE) {
-        status = SGS_LRM_COMMUNICATION_ERROR; goto cleanup;
+    // 只在更新快取狀態時短暫持有 state lock；逾時也發佈到 snapshot
+    EnterCriticalSection(&device->lock);
+    if (status == SGS_LRM_SUCCESS) {
+        status = ParseMeasurementResponse(device, &frame);
+    }
+    if (status == SGS_LRM_SUCCESS) {
+        *distanceTenthMm = device->lastDistanceTenthMm;
+        *resolution = device->lastResolution;
     }
+    PublishMeasurement(device, status);
+    LeaveCriticalSection(&device->lock);
 
-    // CS 在 ReceiveResponse 裡已驗過的話可省；若沒有，保留這段
-    unsigned char expectedChecksum = CalculateChecksum(response, receivedLength - 1);
-    if (response[receivedLength - 1] != expectedChecksum) { status = SGS_LRM_COMMUNICATION_ERROR; goto cleanup; }
+cleanup:
+    LeaveCriticalSection(&device->ioLock);
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SingleMeasurement(SGSLrmHandle handle, double* distance)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) return status;
+    if (!distance) return SGS_LRM_INVALID_PARAMETER;
 
-    status = ParseMeasurementResponse(device, response, receivedLength, distance);
-    if (status == SGS_LRM_SUCCESS) device->lastDistance = *distance;
+    int distanceTenthMm = 0;
+    SGSLrmResolution resolution;
+    status = SingleMeasurement(device, &distanceTenthMm, &resolution);
+    if (status == SGS_LRM_SUCCESS) *distance = (double)distanceTenthMm / SGS_LRM_UNITS_PER_METRE;
+    return status;
+}
 
-cleanup:
-    LeaveCriticalSection(&device->lock);
+SGS_LRM_API SGSLrmStatus SGSLrm_SingleMeasurementTenthMm(SGSLrmHandle handle, int* distanceTenthMm, SGSLrmResolution* resolution)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) return status;
+    if (!distanceTenthMm) return SGS_LRM_INVALID_PARAMETER;
+
+    SGSLrmResolution reported;
+    status = SingleMeasurement(device, distanceTenthMm, &reported);
+    if (status == SGS_LRM_SUCCESS && resolution) *resolution = reported;
     return status;
 }
 
@@ -887,338 +1630,610 @@ cleanup:
 //    return status;
 //}
 
-static DWORD WINAPI ContinuousMeasurementThread(LPVOID lpParam)
+// Runs the user callback on the calling (reactor) thread or queues it for the
+// worker pool. Called without the device lock.
+static void DeliverMeasurement(SGSLrmDevice* device, SGSLrmCallbackMode mode, const SGSLrmDispatchItem* item)
 {
-    SGSLrmDevice* device = (SGSLrmDevice*)lpParam;
-    if (!device) {
-        return 1;
+    if (mode == SGS_LRM_CALLBACK_QUEUED &&
+        SGSLrmDispatcher_Post(&device->dispatch, item)) {
+        return;
     }
+    // Inline mode, or the queue was detached after mode was read
+    SGSLrmDispatchItem_Invoke(device->self, item);
+}
 
-    // Send continuous measurement command only once
-    EnterCriticalSection(&device->lock);
-    
-    if (!device->isConnected || !device->continuousMeasurement) {
-        LeaveCriticalSection(&device->lock);
-        return 0;
-    }
+// A sample waiting to be handed to a user callback once the locks are released
+typedef struct {
+    SGSLrmDevice* device;
+    SGSLrmCallbackMode mode;
+    SGSLrmDispatchItem item;
+} SGSLrmPendingDelivery;
+
+// One chunk carries at most a handful of frames; every streaming handle may
+// also time out in the same pass
+#define MAX_PENDING_DELIVERIES  (SGS_LRM_REACTOR_BUFFER_SIZE / 4 + MAX_BUS_MODULES)
+
+// Publishes a streamed sample and queues its callback. Called with the bus
+// lock and the device lock held.
+static void QueueStreamSample(SGSLrmDevice* device, SGSLrmStatus status, unsigned long long now,
+    SGSLrmPendingDelivery* pending, int* pendingCount)
+{
+    PublishMeasurement(device, status);
+    device->lastFrameMs = now;
 
-    // Send continuous measurement command: ADDR 06 03 CS
-    unsigned char command[4];
-    command[0] = (unsigned char)device->deviceAddress;
-    command[1] = CMD_MEASURE;
-    command[2] = SUBCMD_CONTINUOUS;
-    command[3] = CalculateChecksum(command, 3);
+    const SGSLrmSnapshot* published = &device->snapshot.data;
+    if (published->lastByteNs != 0) {
+        SGSLrmTiming_RecordFrame(&device->timing, published->firstByteNs, published->lastByteNs);
+    } else {
+        SGSLrmTiming_Break(&device->timing);
+    }
 
-    SGSLrmStatus status = SendCommand(device, command, 4);
-    LeaveCriticalSection(&device->lock);
+    if ((device->callback || device->callbackTenthMm || device->callbackEx) && *pendingCount < MAX_PENDING_DELIVERIES) {
+        SGSLrmPendingDelivery* p = &pending[(*pendingCount)++];
+        p->device = device;
+        p->mode = device->callbackMode;
+        p->item.callback = device->callback;
+        p->item.callbackTenthMm = device->callbackTenthMm;
+        p->item.callbackEx = device->callbackEx;
+        p->item.userdata = device->userdata;
+
+        SGSLrmMeasurementEx* m = &p->item.measurement;
+        m->sequence = published->sequence;
+        m->firstByteNs = published->firstByteNs;
+        m->lastByteNs = published->lastByteNs;
+        m->distanceTenthMm = status == SGS_LRM_SUCCESS ? published->distanceTenthMm : 0;
+        m->rawDistanceTenthMm = status == SGS_LRM_SUCCESS ? published->rawDistanceTenthMm : 0;
+        m->distance = (double)m->distanceTenthMm / SGS_LRM_UNITS_PER_METRE;
+        m->resolution = published->resolution;
+        m->status = status;
+        m->errorCode = published->errorCode;
+
+        SGSLrmTrackState track;
+        unsigned long long trackAtNs = published->lastByteNs != 0 ? published->lastByteNs : SGSLrmClock_NowNs();
+        m->tracked = device->tracker.enabled && SGSLrmTracker_Predict(&device->tracker, trackAtNs, &track) == SGS_LRM_SUCCESS;
+        m->trackDistance = m->tracked ? track.distance : 0.0;
+        m->trackVelocity = m->tracked ? track.velocity : 0.0;
+        m->innovation = m->tracked && status == SGS_LRM_SUCCESS ? track.innovation : 0.0;
+    }
+}
 
-    if (status != SGS_LRM_SUCCESS) {
-        return status;
+// Hands a 0x83 frame to the streaming handle at its ADDR byte and config
+// acks to the writes queued for them; frames for addresses nobody streams
+// from are dropped. Called with the bus lock held.
+static void RouteStreamFrame(SGSLrmBus* bus, const SGSLrmFrame* frame, unsigned long long now,
+    SGSLrmPendingDelivery* pending, int* pendingCount)
+{
+    if (SettleQueuedConfigAck(bus, frame)) {
+        return;
     }
 
-    // Continuously receive responses
-    while (device->continuousMeasurement) {
-        double distance = 0.0;
-        status = SGS_LRM_SUCCESS;
+    if (frame->data[1] != CMD_MEASURE || frame->data[2] != RESP_CONTINUOUS) {
+        return;
+    }
 
-        EnterCriticalSection(&device->lock);
-        
-        if (!device->isConnected) {
-            LeaveCriticalSection(&device->lock);
-            break;
+    for (SGSLrmDevice* device = bus->devices; device; device = device->nextOnBus) {
+        if (frame->data[0] != (unsigned char)device->deviceAddress) {
+            continue;
         }
 
-        // Receive response
-        unsigned char response[64];
-        int receivedLength;
-        status = ReceiveResponse(device, response, sizeof(response), &receivedLength);
-
-        // Debug output: show received data (commented out for production)
-        // printf("Received %d bytes\n", receivedLength);
-        
-        if (status == SGS_LRM_SUCCESS && receivedLength >= 4) {
-            // Verify checksum
-            unsigned char expectedChecksum = CalculateChecksum(response, receivedLength - 1);
-            if (response[receivedLength - 1] == expectedChecksum) {
-                // Parse measurement result
-                if (ParseMeasurementResponse(device, response, receivedLength, &distance) == SGS_LRM_SUCCESS) {
-                    device->lastDistance = distance;
-                }
-            }
+        EnterCriticalSection(&device->lock);
+        if (device->continuousMeasurement) {
+            SGSLrmStatus status = ParseMeasurementResponse(device, frame);
+            QueueStreamSample(device, status, now, pending, pendingCount);
         }
-
         LeaveCriticalSection(&device->lock);
-
-        // Call callback if set
-        if (device->callback) {
-            device->callback((SGSLrmHandle)device, distance, status, device->userdata);
-        }
-
-        // Wait for a short interval to avoid overwhelming the system
-        Sleep(5); // 10ms interval for receiving data
+        return;
     }
-
-    return 0;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_StartContinuousMeasurement(SGSLrmHandle handle)
+// Shortest CONTINUOUS deadline among the bus's streaming handles; the
+// reactor's idle period. Called with the bus lock held.
+static unsigned int BusIdleTimeoutMs(SGSLrmBus* bus)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
-    if (status != SGS_LRM_SUCCESS) {
-        return status;
+    unsigned int idleMs = 0;
+    for (SGSLrmDevice* device = bus->devices; device; device = device->nextOnBus) {
+        if (device->continuousMeasurement && (idleMs == 0 || device->streamTimeoutMs < idleMs)) {
+            idleMs = device->streamTimeoutMs;
+        }
     }
+    return idleMs;
+}
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
+// TIMEOUT samples for streaming handles silent past their CONTINUOUS
+// deadline. lineIdle: the reactor saw no bytes for its idle period, which is
+// the shortest deadline on the bus, so handles with that deadline are due
+// however the clock ticks fell. Called with the bus lock held.
+static void ExpireSilentDevices(SGSLrmBus* bus, unsigned long long now, bool lineIdle,
+    SGSLrmPendingDelivery* pending, int* pendingCount)
+{
+    unsigned int idleTimeoutMs = lineIdle ? BusIdleTimeoutMs(bus) : 0;
+    for (SGSLrmDevice* device = bus->devices; device; device = device->nextOnBus) {
+        EnterCriticalSection(&device->lock);
+        if (device->continuousMeasurement && device->lastFrameMs != now &&
+            ((lineIdle && device->streamTimeoutMs <= idleTimeoutMs) ||
+             now - device->lastFrameMs >= device->streamTimeoutMs)) {
+            QueueStreamSample(device, SGS_LRM_TIMEOUT, now, pending, pendingCount);
+        }
+        LeaveCriticalSection(&device->lock);
+    }
+}
+
+static void DeliverPending(const SGSLrmPendingDelivery* pending, int pendingCount)
+{
+    for (int i = 0; i < pendingCount; ++i) {
+        DeliverMeasurement(pending[i].device, pending[i].mode, &pending[i].item);
+    }
+}
+
+// Reactor callback: bytes from a bus with streaming handles. Runs on the
+// shared reactor thread; one chunk may carry several 0x83 frames from
+// different addresses (or a fraction of one).
+static void ContinuousOnData(void* context, const unsigned char* data, int length, unsigned long long arrivalNs)
+{
+    SGSLrmBus* bus = (SGSLrmBus*)context;
+    SGSLrmPendingDelivery pending[MAX_PENDING_DELIVERIES];
+    int pendingCount = 0;
+
+    EnterCriticalSection(&bus->lock);
+
+    if (bus->streamingCount == 0) {
+        LeaveCriticalSection(&bus->lock);
+        return;
+    }
+
+    unsigned long long now = SGSLrmClock_NowMs();
+    int offset = 0;
+    SGSLrmFrame frame;
+    for (;;) {
+        int consumed = 0;
+        bool emitted = SGSLrmFrameParser_Feed(&bus->parser, data + offset, length - offset, arrivalNs, &consumed, &frame);
+        offset += consumed;
+        if (!emitted) break;
+
+        RouteStreamFrame(bus, &frame, now, pending, &pendingCount);
+    }
+
+    // Other modules talking does not keep a silent one alive
+    ExpireSilentDevices(bus, now, false, pending, &pendingCount);
+    ExpireQueuedConfigAcks(bus, now);
+
+    LeaveCriticalSection(&bus->lock);
+
+    // Call callbacks if set
+    DeliverPending(pending, pendingCount);
+}
+
+// Reactor callback: the whole line has been silent for the shortest
+// CONTINUOUS deadline among its streaming handles
+static void ContinuousOnIdle(void* context)
+{
+    SGSLrmBus* bus = (SGSLrmBus*)context;
+    SGSLrmPendingDelivery pending[MAX_PENDING_DELIVERIES];
+    int pendingCount = 0;
+
+    EnterCriticalSection(&bus->lock);
+
+    if (bus->streamingCount == 0) {
+        LeaveCriticalSection(&bus->lock);
+        return;
+    }
+
+    // Line went idle: a held-back 1 mm frame is complete after all
+    unsigned long long now = SGSLrmClock_NowMs();
+    SGSLrmFrame frame;
+    if (SGSLrmFrameParser_Flush(&bus->parser, &frame)) {
+        RouteStreamFrame(bus, &frame, now, pending, &pendingCount);
+    }
+    ExpireSilentDevices(bus, now, true, pending, &pendingCount);
+    ExpireQueuedConfigAcks(bus, now);
+
+    LeaveCriticalSection(&bus->lock);
+
+    DeliverPending(pending, pendingCount);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_StartContinuousMeasurement(SGSLrmHandle handle)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+    
+    EnterCriticalSection(&device->streamLock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
+        LeaveCriticalSection(&device->streamLock);
         return SGS_LRM_NOT_CONNECTED;
     }
 
     if (device->continuousMeasurement) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
+        LeaveCriticalSection(&device->streamLock);
         return SGS_LRM_INVALID_PARAMETER; // Already running
     }
 
+    SGSLrmBus* bus = device->bus;
+    EnterCriticalSection(&bus->streamLock);
+
+    // Send continuous measurement command: ADDR 06 03 CS
+    unsigned char command[4];
+    command[0] = (unsigned char)device->deviceAddress;
+    command[1] = CMD_MEASURE;
+    command[2] = SUBCMD_CONTINUOUS;
+    command[3] = CalculateChecksum(command, 3);
+
+    status = SendCommand(device, command, 4);
+    if (status != SGS_LRM_SUCCESS) {
+        LeaveCriticalSection(&bus->streamLock);
+        LeaveCriticalSection(&device->ioLock);
+        LeaveCriticalSection(&device->streamLock);
+        return status;
+    }
+
+    // wireLock keeps a transaction from starting on the bus mid-change
+    EnterCriticalSection(&bus->wireLock);
+    EnterCriticalSection(&bus->lock);
+    EnterCriticalSection(&device->lock);
+    device->streamTimeoutMs = device->commandTimeoutMs[SGS_LRM_COMMAND_CONTINUOUS];
+    device->lastFrameMs = SGSLrmClock_NowMs();
+    SGSLrmTiming_Init(&device->timing);
     device->continuousMeasurement = true;
-    
-    // Create measurement thread
-    device->continuousThread = CreateThread(
-        NULL,                           // Default security attributes
-        0,                              // Default stack size
-        ContinuousMeasurementThread,    // Thread function
-        device,                         // Thread parameter
-        0,                              // Default creation flags
-        NULL                            // Don't need thread ID
-    );
-
-    if (device->continuousThread == NULL) {
-        device->continuousMeasurement = false;
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
+    LeaveCriticalSection(&device->lock);
+    bool firstOnBus = bus->streamingCount++ == 0;
+    unsigned int idleTimeoutMs = BusIdleTimeoutMs(bus);
+    LeaveCriticalSection(&bus->lock);
+    LeaveCriticalSection(&bus->wireLock);
+
+    // Hand RX to the shared reactor thread (outside the bus locks: the
+    // first callback may already be running when Register returns). Later
+    // handles on the bus share the registration.
+    if (firstOnBus) {
+        bus->reactorSource.idleTimeoutMs = idleTimeoutMs;
+        status = SGSLrmReactor_Register(&bus->reactorSource);
+        if (status != SGS_LRM_SUCCESS) {
+            EnterCriticalSection(&bus->wireLock);
+            EnterCriticalSection(&bus->lock);
+            EnterCriticalSection(&device->lock);
+            device->continuousMeasurement = false;
+            LeaveCriticalSection(&device->lock);
+            bus->streamingCount--;
+            LeaveCriticalSection(&bus->lock);
+            LeaveCriticalSection(&bus->wireLock);
+        }
+    } else {
+        SGSLrmReactor_SetIdleTimeout(&bus->reactorSource, idleTimeoutMs);
     }
 
+    LeaveCriticalSection(&bus->streamLock);
+    LeaveCriticalSection(&device->ioLock);
+    LeaveCriticalSection(&device->streamLock);
+    return status;
+}
+
+// Takes a streaming handle off the bus's reader; the last one unregisters
+// it. On return no reactor callback for the handle is in flight. Caller
+// holds the device's streamLock and ioLock.
+static void StopStreaming(SGSLrmDevice* device)
+{
+    SGSLrmBus* bus = device->bus;
+    EnterCriticalSection(&bus->streamLock);
+
+    EnterCriticalSection(&bus->wireLock);
+    EnterCriticalSection(&bus->lock);
+    EnterCriticalSection(&device->lock);
+    device->continuousMeasurement = false;
     LeaveCriticalSection(&device->lock);
-    return SGS_LRM_SUCCESS;
+    bool lastOnBus = --bus->streamingCount == 0;
+    unsigned int idleTimeoutMs = BusIdleTimeoutMs(bus);
+    LeaveCriticalSection(&bus->lock);
+    LeaveCriticalSection(&bus->wireLock);
+
+    // The reactor callback takes the bus lock, so wait for it without
+    if (lastOnBus) {
+        SGSLrmReactor_Unregister(&bus->reactorSource);
+    } else {
+        SGSLrmReactor_SetIdleTimeout(&bus->reactorSource, idleTimeoutMs);
+        SGSLrmReactor_WaitDispatch(&bus->reactorSource); // A pass may still hold samples for this handle
+    }
+
+    LeaveCriticalSection(&bus->streamLock);
 }
 
 SGS_LRM_API SGSLrmStatus SGSLrm_StopContinuousMeasurement(SGSLrmHandle handle)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->streamLock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->continuousMeasurement) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
+        LeaveCriticalSection(&device->streamLock);
         return SGS_LRM_SUCCESS; // Not running
     }
 
-    device->continuousMeasurement = false;
-    
-    if (device->continuousThread != NULL) {
-        LeaveCriticalSection(&device->lock);
-        
-        // Wait for thread to finish
-        WaitForSingleObject(device->continuousThread, INFINITE);
-        CloseHandle(device->continuousThread);
-        
-        EnterCriticalSection(&device->lock);
-        device->continuousThread = NULL;
-    }
+    // Returns once no callback for this device is in flight
+    StopStreaming(device);
 
-    LeaveCriticalSection(&device->lock);
+    LeaveCriticalSection(&device->ioLock);
+
+    // Same for the worker pool; samples still queued are discarded
+    SGSLrmDispatcher_Cancel(&device->dispatch);
+    LeaveCriticalSection(&device->streamLock);
     return SGS_LRM_SUCCESS;
 }
 
 SGS_LRM_API SGSLrmStatus SGSLrm_SetRange(SGSLrmHandle handle, SGSLrmRange range)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fields = SGS_LRM_CONFIG_RANGE;
+    config.range = range;
+    return WriteConfig(handle, &config, false);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetResolution(SGSLrmHandle handle, SGSLrmResolution resolution)
+{
+    SGSLrmConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fields = SGS_LRM_CONFIG_RESOLUTION;
+    config.resolution = resolution;
+    return WriteConfig(handle, &config, false);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetFrequency(SGSLrmHandle handle, SGSLrmFrequency frequency)
+{
+    SGSLrmConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fields = SGS_LRM_CONFIG_FREQUENCY;
+    config.frequency = frequency;
+    return WriteConfig(handle, &config, false);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetCommandTimeout(SGSLrmHandle handle, SGSLrmCommand command, int timeoutMs)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-    // Validate range values (5, 10, 30, 50, 80 meters) according to protocol
-    unsigned char rangeValue;
-    switch (range) {
-    case SGS_LRM_RANGE_5M:  rangeValue = 0x05; break;  // 5m
-    case SGS_LRM_RANGE_10M: rangeValue = 0x0A; break;  // 10m  
-    case SGS_LRM_RANGE_30M: rangeValue = 0x1E; break;  // 30m
-    case SGS_LRM_RANGE_50M: rangeValue = 0x32; break;  // 50m
-    case SGS_LRM_RANGE_80M: rangeValue = 0x50; break;  // 80m
-    default: return SGS_LRM_INVALID_PARAMETER;
+    if (command < 0 || command >= SGS_LRM_COMMAND_COUNT || timeoutMs < 0 || timeoutMs > MAX_COMMAND_TIMEOUT_MS) {
+        return SGS_LRM_INVALID_PARAMETER;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
+    // Takes effect from the next transaction (or the next Start for CONTINUOUS)
     EnterCriticalSection(&device->lock);
+    device->commandTimeoutMs[command] = timeoutMs == 0 ? g_defaultCommandTimeoutMs[command] : (unsigned int)timeoutMs;
+    LeaveCriticalSection(&device->lock);
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
-    }
+    return SGS_LRM_SUCCESS;
+}
 
-    // Set range command: FA 04 09 RANGE CS (correct protocol format)
-    unsigned char command[5];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_CONFIG;
-    command[2] = SUBCMD_SET_RANGE;
-    command[3] = rangeValue;
-    command[4] = CalculateChecksum(command, 4);
+SGS_LRM_API SGSLrmStatus SGSLrm_GetCommandTimeout(SGSLrmHandle handle, SGSLrmCommand command, int* timeoutMs)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
 
-    status = SendCommand(device, command, 5);
+    if (command < 0 || command >= SGS_LRM_COMMAND_COUNT || !timeoutMs) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
 
-    LeaveCriticalSection(&device->lock);
-    return status;
+    *timeoutMs = (int)CommandTimeoutMs(device, command);
+    return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetResolution(SGSLrmHandle handle, SGSLrmResolution resolution)
+SGS_LRM_API SGSLrmStatus SGSLrm_SetAdaptiveTimeout(SGSLrmHandle handle, SGSLrmCommand command, const SGSLrmAdaptiveTimeout* config)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-	unsigned char resolutionValue;
-    switch (resolution)
-    {
-    case SGS_LRM_RESOLUTION_1MM:
-		resolutionValue = 0x01;
-        break;
-    case SGS_LRM_RESOLUTION_100UM:
-        resolutionValue = 0x02;
-        break;
-    default:
+    // The streaming idle timeout is fixed when streaming starts; nothing to learn from
+    if (command < 0 || command >= SGS_LRM_COMMAND_COUNT || command == SGS_LRM_COMMAND_CONTINUOUS) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    SGSLrmAdaptiveTimeout disabled = { 0 };
+    if (!config) {
+        config = &disabled;
+    }
+    if (config->enabled &&
+        (!(config->multiplier >= 1.0) || config->floorMs < 1 || config->ceilingMs < config->floorMs ||
+         config->ceilingMs > MAX_COMMAND_TIMEOUT_MS)) {
         return SGS_LRM_INVALID_PARAMETER;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
     EnterCriticalSection(&device->lock);
+    device->adaptive[command] = *config;
+    LeaveCriticalSection(&device->lock);
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
-    }
+    return SGS_LRM_SUCCESS;
+}
 
-    // Set resolution command: FA 04 0C RESOLUTION CS
-    // RESOLUTION: 0x01 for 1mm, 0x02 for 0.1mm
-    unsigned char command[5];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_CONFIG;
-    command[2] = SUBCMD_SET_RESOLUTION;
-    command[3] = resolutionValue; // Direct mapping: 1->0x01, 2->0x02
-    command[4] = CalculateChecksum(command, 4);
+SGS_LRM_API SGSLrmStatus SGSLrm_GetLatencyStats(SGSLrmHandle handle, SGSLrmCommand command, SGSLrmLatencyStats* stats)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
 
-    status = SendCommand(device, command, 5);
+    if (command < 0 || command >= SGS_LRM_COMMAND_COUNT || !stats) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
 
+    EnterCriticalSection(&device->lock);
+    const SGSLrmLatencyTracker* latency = &device->latency[command];
+    stats->samples = latency->samples;
+    stats->timeouts = latency->timeouts;
+    stats->ewmaMs = latency->ewmaMs;
+    stats->p99Ms = (int)latency->p99Ms;
+    stats->maxMs = (int)latency->maxMs;
+    stats->currentTimeoutMs = (int)CommandTimeoutMsLocked(device, command);
     LeaveCriticalSection(&device->lock);
-    return status;
+
+    return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetFrequency(SGSLrmHandle handle, SGSLrmFrequency frequency)
+SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementInterval(SGSLrmHandle handle, int intervalMs)
+{
+    SGSLrmConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fields = SGS_LRM_CONFIG_INTERVAL;
+    config.measurementIntervalMs = intervalMs;
+    return WriteConfig(handle, &config, false);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetLastMeasurement(SGSLrmHandle handle, double* distance)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-    // Validate and map frequency values according to protocol specification
-    unsigned char freqValue;
-    switch (frequency) {
-    case SGS_LRM_FREQUENCY_5HZ:  freqValue = 0x05; break;  // 5Hz
-    case SGS_LRM_FREQUENCY_10HZ: freqValue = 0x0A; break;  // 10Hz  
-    case SGS_LRM_FREQUENCY_20HZ: freqValue = 0x14; break;  // 20Hz (maximum frequency)
-    default: return SGS_LRM_INVALID_PARAMETER;
+    if (!distance) {
+        return SGS_LRM_INVALID_PARAMETER;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    SGSLrmSnapshot snapshot;
+    ReadSnapshot(device, &snapshot);
+    *distance = snapshot.distance;
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetLastMeasurementTenthMm(SGSLrmHandle handle, int* distanceTenthMm, SGSLrmResolution* resolution)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
     }
 
-    // Set frequency command: FA 04 0A FREQ CS (correct protocol format)
-    unsigned char command[5];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_CONFIG;
-    command[2] = SUBCMD_SET_FREQUENCY;
-    command[3] = freqValue;
-    command[4] = CalculateChecksum(command, 4);
+    if (!distanceTenthMm) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
 
-    status = SendCommand(device, command, 5);
+    SGSLrmSnapshot snapshot;
+    ReadSnapshot(device, &snapshot);
+    *distanceTenthMm = snapshot.distanceTenthMm;
+    if (resolution) {
+        *resolution = snapshot.resolution;
+    }
 
-    LeaveCriticalSection(&device->lock);
-    return status;
+    return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementInterval(SGSLrmHandle handle, int intervalMs)
+SGS_LRM_API SGSLrmStatus SGSLrm_GetSnapshot(SGSLrmHandle handle, SGSLrmSnapshot* snapshot)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-    // Convert milliseconds to seconds and validate according to protocol
-    // Protocol supports: 0S (continuous) and 1S intervals as per specification
-    unsigned char intervalValue;
-    if (intervalMs == 0) {
-        intervalValue = 0x00; // 0S - continuous measurement
-    } else if (intervalMs >= 1000) {
-        intervalValue = 0x01; // 1S - 1 second interval (minimum discrete interval)
-    } else {
+    if (!snapshot) {
         return SGS_LRM_INVALID_PARAMETER;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
+    ReadSnapshot(device, snapshot);
+    return SGS_LRM_SUCCESS;
+}
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
+SGS_LRM_API SGSLrmStatus SGSLrm_ReadSamples(SGSLrmHandle handle, SGSLrmSample* buffer, int maxCount, int* count)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
     }
 
-    // Set measurement interval command: FA 04 05 INTERVAL CS
-    // INTERVAL: 00=continuous (0S), 01=1 second interval as per protocol specification
-    unsigned char command[5];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_CONFIG;
-    command[2] = SUBCMD_SET_INTERVAL;
-    command[3] = intervalValue; // 0x00 or 0x01 based on protocol
-    command[4] = CalculateChecksum(command, 4);
+    if (!buffer || maxCount <= 0 || !count) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
 
-    status = SendCommand(device, command, 5);
-    // Note: Do not update currentFrequency here as interval and frequency are separate concepts
+    // Consumer side of the ring: no lock, never waits on the producer. Records
+    // are drained a batch at a time and widened into the caller's buffer.
+    SGSLrmSampleRecord records[SAMPLE_BATCH];
+    int total = 0;
+    while (total < maxCount) {
+        int n = SGSLrmSampleRing_PopBatch(&device->samples, records, maxCount - total < SAMPLE_BATCH ? maxCount - total : SAMPLE_BATCH);
+        for (int i = 0; i < n; ++i) {
+            SGSLrmSample* sample = &buffer[total + i];
+            sample->sequence = records[i].sequence;
+            sample->timestampMs = records[i].timestampMs;
+            sample->distance = (double)records[i].distanceTenthMm / SGS_LRM_UNITS_PER_METRE;
+            sample->status = records[i].status;
+            sample->errorCode = records[i].errorCode;
+        }
+        total += n;
+        if (n < SAMPLE_BATCH) break;
+    }
+    *count = total;
+    return SGS_LRM_SUCCESS;
+}
 
-    LeaveCriticalSection(&device->lock);
-    return status;
+SGS_LRM_API SGSLrmStatus SGSLrm_ReadSamplesTenthMm(SGSLrmHandle handle, SGSLrmSampleTenthMm* buffer, int maxCount, int* count)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!buffer || maxCount <= 0 || !count) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    SGSLrmSampleRecord records[SAMPLE_BATCH];
+    int total = 0;
+    while (total < maxCount) {
+        int n = SGSLrmSampleRing_PopBatch(&device->samples, records, maxCount - total < SAMPLE_BATCH ? maxCount - total : SAMPLE_BATCH);
+        for (int i = 0; i < n; ++i) {
+            SGSLrmSampleTenthMm* sample = &buffer[total + i];
+            sample->sequence = (unsigned int)records[i].sequence;
+            sample->timestampMs = (unsigned int)records[i].timestampMs;
+            sample->distanceTenthMm = records[i].distanceTenthMm;
+            sample->status = records[i].status;
+            sample->errorCode = records[i].errorCode;
+            sample->resolution = records[i].resolution;
+            sample->reserved = 0;
+        }
+        total += n;
+        if (n < SAMPLE_BATCH) break;
+    }
+    *count = total;
+    return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_GetLastMeasurement(SGSLrmHandle handle, double* distance)
+SGS_LRM_API SGSLrmStatus SGSLrm_GetSampleOverflow(SGSLrmHandle handle, unsigned long* droppedCount)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-    if (!distance) {
+    if (!droppedCount) {
         return SGS_LRM_INVALID_PARAMETER;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
     EnterCriticalSection(&device->lock);
-    *distance = device->lastDistance;
+    *droppedCount = device->samples.overflowCount;
     LeaveCriticalSection(&device->lock);
 
     return SGS_LRM_SUCCESS;
@@ -1226,17 +2241,16 @@ SGS_LRM_API SGSLrmStatus SGSLrm_GetLastMeasurement(SGSLrmHandle handle, double*
 
 SGS_LRM_API SGSLrmStatus SGSLrm_LaserOn(SGSLrmHandle handle)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
         return SGS_LRM_NOT_CONNECTED;
     }
 
@@ -1250,26 +2264,27 @@ SGS_LRM_API SGSLrmStatus SGSLrm_LaserOn(SGSLrmHandle handle)
 
     status = SendCommand(device, command, 5);
     if (status == SGS_LRM_SUCCESS) {
+        EnterCriticalSection(&device->lock);
         device->laserOn = true; // Update laser status on successful command
+        LeaveCriticalSection(&device->lock);
     }
 
-    LeaveCriticalSection(&device->lock);
+    LeaveCriticalSection(&device->ioLock);
     return status;
 }
 
 SGS_LRM_API SGSLrmStatus SGSLrm_LaserOff(SGSLrmHandle handle)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
         return SGS_LRM_NOT_CONNECTED;
     }
 
@@ -1283,33 +2298,68 @@ SGS_LRM_API SGSLrmStatus SGSLrm_LaserOff(SGSLrmHandle handle)
 
     status = SendCommand(device, command, 5);
     if (status == SGS_LRM_SUCCESS) {
+        EnterCriticalSection(&device->lock);
         device->laserOn = false; // Update laser status on successful command
+        LeaveCriticalSection(&device->lock);
     }
 
-    LeaveCriticalSection(&device->lock);
+    LeaveCriticalSection(&device->ioLock);
     return status;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetAddress(SGSLrmHandle handle, int address)
+typedef struct {
+    const unsigned char* subcommands;   // FA 04 subcommand of each pending write
+    SGSLrmStatus* results;              // SGS_LRM_TIMEOUT while its ack is outstanding
+    int count;
+    int pending;
+} SGSLrmAckCollection;
+
+// FA 04 8X CS acknowledges subcommand X and FA 84 8X NN CS rejects it. Each
+// ack settles the oldest write of its register still waiting; the read ends
+// once none is.
+static bool CollectConfigAck(const SGSLrmFrame* frame, void* context)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
-    if (status != SGS_LRM_SUCCESS) {
-        return status;
+    SGSLrmAckCollection* acks = (SGSLrmAckCollection*)context;
+    if (frame->type != SGS_LRM_FRAME_CONFIG_ACK && frame->type != SGS_LRM_FRAME_CONFIG_NAK) {
+        return false;
+    }
+
+    unsigned char subcommand = frame->data[2] & 0x7F;
+    for (int i = 0; i < acks->count; ++i) {
+        if (acks->subcommands[i] == subcommand && acks->results[i] == SGS_LRM_TIMEOUT) {
+            acks->results[i] = frame->type == SGS_LRM_FRAME_CONFIG_ACK ? SGS_LRM_SUCCESS : SGS_LRM_CONFIG_REJECTED;
+            acks->pending--;
+            break;
+        }
+    }
+    return acks->pending == 0;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetAddress(SGSLrmHandle handle, int address)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
     }
 
     if (address < 0 || address > 255) {
         return SGS_LRM_INVALID_PARAMETER;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
         return SGS_LRM_NOT_CONNECTED;
     }
 
+    // The command is broadcast: on a multi-drop line every module would take the address
+    if (device->bus->multiDrop) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
     // Set address command: FA 04 01 ADDR CS
     unsigned char command[5];
     command[0] = ADDR_BROADCAST;
@@ -1318,319 +2368,1605 @@ SGS_LRM_API SGSLrmStatus SGSLrm_SetAddress(SGSLrmHandle handle, int address)
     command[3] = (unsigned char)address;
     command[4] = CalculateChecksum(command, 4);
 
-    status = SendCommand(device, command, 5);
+    // Acknowledged FA 04 81 CS, refused FA 84 81 02 CS; read like any response,
+    // so not while the line streams
+    status = BeginTransaction(device);
+    if (status != SGS_LRM_SUCCESS) {
+        LeaveCriticalSection(&device->ioLock);
+        return status;
+    }
+
+    unsigned char subcommand = SUBCMD_SET_ADDRESS;
+    SGSLrmStatus result = SGS_LRM_TIMEOUT;
+    SGSLrmAckCollection ack = { &subcommand, &result, 1, 1 };
+    status = WriteCommand(device->bus, command, 5);
+    if (status == SGS_LRM_SUCCESS) {
+        SGSLrmFrame frame;
+        ReceiveMatchingFrameBefore(device->bus, CollectConfigAck, &ack, SGSLrmClock_NowMs() + CONFIG_ACK_TIMEOUT_MS, &frame);
+        status = result;
+    }
     if (status == SGS_LRM_SUCCESS) {
+        EnterCriticalSection(&device->bus->lock); // Routing reads the address
+        EnterCriticalSection(&device->lock);
         device->deviceAddress = address;
+        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->bus->lock);
     }
 
-    LeaveCriticalSection(&device->lock);
+    EndTransaction(device);
+    LeaveCriticalSection(&device->ioLock);
+    return status;
+}
+
+typedef struct {
+    char* list;
+    int size;
+    int length;
+} SGSLrmPortListBuilder;
+
+static void AppendPort(const char* port, const char* stableName, void* context)
+{
+    (void)stableName;
+    SGSLrmPortListBuilder* builder = (SGSLrmPortListBuilder*)context;
+
+    int portNameLen = (int)strlen(port);
+    if (builder->length + portNameLen + 2 < builder->size) // +2 for ';' and '\0'
+    {
+        if (builder->length > 0) {
+            builder->list[builder->length++] = ';';
+        }
+        memcpy(builder->list + builder->length, port, (size_t)portNameLen + 1);
+        builder->length += portNameLen;
+    }
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_EnumComPorts(char* portList, int bufferSize)
+{
+    if (!portList || bufferSize <= 0) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    portList[0] = '\0'; // Initialize empty string
+
+    // The OS already knows its ports: opening COM1..COM256 in turn cost seconds
+    // (and could hang on a Bluetooth port), and grabbed ports other programs held
+    SGSLrmPortListBuilder builder = { portList, bufferSize, 0 };
+    SGSLrmTransport_EnumPorts(AppendPort, &builder);
+
+    return SGS_LRM_SUCCESS;
+}
+
+// One probe thread per port. Threads still blocked when the deadline passes
+// (a port whose open or write hangs) are detached rather than waited for, so
+// the run is reference counted: the caller and every running worker hold a
+// reference, and the last one out frees it.
+typedef struct SGSLrmProbeRun SGSLrmProbeRun;
+
+typedef struct {
+    SGSLrmProbeRun* run;
+    SGSLrmThread thread;
+    char port[128];
+    bool done;
+    SGSLrmStatus status;
+    char deviceId[32];
+} SGSLrmProbeWorker;
+
+struct SGSLrmProbeRun {
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE finished;
+    unsigned long long deadline;
+    int pending;                        // Workers that have not stored a result
+    int refs;                           // Caller plus workers still running
+    int count;
+    SGSLrmProbeWorker* workers;
+};
+
+static void ReleaseProbeRun(SGSLrmProbeRun* run)
+{
+    EnterCriticalSection(&run->lock);
+    bool last = --run->refs == 0;
+    LeaveCriticalSection(&run->lock);
+
+    if (last) {
+        DeleteConditionVariable(&run->finished);
+        DeleteCriticalSection(&run->lock);
+        free(run->workers);
+        free(run);
+    }
+}
+
+// Sends the read-ID command and waits for the answer until deadline
+static SGSLrmStatus ProbePort(const char* port, unsigned long long deadline, char* deviceId, int bufferSize)
+{
+    SGSLrmTransport transport;
+    SGSLrmTransport_Init(&transport, SGSLrmTransport_Default());
+    if (transport.ops->open(&transport, port) != SGS_LRM_SUCCESS) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    unsigned long long now = SGSLrmClock_NowMs();
+    SGSLrmTransportTimeouts timeouts = { 0 };
+    timeouts.readIntervalMs = SGS_LRM_READ_RETURN_ON_DATA;
+    timeouts.writeTotalConstantMs = now < deadline ? (unsigned int)(deadline - now) : 1;
+
+    // Read machine ID command: FA 06 04 FC
+    static const unsigned char command[4] = { ADDR_BROADCAST, CMD_MEASURE, SUBCMD_READ_ID, 0xFC };
+    int written = 0;
+    if (transport.ops->setTimeouts(&transport, &timeouts) != SGS_LRM_SUCCESS ||
+        transport.ops->write(&transport, command, sizeof(command), &written) != SGS_LRM_SUCCESS ||
+        written != (int)sizeof(command)) {
+        transport.ops->close(&transport);
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    SGSLrmFrameParser parser;
+    SGSLrmFrameParser_Init(&parser, SGS_LRM_RESOLUTION_1MM);
+    SGSLrmStatus status = SGS_LRM_TIMEOUT;
+    unsigned char chunk[64];
+    while (status == SGS_LRM_TIMEOUT && (now = SGSLrmClock_NowMs()) < deadline) {
+        int chunkLength = 0;
+        if (transport.ops->readWithin(&transport, chunk, sizeof(chunk), (unsigned int)(deadline - now), &chunkLength) != SGS_LRM_SUCCESS) {
+            status = SGS_LRM_COMMUNICATION_ERROR;
+            break;
+        }
+
+        // Whatever else is on the line (a module left streaming) is skipped
+        int offset = 0;
+        while (offset < chunkLength) {
+            int consumed = 0;
+            SGSLrmFrame frame;
+            bool emitted = SGSLrmFrameParser_Feed(&parser, chunk + offset, chunkLength - offset, 0, &consumed, &frame);
+            offset += consumed;
+            if (emitted && frame.type == SGS_LRM_FRAME_DEVICE_ID) {
+                // FA 06 84 "DAT1...DAT16" CS
+                int dataLength = frame.length - 4;
+                if (dataLength >= bufferSize) dataLength = bufferSize - 1;
+                memcpy(deviceId, &frame.data[3], (size_t)dataLength);
+                deviceId[dataLength] = '\0';
+                status = SGS_LRM_SUCCESS;
+                break;
+            }
+        }
+    }
+
+    transport.ops->close(&transport);
     return status;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_EnumComPorts(char* portList, int bufferSize)
+static DWORD WINAPI ProbeWorker(LPVOID lpParam)
+{
+    SGSLrmProbeWorker* worker = (SGSLrmProbeWorker*)lpParam;
+    SGSLrmProbeRun* run = worker->run;
+
+    char deviceId[32] = "";
+    SGSLrmStatus status = ProbePort(worker->port, run->deadline, deviceId, sizeof(deviceId));
+
+    EnterCriticalSection(&run->lock);
+    worker->status = status;
+    memcpy(worker->deviceId, deviceId, sizeof(deviceId));
+    worker->done = true;
+    if (--run->pending == 0) {
+        WakeAllConditionVariable(&run->finished);
+    }
+    LeaveCriticalSection(&run->lock);
+
+    ReleaseProbeRun(run);
+    return 0;
+}
+
+typedef struct {
+    SGSLrmPortProbe* results;
+    int maxCount;
+    int count;
+} SGSLrmProbeList;
+
+static void AddProbePort(const char* port, const char* stableName, void* context)
+{
+    SGSLrmProbeList* list = (SGSLrmProbeList*)context;
+    if (list->count < list->maxCount) {
+        SGSLrmPortProbe* probe = &list->results[list->count++];
+        strncpy_s(probe->port, sizeof(probe->port), port, _TRUNCATE);
+        strncpy_s(probe->stableName, sizeof(probe->stableName), stableName, _TRUNCATE);
+    }
+}
+
+typedef struct {
+    const char* port;
+    char* stableName;
+    size_t size;
+} SGSLrmStableNameQuery;
+
+static void FindStableName(const char* port, const char* stableName, void* context)
+{
+    SGSLrmStableNameQuery* query = (SGSLrmStableNameQuery*)context;
+    if (strcmp(query->port, port) == 0) {
+        strncpy_s(query->stableName, query->size, stableName, _TRUNCATE);
+    }
+}
+
+// Every port the system lists, from one enumeration: a probe list names
+// many ports, and walking sysfs or the registry once per name does not scale
+typedef struct {
+    SGSLrmPortProbe* ports;
+    int count;
+    int capacity;
+    bool outOfMemory;
+} SGSLrmPortTable;
+
+static void AddPortToTable(const char* port, const char* stableName, void* context)
+{
+    SGSLrmPortTable* table = (SGSLrmPortTable*)context;
+    if (table->outOfMemory) {
+        return;
+    }
+    if (table->count == table->capacity) {
+        int capacity = table->capacity > 0 ? table->capacity * 2 : 16;
+        SGSLrmPortProbe* ports = (SGSLrmPortProbe*)realloc(table->ports, (size_t)capacity * sizeof(SGSLrmPortProbe));
+        if (!ports) {
+            table->outOfMemory = true;
+            return;
+        }
+        table->ports = ports;
+        table->capacity = capacity;
+    }
+    SGSLrmPortProbe* entry = &table->ports[table->count++];
+    strncpy_s(entry->port, sizeof(entry->port), port, _TRUNCATE);
+    strncpy_s(entry->stableName, sizeof(entry->stableName), stableName, _TRUNCATE);
+}
+
+static int ComparePortNames(const void* a, const void* b)
+{
+    return strcmp(((const SGSLrmPortProbe*)a)->port, ((const SGSLrmPortProbe*)b)->port);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_ProbeComPorts(const char* portList, int deadlineMs, SGSLrmPortProbe* results, int maxCount, int* count)
+{
+    if (!results || maxCount <= 0 || !count || deadlineMs < 1 || deadlineMs > MAX_PROBE_DEADLINE_MS) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+    *count = 0;
+
+    unsigned long long deadline = SGSLrmClock_NowMs() + (unsigned int)deadlineMs;
+
+    memset(results, 0, (size_t)maxCount * sizeof(SGSLrmPortProbe));
+    SGSLrmProbeList list = { results, maxCount, 0 };
+    if (!portList) {
+        SGSLrmTransport_EnumPorts(AddProbePort, &list);
+    } else {
+        // Stable names come from one sorted table rather than a walk per listed port
+        SGSLrmPortTable table = { NULL, 0, 0, false };
+        SGSLrmTransport_EnumPorts(AddPortToTable, &table);
+        if (table.outOfMemory) {
+            free(table.ports);
+            return SGS_LRM_OUT_OF_MEMORY;
+        }
+        if (table.count > 1) {
+            qsort(table.ports, (size_t)table.count, sizeof(SGSLrmPortProbe), ComparePortNames);
+        }
+
+        const char* name = portList;
+        while (*name && list.count < maxCount) {
+            const char* end = strchr(name, ';');
+            size_t length = end ? (size_t)(end - name) : strlen(name);
+            if (length > 0 && length < sizeof(results[0].port)) {
+                SGSLrmPortProbe* probe = &results[list.count++];
+                memcpy(probe->port, name, length);
+                probe->port[length] = '\0';
+                const SGSLrmPortProbe* listed = table.count > 0 ?
+                    (const SGSLrmPortProbe*)bsearch(probe, table.ports, (size_t)table.count, sizeof(SGSLrmPortProbe), ComparePortNames) : NULL;
+                if (listed) {
+                    memcpy(probe->stableName, listed->stableName, sizeof(probe->stableName));
+                }
+            }
+            if (!end) break;
+            name = end + 1;
+        }
+        free(table.ports);
+    }
+    if (list.count == 0) {
+        return SGS_LRM_SUCCESS;
+    }
+
+    SGSLrmProbeRun* run = (SGSLrmProbeRun*)calloc(1, sizeof(SGSLrmProbeRun));
+    SGSLrmProbeWorker* workers = (SGSLrmProbeWorker*)calloc((size_t)list.count, sizeof(SGSLrmProbeWorker));
+    if (!run || !workers) {
+        free(run);
+        free(workers);
+        return SGS_LRM_OUT_OF_MEMORY;
+    }
+    InitializeCriticalSection(&run->lock);
+    InitializeConditionVariable(&run->finished);
+    run->deadline = deadline;
+    run->workers = workers;
+    run->count = list.count;
+    run->pending = list.count;
+    run->refs = list.count + 1;
+
+    for (int i = 0; i < list.count; ++i) {
+        SGSLrmProbeWorker* worker = &workers[i];
+        worker->run = run;
+        worker->status = SGS_LRM_TIMEOUT;
+        memcpy(worker->port, results[i].port, sizeof(worker->port));
+    }
+
+    // Workers can finish (and drop their references) before the last one starts
+    EnterCriticalSection(&run->lock);
+    for (int i = 0; i < list.count; ++i) {
+        SGSLrmProbeWorker* worker = &workers[i];
+        if (!SGSLrmThread_Start(&worker->thread, ProbeWorker, worker)) {
+            worker->status = SGS_LRM_COMMUNICATION_ERROR;
+            worker->done = true;
+            run->pending--;
+            run->refs--;
+        }
+    }
+
+    // Return at the deadline whatever is still blocked
+    unsigned long long now;
+    while (run->pending > 0 && (now = SGSLrmClock_NowMs()) < deadline) {
+        SleepConditionVariableCS(&run->finished, &run->lock, (DWORD)(deadline - now));
+    }
+
+    for (int i = 0; i < list.count; ++i) {
+        SGSLrmProbeWorker* worker = &workers[i];
+        results[i].status = worker->done ? worker->status : SGS_LRM_TIMEOUT;
+        if (worker->done && worker->status == SGS_LRM_SUCCESS) {
+            memcpy(results[i].deviceId, worker->deviceId, sizeof(results[i].deviceId));
+        }
+        SGSLrmThread_Detach(&worker->thread);
+    }
+    LeaveCriticalSection(&run->lock);
+
+    ReleaseProbeRun(run);
+    *count = list.count;
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetLaserStatus(SGSLrmHandle handle, bool* isOn)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!isOn) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+    
+    EnterCriticalSection(&device->lock);
+
+    if (!device->isConnected) {
+        LeaveCriticalSection(&device->lock);
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    // Return the tracked laser status instead of default assumption
+    *isOn = device->laserOn;
+
+    LeaveCriticalSection(&device->lock);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementCallback(SGSLrmHandle handle, SGSLrm_MeasurementCallback callback, void* userdata)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+    
+    EnterCriticalSection(&device->lock);
+    device->callback = callback;
+    device->callbackTenthMm = NULL;
+    device->callbackEx = NULL;
+    device->userdata = userdata;
+    LeaveCriticalSection(&device->lock);
+
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementCallbackTenthMm(SGSLrmHandle handle, SGSLrm_MeasurementCallbackTenthMm callback, void* userdata)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    EnterCriticalSection(&device->lock);
+    device->callback = NULL;
+    device->callbackTenthMm = callback;
+    device->callbackEx = NULL;
+    device->userdata = userdata;
+    LeaveCriticalSection(&device->lock);
+
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementCallbackEx(SGSLrmHandle handle, SGSLrm_MeasurementCallbackEx callback, void* userdata)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    EnterCriticalSection(&device->lock);
+    device->callback = NULL;
+    device->callbackTenthMm = NULL;
+    device->callbackEx = callback;
+    device->userdata = userdata;
+    LeaveCriticalSection(&device->lock);
+
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetClockNs(unsigned long long* nowNs)
+{
+    if (!nowNs) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    *nowNs = SGSLrmClock_NowNs();
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetCallbackMode(SGSLrmHandle handle, SGSLrmCallbackMode mode, const SGSLrmCallbackPolicy* policy)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    SGSLrmCallbackPolicy defaults = { 0 };
+    if (!policy) {
+        policy = &defaults;
+    }
+    if (policy->maxQueueDepth < 0 || policy->maxQueueDepth > SGS_LRM_CALLBACK_QUEUE_MAX) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    switch (mode) {
+    case SGS_LRM_CALLBACK_QUEUED:
+        // Attach first so the reactor never sees QUEUED with no workers behind it
+        status = SGSLrmDispatcher_Attach(&device->dispatch, policy);
+        if (status != SGS_LRM_SUCCESS) {
+            return status;
+        }
+        break;
+    case SGS_LRM_CALLBACK_INLINE:
+        break;
+    default:
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->lock);
+    device->callbackMode = mode;
+    LeaveCriticalSection(&device->lock);
+
+    if (mode == SGS_LRM_CALLBACK_INLINE) {
+        // Pending samples are discarded; posts racing with this fall back to inline
+        SGSLrmDispatcher_Detach(&device->dispatch);
+    }
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetCallbackStats(SGSLrmHandle handle, SGSLrmCallbackStats* stats)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!stats) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    SGSLrmDispatcher_GetStats(&device->dispatch, stats);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetRxStats(SGSLrmHandle handle, SGSLrmRxStats* stats)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!stats) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->lock);
+    *stats = device->rxStats;
+    LeaveCriticalSection(&device->lock);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetFilter(SGSLrmHandle handle, const SGSLrmFilterConfig* config)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (config && SGSLrmFilter_Validate(config) != SGS_LRM_SUCCESS) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->lock);
+    SGSLrmFilter_Init(&device->filter, config);
+    LeaveCriticalSection(&device->lock);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetFilterStats(SGSLrmHandle handle, SGSLrmFilterStats* stats)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!stats) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->lock);
+    *stats = device->filter.stats;
+    LeaveCriticalSection(&device->lock);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetTracker(SGSLrmHandle handle, const SGSLrmTrackerConfig* config)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (config && SGSLrmTracker_Validate(config) != SGS_LRM_SUCCESS) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->lock);
+    SGSLrmTracker_Init(&device->tracker, config);
+    LeaveCriticalSection(&device->lock);
+    return SGS_LRM_SUCCESS;
+}
+
+// Both track getters: the state at atNs, or at the last update when atNs is 0
+static SGSLrmStatus ReadTrack(SGSLrmHandle handle, bool predict, unsigned long long atNs, SGSLrmTrackState* state)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!state) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    if (predict && atNs == 0) {
+        atNs = SGSLrmClock_NowNs();
+    }
+
+    EnterCriticalSection(&device->lock);
+    status = SGS_LRM_NO_TRACK;
+    if (device->tracker.enabled) {
+        status = SGSLrmTracker_Predict(&device->tracker, predict ? atNs : device->tracker.timeNs, state);
+    }
+    LeaveCriticalSection(&device->lock);
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetTrack(SGSLrmHandle handle, SGSLrmTrackState* state)
+{
+    return ReadTrack(handle, false, 0, state);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_PredictTrack(SGSLrmHandle handle, unsigned long long atNs, SGSLrmTrackState* state)
+{
+    return ReadTrack(handle, true, atNs, state);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetTimingStats(SGSLrmHandle handle, SGSLrmTimingStats* stats)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!stats) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->lock);
+    SGSLrmTiming_GetStats(&device->timing, stats);
+    LeaveCriticalSection(&device->lock);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetDistanceCorrection(SGSLrmHandle handle, int correctionMm)
+{
+    SGSLrmConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fields = SGS_LRM_CONFIG_CORRECTION;
+    config.distanceCorrectionMm = correctionMm;
+    return WriteConfig(handle, &config, false);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetStartPosition(SGSLrmHandle handle, SGSLrmStartPosition position)
+{
+    SGSLrmConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fields = SGS_LRM_CONFIG_START_POSITION;
+    config.startPosition = position;
+    return WriteConfig(handle, &config, false);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetAutoMeasurement(SGSLrmHandle handle, bool enable)
+{
+    SGSLrmConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fields = SGS_LRM_CONFIG_AUTO_MEASUREMENT;
+    config.autoMeasurement = enable;
+    return WriteConfig(handle, &config, false);
+}
+
+// Builds the FA 04 write for one SGS_LRM_CONFIG_* register of config. The
+// module answers FA 04 8X CS, or FA 84 8X 01 CS when it refuses the value.
+static SGSLrmStatus EncodeConfigRegister(const SGSLrmConfig* config, unsigned int field, unsigned char* command, int* length)
+{
+    command[0] = ADDR_BROADCAST;
+    command[1] = CMD_CONFIG;
+    *length = 5;
+
+    switch (field) {
+    case SGS_LRM_CONFIG_RANGE:
+        // FA 04 09 RANGE CS: 5, 10, 30, 50 or 80 m
+        command[2] = SUBCMD_SET_RANGE;
+        switch (config->range) {
+        case SGS_LRM_RANGE_5M:  command[3] = 0x05; break;
+        case SGS_LRM_RANGE_10M: command[3] = 0x0A; break;
+        case SGS_LRM_RANGE_30M: command[3] = 0x1E; break;
+        case SGS_LRM_RANGE_50M: command[3] = 0x32; break;
+        case SGS_LRM_RANGE_80M: command[3] = 0x50; break;
+        default: return SGS_LRM_INVALID_PARAMETER;
+        }
+        break;
+    case SGS_LRM_CONFIG_RESOLUTION:
+        // FA 04 0C RESOLUTION CS: 0x01 for 1mm, 0x02 for 0.1mm
+        command[2] = SUBCMD_SET_RESOLUTION;
+        switch (config->resolution) {
+        case SGS_LRM_RESOLUTION_1MM:   command[3] = 0x01; break;
+        case SGS_LRM_RESOLUTION_100UM: command[3] = 0x02; break;
+        default: return SGS_LRM_INVALID_PARAMETER;
+        }
+        break;
+    case SGS_LRM_CONFIG_FREQUENCY:
+        // FA 04 0A FREQ CS: 5, 10 or 20 Hz
+        command[2] = SUBCMD_SET_FREQUENCY;
+        switch (config->frequency) {
+        case SGS_LRM_FREQUENCY_5HZ:  command[3] = 0x05; break;
+        case SGS_LRM_FREQUENCY_10HZ: command[3] = 0x0A; break;
+        case SGS_LRM_FREQUENCY_20HZ: command[3] = 0x14; break;
+        default: return SGS_LRM_INVALID_PARAMETER;
+        }
+        break;
+    case SGS_LRM_CONFIG_INTERVAL:
+        // FA 04 05 INTERVAL CS: 00=continuous (0S), 01=1 second interval
+        command[2] = SUBCMD_SET_INTERVAL;
+        if (config->measurementIntervalMs == 0) {
+            command[3] = 0x00;
+        } else if (config->measurementIntervalMs >= 1000) {
+            command[3] = 0x01;
+        } else {
+            return SGS_LRM_INVALID_PARAMETER;
+        }
+        break;
+    case SGS_LRM_CONFIG_CORRECTION:
+        // FA 04 06 SIGN VALUE CS
+        if (config->distanceCorrectionMm < -255 || config->distanceCorrectionMm > 255) {
+            return SGS_LRM_INVALID_PARAMETER;
+        }
+        command[2] = SUBCMD_SET_CORRECTION;
+        command[3] = config->distanceCorrectionMm < 0 ? 0x2D : 0x2B;
+        command[4] = (unsigned char)abs(config->distanceCorrectionMm);
+        *length = 6;
+        break;
+    case SGS_LRM_CONFIG_START_POSITION:
+        // FA 04 08 POSITION CS: 0=tail, 1=top
+        command[2] = SUBCMD_SET_POSITION;
+        switch (config->startPosition) {
+        case SGS_LRM_START_POSITION_TAIL: command[3] = 0x00; break;
+        case SGS_LRM_START_POSITION_TOP:  command[3] = 0x01; break;
+        default: return SGS_LRM_INVALID_PARAMETER;
+        }
+        break;
+    case SGS_LRM_CONFIG_AUTO_MEASUREMENT:
+        // FA 04 0D ENABLE CS: measure on power up
+        command[2] = SUBCMD_SET_AUTO_MEASURE;
+        command[3] = config->autoMeasurement ? 0x01 : 0x00;
+        break;
+    default:
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    command[*length - 1] = CalculateChecksum(command, *length - 1);
+    return SGS_LRM_SUCCESS;
+}
+
+static void CopyConfigRegister(SGSLrmConfig* to, const SGSLrmConfig* from, unsigned int field)
+{
+    switch (field) {
+    case SGS_LRM_CONFIG_RANGE:            to->range = from->range; break;
+    case SGS_LRM_CONFIG_RESOLUTION:       to->resolution = from->resolution; break;
+    case SGS_LRM_CONFIG_FREQUENCY:        to->frequency = from->frequency; break;
+    case SGS_LRM_CONFIG_INTERVAL:         to->measurementIntervalMs = from->measurementIntervalMs; break;
+    case SGS_LRM_CONFIG_CORRECTION:       to->distanceCorrectionMm = from->distanceCorrectionMm; break;
+    case SGS_LRM_CONFIG_START_POSITION:   to->startPosition = from->startPosition; break;
+    case SGS_LRM_CONFIG_AUTO_MEASUREMENT: to->autoMeasurement = from->autoMeasurement; break;
+    default: break;
+    }
+    to->fields |= field;
+}
+
+// Register an FA 04 subcommand writes; 0 for the address, which is not one
+static unsigned int ConfigFieldOf(unsigned char subcommand)
+{
+    switch (subcommand) {
+    case SUBCMD_SET_RANGE:        return SGS_LRM_CONFIG_RANGE;
+    case SUBCMD_SET_RESOLUTION:   return SGS_LRM_CONFIG_RESOLUTION;
+    case SUBCMD_SET_FREQUENCY:    return SGS_LRM_CONFIG_FREQUENCY;
+    case SUBCMD_SET_INTERVAL:     return SGS_LRM_CONFIG_INTERVAL;
+    case SUBCMD_SET_CORRECTION:   return SGS_LRM_CONFIG_CORRECTION;
+    case SUBCMD_SET_POSITION:     return SGS_LRM_CONFIG_START_POSITION;
+    case SUBCMD_SET_AUTO_MEASURE: return SGS_LRM_CONFIG_AUTO_MEASUREMENT;
+    default:                      return 0;
+    }
+}
+
+static int ConfigRegisterIndex(unsigned int field)
+{
+    int index = 0;
+    while (field > 1) {
+        field >>= 1;
+        index++;
+    }
+    return index;
+}
+
+// The module acknowledged value's register. Config writes are broadcast, so
+// every handle on the line follows: resolution changes the frame length and
+// range the measurement time, which is relearnt from scratch. Called with the
+// bus lock held.
+static void CommitConfigRegister(SGSLrmBus* bus, const SGSLrmConfig* value, unsigned int field)
+{
+    CopyConfigRegister(&bus->configShadow, value, field);
+    bus->configFailed &= ~field;
+
+    if (field == SGS_LRM_CONFIG_RESOLUTION) {
+        bus->parser.resolution = value->resolution; // Expected measurement frame length from now on
+    } else if (field != SGS_LRM_CONFIG_RANGE) {
+        return;
+    }
+
+    for (SGSLrmDevice* device = bus->devices; device; device = device->nextOnBus) {
+        EnterCriticalSection(&device->lock);
+        if (field == SGS_LRM_CONFIG_RESOLUTION) {
+            device->resolution = value->resolution;
+        } else {
+            SGSLrmLatency_Init(&device->latency[SGS_LRM_COMMAND_SINGLE_MEASUREMENT]);
+        }
+        LeaveCriticalSection(&device->lock);
+    }
+}
+
+// Rejected or never acknowledged: what the module holds is unknown, so the
+// next SGSLrm_ApplyConfig rewrites it. Called with the bus lock held.
+static void FailConfigRegister(SGSLrmBus* bus, unsigned int field)
+{
+    bus->configShadow.fields &= ~field;
+    bus->configFailed |= field;
+}
+
+// Settles the queued write an ack belongs to, wherever the ack is read: by
+// the reactor while the line streams, or by the first transaction after it
+// stops. Returns true if the frame was consumed.
+static bool SettleQueuedConfigAck(SGSLrmBus* bus, const SGSLrmFrame* frame)
+{
+    if (frame->type != SGS_LRM_FRAME_CONFIG_ACK && frame->type != SGS_LRM_FRAME_CONFIG_NAK) {
+        return false;
+    }
+
+    unsigned int field = ConfigFieldOf(frame->data[2] & 0x7F);
+    EnterCriticalSection(&bus->lock);
+    bool queued = field != 0 && (bus->configQueued.fields & field) != 0;
+    if (queued) {
+        bus->configQueued.fields &= ~field;
+        if (frame->type == SGS_LRM_FRAME_CONFIG_ACK) {
+            CommitConfigRegister(bus, &bus->configQueued, field);
+        } else {
+            FailConfigRegister(bus, field);
+        }
+    }
+    LeaveCriticalSection(&bus->lock);
+    return queued;
+}
+
+// Queued writes whose ack is overdue count as failed. Called with the bus lock held.
+static void ExpireQueuedConfigAcks(SGSLrmBus* bus, unsigned long long now)
+{
+    for (unsigned int field = 1; bus->configQueued.fields & ~(field - 1); field <<= 1) {
+        if ((bus->configQueued.fields & field) && now >= bus->configAckDeadlineMs[ConfigRegisterIndex(field)]) {
+            bus->configQueued.fields &= ~field;
+            FailConfigRegister(bus, field);
+        }
+    }
+}
+
+// Writes config's selected registers back to back; refused on a multi-drop
+// line, like SGSLrm_SetAddress. onlyChanged skips those
+// the shadow says the modules already hold (SGSLrm_ApplyConfig); the single
+// setters always write. On an idle line every ack is collected in one pass
+// before returning. While the line streams the reactor owns RX: the writes
+// are queued and settle as their acks come in, or fail after
+// CONFIG_ACK_TIMEOUT_MS (SGSLrm_GetConfigStatus).
+static SGSLrmStatus WriteConfig(SGSLrmHandle handle, const SGSLrmConfig* config, bool onlyChanged)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!config || (config->fields & ~SGS_LRM_CONFIG_ALL)) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    // Encode every selected register first: a bad value fails the call before anything is sent
+    unsigned int fields[CONFIG_REGISTER_COUNT];
+    unsigned char commands[CONFIG_REGISTER_COUNT][6];
+    int lengths[CONFIG_REGISTER_COUNT];
+    int selected = 0;
+    for (unsigned int field = 1; field & SGS_LRM_CONFIG_ALL; field <<= 1) {
+        if (!(config->fields & field)) continue;
+        status = EncodeConfigRegister(config, field, commands[selected], &lengths[selected]);
+        if (status != SGS_LRM_SUCCESS) {
+            return status;
+        }
+        fields[selected++] = field;
+    }
+
+    EnterCriticalSection(&device->ioLock);
+
+    if (!device->isConnected) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    // Config writes are broadcast: on a multi-drop line every module would take
+    // the value and their acks would collide, so no write could be confirmed
+    if (device->bus->multiDrop) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    SGSLrmBus* bus = device->bus;
+    AcquireLine(bus, device);
+
+    EnterCriticalSection(&bus->lock);
+    ExpireQueuedConfigAcks(bus, SGSLrmClock_NowMs());
+    SGSLrmConfig shadow = bus->configShadow;
+    bool queue = bus->streamingCount > 0;
+    LeaveCriticalSection(&bus->lock);
+
+    unsigned char subcommands[CONFIG_REGISTER_COUNT];
+    SGSLrmStatus results[CONFIG_REGISTER_COUNT];
+    int sent[CONFIG_REGISTER_COUNT];
+    SGSLrmAckCollection acks = { subcommands, results, 0, 0 };
+    for (int i = 0; i < selected; ++i) {
+        if (onlyChanged && (shadow.fields & fields[i])) {
+            unsigned char current[6];
+            int currentLength = 0;
+            if (EncodeConfigRegister(&shadow, fields[i], current, &currentLength) == SGS_LRM_SUCCESS &&
+                currentLength == lengths[i] && memcmp(current, commands[i], (size_t)currentLength) == 0) {
+                continue;
+            }
+        }
+
+        subcommands[acks.count] = commands[i][2];
+        results[acks.count] = WriteCommand(bus, commands[i], lengths[i]);
+        if (results[acks.count] == SGS_LRM_SUCCESS) {
+            results[acks.count] = SGS_LRM_TIMEOUT; // Until its ack arrives
+            acks.pending++;
+        }
+        sent[acks.count++] = i;
+    }
+
+    // One pass over the line for every ack
+    if (!queue && acks.pending > 0) {
+        SGSLrmFrame frame;
+        ReceiveMatchingFrameBefore(bus, CollectConfigAck, &acks, SGSLrmClock_NowMs() + CONFIG_ACK_TIMEOUT_MS, &frame);
+    }
+
+    status = SGS_LRM_SUCCESS;
+    EnterCriticalSection(&bus->lock);
+    unsigned long long deadline = SGSLrmClock_NowMs() + CONFIG_ACK_TIMEOUT_MS;
+    for (int j = 0; j < acks.count; ++j) {
+        unsigned int field = fields[sent[j]];
+        bus->configQueued.fields &= ~field; // Superseded by this write
+        if (queue && results[j] == SGS_LRM_TIMEOUT) {
+            bus->configShadow.fields &= ~field;
+            CopyConfigRegister(&bus->configQueued, config, field);
+            bus->configAckDeadlineMs[ConfigRegisterIndex(field)] = deadline;
+        } else if (results[j] == SGS_LRM_SUCCESS) {
+            CommitConfigRegister(bus, config, field);
+        } else {
+            FailConfigRegister(bus, field);
+            if (status == SGS_LRM_SUCCESS) status = results[j];
+        }
+    }
+    LeaveCriticalSection(&bus->lock);
+
+    LeaveCriticalSection(&bus->wireLock);
+    LeaveCriticalSection(&device->ioLock);
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_ApplyConfig(SGSLrmHandle handle, const SGSLrmConfig* config)
+{
+    return WriteConfig(handle, config, true);
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetConfig(SGSLrmHandle handle, SGSLrmConfig* config)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!config) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->ioLock);
+
+    if (!device->isConnected) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    EnterCriticalSection(&device->bus->lock);
+    ExpireQueuedConfigAcks(device->bus, SGSLrmClock_NowMs());
+    *config = device->bus->configShadow;
+    LeaveCriticalSection(&device->bus->lock);
+
+    LeaveCriticalSection(&device->ioLock);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_GetConfigStatus(SGSLrmHandle handle, unsigned int* pending, unsigned int* failed)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!pending || !failed) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&device->ioLock);
+
+    if (!device->isConnected) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    EnterCriticalSection(&device->bus->lock);
+    ExpireQueuedConfigAcks(device->bus, SGSLrmClock_NowMs());
+    *pending = device->bus->configQueued.fields;
+    *failed = device->bus->configFailed;
+    LeaveCriticalSection(&device->bus->lock);
+
+    LeaveCriticalSection(&device->ioLock);
+    return SGS_LRM_SUCCESS;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_BroadcastMeasurement(SGSLrmHandle handle)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+    
+    EnterCriticalSection(&device->ioLock);
+
+    if (!device->isConnected) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    // Broadcast measurement command: FA 06 06 FA (no response, result stored in module cache)
+    unsigned char command[4];
+    command[0] = ADDR_BROADCAST;
+    command[1] = CMD_MEASURE;
+    command[2] = SUBCMD_BROADCAST_MEASURE;
+    command[3] = 0xFA; // Fixed checksum as per protocol
+
+    status = SendCommand(device, command, 4);
+
+    LeaveCriticalSection(&device->ioLock);
+    return status;
+}
+
+// Shared by the double and integer entry points, as SingleMeasurement
+static SGSLrmStatus ReadCache(SGSLrmDevice* device, int* distanceTenthMm, SGSLrmResolution* resolution)
+{
+    SGSLrmStatus status;
+    EnterCriticalSection(&device->ioLock);
+
+    if (!device->isConnected) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_NOT_CONNECTED;
+    }
+
+    // The reactor owns RX while streaming; a response could not be waited for
+    if (device->continuousMeasurement) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    // Read cache command: ADDR 06 07 CS
+    unsigned char command[4];
+    command[0] = (unsigned char)device->deviceAddress; // Device address
+    command[1] = CMD_MEASURE;
+    command[2] = SUBCMD_READ_CACHE;
+    command[3] = CalculateChecksum(command, 3);
+
+    status = BeginTransaction(device);
+    if (status != SGS_LRM_SUCCESS) {
+        LeaveCriticalSection(&device->ioLock);
+        return status; // Another handle on the bus is streaming
+    }
+
+    status = SendCommand(device, command, 4);
+    if (status != SGS_LRM_SUCCESS) {
+        EndTransaction(device);
+        LeaveCriticalSection(&device->ioLock);
+        return status;
+    }
+
+    // Receive response (checksum verified by the frame parser)
+    SGSLrmFrame frame;
+    status = ReceiveFrame(device, device->deviceAddress, CMD_MEASURE, RESP_READ_CACHE, SGS_LRM_COMMAND_READ_CACHE, &frame);
+    EndTransaction(device);
+
+    // Parse measurement result (same format as single measurement)
+    EnterCriticalSection(&device->lock);
+    if (status == SGS_LRM_SUCCESS) {
+        status = ParseMeasurementResponse(device, &frame);
+    }
+    if (status == SGS_LRM_SUCCESS) {
+        *distanceTenthMm = device->lastDistanceTenthMm;
+        *resolution = device->lastResolution;
+    }
+    PublishMeasurement(device, status);
+    LeaveCriticalSection(&device->lock);
+
+    LeaveCriticalSection(&device->ioLock);
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_ReadCache(SGSLrmHandle handle, double* distance)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!distance) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    int distanceTenthMm = 0;
+    SGSLrmResolution resolution;
+    status = ReadCache(device, &distanceTenthMm, &resolution);
+    if (status == SGS_LRM_SUCCESS) {
+        *distance = (double)distanceTenthMm / SGS_LRM_UNITS_PER_METRE;
+    }
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_ReadCacheTenthMm(SGSLrmHandle handle, int* distanceTenthMm, SGSLrmResolution* resolution)
+{
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!distanceTenthMm) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    SGSLrmResolution reported;
+    status = ReadCache(device, distanceTenthMm, &reported);
+    if (status == SGS_LRM_SUCCESS && resolution) {
+        *resolution = reported;
+    }
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_SetSyncWindow(SGSLrmBusHandle handle, int windowMs)
+{
+    SGSLrmBus* bus = NULL;
+    SGSLrmStatus status = ValidateBusHandle(handle, &bus);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (windowMs < 0 || windowMs > MAX_COMMAND_TIMEOUT_MS) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&bus->wireLock);
+    bus->syncWindowMs = (unsigned int)windowMs;
+    LeaveCriticalSection(&bus->wireLock);
+    return SGS_LRM_SUCCESS;
+}
+
+// Handle attached to the bus at address, or NULL. Called with wireLock held,
+// which keeps the handle from detaching.
+static SGSLrmDevice* FindDeviceOnBus(SGSLrmBus* bus, int address)
+{
+    EnterCriticalSection(&bus->lock);
+    SGSLrmDevice* device = bus->devices;
+    while (device && device->deviceAddress != address) {
+        device = device->nextOnBus;
+    }
+    LeaveCriticalSection(&bus->lock);
+    return device;
+}
+
+// Validation shared by the bus-wide cache operations
+static SGSLrmStatus ValidateSweep(SGSLrmBusHandle handle, const int* addresses, int count, SGSLrmSyncResult* results, SGSLrmBus** bus)
 {
-    if (!portList || bufferSize <= 0) {
+    SGSLrmStatus status = ValidateBusHandle(handle, bus);
+    if (status != SGS_LRM_SUCCESS) {
+        return status;
+    }
+
+    if (!addresses || !results || count <= 0) {
         return SGS_LRM_INVALID_PARAMETER;
     }
 
-    portList[0] = '\0'; // Initialize empty string
-    int currentPos = 0;
-    
-    for (int i = 1; i <= 256; i++) {
-        char portName[16];
-        sprintf_s(portName, sizeof(portName), "COM%d", i);
-        
-        HANDLE hPort = CreateFileA(portName,
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            NULL,
-            OPEN_EXISTING,
-            0,
-            NULL);
-            
-        if (hPort != INVALID_HANDLE_VALUE) {
-            CloseHandle(hPort);
-            
-            // Add port to list
-            int portNameLen = (int)strlen(portName);
-            if (currentPos + portNameLen + 2 < bufferSize) // +2 for ';' and '\0'
-            {
-                if (currentPos > 0) {
-                    strcat_s(portList, bufferSize, ";");
-                    currentPos++;
-                }
-                strcat_s(portList, bufferSize, portName);
-                currentPos += portNameLen;
-            }
+    for (int i = 0; i < count; ++i) {
+        if (addresses[i] < 0 || addresses[i] > 255 || addresses[i] == ADDR_BROADCAST) {
+            return SGS_LRM_INVALID_PARAMETER;
         }
     }
-    
     return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_GetLaserStatus(SGSLrmHandle handle, bool* isOn)
+// Reads ADDR 06 07 from each address back to back. The next command goes out
+// the moment the previous answer's checksum byte is parsed (the answer ends
+// the quiet period), so the line only idles for the modules' turnaround.
+// Called with the line taken (AcquireLine) and no handle streaming.
+static void SweepCaches(SGSLrmBus* bus, const int* addresses, int count, SGSLrmSyncResult* results)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
-    if (status != SGS_LRM_SUCCESS) {
-        return status;
+    // Whatever the line still owes (e.g. the sync window) is not sweep time
+    unsigned long long now = SGSLrmClock_NowMs();
+    if (now < bus->txQuietUntilMs) {
+        Sleep((DWORD)(bus->txQuietUntilMs - now));
     }
 
-    if (!isOn) {
-        return SGS_LRM_INVALID_PARAMETER;
-    }
+    unsigned long long startUs = SGSLrmClock_NowUs();
+    int wireBytes = 0;
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
+    for (int i = 0; i < count; ++i) {
+        unsigned char command[4] = { (unsigned char)addresses[i], CMD_MEASURE, SUBCMD_READ_CACHE, 0 };
+        command[3] = CalculateChecksum(command, 3);
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
-    }
+        results[i].distance = 0.0;
+        results[i].status = WriteCommand(bus, command, sizeof(command));
+        if (results[i].status != SGS_LRM_SUCCESS) {
+            continue;
+        }
+        wireBytes += sizeof(command);
 
-    // Return the tracked laser status instead of default assumption
-    *isOn = device->laserOn;
+        // An attached handle lends its deadline and learns from the answer
+        SGSLrmDevice* device = FindDeviceOnBus(bus, addresses[i]);
+        SGSLrmFrame frame;
+        if (device) {
+            results[i].status = ReceiveFrame(device, addresses[i], CMD_MEASURE, RESP_READ_CACHE, SGS_LRM_COMMAND_READ_CACHE, &frame);
+        } else {
+            unsigned long long deadline = SGSLrmClock_NowMs() + g_defaultCommandTimeoutMs[SGS_LRM_COMMAND_READ_CACHE];
+            results[i].status = ReceiveFrameBefore(bus, addresses[i], CMD_MEASURE, RESP_READ_CACHE, deadline, &frame);
+        }
+        if (results[i].status == SGS_LRM_SUCCESS) {
+            wireBytes += frame.length;
+        }
 
-    LeaveCriticalSection(&device->lock);
-    return SGS_LRM_SUCCESS;
+        if (device) {
+            EnterCriticalSection(&device->lock);
+            if (results[i].status == SGS_LRM_SUCCESS) {
+                results[i].status = ParseMeasurementResponse(device, &frame);
+            }
+            if (results[i].status == SGS_LRM_SUCCESS) {
+                results[i].distance = (double)device->lastDistanceTenthMm / SGS_LRM_UNITS_PER_METRE;
+            }
+            PublishMeasurement(device, results[i].status);
+            LeaveCriticalSection(&device->lock);
+        } else if (results[i].status == SGS_LRM_SUCCESS) {
+            int errorCode = 0;
+            int distanceTenthMm = 0;
+            SGSLrmResolution resolution;
+            results[i].status = DecodeMeasurementFrame(frame.data, frame.length, addresses[i], &distanceTenthMm, &resolution, &errorCode);
+            if (results[i].status == SGS_LRM_SUCCESS) {
+                results[i].distance = (double)distanceTenthMm / SGS_LRM_UNITS_PER_METRE;
+            }
+        }
+    }
+
+    double sweepMs = (SGSLrmClock_NowUs() - startUs) / 1000.0;
+
+    // What the line needs for this many answers at the current resolution
+    int answerLength = bus->parser.resolution == SGS_LRM_RESOLUTION_100UM ? 12 : 11;
+    double expectedWireMs = count * (4 + answerLength) * 10 * 1000.0 / LINE_BAUD_RATE;
+
+    EnterCriticalSection(&bus->lock);
+    SGSLrmSweepStats* stats = &bus->sweepStats;
+    stats->sweeps++;
+    stats->lastCount = count;
+    stats->lastSweepMs = sweepMs;
+    if (stats->sweeps == 1 || sweepMs < stats->bestSweepMs) stats->bestSweepMs = sweepMs;
+    stats->wireMs = wireBytes * 10 * 1000.0 / LINE_BAUD_RATE;
+    stats->utilisation = sweepMs > 0.0 ? stats->wireMs / sweepMs : 0.0;
+    stats->achievableHz = 1000.0 / expectedWireMs;
+    LeaveCriticalSection(&bus->lock);
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementCallback(SGSLrmHandle handle, SGSLrm_MeasurementCallback callback, void* userdata)
+SGS_LRM_API SGSLrmStatus SGSLrm_SweepCache(SGSLrmBusHandle handle, const int* addresses, int count, SGSLrmSyncResult* results)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmBus* bus = NULL;
+    SGSLrmStatus status = ValidateSweep(handle, addresses, count, results, &bus);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
-    device->callback = callback;
-    device->userdata = userdata;
-    LeaveCriticalSection(&device->lock);
+    AcquireLine(bus, NULL);
+
+    if (bus->streamingCount > 0) {
+        LeaveCriticalSection(&bus->wireLock);
+        return SGS_LRM_INVALID_PARAMETER; // The reactor owns RX while streaming
+    }
+
+    SweepCaches(bus, addresses, count, results);
 
+    LeaveCriticalSection(&bus->wireLock);
     return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetDistanceCorrection(SGSLrmHandle handle, int correctionMm)
+SGS_LRM_API SGSLrmStatus SGSLrm_SyncAcquire(SGSLrmBusHandle handle, const int* addresses, int count, SGSLrmSyncResult* results)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmBus* bus = NULL;
+    SGSLrmStatus status = ValidateSweep(handle, addresses, count, results, &bus);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-    // Validate correction range (-255 to +255 mm)
-    if (correctionMm < -255 || correctionMm > 255) {
-        return SGS_LRM_INVALID_PARAMETER;
-    }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
+    // One cycle owns the line from trigger to last read
+    AcquireLine(bus, NULL);
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
+    if (bus->streamingCount > 0) {
+        LeaveCriticalSection(&bus->wireLock);
+        return SGS_LRM_INVALID_PARAMETER; // The reactor owns RX while streaming
     }
 
-    // Distance correction command: FA 04 06 SIGN VALUE CS
-    unsigned char command[5];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_CONFIG;
-    command[2] = SUBCMD_SET_CORRECTION;
-    
-    if (correctionMm < 0) {
-        command[3] = 0x2D; // Negative sign (-)
-        command[4] = (unsigned char)(-correctionMm); // Absolute value
-    } else {
-        command[3] = 0x2B; // Positive sign (+)  
-        command[4] = (unsigned char)correctionMm;
+    // Broadcast measurement command: FA 06 06 FA (no response, result stored in module cache)
+    unsigned char trigger[4] = { ADDR_BROADCAST, CMD_MEASURE, SUBCMD_BROADCAST_MEASURE, 0xFA };
+    status = WriteCommand(bus, trigger, sizeof(trigger));
+    if (status != SGS_LRM_SUCCESS) {
+        LeaveCriticalSection(&bus->wireLock);
+        return status;
     }
-    
-    // This is actually a 6-byte command: FA 04 06 SIGN VALUE CS
-    unsigned char fullCommand[6];
-    fullCommand[0] = ADDR_BROADCAST;
-    fullCommand[1] = CMD_CONFIG; 
-    fullCommand[2] = SUBCMD_SET_CORRECTION;
-    fullCommand[3] = command[3]; // Sign
-    fullCommand[4] = command[4]; // Value
-    fullCommand[5] = CalculateChecksum(fullCommand, 5); // Checksum
 
-    status = SendCommand(device, fullCommand, 6);
+    // The window rides on line pacing: the first read goes out when it ends
+    unsigned long long windowEnd = SGSLrmClock_NowMs() + bus->syncWindowMs;
+    if (bus->txQuietUntilMs < windowEnd) bus->txQuietUntilMs = windowEnd;
 
-    LeaveCriticalSection(&device->lock);
-    return status;
+    SweepCaches(bus, addresses, count, results);
+
+    LeaveCriticalSection(&bus->wireLock);
+    return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetStartPosition(SGSLrmHandle handle, SGSLrmStartPosition position)
+SGS_LRM_API SGSLrmStatus SGSLrm_GetSweepStats(SGSLrmBusHandle handle, SGSLrmSweepStats* stats)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmBus* bus = NULL;
+    SGSLrmStatus status = ValidateBusHandle(handle, &bus);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
 
-	unsigned char commandValue;
-    switch (position)
-    {
-    case SGS_LRM_START_POSITION_TAIL:
-        commandValue = 0x00;
-        break;
-	case SGS_LRM_START_POSITION_TOP:
-        commandValue = 0x01;
-		break;
-    default:
+    if (!stats) {
         return SGS_LRM_INVALID_PARAMETER;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
+    // Never waits for a sweep in progress
+    EnterCriticalSection(&bus->lock);
+    *stats = bus->sweepStats;
+    LeaveCriticalSection(&bus->lock);
+    return SGS_LRM_SUCCESS;
+}
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
+// Cache file: one line per port, "key<TAB>address[=deviceId] address ...",
+// addresses in decimal. A port that was scanned and found empty keeps its
+// line, so an empty line is a hit too.
+static bool LoadDiscoveryCache(const char* path, const char* key, SGSLrmDiscoveredModule* found, int* foundCount)
+{
+    FILE* file = NULL;
+    if (fopen_s(&file, path, "r") != 0) {
+        return false;
     }
 
-    // Set start position command: FA 04 08 POSITION CS
-    unsigned char command[5];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_CONFIG;
-    command[2] = SUBCMD_SET_POSITION;
-    command[3] = commandValue; // 0=tail, 1=top
-    command[4] = CalculateChecksum(command, 4);
+    char* line = (char*)malloc(DISCOVERY_CACHE_LINE);
+    size_t keyLength = strlen(key);
+    bool hit = false;
+    while (line && !hit && fgets(line, DISCOVERY_CACHE_LINE, file)) {
+        if (strncmp(line, key, keyLength) != 0 || line[keyLength] != '\t') {
+            continue;
+        }
 
-    status = SendCommand(device, command, 5);
+        hit = true;
+        *foundCount = 0;
+        const char* p = line + keyLength + 1;
+        for (;;) {
+            char* end = NULL;
+            long address = strtol(p, &end, 10);
+            if (end == p) break;
+            if (address < 0 || address > 0xFF || address == ADDR_BROADCAST || *foundCount == MAX_BUS_MODULES) {
+                hit = false; // Damaged line: scan again and rewrite it
+                break;
+            }
 
-    LeaveCriticalSection(&device->lock);
-    return status;
+            SGSLrmDiscoveredModule* module = &found[(*foundCount)++];
+            module->address = (int)address;
+            module->deviceId[0] = '\0';
+            p = end;
+            if (*p == '=') {
+                size_t length = strcspn(++p, " \t\r\n");
+                // An edited file may hold a longer ID than fits; keep its start
+                size_t copied = length < sizeof(module->deviceId) ? length : sizeof(module->deviceId) - 1;
+                strncpy_s(module->deviceId, sizeof(module->deviceId), p, copied);
+                p += length;
+            }
+        }
+    }
+
+    free(line);
+    fclose(file);
+    return hit;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_SetAutoMeasurement(SGSLrmHandle handle, bool enable)
+// Rewrites the cache with key's line replaced; other ports' lines are kept
+static void SaveDiscoveryCache(const char* path, const char* key, const SGSLrmDiscoveredModule* found, int foundCount)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
-    if (status != SGS_LRM_SUCCESS) {
-        return status;
+    char* old = NULL;
+    size_t oldLength = 0;
+    FILE* file = NULL;
+    if (fopen_s(&file, path, "rb") == 0) {
+        size_t capacity = 0;
+        for (;;) {
+            if (oldLength == capacity) {
+                capacity = capacity ? capacity * 2 : DISCOVERY_CACHE_LINE;
+                char* grown = (char*)realloc(old, capacity + 1);
+                if (!grown) break;
+                old = grown;
+            }
+            size_t n = fread(old + oldLength, 1, capacity - oldLength, file);
+            if (n == 0) break;
+            oldLength += n;
+        }
+        fclose(file);
+        if (old) old[oldLength] = '\0';
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
-
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
+    if (fopen_s(&file, path, "wb") != 0) {
+        free(old);
+        return; // The scan result is still returned, just not remembered
     }
 
-    // Set auto measurement command: FA 04 0D ENABLE CS
-    unsigned char command[5];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_CONFIG;
-    command[2] = SUBCMD_SET_AUTO_MEASURE;
-    command[3] = (unsigned char)enable; // 0=disable, 1=enable
-    command[4] = CalculateChecksum(command, 4);
+    size_t keyLength = strlen(key);
+    for (const char* line = old; line && *line; ) {
+        const char* end = strchr(line, '\n');
+        size_t length = end ? (size_t)(end - line) + 1 : strlen(line);
+        if (!(strncmp(line, key, keyLength) == 0 && line[keyLength] == '\t')) {
+            fwrite(line, 1, length, file);
+            if (!end) fputc('\n', file);
+        }
+        line += length;
+    }
 
-    status = SendCommand(device, command, 5);
+    fprintf(file, "%s\t", key);
+    for (int i = 0; i < foundCount; ++i) {
+        fprintf(file, i > 0 ? " %d" : "%d", found[i].address);
+        if (found[i].deviceId[0]) fprintf(file, "=%s", found[i].deviceId);
+    }
+    fputc('\n', file);
 
-    LeaveCriticalSection(&device->lock);
-    return status;
+    fclose(file);
+    free(old);
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_BroadcastMeasurement(SGSLrmHandle handle)
+// Tries each candidate with a cache read; the next command goes out the
+// moment an answer arrives or probeTimeoutMs passes. Caller took the line (AcquireLine).
+static SGSLrmStatus ScanAddresses(SGSLrmBus* bus, const int* candidates, int candidateCount, unsigned int probeTimeoutMs,
+    SGSLrmDiscoveredModule* found, int* foundCount)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
-    if (status != SGS_LRM_SUCCESS) {
-        return status;
-    }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
+    *foundCount = 0;
+    SGSLrmFrame frame;
+    for (int i = 0; i < candidateCount; ++i) {
+        unsigned char command[4] = { (unsigned char)candidates[i], CMD_MEASURE, SUBCMD_READ_CACHE, 0 };
+        command[3] = CalculateChecksum(command, 3);
+
+        SGSLrmStatus status = WriteCommand(bus, command, sizeof(command));
+        if (status == SGS_LRM_SUCCESS) {
+            status = ReceiveFrameBefore(bus, candidates[i], CMD_MEASURE, RESP_READ_CACHE, SGSLrmClock_NowMs() + probeTimeoutMs, &frame);
+        }
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
+        // A reading or an ERR-XX frame both mean a module holds the address
+        if (status == SGS_LRM_SUCCESS) {
+            found[*foundCount].address = candidates[i];
+            found[*foundCount].deviceId[0] = '\0';
+            (*foundCount)++;
+        } else if (status != SGS_LRM_TIMEOUT) {
+            return status;
+        }
     }
 
-    // Broadcast measurement command: FA 06 06 FA (no response, result stored in module cache)
-    unsigned char command[4];
-    command[0] = ADDR_BROADCAST;
-    command[1] = CMD_MEASURE;
-    command[2] = SUBCMD_BROADCAST_MEASURE;
-    command[3] = 0xFA; // Fixed checksum as per protocol
-
-    status = SendCommand(device, command, 4);
+    // Read machine ID is broadcast (FA 06 04 FC): with two modules on the
+    // line both would answer at once, so only a lone module gets its ID read
+    if (*foundCount == 1) {
+        static const unsigned char command[4] = { ADDR_BROADCAST, CMD_MEASURE, SUBCMD_READ_ID, 0xFC };
+        unsigned long long deadline = SGSLrmClock_NowMs() + g_defaultCommandTimeoutMs[SGS_LRM_COMMAND_READ_DEVICE_ID];
+        if (WriteCommand(bus, command, sizeof(command)) == SGS_LRM_SUCCESS &&
+            ReceiveFrameBefore(bus, ADDR_BROADCAST, CMD_MEASURE, RESP_DEVICE_ID, deadline, &frame) == SGS_LRM_SUCCESS) {
+            // FA 06 84 "DAT1...DAT16" CS
+            strncpy_s(found[0].deviceId, sizeof(found[0].deviceId), (const char*)&frame.data[3], (size_t)(frame.length - 4));
+        }
+    }
 
-    LeaveCriticalSection(&device->lock);
-    return status;
+    return SGS_LRM_SUCCESS;
 }
 
-SGS_LRM_API SGSLrmStatus SGSLrm_ReadCache(SGSLrmHandle handle, double* distance)
+SGS_LRM_API SGSLrmStatus SGSLrm_DiscoverAddresses(const char* comPort, const SGSLrmDiscoveryOptions* options,
+    SGSLrmDiscoveredModule* modules, int maxCount, int* count, bool* fromCache)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
-    if (status != SGS_LRM_SUCCESS) {
-        return status;
+    SGSLrmDiscoveryOptions defaults = { 0 };
+    if (!options) {
+        options = &defaults;
     }
 
-    if (!distance) {
+    if (!comPort || !modules || maxCount <= 0 || !count ||
+        options->probeTimeoutMs < 0 || options->probeTimeoutMs > DISCOVERY_PROBE_MAX_MS) {
         return SGS_LRM_INVALID_PARAMETER;
     }
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-    
-    EnterCriticalSection(&device->lock);
+    int everyAddress[MAX_BUS_MODULES];
+    const int* candidates = options->candidates;
+    int candidateCount = options->candidateCount;
+    if (candidates) {
+        if (candidateCount <= 0 || candidateCount > MAX_BUS_MODULES) {
+            return SGS_LRM_INVALID_PARAMETER;
+        }
+        for (int i = 0; i < candidateCount; ++i) {
+            if (candidates[i] < 0 || candidates[i] > 0xFF || candidates[i] == ADDR_BROADCAST) {
+                return SGS_LRM_INVALID_PARAMETER;
+            }
+        }
+    } else {
+        candidateCount = 0;
+        for (int address = 0; address <= 0xFF; ++address) {
+            if (address != ADDR_BROADCAST) everyAddress[candidateCount++] = address;
+        }
+        candidates = everyAddress;
+    }
 
-    if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_NOT_CONNECTED;
+    unsigned int probeTimeoutMs = options->probeTimeoutMs > 0 ? (unsigned int)options->probeTimeoutMs : DISCOVERY_PROBE_DEFAULT_MS;
+
+    *count = 0;
+    if (fromCache) {
+        *fromCache = false;
     }
 
-    // Read cache command: ADDR 06 07 CS
-    unsigned char command[4];
-    command[0] = (unsigned char)device->deviceAddress; // Device address
-    command[1] = CMD_MEASURE;
-    command[2] = SUBCMD_READ_CACHE;
-    command[3] = CalculateChecksum(command, 3);
+    SGSLrmDiscoveredModule* found = (SGSLrmDiscoveredModule*)malloc(MAX_BUS_MODULES * sizeof(SGSLrmDiscoveredModule));
+    if (!found) {
+        return SGS_LRM_OUT_OF_MEMORY;
+    }
+    int foundCount = 0;
+
+    // The by-id name carries the adapter's serial number, so the cached set
+    // follows the adapter to whatever ttyUSBn it enumerates as next time
+    char key[128] = "";
+    SGSLrmStableNameQuery query = { comPort, key, sizeof(key) };
+    SGSLrmTransport_EnumPorts(FindStableName, &query);
+    if (!key[0]) {
+        strncpy_s(key, sizeof(key), comPort, _TRUNCATE);
+    }
 
-    status = SendCommand(device, command, 4);
-    if (status != SGS_LRM_SUCCESS) {
-        LeaveCriticalSection(&device->lock);
-        return status;
+    SGSLrmStatus status = SGS_LRM_SUCCESS;
+    bool cached = options->cacheFile && !options->refresh && LoadDiscoveryCache(options->cacheFile, key, found, &foundCount);
+    if (!cached) {
+        // A private bus: nobody else can attach to it while it scans
+        SGSLrmBus* bus = NULL;
+        status = OpenBus(comPort, false, SGS_LRM_RESOLUTION_1MM, &bus);
+        if (status == SGS_LRM_SUCCESS) {
+            AcquireLine(bus, NULL);
+            status = ScanAddresses(bus, candidates, candidateCount, probeTimeoutMs, found, &foundCount);
+            LeaveCriticalSection(&bus->wireLock);
+            ReleaseBus(bus);
+        }
+        if (status == SGS_LRM_SUCCESS && options->cacheFile) {
+            SaveDiscoveryCache(options->cacheFile, key, found, foundCount);
+        }
     }
 
-    // Receive response
-    unsigned char response[64];
-    int receivedLength;
-    status = ReceiveResponse(device, response, sizeof(response), &receivedLength);
-    if (status != SGS_LRM_SUCCESS) {
-        LeaveCriticalSection(&device->lock);
-        return status;
+    if (status == SGS_LRM_SUCCESS) {
+        *count = foundCount < maxCount ? foundCount : maxCount;
+        memcpy(modules, found, (size_t)*count * sizeof(SGSLrmDiscoveredModule));
+        if (fromCache) {
+            *fromCache = cached;
+        }
     }
 
-    // Verify checksum
-    if (receivedLength < 4) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
+    free(found);
+    return status;
+}
+
+SGS_LRM_API SGSLrmStatus SGSLrm_DecodeMeasurement(const unsigned char* frame, int length, int* distanceTenthMm, double* distance, int* errorCode)
+{
+    if (!frame || length < 4) {
+        return SGS_LRM_INVALID_PARAMETER;
     }
-    
-    unsigned char expectedChecksum = CalculateChecksum(response, receivedLength - 1);
-    if (response[receivedLength - 1] != expectedChecksum) {
-        LeaveCriticalSection(&device->lock);
+    // Replayed bytes have not been through the frame parser
+    if (frame[length - 1] != CalculateChecksum(frame, length - 1)) {
         return SGS_LRM_COMMUNICATION_ERROR;
     }
 
-    // Parse measurement result (same format as single measurement)
-    status = ParseMeasurementResponse(device, response, receivedLength, distance);
+    int units = 0;
+    int code = 0;
+    SGSLrmResolution resolution;
+    SGSLrmStatus status = SGSLrmDecode_Measurement(frame, length, &units, &resolution, &code);
     if (status == SGS_LRM_SUCCESS) {
-        device->lastDistance = *distance;
+        if (distanceTenthMm) *distanceTenthMm = units;
+        if (distance) *distance = (double)units / SGS_LRM_UNITS_PER_METRE;
+    }
+    if (errorCode && status != SGS_LRM_COMMUNICATION_ERROR) {
+        *errorCode = code;
     }
-
-    LeaveCriticalSection(&device->lock);
     return status;
 }
 
 SGS_LRM_API SGSLrmStatus SGSLrm_ReadDeviceID(SGSLrmHandle handle, char* deviceId, int bufferSize)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
@@ -1638,16 +3974,20 @@ SGS_LRM_API SGSLrmStatus SGSLrm_ReadDeviceID(SGSLrmHandle handle, char* deviceId
     if (!deviceId || bufferSize <= 0) {
         return SGS_LRM_INVALID_PARAMETER;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
         return SGS_LRM_NOT_CONNECTED;
     }
 
+    // The reactor owns RX while streaming; a response could not be waited for
+    if (device->continuousMeasurement) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
     // Read machine ID command: FA 06 04 FC
     // Protocol specifies fixed checksum 0xFC for this command
     unsigned char command[4];
@@ -1656,56 +3996,43 @@ SGS_LRM_API SGSLrmStatus SGSLrm_ReadDeviceID(SGSLrmHandle handle, char* deviceId
     command[2] = SUBCMD_READ_ID;
     command[3] = 0xFC; // Fixed checksum as per protocol
 
+    status = BeginTransaction(device);
+    if (status != SGS_LRM_SUCCESS) {
+        LeaveCriticalSection(&device->ioLock);
+        return status; // Another handle on the bus is streaming
+    }
+
     status = SendCommand(device, command, 4);
     if (status != SGS_LRM_SUCCESS) {
-        LeaveCriticalSection(&device->lock);
+        EndTransaction(device);
+        LeaveCriticalSection(&device->ioLock);
         return status;
     }
 
     // Receive response
     // Expected format: FA 06 84 "DAT1 DAT2...DAT16" CS
     // DATn are in ASCII format
-    unsigned char response[64];
-    int receivedLength;
-    status = ReceiveResponse(device, response, sizeof(response), &receivedLength);
+    SGSLrmFrame frame;
+    status = ReceiveFrame(device, ADDR_BROADCAST, CMD_MEASURE, RESP_DEVICE_ID, SGS_LRM_COMMAND_READ_DEVICE_ID, &frame);
+    EndTransaction(device);
     if (status != SGS_LRM_SUCCESS) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
         return status;
     }
 
-    // Verify minimum response length
-    if (receivedLength < 5) { // At least FA 06 84 [1 byte data] CS
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
-    }
-
-    // Verify checksum
-    unsigned char expectedChecksum = CalculateChecksum(response, receivedLength - 1);
-    if (response[receivedLength - 1] != expectedChecksum) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
+    // Extract device ID data (excluding FA, 06, 84, and CS)
+    int dataLength = frame.length - 4; // Subtract header (3 bytes) and checksum (1 byte)
+    if (dataLength >= bufferSize) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_PARAMETER; // Buffer too small
     }
 
-    // Parse device ID response
-    // Response format: FA 06 84 [ASCII DATA...] CS
-    if (response[0] == ADDR_BROADCAST && response[1] == CMD_MEASURE && response[2] == RESP_DEVICE_ID) {
-        // Extract device ID data (excluding FA, 06, 84, and CS)
-        int dataLength = receivedLength - 4; // Subtract header (3 bytes) and checksum (1 byte)
-        if (dataLength > 0 && dataLength < bufferSize) {
-            // Copy ASCII device ID data starting from response[3]
-            memcpy(deviceId, &response[3], dataLength);
-            deviceId[dataLength] = '\0'; // Null-terminate the string
-            
-            LeaveCriticalSection(&device->lock);
-            return SGS_LRM_SUCCESS;
-        } else if (dataLength >= bufferSize) {
-            LeaveCriticalSection(&device->lock);
-            return SGS_LRM_INVALID_PARAMETER; // Buffer too small
-        }
-    }
+    // Copy ASCII device ID data starting from frame.data[3]
+    memcpy(deviceId, &frame.data[3], dataLength);
+    deviceId[dataLength] = '\0'; // Null-terminate the string
 
-    LeaveCriticalSection(&device->lock);
-    return SGS_LRM_COMMUNICATION_ERROR;
+    LeaveCriticalSection(&device->ioLock);
+    return SGS_LRM_SUCCESS;
 }
 
 // Helper function for debugging and maintenance
@@ -1732,20 +4059,25 @@ static const char* GetCommandDescription(unsigned char cmd1, unsigned char cmd2)
 
 SGS_LRM_API SGSLrmStatus SGSLrm_Shutdown(SGSLrmHandle handle)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
+    EnterCriticalSection(&device->ioLock);
 
     if (!device->isConnected) {
-        LeaveCriticalSection(&device->lock);
+        LeaveCriticalSection(&device->ioLock);
         return SGS_LRM_NOT_CONNECTED;
     }
 
+    // The reactor owns RX while streaming; a response could not be waited for
+    if (device->continuousMeasurement) {
+        LeaveCriticalSection(&device->ioLock);
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
     // Shutdown command: ADDR 04 02 CS
     unsigned char command[4];
     command[0] = (unsigned char)device->deviceAddress; // Device address
@@ -1753,49 +4085,32 @@ SGS_LRM_API SGSLrmStatus SGSLrm_Shutdown(SGSLrmHandle handle)
     command[2] = SUBCMD_SHUTDOWN;
     command[3] = CalculateChecksum(command, 3);
 
-    status = SendCommand(device, command, 4);
+    status = BeginTransaction(device);
     if (status != SGS_LRM_SUCCESS) {
-        LeaveCriticalSection(&device->lock);
-        return status;
+        LeaveCriticalSection(&device->ioLock);
+        return status; // Another handle on the bus is streaming
     }
 
-    // Receive response (expected: ADDR 04 82 CS as per protocol)
-    unsigned char response[64];
-    int receivedLength;
-    status = ReceiveResponse(device, response, sizeof(response), &receivedLength);
+    status = SendCommand(device, command, 4);
     if (status != SGS_LRM_SUCCESS) {
-        LeaveCriticalSection(&device->lock);
+        EndTransaction(device);
+        LeaveCriticalSection(&device->ioLock);
         return status;
     }
 
-    // Verify response
-    if (receivedLength < 4) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
-    }
-
-    // Verify checksum
-    unsigned char expectedChecksum = CalculateChecksum(response, receivedLength - 1);
-    if (response[receivedLength - 1] != expectedChecksum) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_COMMUNICATION_ERROR;
-    }
-
-    // Check if response matches expected format: ADDR 04 82 CS
-    if (response[0] == (unsigned char)device->deviceAddress && 
-        response[1] == 0x04 && 
-        response[2] == 0x82) {
-        LeaveCriticalSection(&device->lock);
-        return SGS_LRM_SUCCESS;
-    }
+    // Receive response (expected: ADDR 04 82 CS as per protocol)
+    SGSLrmFrame frame;
+    status = ReceiveFrame(device, device->deviceAddress, CMD_CONFIG, 0x82, SGS_LRM_COMMAND_SHUTDOWN, &frame);
+    EndTransaction(device);
 
-    LeaveCriticalSection(&device->lock);
-    return SGS_LRM_COMMUNICATION_ERROR;
+    LeaveCriticalSection(&device->ioLock);
+    return status;
 }
 
 SGS_LRM_API SGSLrmStatus SGSLrm_GetMeasurementError(SGSLrmHandle handle, int* errorCode)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) {
         return status;
     }
@@ -1803,12 +4118,10 @@ SGS_LRM_API SGSLrmStatus SGSLrm_GetMeasurementError(SGSLrmHandle handle, int* er
     if (!errorCode) {
         return SGS_LRM_INVALID_PARAMETER;
     }
-
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
     
-    EnterCriticalSection(&device->lock);
-    *errorCode = device->lastErrorCode;
-    LeaveCriticalSection(&device->lock);
+    SGSLrmSnapshot snapshot;
+    ReadSnapshot(device, &snapshot);
+    *errorCode = snapshot.errorCode;
 
     return SGS_LRM_SUCCESS;
 }
@@ -1816,21 +4129,20 @@ SGS_LRM_API SGSLrmStatus SGSLrm_GetMeasurementError(SGSLrmHandle handle, int* er
 SGS_LRM_API SGSLrmStatus SGSLrm_GetLastHardwareErrorAscii(SGSLrmHandle handle,
     char* buf, int bufSize)
 {
-    SGSLrmStatus status = ValidateHandle(handle);
+    SGSLrmDevice* device = NULL;
+    SGSLrmStatus status = ValidateHandle(handle, &device);
     if (status != SGS_LRM_SUCCESS) return status;
     if (!buf || bufSize <= 0) return SGS_LRM_INVALID_PARAMETER;
 
-    SGSLrmDevice* device = (SGSLrmDevice*)handle;
-
-    EnterCriticalSection(&device->lock);
+    SGSLrmSnapshot snapshot;
+    ReadSnapshot(device, &snapshot);
     // 若沒有錯誤，回空字串，維持簡單語義
-    if (device->lastErrorAscii[0] == '\0') {
+    if (snapshot.errorAscii[0] == '\0') {
         if (bufSize > 0) buf[0] = '\0';
     }
     else {
-        strncpy_s(buf, bufSize, device->lastErrorAscii, _TRUNCATE);
+        strncpy_s(buf, bufSize, snapshot.errorAscii, _TRUNCATE);
     }
-    LeaveCriticalSection(&device->lock);
 
     return SGS_LRM_SUCCESS;
 }
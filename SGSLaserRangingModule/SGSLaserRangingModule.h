@@ -3,7 +3,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 
-#if defined(_SGS_LRM_EXPORT)
+#if !defined(_WIN32)
+#define SGS_LRM_API __attribute__((visibility("default")))
+#elif defined(_SGS_LRM_EXPORT)
 #define SGS_LRM_API __declspec(dllexport)
 #else
 #define SGS_LRM_API __declspec(dllimport)
@@ -14,7 +16,12 @@ extern "C" {
 #endif
 	
 	typedef int SGSLrmStatus;
+
+	// Opaque tokens (slot index + generation), not addresses. Once destroyed or
+	// closed, a handle is rejected with SGS_LRM_INVALID_HANDLE even after its
+	// slot has been reused. Never NULL when valid.
 	typedef void* SGSLrmHandle;
+	typedef void* SGSLrmBusHandle;
 
 	// Status codes
 #define SGS_LRM_SUCCESS                 0       // Operation successful
@@ -25,6 +32,8 @@ extern "C" {
 #define SGS_LRM_TIMEOUT                 -5       // Operation timeout
 #define SGS_LRM_OUT_OF_MEMORY           -6       // Out of memory
 #define SGS_LRM_MEASUREMENT_ERROR       -7       // Measurement error
+#define SGS_LRM_CONFIG_REJECTED         -8       // Module answered a config write with its failure code (FA 84 8X 01)
+#define SGS_LRM_NO_TRACK                -9       // Tracker off, not started, or coasted past its limit
 
 	typedef int SGSLrmRange;
 #define SGS_LRM_RANGE_5M      0
@@ -36,6 +45,7 @@ extern "C" {
 	typedef int SGSLrmResolution;
 #define SGS_LRM_RESOLUTION_1MM		0
 #define SGS_LRM_RESOLUTION_100UM	1
+#define SGS_LRM_UNITS_PER_METRE		10000	// Integer distances count 0.1 mm units
 
 	typedef int SGSLrmFrequency;
 #define SGS_LRM_FREQUENCY_5HZ      0
@@ -56,7 +66,68 @@ extern "C" {
 	SGS_LRM_API SGSLrmStatus SGSLrm_Disconnect(SGSLrmHandle handle);
 	SGS_LRM_API SGSLrmStatus SGSLrm_IsConnected(SGSLrmHandle handle, bool* connected);
 
-	// Device configuration
+	// Multi-drop (RS-485) bus: several modules, each at its own address, on one
+	// serial port. The bus owns the port and its single reader; handles attached
+	// with SGSLrm_ConnectBus take turns on the line, one transaction at a time,
+	// and streamed frames are routed to the handle whose address they carry.
+	// SGSLrm_Connect is the one-module case and gives its handle a private bus.
+	// Config writes are broadcast (ADDR 0xFA), so the setters, SGSLrm_ApplyConfig and
+	// SGSLrm_SetAddress are refused on a bus opened here.
+	SGS_LRM_API SGSLrmStatus SGSLrm_OpenBus(const char* comPort, SGSLrmBusHandle* bus);
+	SGS_LRM_API SGSLrmStatus SGSLrm_CloseBus(SGSLrmBusHandle bus); // Port closes once the last attached handle disconnects
+	SGS_LRM_API SGSLrmStatus SGSLrm_ConnectBus(SGSLrmHandle handle, SGSLrmBusHandle bus, int address); // Any address but the broadcast 0xFA, unique on the bus
+
+	// Synchronized acquisition: one broadcast trigger (FA 06 06 FA) makes every module on the
+	// bus measure at once; after the sync window the cached results are read back to back
+	// (ADDR 06 07), giving one time-coherent reading per address. Handles attached at those
+	// addresses get the readings too (snapshot, sample queue). Refused while the bus streams.
+	typedef struct {
+		double distance;                // Metres, valid when status is SGS_LRM_SUCCESS
+		SGSLrmStatus status;            // This address's outcome (TIMEOUT, MEASUREMENT_ERROR, ...)
+	} SGSLrmSyncResult;
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetSyncWindow(SGSLrmBusHandle bus, int windowMs); // Trigger to first read, 0..60000, default 200
+	SGS_LRM_API SGSLrmStatus SGSLrm_SyncAcquire(SGSLrmBusHandle bus, const int* addresses, int count, SGSLrmSyncResult* results);
+
+	// Cache sweep without a trigger: ADDR 06 07 read from each address back to back, each
+	// command sent the moment the previous answer's checksum byte arrives. SyncAcquire sweeps
+	// the same way and feeds the same statistics.
+	SGS_LRM_API SGSLrmStatus SGSLrm_SweepCache(SGSLrmBusHandle bus, const int* addresses, int count, SGSLrmSyncResult* results);
+	typedef struct {
+		unsigned long sweeps;           // Sweeps completed on this bus
+		int lastCount;                  // Addresses in the last sweep
+		double lastSweepMs;             // First command to last answer of the last sweep (window excluded)
+		double bestSweepMs;
+		double wireMs;                  // Time the last sweep's bytes need on a 9600 baud line
+		double utilisation;             // wireMs / lastSweepMs; 1.0 when the line never idled
+		double achievableHz;            // Sweep rate 9600 baud allows for lastCount addresses
+	} SGSLrmSweepStats;
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetSweepStats(SGSLrmBusHandle bus, SGSLrmSweepStats* stats);
+
+	// Address discovery: ADDR 06 07 sent to each candidate address back to back, the next
+	// command going out as soon as an answer arrives or the short per-address deadline
+	// passes. Every address that answers (with a reading or an error frame) is on the line.
+	// With cacheFile set the responders are stored under the port's /dev/serial/by-id name
+	// (its port name where there is none) and later calls return them without a scan.
+	// The port must not be open elsewhere in the process while it is scanned.
+	typedef struct {
+		const int* candidates;          // Addresses to try; NULL tries every address but broadcast 0xFA
+		int candidateCount;
+		int probeTimeoutMs;             // Answer deadline per address, 0 for the default (30), at most 1000
+		const char* cacheFile;          // Text file shared by all ports; NULL always scans
+		bool refresh;                   // Scan even when the cache knows the port, then update it
+	} SGSLrmDiscoveryOptions;
+	typedef struct {
+		int address;
+		char deviceId[32];              // Read-ID is broadcast-only: filled when this is the only module found, else ""
+	} SGSLrmDiscoveredModule;
+	SGS_LRM_API SGSLrmStatus SGSLrm_DiscoverAddresses(const char* comPort, const SGSLrmDiscoveryOptions* options,
+		SGSLrmDiscoveredModule* modules, int maxCount, int* count, bool* fromCache); // options and fromCache may be NULL; at most maxCount modules, in candidate order
+
+	// Device configuration. Each setter waits for the module's FA 04 8X acknowledgement and
+	// returns SGS_LRM_CONFIG_REJECTED for its failure code or SGS_LRM_TIMEOUT when none
+	// arrives. While the line streams the reactor owns RX, so register setters (all but
+	// SetAddress, which is refused) queue the ack instead and return once the write is sent;
+	// SGSLrm_GetConfigStatus reports how queued writes settled.
 	SGS_LRM_API SGSLrmStatus SGSLrm_SetAddress(SGSLrmHandle handle, int address);
 	SGS_LRM_API SGSLrmStatus SGSLrm_SetRange(SGSLrmHandle handle, SGSLrmRange range);
 	SGS_LRM_API SGSLrmStatus SGSLrm_SetResolution(SGSLrmHandle handle, SGSLrmResolution resolution);
@@ -66,6 +137,68 @@ extern "C" {
 	SGS_LRM_API SGSLrmStatus SGSLrm_SetStartPosition(SGSLrmHandle handle, SGSLrmStartPosition position); // 0=tail, 1=top
 	SGS_LRM_API SGSLrmStatus SGSLrm_SetAutoMeasurement(SGSLrmHandle handle, bool enable); // Auto measurement on power up
 
+	// Whole-profile configuration. The bus keeps a shadow of every register the module has
+	// acknowledged; SGSLrm_ApplyConfig writes only the selected registers whose value differs
+	// from it, back to back, then collects the FA 04 8X acks in one pass. A register updates
+	// the shadow once acknowledged; one that was rejected or never acknowledged is dropped from
+	// it and written again next time. Config writes are broadcast and every module on the
+	// line would ack at once, so on a multi-drop bus (SGSLrm_OpenBus) they are refused with
+	// SGS_LRM_INVALID_PARAMETER, as SGSLrm_SetAddress is; configure each module on its own
+	// line first. The single setters above are one-register applies that always write.
+	// While the line streams the writes are queued as the setters' are.
+#define SGS_LRM_CONFIG_RANGE                0x01
+#define SGS_LRM_CONFIG_RESOLUTION           0x02
+#define SGS_LRM_CONFIG_FREQUENCY            0x04
+#define SGS_LRM_CONFIG_INTERVAL             0x08
+#define SGS_LRM_CONFIG_CORRECTION           0x10
+#define SGS_LRM_CONFIG_START_POSITION       0x20
+#define SGS_LRM_CONFIG_AUTO_MEASUREMENT     0x40
+#define SGS_LRM_CONFIG_ALL                  0x7F
+	typedef struct {
+		unsigned int fields;            // SGS_LRM_CONFIG_* registers to apply; the rest are left alone
+		SGSLrmRange range;
+		SGSLrmResolution resolution;
+		SGSLrmFrequency frequency;
+		int measurementIntervalMs;      // 0 or >= 1000, as SGSLrm_SetMeasurementInterval
+		int distanceCorrectionMm;       // -255..255
+		SGSLrmStartPosition startPosition;
+		bool autoMeasurement;
+	} SGSLrmConfig;
+	SGS_LRM_API SGSLrmStatus SGSLrm_ApplyConfig(SGSLrmHandle handle, const SGSLrmConfig* config); // First failure (CONFIG_REJECTED, TIMEOUT, ...) in register order
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetConfig(SGSLrmHandle handle, SGSLrmConfig* config); // Shadow; fields has the registers it knows
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetConfigStatus(SGSLrmHandle handle, unsigned int* pending, unsigned int* failed); // SGS_LRM_CONFIG_* masks: queued writes awaiting their ack; registers whose last write was rejected or unanswered
+
+	// Response deadlines per command; a transaction fails with SGS_LRM_TIMEOUT once its deadline passes
+	typedef int SGSLrmCommand;
+#define SGS_LRM_COMMAND_SINGLE_MEASUREMENT  0   // Default 1000 ms
+#define SGS_LRM_COMMAND_CONTINUOUS          1   // Silence tolerated while streaming before a TIMEOUT sample, default 1000 ms
+#define SGS_LRM_COMMAND_READ_CACHE          2   // Default 50 ms
+#define SGS_LRM_COMMAND_READ_DEVICE_ID      3   // Default 80 ms
+#define SGS_LRM_COMMAND_SHUTDOWN            4   // Default 50 ms
+#define SGS_LRM_COMMAND_COUNT               5
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetCommandTimeout(SGSLrmHandle handle, SGSLrmCommand command, int timeoutMs); // 1..60000, 0 = default
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetCommandTimeout(SGSLrmHandle handle, SGSLrmCommand command, int* timeoutMs);
+
+	// Adaptive deadlines: once enough responses have been timed, a command waits multiplier x p99
+	// of its observed latency, clamped to [floorMs, ceilingMs]. Learning restarts after SetRange.
+	typedef struct {
+		bool enabled;
+		double multiplier;              // >= 1.0, e.g. 3.0
+		int floorMs;                    // 1..60000
+		int ceilingMs;                  // floorMs..60000
+	} SGSLrmAdaptiveTimeout;
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetAdaptiveTimeout(SGSLrmHandle handle, SGSLrmCommand command, const SGSLrmAdaptiveTimeout* config); // Not for CONTINUOUS
+
+	typedef struct {
+		unsigned long samples;          // Responses timed
+		unsigned long timeouts;         // Deadlines that expired
+		double ewmaMs;                  // Smoothed response latency
+		int p99Ms;                      // Over the last 128 responses (timeouts count at their deadline)
+		int maxMs;
+		int currentTimeoutMs;           // Deadline the next transaction will use
+	} SGSLrmLatencyStats;
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetLatencyStats(SGSLrmHandle handle, SGSLrmCommand command, SGSLrmLatencyStats* stats);
+
 	// Measurement functions
 	SGS_LRM_API SGSLrmStatus SGSLrm_SingleMeasurement(SGSLrmHandle handle, double* distance);
 	SGS_LRM_API SGSLrmStatus SGSLrm_StartContinuousMeasurement(SGSLrmHandle handle);
@@ -74,17 +207,210 @@ extern "C" {
 	SGS_LRM_API SGSLrmStatus SGSLrm_BroadcastMeasurement(SGSLrmHandle handle);
 	SGS_LRM_API SGSLrmStatus SGSLrm_ReadCache(SGSLrmHandle handle, double* distance);
 
+	// Integer variants: the distance as a count of 0.1 mm units (SGS_LRM_UNITS_PER_METRE per
+	// metre), exactly as the module sent it, and the resolution it was sent at (1 mm readings
+	// are multiples of 10). resolution may be NULL. The double APIs return the same reading
+	// divided by SGS_LRM_UNITS_PER_METRE.
+	SGS_LRM_API SGSLrmStatus SGSLrm_SingleMeasurementTenthMm(SGSLrmHandle handle, int* distanceTenthMm, SGSLrmResolution* resolution);
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetLastMeasurementTenthMm(SGSLrmHandle handle, int* distanceTenthMm, SGSLrmResolution* resolution);
+	SGS_LRM_API SGSLrmStatus SGSLrm_ReadCacheTenthMm(SGSLrmHandle handle, int* distanceTenthMm, SGSLrmResolution* resolution);
+
+	// Measurement snapshot, published after every measurement and read without locking
+	typedef struct {
+		double distance;                // Last successful distance in metres (same as GetLastMeasurement)
+		SGSLrmStatus status;            // Outcome of the most recent measurement
+		int errorCode;                  // Last hardware error code (e.g. 16), 0 after a valid reading
+		char errorAscii[8];             // Last raw "ERR-XX", empty after a valid reading
+		unsigned long long sequence;    // Measurements published on this handle so far
+		unsigned long long timestampMs; // Monotonic publication time (GetTickCount64 / CLOCK_MONOTONIC)
+		int distanceTenthMm;            // distance in 0.1 mm units
+		SGSLrmResolution resolution;    // Resolution distanceTenthMm was reported at
+		unsigned long long firstByteNs; // SGSLrm_GetClockNs() when the frame's first byte was read; 0 without a frame
+		unsigned long long lastByteNs;  // ...and when its checksum byte was read
+		int rawDistanceTenthMm;         // Last successful reading as the module sent it, before SGSLrm_SetFilter
+	} SGSLrmSnapshot;
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetSnapshot(SGSLrmHandle handle, SGSLrmSnapshot* snapshot);
+
+	// Sample queue: every measurement is also queued per handle (256 deep) for bulk draining.
+	// ReadSamples copies up to maxCount of the oldest queued samples; call it from one thread per handle.
+	typedef struct {
+		unsigned long long sequence;    // Same numbering as SGSLrmSnapshot.sequence
+		unsigned long long timestampMs; // Monotonic publication time
+		double distance;                // Metres; last successful distance when status is not SUCCESS
+		SGSLrmStatus status;
+		int errorCode;                  // Hardware error code (e.g. 16), 0 for a valid reading
+	} SGSLrmSample;
+	SGS_LRM_API SGSLrmStatus SGSLrm_ReadSamples(SGSLrmHandle handle, SGSLrmSample* buffer, int maxCount, int* count);
+
+	// Half-size sample for bulk buffers: the same queue drained as integers. sequence and
+	// timestampMs are the low 32 bits of SGSLrmSample's; differences between them stay exact
+	// across the wrap. Use one ReadSamples variant per handle, from one thread.
+	typedef struct {
+		unsigned int sequence;
+		unsigned int timestampMs;
+		int distanceTenthMm;            // 0.1 mm units; last successful distance when status is not SUCCESS
+		signed char status;             // SGSLrmStatus
+		unsigned char errorCode;        // Hardware error code (e.g. 16), 0 for a valid reading
+		unsigned char resolution;       // SGSLrmResolution distanceTenthMm was reported at
+		unsigned char reserved;
+	} SGSLrmSampleTenthMm;
+	SGS_LRM_API SGSLrmStatus SGSLrm_ReadSamplesTenthMm(SGSLrmHandle handle, SGSLrmSampleTenthMm* buffer, int maxCount, int* count);
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetSampleOverflow(SGSLrmHandle handle, unsigned long* droppedCount); // Samples lost to a full queue
+
+	// Optional filter pipeline, run on every valid reading as it is parsed, so the last
+	// measurement, snapshot, sample queue and callbacks all see the filtered distance.
+	// Stages run in this order; a window of 0 turns a stage off:
+	//   Hampel: once its window is full, a reading further than hampelThreshold * 1.4826 * MAD
+	//           (and hampelFloorTenthMm) from the window median is replaced by that median
+	//   median: sliding-window median, O(log n) per reading
+	//   average: moving average, rounded to 0.1 mm
+	// Error frames and timeouts bypass the filters. Setting a filter empties its windows.
+#define SGS_LRM_FILTER_WINDOW_MAX   63
+	typedef struct {
+		int hampelWindow;               // 0 = off, else odd, 3..SGS_LRM_FILTER_WINDOW_MAX
+		double hampelThreshold;         // In scaled MADs, > 0, e.g. 3.0
+		int hampelFloorTenthMm;         // Deviations up to this are never rejected (a flat window has MAD 0)
+		int medianWindow;               // 0 = off, 1..SGS_LRM_FILTER_WINDOW_MAX
+		int averageWindow;              // 0 = off, 1..SGS_LRM_FILTER_WINDOW_MAX
+	} SGSLrmFilterConfig;
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetFilter(SGSLrmHandle handle, const SGSLrmFilterConfig* config); // NULL = no filtering
+
+	typedef struct {
+		unsigned long filtered;         // Readings run through the pipeline
+		unsigned long rejected;         // Replaced by the Hampel median
+	} SGSLrmFilterStats;
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetFilterStats(SGSLrmHandle handle, SGSLrmFilterStats* stats); // Restart with SetFilter
+
+	// Constant-velocity Kalman tracker for moving targets. Every valid reading (after SetFilter's
+	// pipeline; a median adds lag) updates distance and velocity at its checksum-byte RX stamp.
+	// ERR frames, TIMEOUT samples and unparseable answers are dropouts: the track coasts on its
+	// prediction and ends once maxCoastMs pass without a reading; the next reading starts a new one.
+	typedef struct {
+		double measurementNoiseM;       // Standard deviation of a reading, metres, > 0 (e.g. 0.002)
+		double accelerationNoise;       // Standard deviation of unmodelled acceleration, m/s^2, > 0 (e.g. 0.5)
+		int maxCoastMs;                 // 1..60000
+	} SGSLrmTrackerConfig;
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetTracker(SGSLrmHandle handle, const SGSLrmTrackerConfig* config); // NULL = off; restarts the track
+
+	typedef struct {
+		unsigned long long timeNs;      // SGSLrm_GetClockNs() instant the estimate is for
+		double distance;                // Metres
+		double velocity;                // m/s, positive moving away
+		double distanceStdDev;          // From the filter covariance
+		double velocityStdDev;
+		double innovation;              // Last reading minus its prediction, metres
+		unsigned long long sequence;    // Sample that last updated the track
+		unsigned long updates;          // Readings taken in since the track started
+		unsigned long dropouts;         // Since SetTracker
+	} SGSLrmTrackState;
+	// State at the last reading; SGS_LRM_NO_TRACK when there is none
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetTrack(SGSLrmHandle handle, SGSLrmTrackState* state);
+	// State predicted to atNs (SGSLrm_GetClockNs timebase, 0 = now) without touching the line,
+	// e.g. on a control loop's own tick between samples
+	SGS_LRM_API SGSLrmStatus SGSLrm_PredictTrack(SGSLrmHandle handle, unsigned long long atNs, SGSLrmTrackState* state);
+
 	// Laser control
 	SGS_LRM_API SGSLrmStatus SGSLrm_LaserOn(SGSLrmHandle handle);
 	SGS_LRM_API SGSLrmStatus SGSLrm_LaserOff(SGSLrmHandle handle);
 	SGS_LRM_API SGSLrmStatus SGSLrm_GetLaserStatus(SGSLrmHandle handle, bool* isOn);
 
 	// Callback function
+	// Continuous-mode callbacks for all handles run on one shared I/O thread (INLINE mode); keep them short.
 	typedef void (*SGSLrm_MeasurementCallback)(SGSLrmHandle handle, double distance, SGSLrmStatus status, void* userdata);
 	SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementCallback(SGSLrmHandle handle, SGSLrm_MeasurementCallback callback, void* userdata);
+	// Integer form of the callback; a handle has one callback, so setting either replaces the other
+	typedef void (*SGSLrm_MeasurementCallbackTenthMm)(SGSLrmHandle handle, int distanceTenthMm, SGSLrmResolution resolution, SGSLrmStatus status, void* userdata);
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementCallbackTenthMm(SGSLrmHandle handle, SGSLrm_MeasurementCallbackTenthMm callback, void* userdata);
+	// Extended form: the reading with its sample sequence and the RX timestamps of its frame, taken
+	// when the driver handed over the first byte and the checksum byte (before any lock or queue).
+	// Replaces the other callback kinds like they replace each other.
+	typedef struct {
+		unsigned long long sequence;    // Same numbering as SGSLrmSnapshot.sequence; gaps are samples lost upstream
+		unsigned long long firstByteNs; // SGSLrm_GetClockNs() timebase; 0 for a TIMEOUT sample (no frame)
+		unsigned long long lastByteNs;
+		double distance;                // Metres; 0 when status is not SUCCESS
+		int distanceTenthMm;            // distance in 0.1 mm units
+		SGSLrmResolution resolution;
+		SGSLrmStatus status;
+		int errorCode;                  // Hardware error code (e.g. 16), 0 for a valid reading
+		int rawDistanceTenthMm;         // distanceTenthMm before SGSLrm_SetFilter; 0 when status is not SUCCESS
+		bool tracked;                   // SGSLrm_SetTracker has a track; the three below are set
+		double trackDistance;           // Metres, at lastByteNs (for a TIMEOUT, predicted to delivery)
+		double trackVelocity;           // m/s, positive moving away
+		double innovation;              // Reading minus prediction, metres; 0 for a dropout
+	} SGSLrmMeasurementEx;
+	typedef void (*SGSLrm_MeasurementCallbackEx)(SGSLrmHandle handle, const SGSLrmMeasurementEx* measurement, void* userdata);
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetMeasurementCallbackEx(SGSLrmHandle handle, SGSLrm_MeasurementCallbackEx callback, void* userdata);
+	// The RX timestamp clock (QueryPerformanceCounter / CLOCK_MONOTONIC_RAW) in nanoseconds
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetClockNs(unsigned long long* nowNs);
+
+	// Callback dispatch: INLINE runs callbacks on the I/O thread; QUEUED hands samples to a small
+	// worker pool through a bounded per-handle queue so slow callbacks never delay reception.
+	typedef int SGSLrmCallbackMode;
+#define SGS_LRM_CALLBACK_INLINE     0       // Default
+#define SGS_LRM_CALLBACK_QUEUED     1
+#define SGS_LRM_CALLBACK_QUEUE_MAX  64      // Largest per-handle queue depth
+
+	typedef struct {
+		int maxQueueDepth;              // 1..SGS_LRM_CALLBACK_QUEUE_MAX, 0 = maximum; when full the oldest pending sample is dropped
+		bool coalesce;                  // Deliver only the newest pending sample; older ones are counted as coalesced
+		bool unordered;                 // Let several workers run this handle's callbacks at once (no ordering)
+	} SGSLrmCallbackPolicy;
+	SGS_LRM_API SGSLrmStatus SGSLrm_SetCallbackMode(SGSLrmHandle handle, SGSLrmCallbackMode mode, const SGSLrmCallbackPolicy* policy); // policy may be NULL
+
+	typedef struct {
+		int queueDepth;                 // Samples waiting now
+		int maxQueueDepthSeen;          // High-water mark
+		unsigned long delivered;        // Callbacks run by the workers
+		unsigned long dropped;          // Lost to a full queue or discarded by Stop/Disconnect
+		unsigned long coalesced;        // Superseded by a newer sample
+	} SGSLrmCallbackStats;
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetCallbackStats(SGSLrmHandle handle, SGSLrmCallbackStats* stats);
+
+	// Arrival timing of streamed frames from their RX timestamps; restarts with every
+	// StartContinuousMeasurement. The interval runs checksum byte to checksum byte of consecutive
+	// frames; a TIMEOUT sample breaks the chain rather than counting as one long interval.
+	typedef struct {
+		unsigned long frames;           // Frames stamped
+		unsigned long intervals;        // Intervals measured
+		double meanIntervalUs;
+		double jitterUs;                // Standard deviation of the interval
+		double minIntervalUs;
+		double maxIntervalUs;
+		double meanTransferUs;          // First byte to checksum byte of a frame
+		double maxTransferUs;
+	} SGSLrmTimingStats;
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetTimingStats(SGSLrmHandle handle, SGSLrmTimingStats* stats);
+
+	// Each transaction first drains, without waiting, whatever is already on the line: answers
+	// to reads that timed out, frames from a stream just stopped, stray acks. None of it can
+	// then be taken for the answer to the new command. Measurement frames among it are still
+	// published to the handle they are addressed to; the rest is discarded.
+	typedef struct {
+		unsigned long drains;           // Transactions that found stale input
+		unsigned long discardedBytes;   // Stale bytes thrown away, discarded frames included
+		unsigned long discardedFrames;  // Complete frames thrown away (answers nobody waits for)
+		unsigned long salvagedFrames;   // Measurement frames published from stale input
+	} SGSLrmRxStats;
+	SGS_LRM_API SGSLrmStatus SGSLrm_GetRxStats(SGSLrmHandle handle, SGSLrmRxStats* stats); // Counted against the handle whose transaction drained
 
 	// Utility functions
-	SGS_LRM_API SGSLrmStatus SGSLrm_EnumComPorts(char* portList, int bufferSize);
+	SGS_LRM_API SGSLrmStatus SGSLrm_EnumComPorts(char* portList, int bufferSize); // ';'-separated, from the OS device list; no port is opened
+
+	// Parallel port probe: every port is opened at once and sent the read-ID command
+	// (FA 06 04 FC); the call returns when all have answered or deadlineMs has passed,
+	// whichever comes first, so a full scan costs one deadline rather than one per port.
+	typedef struct {
+		char port[128];
+		char stableName[128];           // /dev/serial/by-id name, "" when the OS gives none
+		SGSLrmStatus status;            // SUCCESS: a module answered; TIMEOUT: silent; COMMUNICATION_ERROR: could not open/write
+		char deviceId[32];              // Module's ID string when status is SGS_LRM_SUCCESS
+	} SGSLrmPortProbe;
+	SGS_LRM_API SGSLrmStatus SGSLrm_ProbeComPorts(const char* portList, int deadlineMs, SGSLrmPortProbe* results, int maxCount, int* count); // portList ';'-separated or NULL for every port; deadlineMs 1..60000
+	// Decodes one raw measurement frame (ADDR 06 8X payload CS), e.g. from a capture being
+	// replayed. The checksum is verified; outputs may be NULL. ERR-XX frames return
+	// SGS_LRM_MEASUREMENT_ERROR with *errorCode; malformed frames SGS_LRM_COMMUNICATION_ERROR.
+	SGS_LRM_API SGSLrmStatus SGSLrm_DecodeMeasurement(const unsigned char* frame, int length, int* distanceTenthMm, double* distance, int* errorCode);
 	SGS_LRM_API SGSLrmStatus SGSLrm_ReadDeviceID(SGSLrmHandle handle, char* deviceId, int bufferSize);
 	SGS_LRM_API SGSLrmStatus SGSLrm_Shutdown(SGSLrmHandle handle);
 	SGS_LRM_API SGSLrmStatus SGSLrm_GetMeasurementError(SGSLrmHandle handle, int* errorCode);
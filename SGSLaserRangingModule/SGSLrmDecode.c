@@ -0,0 +1,64 @@
+#include "SGSLrmDecode.h"
+
+#define IS_DIGIT(c) ((unsigned char)((c) - '0') <= 9)
+
+#define MAX_METRES          9999
+#define MAX_DECIMALS        4       // 0.1 mm
+
+static const int g_decimalScale[MAX_DECIMALS + 1] = { 10000, 1000, 100, 10, 1 };
+
+SGSLrmStatus SGSLrmDecode_Measurement(const unsigned char* frame, int length, int* units, SGSLrmResolution* resolution,
+    int* errorCode)
+{
+    // Single, continuous and cache-read answers carry a distance or an error
+    if (length < 4 || frame[1] != 0x06 || (frame[2] != 0x82 && frame[2] != 0x83 && frame[2] != 0x87)) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    // ADDR 06 8X 'E' 'R' 'R' '-' ['-' ['-']] d d CS, as the frame parser accepts it
+    if (frame[3] == 'E') {
+        if (length < 10 || length > 12 || frame[4] != 'R' || frame[5] != 'R' || frame[6] != '-' ||
+            !IS_DIGIT(frame[length - 3]) || !IS_DIGIT(frame[length - 2])) {
+            return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        for (int i = 7; i < length - 3; ++i) {
+            if (frame[i] != '-') return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        *errorCode = (frame[length - 3] - '0') * 10 + (frame[length - 2] - '0');
+        return SGS_LRM_MEASUREMENT_ERROR;
+    }
+
+    if (length - 4 < 3 || length - 4 > 12) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    const unsigned char* p = frame + 3;
+    const unsigned char* end = frame + length - 1;
+
+    // Whole metres: at least one digit
+    int metres = 0;
+    const unsigned char* start = p;
+    while (p < end && IS_DIGIT(*p)) {
+        metres = metres * 10 + (*p++ - '0');
+        if (metres > MAX_METRES) return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    if (p == start) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    // Optional '.' and one to four decimals
+    int fraction = 0;
+    int decimals = 0;
+    if (p < end) {
+        if (*p++ != '.' || p == end) return SGS_LRM_COMMUNICATION_ERROR;
+        for (; p < end; ++p) {
+            if (!IS_DIGIT(*p) || ++decimals > MAX_DECIMALS) return SGS_LRM_COMMUNICATION_ERROR;
+            fraction = fraction * 10 + (*p - '0');
+        }
+    }
+
+    *units = metres * SGS_LRM_UNITS_PER_METRE + fraction * g_decimalScale[decimals];
+    *resolution = decimals == MAX_DECIMALS ? SGS_LRM_RESOLUTION_100UM : SGS_LRM_RESOLUTION_1MM;
+    *errorCode = 0;
+    return SGS_LRM_SUCCESS;
+}
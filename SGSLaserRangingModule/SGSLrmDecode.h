@@ -0,0 +1,24 @@
+#pragma once
+
+// Internal measurement-frame decoder.
+// One pass over ADDR 06 8X payload CS validates the payload and converts it:
+// "XXX.XXX" (1 mm) and "XXX.XXXX" (0.1 mm) become an integer count of 0.1 mm
+// units, "ERR-XX" (also "ERR--XX"/"ERR---XX") its error number. No copy, no
+// strtod, so the result does not depend on the C locale.
+
+#include "SGSLaserRangingModule.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Returns SGS_LRM_SUCCESS with *units and the *resolution the payload was
+// written at (four decimals: 0.1 mm, else 1 mm), SGS_LRM_MEASUREMENT_ERROR
+// with *errorCode for an ERR frame, SGS_LRM_COMMUNICATION_ERROR for anything
+// else. Neither ADDR nor CS is checked: the frame parser already has.
+SGSLrmStatus SGSLrmDecode_Measurement(const unsigned char* frame, int length, int* units, SGSLrmResolution* resolution,
+    int* errorCode);
+
+#if defined(__cplusplus)
+}
+#endif
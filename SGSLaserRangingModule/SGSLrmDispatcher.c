@@ -0,0 +1,311 @@
+#include "SGSLrmDispatcher.h"
+
+// Dispatcher state. lock protects every queue's bookkeeping and the ready
+// list; lifecycle serialises starting/stopping the workers (never taken by a
+// worker, so Detach can join while holding it). Callbacks run with lock
+// released, so they may call back into the library.
+typedef struct {
+    CRITICAL_SECTION lock;
+    CRITICAL_SECTION lifecycle;
+    CONDITION_VARIABLE workAvailable;
+    CONDITION_VARIABLE callbackDone;
+    SGSLrmDispatchQueue* readyHead;
+    SGSLrmDispatchQueue* readyTail;
+    SGSLrmThread workers[SGS_LRM_DISPATCH_WORKERS];
+    int attachedCount;
+    bool running;
+    bool stopping;
+} SGSLrmDispatcherState;
+
+static SGSLrmDispatcherState g_dispatcher;
+static volatile LONG g_dispatcherInitOnceFlag = 0;
+static volatile bool g_dispatcherInitialized = false;
+
+static void InitializeDispatcher(void)
+{
+    if (InterlockedCompareExchange(&g_dispatcherInitOnceFlag, 1, 0) != 0) {
+        while (!g_dispatcherInitialized) Sleep(0);
+        return;
+    }
+
+    ZeroMemory(&g_dispatcher, sizeof(g_dispatcher));
+    InitializeCriticalSection(&g_dispatcher.lock);
+    InitializeCriticalSection(&g_dispatcher.lifecycle);
+    InitializeConditionVariable(&g_dispatcher.workAvailable);
+    InitializeConditionVariable(&g_dispatcher.callbackDone);
+
+    g_dispatcherInitialized = true;
+}
+
+static bool OnWorkerThread(void)
+{
+    for (int i = 0; i < SGS_LRM_DISPATCH_WORKERS; ++i) {
+        if (SGSLrmThread_IsCurrent(&g_dispatcher.workers[i])) return true;
+    }
+    return false;
+}
+
+// Ready list helpers; called with lock held.
+static void PushReady(SGSLrmDispatchQueue* queue)
+{
+    queue->ready = true;
+    queue->nextReady = NULL;
+    if (g_dispatcher.readyTail) {
+        g_dispatcher.readyTail->nextReady = queue;
+    } else {
+        g_dispatcher.readyHead = queue;
+    }
+    g_dispatcher.readyTail = queue;
+    WakeConditionVariable(&g_dispatcher.workAvailable);
+}
+
+static SGSLrmDispatchQueue* PopReady(void)
+{
+    SGSLrmDispatchQueue* queue = g_dispatcher.readyHead;
+    g_dispatcher.readyHead = queue->nextReady;
+    if (!g_dispatcher.readyHead) g_dispatcher.readyTail = NULL;
+    queue->nextReady = NULL;
+    queue->ready = false;
+    return queue;
+}
+
+static void RemoveReady(SGSLrmDispatchQueue* queue)
+{
+    if (!queue->ready) return;
+    SGSLrmDispatchQueue* prev = NULL;
+    for (SGSLrmDispatchQueue* q = g_dispatcher.readyHead; q; prev = q, q = q->nextReady) {
+        if (q != queue) continue;
+        if (prev) prev->nextReady = q->nextReady; else g_dispatcher.readyHead = q->nextReady;
+        if (g_dispatcher.readyTail == q) g_dispatcher.readyTail = prev;
+        break;
+    }
+    queue->nextReady = NULL;
+    queue->ready = false;
+}
+
+// An ordered queue stays off the ready list while one of its callbacks runs.
+static bool CanSchedule(const SGSLrmDispatchQueue* queue)
+{
+    return queue->count > 0 && !queue->ready && (queue->policy.unordered || queue->inFlight == 0);
+}
+
+static void DropOldest(SGSLrmDispatchQueue* queue)
+{
+    queue->head = (queue->head + 1) % SGS_LRM_CALLBACK_QUEUE_MAX;
+    queue->count--;
+    queue->stats.dropped++;
+}
+
+static DWORD WINAPI DispatchWorker(LPVOID lpParam)
+{
+    (void)lpParam;
+    EnterCriticalSection(&g_dispatcher.lock);
+    for (;;) {
+        while (!g_dispatcher.stopping && !g_dispatcher.readyHead) {
+            SleepConditionVariableCS(&g_dispatcher.workAvailable, &g_dispatcher.lock, INFINITE);
+        }
+        if (g_dispatcher.stopping) break;
+
+        SGSLrmDispatchQueue* queue = PopReady();
+        SGSLrmDispatchItem item = queue->items[queue->head];
+        queue->head = (queue->head + 1) % SGS_LRM_CALLBACK_QUEUE_MAX;
+        queue->count--;
+        queue->inFlight++;
+        if (CanSchedule(queue)) PushReady(queue); // Unordered: another worker may take the next item
+        LeaveCriticalSection(&g_dispatcher.lock);
+
+        SGSLrmDispatchItem_Invoke(queue->handle, &item);
+
+        EnterCriticalSection(&g_dispatcher.lock);
+        queue->inFlight--;
+        queue->stats.delivered++;
+        if (CanSchedule(queue)) PushReady(queue); // Back of the line: other handles go first
+        WakeAllConditionVariable(&g_dispatcher.callbackDone);
+    }
+    LeaveCriticalSection(&g_dispatcher.lock);
+    return 0;
+}
+
+// Called with lifecycle held, not lock.
+static SGSLrmStatus StartWorkers(void)
+{
+    g_dispatcher.stopping = false;
+    for (int i = 0; i < SGS_LRM_DISPATCH_WORKERS; ++i) {
+        if (!SGSLrmThread_Start(&g_dispatcher.workers[i], DispatchWorker, NULL)) {
+            EnterCriticalSection(&g_dispatcher.lock);
+            g_dispatcher.stopping = true;
+            WakeAllConditionVariable(&g_dispatcher.workAvailable);
+            LeaveCriticalSection(&g_dispatcher.lock);
+            while (i-- > 0) SGSLrmThread_Join(&g_dispatcher.workers[i]);
+            g_dispatcher.stopping = false;
+            return SGS_LRM_OUT_OF_MEMORY;
+        }
+    }
+    g_dispatcher.running = true;
+    return SGS_LRM_SUCCESS;
+}
+
+void SGSLrmDispatchQueue_Init(SGSLrmDispatchQueue* queue, SGSLrmHandle handle)
+{
+    ZeroMemory(queue, sizeof(*queue));
+    queue->handle = handle;
+}
+
+SGSLrmStatus SGSLrmDispatcher_Attach(SGSLrmDispatchQueue* queue, const SGSLrmCallbackPolicy* policy)
+{
+    if (!queue || !policy) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    if (!g_dispatcherInitialized) {
+        InitializeDispatcher();
+    }
+
+    bool onWorker = OnWorkerThread();
+    if (!onWorker) EnterCriticalSection(&g_dispatcher.lifecycle);
+
+    if (!g_dispatcher.running) {
+        SGSLrmStatus status = StartWorkers();
+        if (status != SGS_LRM_SUCCESS) {
+            if (!onWorker) LeaveCriticalSection(&g_dispatcher.lifecycle);
+            return status;
+        }
+    }
+
+    EnterCriticalSection(&g_dispatcher.lock);
+    queue->policy = *policy;
+    if (queue->policy.maxQueueDepth <= 0) queue->policy.maxQueueDepth = SGS_LRM_CALLBACK_QUEUE_MAX;
+    while (queue->count > queue->policy.maxQueueDepth) DropOldest(queue);
+    if (!queue->attached) {
+        queue->attached = true;
+        g_dispatcher.attachedCount++;
+    }
+    if (CanSchedule(queue)) PushReady(queue); // Switching to unordered may free a waiting item
+    LeaveCriticalSection(&g_dispatcher.lock);
+
+    if (!onWorker) LeaveCriticalSection(&g_dispatcher.lifecycle);
+    return SGS_LRM_SUCCESS;
+}
+
+void SGSLrmDispatcher_Cancel(SGSLrmDispatchQueue* queue)
+{
+    if (!queue || !g_dispatcherInitialized) {
+        return;
+    }
+
+    bool onWorker = OnWorkerThread();
+    EnterCriticalSection(&g_dispatcher.lock);
+    RemoveReady(queue);
+    queue->stats.dropped += queue->count;
+    queue->count = 0;
+    queue->head = 0;
+    if (!onWorker) {
+        while (queue->inFlight > 0) {
+            SleepConditionVariableCS(&g_dispatcher.callbackDone, &g_dispatcher.lock, INFINITE);
+        }
+    }
+    LeaveCriticalSection(&g_dispatcher.lock);
+}
+
+void SGSLrmDispatcher_Detach(SGSLrmDispatchQueue* queue)
+{
+    if (!queue || !g_dispatcherInitialized) {
+        return;
+    }
+
+    bool onWorker = OnWorkerThread();
+    if (!onWorker) EnterCriticalSection(&g_dispatcher.lifecycle);
+
+    EnterCriticalSection(&g_dispatcher.lock);
+    if (queue->attached) {
+        queue->attached = false;
+        g_dispatcher.attachedCount--;
+    }
+    LeaveCriticalSection(&g_dispatcher.lock);
+    SGSLrmDispatcher_Cancel(queue);
+
+    // A worker cannot join itself; the pool then idles until the next attach
+    EnterCriticalSection(&g_dispatcher.lock);
+    bool stopWorkers = !onWorker && g_dispatcher.running && g_dispatcher.attachedCount == 0;
+    if (stopWorkers) {
+        g_dispatcher.stopping = true;
+        WakeAllConditionVariable(&g_dispatcher.workAvailable);
+    }
+    LeaveCriticalSection(&g_dispatcher.lock);
+
+    if (stopWorkers) {
+        for (int i = 0; i < SGS_LRM_DISPATCH_WORKERS; ++i) {
+            SGSLrmThread_Join(&g_dispatcher.workers[i]);
+        }
+        EnterCriticalSection(&g_dispatcher.lock);
+        g_dispatcher.running = false;
+        g_dispatcher.stopping = false;
+        LeaveCriticalSection(&g_dispatcher.lock);
+    }
+
+    if (!onWorker) LeaveCriticalSection(&g_dispatcher.lifecycle);
+}
+
+bool SGSLrmDispatcher_Post(SGSLrmDispatchQueue* queue, const SGSLrmDispatchItem* item)
+{
+    if (!queue || !item || !g_dispatcherInitialized) {
+        return false;
+    }
+
+    EnterCriticalSection(&g_dispatcher.lock);
+    if (!queue->attached) {
+        LeaveCriticalSection(&g_dispatcher.lock);
+        return false;
+    }
+
+    if (queue->policy.coalesce && queue->count > 0) {
+        // Only the newest sample matters: forget whatever is still waiting
+        queue->stats.coalesced += queue->count;
+        queue->count = 0;
+    } else if (queue->count >= queue->policy.maxQueueDepth) {
+        DropOldest(queue);
+    }
+
+    queue->items[(queue->head + queue->count) % SGS_LRM_CALLBACK_QUEUE_MAX] = *item;
+    queue->count++;
+    if (queue->count > queue->stats.maxQueueDepthSeen) queue->stats.maxQueueDepthSeen = queue->count;
+    if (CanSchedule(queue)) PushReady(queue);
+
+    LeaveCriticalSection(&g_dispatcher.lock);
+    return true;
+}
+
+void SGSLrmDispatchItem_Invoke(SGSLrmHandle handle, const SGSLrmDispatchItem* item)
+{
+    const SGSLrmMeasurementEx* m = &item->measurement;
+    if (item->callbackEx) {
+        item->callbackEx(handle, m, item->userdata);
+    } else if (item->callbackTenthMm) {
+        item->callbackTenthMm(handle, m->distanceTenthMm, m->resolution, m->status, item->userdata);
+    } else if (item->callback) {
+        item->callback(handle, m->distance, m->status, item->userdata);
+    }
+}
+
+void SGSLrmDispatcher_GetStats(SGSLrmDispatchQueue* queue, SGSLrmCallbackStats* stats)
+{
+    if (!g_dispatcherInitialized) {
+        *stats = queue->stats;
+        return;
+    }
+    EnterCriticalSection(&g_dispatcher.lock);
+    *stats = queue->stats;
+    stats->queueDepth = queue->count;
+    LeaveCriticalSection(&g_dispatcher.lock);
+}
+
+int SGSLrmDispatcher_ThreadCount(void)
+{
+    if (!g_dispatcherInitialized) {
+        return 0;
+    }
+    EnterCriticalSection(&g_dispatcher.lock);
+    int count = g_dispatcher.running ? SGS_LRM_DISPATCH_WORKERS : 0;
+    LeaveCriticalSection(&g_dispatcher.lock);
+    return count;
+}
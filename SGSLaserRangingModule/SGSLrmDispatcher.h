@@ -0,0 +1,76 @@
+#pragma once
+
+// Internal callback dispatcher.
+// In queued mode the I/O side posts (callback, sample) items to a bounded
+// per-handle queue instead of calling the user callback itself; a small pool
+// of worker threads drains the queues. A handle with pending items sits on a
+// FIFO ready list, so handles are served round-robin. Unless the policy is
+// unordered, at most one worker runs a given handle's callbacks at a time,
+// which keeps them in arrival order.
+//
+// The workers are started by the first attached queue and stopped when the
+// last one detaches. Queues are embedded in their device (no allocation).
+
+#include "SGSLaserRangingModule.h"
+#include "SGSLrmPlatform.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define SGS_LRM_DISPATCH_WORKERS    2
+
+// One callback invocation. A handle has one kind of callback set; the others
+// are handed their part of measurement.
+typedef struct {
+    SGSLrm_MeasurementCallback callback;
+    SGSLrm_MeasurementCallbackTenthMm callbackTenthMm;
+    SGSLrm_MeasurementCallbackEx callbackEx;
+    void* userdata;
+    SGSLrmMeasurementEx measurement;
+} SGSLrmDispatchItem;
+
+typedef struct SGSLrmDispatchQueue {
+    SGSLrmHandle handle;                // Passed to the callbacks
+
+    // Dispatcher bookkeeping, all under the dispatcher lock
+    SGSLrmCallbackPolicy policy;
+    SGSLrmDispatchItem items[SGS_LRM_CALLBACK_QUEUE_MAX];
+    int head;                           // Oldest pending item
+    int count;                          // Pending items
+    int inFlight;                       // Callbacks running on workers now
+    bool attached;
+    bool ready;                         // On the ready list
+    struct SGSLrmDispatchQueue* nextReady;
+    SGSLrmCallbackStats stats;
+} SGSLrmDispatchQueue;
+
+// Only while the queue is detached (handle creation).
+void SGSLrmDispatchQueue_Init(SGSLrmDispatchQueue* queue, SGSLrmHandle handle);
+
+// Applies policy (already validated) and starts accepting posts; may be called
+// again on an attached queue to change the policy.
+SGSLrmStatus SGSLrmDispatcher_Attach(SGSLrmDispatchQueue* queue, const SGSLrmCallbackPolicy* policy);
+
+// Cancels and stops accepting posts.
+void SGSLrmDispatcher_Detach(SGSLrmDispatchQueue* queue);
+
+// Queues one callback invocation. Returns false when the queue is not
+// attached, in which case the caller should invoke the callback itself.
+bool SGSLrmDispatcher_Post(SGSLrmDispatchQueue* queue, const SGSLrmDispatchItem* item);
+
+// Runs item's callback on the calling thread.
+void SGSLrmDispatchItem_Invoke(SGSLrmHandle handle, const SGSLrmDispatchItem* item);
+
+// Discards pending items (counted as dropped). On return no callback for this
+// queue is running, unless called from inside one on a worker thread.
+void SGSLrmDispatcher_Cancel(SGSLrmDispatchQueue* queue);
+
+void SGSLrmDispatcher_GetStats(SGSLrmDispatchQueue* queue, SGSLrmCallbackStats* stats);
+
+// Number of worker threads currently running; for diagnostics.
+int SGSLrmDispatcher_ThreadCount(void);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,220 @@
+#include "SGSLrmFilter.h"
+#include <string.h>
+
+#define MAD_SCALE   1.4826      // MAD to standard deviation for Gaussian noise
+
+// Heap positions run from -(window / 2) to (window - 1) / 2
+#define HEAP(m, i)  ((m)->heap[(i) + (m)->window / 2])
+#define MIN_COUNT(m) (((m)->count - 1) / 2)    // Values in the min-heap
+#define MAX_COUNT(m) ((m)->count / 2)          // Values in the max-heap
+
+static bool Less(const SGSLrmMediator* m, int i, int j)
+{
+    return m->data[HEAP(m, i)] < m->data[HEAP(m, j)];
+}
+
+static void Exchange(SGSLrmMediator* m, int i, int j)
+{
+    int t = HEAP(m, i);
+    HEAP(m, i) = HEAP(m, j);
+    HEAP(m, j) = t;
+    m->pos[HEAP(m, i)] = i;
+    m->pos[HEAP(m, j)] = j;
+}
+
+// Swaps i and j when the value at i is less; true if it did.
+static bool CompareExchange(SGSLrmMediator* m, int i, int j)
+{
+    if (!Less(m, i, j)) return false;
+    Exchange(m, i, j);
+    return true;
+}
+
+// Restores the min-heap below i / 2
+static void MinSortDown(SGSLrmMediator* m, int i)
+{
+    for (; i <= MIN_COUNT(m); i *= 2) {
+        if (i > 1 && i < MIN_COUNT(m) && Less(m, i + 1, i)) ++i;
+        if (!CompareExchange(m, i, i / 2)) break;
+    }
+}
+
+// Restores the max-heap below i / 2 (negative positions)
+static void MaxSortDown(SGSLrmMediator* m, int i)
+{
+    for (; i >= -MAX_COUNT(m); i *= 2) {
+        if (i < -1 && i > -MAX_COUNT(m) && Less(m, i, i - 1)) --i;
+        if (!CompareExchange(m, i / 2, i)) break;
+    }
+}
+
+// Moves i up the min-heap; true if it became the median
+static bool MinSortUp(SGSLrmMediator* m, int i)
+{
+    while (i > 0 && CompareExchange(m, i, i / 2)) i /= 2;
+    return i == 0;
+}
+
+// Moves i up the max-heap; true if it became the median
+static bool MaxSortUp(SGSLrmMediator* m, int i)
+{
+    while (i < 0 && CompareExchange(m, i / 2, i)) i /= 2;
+    return i == 0;
+}
+
+void SGSLrmMediator_Init(SGSLrmMediator* mediator, int window)
+{
+    mediator->window = window;
+    mediator->count = 0;
+    mediator->next = 0;
+    // Slots fill the median, then alternate max-heap and min-heap
+    for (int slot = 0; slot < window; ++slot) {
+        mediator->data[slot] = 0;
+        mediator->pos[slot] = ((slot + 1) / 2) * ((slot & 1) ? -1 : 1);
+        HEAP(mediator, mediator->pos[slot]) = slot;
+    }
+}
+
+void SGSLrmMediator_Insert(SGSLrmMediator* m, int value)
+{
+    bool filling = m->count < m->window;
+    int p = m->pos[m->next];
+    int old = m->data[m->next];
+    m->data[m->next] = value;
+    m->next = (m->next + 1) % m->window;
+    if (filling) m->count++;
+
+    if (p > 0) {
+        if (!filling && old < value) MinSortDown(m, p * 2);
+        else if (MinSortUp(m, p)) MaxSortDown(m, -1);
+    } else if (p < 0) {
+        if (!filling && value < old) MaxSortDown(m, p * 2);
+        else if (MaxSortUp(m, p)) MinSortDown(m, 1);
+    } else {
+        if (MAX_COUNT(m)) MaxSortDown(m, -1);
+        if (MIN_COUNT(m)) MinSortDown(m, 1);
+    }
+}
+
+int SGSLrmMediator_Median(const SGSLrmMediator* m)
+{
+    int v = m->data[HEAP(m, 0)];
+    if ((m->count & 1) == 0) {
+        int lower = m->data[HEAP(m, -1)];
+        v = lower + (v - lower) / 2;
+    }
+    return v;
+}
+
+// k-th smallest of values[0..count), reordering them (Hoare selection).
+static int Select(int* values, int count, int k)
+{
+    int lo = 0, hi = count - 1;
+    while (lo < hi) {
+        int pivot = values[lo + (hi - lo) / 2];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                int t = values[i];
+                values[i] = values[j];
+                values[j] = t;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else break;
+    }
+    return values[k];
+}
+
+SGSLrmStatus SGSLrmFilter_Validate(const SGSLrmFilterConfig* config)
+{
+    if (config->hampelWindow != 0 &&
+        (config->hampelWindow < 3 || config->hampelWindow > SGS_LRM_FILTER_WINDOW_MAX || (config->hampelWindow & 1) == 0 ||
+         !(config->hampelThreshold > 0.0) || config->hampelFloorTenthMm < 0)) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+    if (config->medianWindow < 0 || config->medianWindow > SGS_LRM_FILTER_WINDOW_MAX ||
+        config->averageWindow < 0 || config->averageWindow > SGS_LRM_FILTER_WINDOW_MAX) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+    return SGS_LRM_SUCCESS;
+}
+
+void SGSLrmFilter_Init(SGSLrmFilter* filter, const SGSLrmFilterConfig* config)
+{
+    memset(filter, 0, sizeof(*filter));
+    if (config) filter->config = *config;
+    if (filter->config.hampelWindow > 0) SGSLrmMediator_Init(&filter->hampel, filter->config.hampelWindow);
+    if (filter->config.medianWindow > 0) SGSLrmMediator_Init(&filter->median, filter->config.medianWindow);
+}
+
+bool SGSLrmFilter_IsEnabled(const SGSLrmFilter* filter)
+{
+    return filter->config.hampelWindow > 0 || filter->config.medianWindow > 0 || filter->config.averageWindow > 0;
+}
+
+// Judges value against the trailing window it has just joined; the window
+// keeps the raw value, so a real step is accepted once it fills half of it.
+static int Hampel(SGSLrmFilter* filter, int value)
+{
+    SGSLrmMediator* m = &filter->hampel;
+    SGSLrmMediator_Insert(m, value);
+    if (m->count < m->window) {
+        return value;
+    }
+
+    int median = SGSLrmMediator_Median(m);
+    for (int i = 0; i < m->count; ++i) {
+        int deviation = m->data[i] - median;
+        filter->scratch[i] = deviation < 0 ? -deviation : deviation;
+    }
+    double mad = (double)Select(filter->scratch, m->count, m->count / 2);
+
+    int deviation = value - median;
+    if (deviation < 0) deviation = -deviation;
+    double limit = filter->config.hampelThreshold * MAD_SCALE * mad;
+    if (deviation > filter->config.hampelFloorTenthMm && (double)deviation > limit) {
+        filter->stats.rejected++;
+        return median;
+    }
+    return value;
+}
+
+static int MovingAverage(SGSLrmFilter* filter, int value)
+{
+    int window = filter->config.averageWindow;
+    if (filter->averageCount == window) {
+        filter->averageSum -= filter->average[filter->averageNext];
+    } else {
+        filter->averageCount++;
+    }
+    filter->average[filter->averageNext] = value;
+    filter->averageNext = (filter->averageNext + 1) % window;
+    filter->averageSum += value;
+
+    long long n = filter->averageCount;
+    long long sum = filter->averageSum;
+    return (int)(sum >= 0 ? (sum + n / 2) / n : (sum - n / 2) / n);
+}
+
+int SGSLrmFilter_Apply(SGSLrmFilter* filter, int valueTenthMm)
+{
+    int value = valueTenthMm;
+    if (filter->config.hampelWindow > 0) {
+        value = Hampel(filter, value);
+    }
+    if (filter->config.medianWindow > 0) {
+        SGSLrmMediator_Insert(&filter->median, value);
+        value = SGSLrmMediator_Median(&filter->median);
+    }
+    if (filter->config.averageWindow > 0) {
+        value = MovingAverage(filter, value);
+    }
+    filter->stats.filtered++;
+    return value;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Internal per-device filter pipeline for readings in 0.1 mm units.
+// Stages run in order, each one skipped when its window is 0:
+//   Hampel   trailing-window median and MAD; a reading further than
+//            threshold * 1.4826 * MAD (and the floor) from the median is
+//            replaced by the median and counted as rejected
+//   median   sliding-window median
+//   average  moving average, rounded to the nearest unit
+// Medians come from a two-heap "mediator": the window's values in a ring,
+// a max-heap below the median and a min-heap above it, with each ring slot's
+// heap position tracked so the value leaving the window is replaced in
+// place. Every insert is O(log n). All windows are fixed arrays: nothing is
+// allocated per sample, or at all.
+// Not thread-safe: the owner serialises access (the device state lock).
+
+#include "SGSLaserRangingModule.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct {
+    int window;                             // 1..SGS_LRM_FILTER_WINDOW_MAX
+    int count;                              // Values held, up to window
+    int next;                               // Ring slot the next value replaces
+    int data[SGS_LRM_FILTER_WINDOW_MAX];    // Ring of values
+    int pos[SGS_LRM_FILTER_WINDOW_MAX];     // Heap position of each ring slot
+    int heap[SGS_LRM_FILTER_WINDOW_MAX];    // Ring slots; position 0 is the median, <0 max-heap, >0 min-heap
+} SGSLrmMediator;
+
+typedef struct {
+    SGSLrmFilterConfig config;
+    SGSLrmMediator hampel;
+    SGSLrmMediator median;
+    int average[SGS_LRM_FILTER_WINDOW_MAX]; // Ring of the average's inputs
+    int averageCount;
+    int averageNext;
+    long long averageSum;
+    int scratch[SGS_LRM_FILTER_WINDOW_MAX]; // Deviations for the MAD
+    SGSLrmFilterStats stats;
+} SGSLrmFilter;
+
+// window in 1..SGS_LRM_FILTER_WINDOW_MAX; empties the window.
+void SGSLrmMediator_Init(SGSLrmMediator* mediator, int window);
+
+// Adds value, dropping the oldest once the window is full.
+void SGSLrmMediator_Insert(SGSLrmMediator* mediator, int value);
+
+// Median of the values held (mean of the middle two, rounded down, for an
+// even count). At least one value must have been inserted.
+int SGSLrmMediator_Median(const SGSLrmMediator* mediator);
+
+// config already validated (SGSLrmFilter_Validate); NULL turns filtering off.
+void SGSLrmFilter_Init(SGSLrmFilter* filter, const SGSLrmFilterConfig* config);
+
+// SGS_LRM_SUCCESS, or SGS_LRM_INVALID_PARAMETER for a window out of range, an
+// even Hampel window or a non-positive Hampel threshold.
+SGSLrmStatus SGSLrmFilter_Validate(const SGSLrmFilterConfig* config);
+
+bool SGSLrmFilter_IsEnabled(const SGSLrmFilter* filter);
+
+// Runs one reading through the pipeline and returns the filtered value.
+int SGSLrmFilter_Apply(SGSLrmFilter* filter, int valueTenthMm);
+
+#if defined(__cplusplus)
+}
+#endif
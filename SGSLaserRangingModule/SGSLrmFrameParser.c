@@ -0,0 +1,211 @@
+#include "SGSLrmFrameParser.h"
+#include "SGSLaserRangingModule.h"
+#include <string.h>
+
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+typedef enum {
+    CLASSIFY_INVALID,       // buffer[0] cannot start a frame
+    CLASSIFY_NEED_MORE,     // valid prefix, frame not complete yet
+    CLASSIFY_COMPLETE,      // *frameLength bytes form a frame
+} ClassifyResult;
+
+static unsigned char Checksum(const unsigned char* data, int length)
+{
+    unsigned int sum = 0;
+    for (int i = 0; i < length; ++i) sum += data[i];
+    return (unsigned char)(0x100 - (sum & 0xFF));
+}
+
+static bool IsMeasurementResponse(unsigned char code)
+{
+    return code == 0x82 || code == 0x83 || code == 0x87;
+}
+
+// Completes a fixed-length frame once all bytes are in and the checksum holds.
+static ClassifyResult FixedLength(const unsigned char* buf, int len, int n, int* frameLength)
+{
+    if (len < n) return CLASSIFY_NEED_MORE;
+    if (buf[n - 1] != Checksum(buf, n - 1)) return CLASSIFY_INVALID;
+    *frameLength = n;
+    return CLASSIFY_COMPLETE;
+}
+
+// "ERR" then one to three '-' then two digits, e.g. "ERR-16".
+static ClassifyResult ClassifyError(const unsigned char* buf, int len, int* frameLength)
+{
+    static const unsigned char prefix[] = { 'E', 'R', 'R', '-' };
+    for (int i = 0; i < 4 && 3 + i < len; ++i) {
+        if (buf[3 + i] != prefix[i]) return CLASSIFY_INVALID;
+    }
+
+    int pos = 7;
+    while (pos < len && pos < 9 && buf[pos] == '-') pos++;
+    if (pos >= len) return CLASSIFY_NEED_MORE;
+    // Two digits then CS
+    if (!IS_DIGIT(buf[pos])) return CLASSIFY_INVALID;
+    if (pos + 1 < len && !IS_DIGIT(buf[pos + 1])) return CLASSIFY_INVALID;
+    return FixedLength(buf, len, pos + 3, frameLength);
+}
+
+// "XXX.XXX" (1 mm) or "XXX.XXXX" (0.1 mm). The checksum of a 1 mm frame can be
+// an ASCII digit, so an 11-byte frame is only held back for a possible 12th
+// byte when the parser believes 0.1 mm resolution is active.
+static ClassifyResult ClassifyMeasurement(const SGSLrmFrameParser* parser, const unsigned char* buf, int len, int* frameLength)
+{
+    for (int i = 3; i < len && i < 11; ++i) {
+        bool ok = (i == 6) ? (buf[i] == '.') : IS_DIGIT(buf[i]);
+        if (!ok) {
+            // buf[10] may be the CS of a 1 mm frame
+            if (i == 10) break;
+            return CLASSIFY_INVALID;
+        }
+    }
+    if (len < 11) return CLASSIFY_NEED_MORE;
+
+    bool shortValid = buf[10] == Checksum(buf, 10);
+    bool mayBeLong = IS_DIGIT(buf[10]);
+
+    if (shortValid && (!mayBeLong || parser->resolution != SGS_LRM_RESOLUTION_100UM)) {
+        *frameLength = 11;
+        return CLASSIFY_COMPLETE;
+    }
+    if (!mayBeLong) return CLASSIFY_INVALID;
+    if (len < 12) return CLASSIFY_NEED_MORE;
+
+    if (buf[11] == Checksum(buf, 11)) {
+        *frameLength = 12;
+        return CLASSIFY_COMPLETE;
+    }
+    if (shortValid) {
+        *frameLength = 11;
+        return CLASSIFY_COMPLETE;
+    }
+    return CLASSIFY_INVALID;
+}
+
+static ClassifyResult Classify(const SGSLrmFrameParser* parser, int* frameLength, SGSLrmFrameType* type)
+{
+    const unsigned char* buf = parser->buffer;
+    int len = parser->length;
+
+    if (len < 2) return CLASSIFY_NEED_MORE;
+
+    switch (buf[1]) {
+    case 0x04:  // ADDR 04 8X CS
+        if (len < 3) return CLASSIFY_NEED_MORE;
+        if ((buf[2] & 0xF0) != 0x80) return CLASSIFY_INVALID;
+        *type = SGS_LRM_FRAME_CONFIG_ACK;
+        return FixedLength(buf, len, 4, frameLength);
+
+    case 0x84:  // FA 84 8X XX CS
+        if (len < 3) return CLASSIFY_NEED_MORE;
+        if ((buf[2] & 0xF0) != 0x80) return CLASSIFY_INVALID;
+        *type = SGS_LRM_FRAME_CONFIG_NAK;
+        return FixedLength(buf, len, 5, frameLength);
+
+    case 0x06:
+        if (len < 3) return CLASSIFY_NEED_MORE;
+        if (buf[2] == 0x84) {
+            *type = SGS_LRM_FRAME_DEVICE_ID;
+            return FixedLength(buf, len, 20, frameLength);
+        }
+        if (buf[2] == 0x85) {
+            *type = SGS_LRM_FRAME_LASER;
+            return FixedLength(buf, len, 5, frameLength);
+        }
+        if (!IsMeasurementResponse(buf[2])) return CLASSIFY_INVALID;
+        if (len < 4) return CLASSIFY_NEED_MORE;
+        if (buf[3] == 'E') {
+            *type = SGS_LRM_FRAME_HW_ERROR;
+            return ClassifyError(buf, len, frameLength);
+        }
+        if (!IS_DIGIT(buf[3])) return CLASSIFY_INVALID;
+        *type = SGS_LRM_FRAME_MEASUREMENT;
+        return ClassifyMeasurement(parser, buf, len, frameLength);
+
+    default:
+        return CLASSIFY_INVALID;
+    }
+}
+
+static void Discard(SGSLrmFrameParser* parser, int count)
+{
+    memmove(parser->buffer, parser->buffer + count, (size_t)(parser->length - count));
+    memmove(parser->arrivalNs, parser->arrivalNs + count, (size_t)(parser->length - count) * sizeof(parser->arrivalNs[0]));
+    parser->length -= count;
+}
+
+static void Emit(SGSLrmFrameParser* parser, int frameLength, SGSLrmFrameType type, SGSLrmFrame* frame)
+{
+    frame->type = type;
+    frame->length = frameLength;
+    memcpy(frame->data, parser->buffer, (size_t)frameLength);
+    frame->firstByteNs = parser->arrivalNs[0];
+    frame->lastByteNs = parser->arrivalNs[frameLength - 1];
+    Discard(parser, frameLength);
+    parser->frameCount++;
+
+    // Track the module's actual resolution from unambiguous frames
+    if (type == SGS_LRM_FRAME_MEASUREMENT) {
+        parser->resolution = frameLength == 12 ? SGS_LRM_RESOLUTION_100UM : SGS_LRM_RESOLUTION_1MM;
+    }
+}
+
+// Pulls one frame out of the buffer, resynchronising past invalid bytes.
+static bool Extract(SGSLrmFrameParser* parser, SGSLrmFrame* frame)
+{
+    while (parser->length > 0) {
+        int frameLength = 0;
+        SGSLrmFrameType type = SGS_LRM_FRAME_MEASUREMENT;
+        switch (Classify(parser, &frameLength, &type)) {
+        case CLASSIFY_COMPLETE:
+            Emit(parser, frameLength, type, frame);
+            return true;
+        case CLASSIFY_NEED_MORE:
+            return false;
+        case CLASSIFY_INVALID:
+        default:
+            Discard(parser, 1);
+            parser->discardedBytes++;
+            break;
+        }
+    }
+    return false;
+}
+
+void SGSLrmFrameParser_Init(SGSLrmFrameParser* parser, int resolution)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->resolution = resolution;
+}
+
+void SGSLrmFrameParser_Reset(SGSLrmFrameParser* parser)
+{
+    parser->discardedBytes += (unsigned long)parser->length;
+    parser->length = 0;
+}
+
+bool SGSLrmFrameParser_Feed(SGSLrmFrameParser* parser, const unsigned char* data, int length,
+    unsigned long long arrivalNs, int* consumed, SGSLrmFrame* frame)
+{
+    *consumed = 0;
+    for (;;) {
+        if (Extract(parser, frame)) return true;
+        if (*consumed >= length) return false;
+        // Extract() leaves at most one partial frame, which always fits
+        parser->arrivalNs[parser->length] = arrivalNs;
+        parser->buffer[parser->length++] = data[(*consumed)++];
+    }
+}
+
+bool SGSLrmFrameParser_Flush(SGSLrmFrameParser* parser, SGSLrmFrame* frame)
+{
+    const unsigned char* buf = parser->buffer;
+    if (parser->length == 11 && buf[1] == 0x06 && IsMeasurementResponse(buf[2]) &&
+        IS_DIGIT(buf[3]) && buf[10] == Checksum(buf, 10)) {
+        Emit(parser, 11, SGS_LRM_FRAME_MEASUREMENT, frame);
+        return true;
+    }
+    return false;
+}
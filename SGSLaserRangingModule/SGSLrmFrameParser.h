@@ -0,0 +1,74 @@
+#pragma once
+
+// Internal incremental frame parser.
+// Bytes are pushed in as they come off the wire, in whatever chunking the
+// driver delivers; a frame is emitted the moment its checksum byte arrives.
+// Garbage and corrupted frames are skipped one byte at a time until the next
+// plausible ADDR 06/04/84 header, so split and merged reads both work.
+// Every byte keeps the arrival stamp of the chunk it came in, so a frame
+// knows when its first byte and its checksum byte were read.
+//
+// Frame layouts (communication agreement):
+//   ADDR 06 8X "XXX.XXX" CS          measurement, 1 mm      (11 bytes)
+//   ADDR 06 8X "XXX.XXXX" CS         measurement, 0.1 mm    (12 bytes)
+//   ADDR 06 8X "ERR-XX" CS           hardware error         (10 bytes, "ERR--XX"/"ERR---XX" also accepted)
+//   FA 06 84 DAT1..DAT16 CS          device ID              (20 bytes)
+//   ADDR 06 85 XX CS                 laser control          (5 bytes)
+//   ADDR 04 8X CS                    config/shutdown ack    (4 bytes)
+//   FA 84 8X XX CS                   config failure         (5 bytes)
+
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define SGS_LRM_MAX_FRAME_LENGTH    20
+#define SGS_LRM_PARSER_BUFFER_SIZE  64
+
+typedef enum {
+    SGS_LRM_FRAME_MEASUREMENT = 0,
+    SGS_LRM_FRAME_HW_ERROR,
+    SGS_LRM_FRAME_DEVICE_ID,
+    SGS_LRM_FRAME_LASER,
+    SGS_LRM_FRAME_CONFIG_ACK,
+    SGS_LRM_FRAME_CONFIG_NAK,
+} SGSLrmFrameType;
+
+typedef struct {
+    SGSLrmFrameType type;
+    int length;
+    unsigned char data[SGS_LRM_MAX_FRAME_LENGTH];
+    unsigned long long firstByteNs;     // SGSLrmClock_NowNs() when data[0] was read
+    unsigned long long lastByteNs;      // ...and when the checksum byte was read
+} SGSLrmFrame;
+
+typedef struct {
+    unsigned char buffer[SGS_LRM_PARSER_BUFFER_SIZE];
+    unsigned long long arrivalNs[SGS_LRM_PARSER_BUFFER_SIZE];  // per buffered byte
+    int length;
+    int resolution;                 // SGS_LRM_RESOLUTION_* last seen/configured, disambiguates 11/12 byte frames
+    unsigned long discardedBytes;   // bytes skipped while resynchronising
+    unsigned long frameCount;       // frames emitted
+} SGSLrmFrameParser;
+
+void SGSLrmFrameParser_Init(SGSLrmFrameParser* parser, int resolution);
+
+// Drops buffered bytes (counted as discarded); keeps statistics and resolution.
+void SGSLrmFrameParser_Reset(SGSLrmFrameParser* parser);
+
+// Consumes bytes from data until a frame completes or the input is exhausted.
+// Returns true with *frame filled when a frame was emitted; *consumed tells how
+// many input bytes were used, so the caller loops until all are consumed.
+// Frames already complete in the internal buffer are returned first, so
+// calling with length 0 drains them. arrivalNs stamps the bytes of data.
+bool SGSLrmFrameParser_Feed(SGSLrmFrameParser* parser, const unsigned char* data, int length,
+    unsigned long long arrivalNs, int* consumed, SGSLrmFrame* frame);
+
+// Called when the line went idle: emits a buffered 1 mm measurement frame that
+// was being held back in case it was the head of a 0.1 mm frame.
+bool SGSLrmFrameParser_Flush(SGSLrmFrameParser* parser, SGSLrmFrame* frame);
+
+#if defined(__cplusplus)
+}
+#endif
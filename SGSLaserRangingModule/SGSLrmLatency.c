@@ -0,0 +1,52 @@
+#include "SGSLrmLatency.h"
+#include <string.h>
+
+#define EWMA_WEIGHT 0.125   // Same smoothing as TCP's SRTT
+
+void SGSLrmLatency_Init(SGSLrmLatencyTracker* tracker)
+{
+    memset(tracker, 0, sizeof(*tracker));
+}
+
+// Window is small: an insertion sort of a copy is cheaper than keeping a
+// histogram, and runs once per transaction, not per getter.
+static unsigned int Percentile99(const SGSLrmLatencyTracker* tracker)
+{
+    unsigned int sorted[SGS_LRM_LATENCY_WINDOW];
+    int n = tracker->filled;
+    for (int i = 0; i < n; ++i) {
+        unsigned int v = tracker->window[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    int rank = (n * 99 + 99) / 100;     // ceil(0.99 * n)
+    return sorted[rank - 1];
+}
+
+static void Add(SGSLrmLatencyTracker* tracker, unsigned int ms)
+{
+    tracker->window[tracker->next] = ms;
+    tracker->next = (tracker->next + 1) % SGS_LRM_LATENCY_WINDOW;
+    if (tracker->filled < SGS_LRM_LATENCY_WINDOW) tracker->filled++;
+
+    tracker->ewmaMs = tracker->samples + tracker->timeouts == 0 ? ms
+        : tracker->ewmaMs + EWMA_WEIGHT * ((double)ms - tracker->ewmaMs);
+    if (ms > tracker->maxMs) tracker->maxMs = ms;
+    tracker->p99Ms = Percentile99(tracker);
+}
+
+void SGSLrmLatency_Record(SGSLrmLatencyTracker* tracker, unsigned int latencyMs)
+{
+    Add(tracker, latencyMs);
+    tracker->samples++;
+}
+
+void SGSLrmLatency_RecordTimeout(SGSLrmLatencyTracker* tracker, unsigned int deadlineMs)
+{
+    Add(tracker, deadlineMs);
+    tracker->timeouts++;
+}
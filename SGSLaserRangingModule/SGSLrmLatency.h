@@ -0,0 +1,35 @@
+#pragma once
+
+// Internal response-latency tracker, one per device and command.
+// Keeps an EWMA and the 99th percentile over the last
+// SGS_LRM_LATENCY_WINDOW responses. Timeouts enter the window at the deadline
+// that expired, so a run of timeouts pushes p99 (and an adaptive deadline
+// derived from it) upwards instead of leaving it stuck too low.
+// Not thread-safe: the owner serialises access (the device state lock).
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define SGS_LRM_LATENCY_WINDOW  128
+
+typedef struct {
+    unsigned int window[SGS_LRM_LATENCY_WINDOW];   // Milliseconds, oldest overwritten first
+    int next;
+    int filled;
+    unsigned long samples;          // Responses timed
+    unsigned long timeouts;         // Deadlines that expired
+    double ewmaMs;
+    unsigned int maxMs;
+    unsigned int p99Ms;             // Recomputed on every record
+} SGSLrmLatencyTracker;
+
+void SGSLrmLatency_Init(SGSLrmLatencyTracker* tracker);
+
+void SGSLrmLatency_Record(SGSLrmLatencyTracker* tracker, unsigned int latencyMs);
+
+void SGSLrmLatency_RecordTimeout(SGSLrmLatencyTracker* tracker, unsigned int deadlineMs);
+
+#if defined(__cplusplus)
+}
+#endif
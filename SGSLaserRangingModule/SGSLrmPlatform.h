@@ -0,0 +1,314 @@
+﻿#pragma once
+
+// Internal platform layer.
+// The library was written against Win32; on POSIX targets this header maps the
+// small subset of Win32/CRT primitives the library uses (critical sections,
+// condition variables, Sleep, interlocked ops, the *_s string helpers) onto
+// pthreads/libc so the same source builds on both. Threads get a thin wrapper
+// because the two thread-procedure signatures cannot be shimmed directly.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+
+#include <windows.h>
+#include <malloc.h>
+
+typedef struct {
+    HANDLE handle;
+} SGSLrmThread;
+
+typedef DWORD (WINAPI* SGSLrmThreadProc)(LPVOID lpParam);
+
+static __inline bool SGSLrmThread_Start(SGSLrmThread* thread, SGSLrmThreadProc proc, LPVOID arg)
+{
+    thread->handle = CreateThread(NULL, 0, proc, arg, 0, NULL);
+    return thread->handle != NULL;
+}
+
+static __inline bool SGSLrmThread_IsStarted(const SGSLrmThread* thread)
+{
+    return thread->handle != NULL;
+}
+
+static __inline void SGSLrmThread_Join(SGSLrmThread* thread)
+{
+    if (thread->handle != NULL) {
+        WaitForSingleObject(thread->handle, INFINITE);
+        CloseHandle(thread->handle);
+        thread->handle = NULL;
+    }
+}
+
+static __inline bool SGSLrmThread_IsCurrent(const SGSLrmThread* thread)
+{
+    return thread->handle != NULL && GetThreadId(thread->handle) == GetCurrentThreadId();
+}
+
+// Lets the thread run on unjoined; it must free whatever it still uses.
+static __inline void SGSLrmThread_Detach(SGSLrmThread* thread)
+{
+    if (thread->handle != NULL) {
+        CloseHandle(thread->handle);
+        thread->handle = NULL;
+    }
+}
+
+// Monotonic millisecond clock
+static __inline unsigned long long SGSLrmClock_NowMs(void)
+{
+    return GetTickCount64();
+}
+
+// Microsecond clock for timing sub-millisecond work
+static __inline unsigned long long SGSLrmClock_NowUs(void)
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)(counter.QuadPart / frequency.QuadPart * 1000000ULL +
+        counter.QuadPart % frequency.QuadPart * 1000000ULL / frequency.QuadPart);
+}
+
+// Nanosecond clock for RX timestamps; free of NTP slewing
+static __inline unsigned long long SGSLrmClock_NowNs(void)
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)(counter.QuadPart / frequency.QuadPart * 1000000000ULL +
+        counter.QuadPart % frequency.QuadPart * 1000000000ULL / frequency.QuadPart);
+}
+
+// Cache-line aligned heap blocks (registry chunks)
+static __inline void* SGSLrmMemory_AllocAligned(size_t size, size_t alignment)
+{
+    return _aligned_malloc(size, alignment);
+}
+
+static __inline void SGSLrmMemory_FreeAligned(void* block)
+{
+    _aligned_free(block);
+}
+
+// Win32 condition variables hold no resources; the POSIX shim's do
+static __inline void DeleteConditionVariable(CONDITION_VARIABLE* cv) { (void)cv; }
+
+// Fences for lock-free publication (seqlock readers/writers)
+static __inline void SGSLrmFence_Acquire(void) { MemoryBarrier(); }
+static __inline void SGSLrmFence_Release(void) { MemoryBarrier(); }
+
+#else // POSIX
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <stdint.h>
+
+typedef int32_t LONG;
+typedef uint32_t DWORD;
+typedef void* LPVOID;
+#define WINAPI
+
+// CRITICAL_SECTION is recursive on Windows; keep the same semantics.
+typedef pthread_mutex_t CRITICAL_SECTION;
+
+static inline void InitializeCriticalSection(CRITICAL_SECTION* cs)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(cs, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+static inline void DeleteCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_destroy(cs); }
+static inline void EnterCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_lock(cs); }
+static inline void LeaveCriticalSection(CRITICAL_SECTION* cs) { pthread_mutex_unlock(cs); }
+
+static inline void Sleep(DWORD ms)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static inline LONG InterlockedCompareExchange(volatile LONG* dest, LONG exchange, LONG comparand)
+{
+    return __sync_val_compare_and_swap(dest, comparand, exchange);
+}
+
+// CONDITION_VARIABLE, used with a CRITICAL_SECTION entered exactly once.
+// Timed waits run on CLOCK_MONOTONIC, as SGSLrmClock_NowMs does, so a wall
+// clock step (NTP, RTC sync) neither stretches nor cuts them short.
+typedef pthread_cond_t CONDITION_VARIABLE;
+#define INFINITE 0xFFFFFFFFu
+
+static inline void InitializeConditionVariable(CONDITION_VARIABLE* cv)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cv, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static inline void DeleteConditionVariable(CONDITION_VARIABLE* cv) { pthread_cond_destroy(cv); }
+static inline void WakeConditionVariable(CONDITION_VARIABLE* cv) { pthread_cond_signal(cv); }
+static inline void WakeAllConditionVariable(CONDITION_VARIABLE* cv) { pthread_cond_broadcast(cv); }
+
+// Returns false on timeout, like the Win32 call.
+static inline bool SleepConditionVariableCS(CONDITION_VARIABLE* cv, CRITICAL_SECTION* cs, DWORD ms)
+{
+    if (ms == INFINITE) {
+        return pthread_cond_wait(cv, cs) == 0;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += (time_t)(ms / 1000);
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(cv, cs, &ts) == 0;
+}
+
+#define ZeroMemory(p, n) memset((p), 0, (n))
+
+#ifndef _TRUNCATE
+#define _TRUNCATE ((size_t)-1)
+#endif
+
+// Truncates instead of failing; callers pass _TRUNCATE or a count below destSize.
+static inline int strncpy_s(char* dest, size_t destSize, const char* src, size_t count)
+{
+    if (!dest || destSize == 0) return EINVAL;
+    if (!src) { dest[0] = '\0'; return EINVAL; }
+    size_t n = strlen(src);
+    if (count != _TRUNCATE && count < n) n = count;
+    if (n >= destSize) n = destSize - 1;
+    memcpy(dest, src, n);
+    dest[n] = '\0';
+    return 0;
+}
+
+static inline int strcat_s(char* dest, size_t destSize, const char* src)
+{
+    size_t used = strnlen(dest, destSize);
+    size_t n = strlen(src);
+    if (used + n >= destSize) return ERANGE;
+    memcpy(dest + used, src, n + 1);
+    return 0;
+}
+
+#define sprintf_s snprintf
+
+static inline int fopen_s(FILE** file, const char* path, const char* mode)
+{
+    *file = fopen(path, mode);
+    return *file ? 0 : errno;
+}
+
+typedef DWORD (*SGSLrmThreadProc)(LPVOID lpParam);
+
+typedef struct {
+    pthread_t tid;
+    bool started;
+    SGSLrmThreadProc proc;
+    LPVOID arg;
+} SGSLrmThread;
+
+static inline void* SGSLrmThread_Trampoline(void* p)
+{
+    SGSLrmThread* thread = (SGSLrmThread*)p;
+    thread->proc(thread->arg);
+    return NULL;
+}
+
+// The SGSLrmThread must stay at a stable address until joined.
+static inline bool SGSLrmThread_Start(SGSLrmThread* thread, SGSLrmThreadProc proc, LPVOID arg)
+{
+    thread->proc = proc;
+    thread->arg = arg;
+    thread->started = pthread_create(&thread->tid, NULL, SGSLrmThread_Trampoline, thread) == 0;
+    return thread->started;
+}
+
+static inline bool SGSLrmThread_IsStarted(const SGSLrmThread* thread)
+{
+    return thread->started;
+}
+
+static inline void SGSLrmThread_Join(SGSLrmThread* thread)
+{
+    if (thread->started) {
+        pthread_join(thread->tid, NULL);
+        thread->started = false;
+    }
+}
+
+static inline bool SGSLrmThread_IsCurrent(const SGSLrmThread* thread)
+{
+    return thread->started && pthread_equal(thread->tid, pthread_self());
+}
+
+// Lets the thread run on unjoined; it must free whatever it still uses.
+static inline void SGSLrmThread_Detach(SGSLrmThread* thread)
+{
+    if (thread->started) {
+        pthread_detach(thread->tid);
+        thread->started = false;
+    }
+}
+
+// Monotonic millisecond clock
+static inline unsigned long long SGSLrmClock_NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000ULL + (unsigned long long)(ts.tv_nsec / 1000000L);
+}
+
+static inline unsigned long long SGSLrmClock_NowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)(ts.tv_nsec / 1000L);
+}
+
+// Nanosecond clock for RX timestamps; CLOCK_MONOTONIC_RAW is not slewed by NTP
+static inline unsigned long long SGSLrmClock_NowNs(void)
+{
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC_RAW)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+// Cache-line aligned heap blocks (registry chunks)
+static inline void* SGSLrmMemory_AllocAligned(size_t size, size_t alignment)
+{
+    void* block = NULL;
+    return posix_memalign(&block, alignment, size) == 0 ? block : NULL;
+}
+
+static inline void SGSLrmMemory_FreeAligned(void* block)
+{
+    free(block);
+}
+
+// Fences for lock-free publication (seqlock readers/writers)
+static inline void SGSLrmFence_Acquire(void) { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+static inline void SGSLrmFence_Release(void) { __atomic_thread_fence(__ATOMIC_RELEASE); }
+
+#endif
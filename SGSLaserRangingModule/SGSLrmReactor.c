@@ -0,0 +1,417 @@
+﻿#include "SGSLrmReactor.h"
+
+#if !defined(_WIN32)
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define REACTOR_MAX_EVENTS  16
+
+// Reactor state. lock protects the source list and the dispatch marker;
+// lifecycle serialises starting/stopping the thread (never taken by the
+// reactor thread itself, so Unregister can join while holding it).
+// Callbacks run with lock released, so they may call back into the library.
+typedef struct {
+    CRITICAL_SECTION lock;
+    CRITICAL_SECTION lifecycle;
+    CONDITION_VARIABLE dispatchDone;
+    SGSLrmReactorSource* sources;
+    SGSLrmReactorSource* dispatching;   // Source whose callback is running now
+    SGSLrmThread thread;
+    bool running;
+    bool stopping;
+#if defined(_WIN32)
+    HANDLE completionPort;              // Kept for the process lifetime: a handle can only ever be associated with one port
+#else
+    int epollFd;
+    int wakeFds[2];                     // Self-pipe that interrupts epoll_wait
+#endif
+} SGSLrmReactorState;
+
+static SGSLrmReactorState g_reactor;
+static volatile LONG g_reactorInitOnceFlag = 0;
+static volatile bool g_reactorInitialized = false;
+static bool g_reactorBackendReady = false;
+
+static void InitializeReactor(void)
+{
+    if (InterlockedCompareExchange(&g_reactorInitOnceFlag, 1, 0) != 0) {
+        while (!g_reactorInitialized) Sleep(0);
+        return;
+    }
+
+    ZeroMemory(&g_reactor, sizeof(g_reactor));
+    InitializeCriticalSection(&g_reactor.lock);
+    InitializeCriticalSection(&g_reactor.lifecycle);
+    InitializeConditionVariable(&g_reactor.dispatchDone);
+
+#if defined(_WIN32)
+    g_reactor.completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    g_reactorBackendReady = g_reactor.completionPort != NULL;
+#else
+    g_reactor.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    g_reactor.wakeFds[0] = g_reactor.wakeFds[1] = -1;
+    if (g_reactor.epollFd >= 0 && pipe(g_reactor.wakeFds) == 0) {
+        fcntl(g_reactor.wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(g_reactor.wakeFds[1], F_SETFL, O_NONBLOCK);
+        fcntl(g_reactor.wakeFds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(g_reactor.wakeFds[1], F_SETFD, FD_CLOEXEC);
+        struct epoll_event ev = { 0 };
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL; // NULL marks the wake pipe
+        g_reactorBackendReady = epoll_ctl(g_reactor.epollFd, EPOLL_CTL_ADD, g_reactor.wakeFds[0], &ev) == 0;
+    }
+#endif
+
+    g_reactorInitialized = true;
+}
+
+// Interrupts the reactor's wait so it re-reads the source list / stop flag.
+static void WakeReactor(void)
+{
+#if defined(_WIN32)
+    PostQueuedCompletionStatus(g_reactor.completionPort, 0, 0, NULL);
+#else
+    unsigned char b = 1;
+    ssize_t rc = write(g_reactor.wakeFds[1], &b, 1);
+    (void)rc; // A full pipe already guarantees a wake-up
+#endif
+}
+
+// Runs a source callback with lock released. Called and returns with lock held.
+static void Dispatch(SGSLrmReactorSource* source, const unsigned char* data, int length, unsigned long long arrivalNs)
+{
+    g_reactor.dispatching = source;
+    LeaveCriticalSection(&g_reactor.lock);
+
+    if (length > 0) {
+        source->onData(source->context, data, length, arrivalNs);
+    } else if (source->onIdle) {
+        source->onIdle(source->context);
+    }
+
+    EnterCriticalSection(&g_reactor.lock);
+    g_reactor.dispatching = NULL;
+    WakeAllConditionVariable(&g_reactor.dispatchDone);
+}
+
+// Milliseconds until the earliest idle deadline, or -1 when none is armed.
+static long long NextIdleTimeoutMs(unsigned long long now)
+{
+    long long best = -1;
+    for (SGSLrmReactorSource* s = g_reactor.sources; s; s = s->next) {
+        if (!s->onIdle || s->idleTimeoutMs == 0) continue;
+        long long due = (long long)(s->lastActivityMs + s->idleTimeoutMs) - (long long)now;
+        if (due < 0) due = 0;
+        if (best < 0 || due < best) best = due;
+    }
+    return best;
+}
+
+static void DispatchIdleSources(void)
+{
+    unsigned long long now = SGSLrmClock_NowMs();
+    SGSLrmReactorSource* s = g_reactor.sources;
+    while (s) {
+        if (s->onIdle && s->idleTimeoutMs != 0 && now - s->lastActivityMs >= s->idleTimeoutMs) {
+            s->lastActivityMs = now; // Re-arm: fires once per silent period
+            Dispatch(s, NULL, 0, 0);
+            s = g_reactor.sources;   // The list may have changed while unlocked
+            continue;
+        }
+        s = s->next;
+    }
+}
+
+#if defined(_WIN32)
+
+// ===== IOCP backend: one overlapped ReadFile outstanding per source =====
+
+static bool IssueRead(SGSLrmReactorSource* source)
+{
+    ZeroMemory(&source->overlapped, sizeof(source->overlapped));
+    source->readPending = true;
+    if (!ReadFile((HANDLE)source->transport->native, source->buffer, sizeof(source->buffer), NULL, &source->overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+        source->readPending = false;
+        return false;
+    }
+    return true;
+}
+
+static SGSLrmStatus BackendAdd(SGSLrmReactorSource* source)
+{
+    HANDLE hPort = (HANDLE)source->transport->native;
+    // Fails with ERROR_INVALID_PARAMETER when the handle is already associated
+    // (a previous streaming session on the same open port); that is fine.
+    if (CreateIoCompletionPort(hPort, g_reactor.completionPort, 0, 0) == NULL &&
+        GetLastError() != ERROR_INVALID_PARAMETER) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    if (source->readPending) {
+        // Completion of a cancelled read from the previous session is still
+        // queued; the reactor re-issues the read when it dequeues it.
+        return SGS_LRM_SUCCESS;
+    }
+    return IssueRead(source) ? SGS_LRM_SUCCESS : SGS_LRM_COMMUNICATION_ERROR;
+}
+
+static void BackendRemove(SGSLrmReactorSource* source)
+{
+    if (source->readPending) {
+        CancelIoEx((HANDLE)source->transport->native, &source->overlapped);
+    }
+}
+
+static bool BackendBusy(const SGSLrmReactorSource* source)
+{
+    return source->readPending;
+}
+
+static void ReactorWait(DWORD timeoutMs)
+{
+    DWORD transferred = 0;
+    ULONG_PTR key = 0;
+    OVERLAPPED* ov = NULL;
+
+    BOOL ok = GetQueuedCompletionStatus(g_reactor.completionPort, &transferred, &key, &ov, timeoutMs);
+    unsigned long long arrivalNs = SGSLrmClock_NowNs();
+    DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+    EnterCriticalSection(&g_reactor.lock);
+    if (ov == NULL) {
+        return; // Wake-up or timeout
+    }
+
+    SGSLrmReactorSource* source = CONTAINING_RECORD(ov, SGSLrmReactorSource, overlapped);
+    source->readPending = false;
+    if (!source->registered) {
+        WakeAllConditionVariable(&g_reactor.dispatchDone);
+        return;
+    }
+
+    if (ok && transferred > 0) {
+        source->lastActivityMs = SGSLrmClock_NowMs();
+        Dispatch(source, source->buffer, (int)transferred, arrivalNs);
+    }
+    // A zero-byte completion is the COMMTIMEOUTS total timeout on a silent line;
+    // an aborted one is a read cancelled by an earlier Unregister of this source.
+    if (source->registered && !source->readPending && (ok || error == ERROR_OPERATION_ABORTED)) {
+        IssueRead(source);
+    }
+}
+
+#else
+
+// ===== epoll backend: level-triggered readability on the tty descriptors =====
+
+static SGSLrmStatus BackendAdd(SGSLrmReactorSource* source)
+{
+    struct epoll_event ev = { 0 };
+    ev.events = EPOLLIN;
+    ev.data.ptr = source;
+    if (epoll_ctl(g_reactor.epollFd, EPOLL_CTL_ADD, (int)source->transport->native, &ev) != 0) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    return SGS_LRM_SUCCESS;
+}
+
+static void BackendRemove(SGSLrmReactorSource* source)
+{
+    epoll_ctl(g_reactor.epollFd, EPOLL_CTL_DEL, (int)source->transport->native, NULL);
+}
+
+static bool BackendBusy(const SGSLrmReactorSource* source)
+{
+    (void)source;
+    return false;
+}
+
+static void ReactorWait(DWORD timeoutMs)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    int n = epoll_wait(g_reactor.epollFd, events, REACTOR_MAX_EVENTS, timeoutMs == INFINITE ? -1 : (int)timeoutMs);
+
+    EnterCriticalSection(&g_reactor.lock);
+    for (int i = 0; i < n; ++i) {
+        SGSLrmReactorSource* source = (SGSLrmReactorSource*)events[i].data.ptr;
+        if (source == NULL) {
+            unsigned char drain[16];
+            while (read(g_reactor.wakeFds[0], drain, sizeof(drain)) > 0) {
+            }
+            continue;
+        }
+        if (!source->registered) {
+            continue; // Unregistered by an earlier callback in this batch
+        }
+
+        unsigned char buffer[SGS_LRM_REACTOR_BUFFER_SIZE];
+        ssize_t got = read((int)source->transport->native, buffer, sizeof(buffer));
+        if (got > 0) {
+            unsigned long long arrivalNs = SGSLrmClock_NowNs();
+            source->lastActivityMs = SGSLrmClock_NowMs();
+            Dispatch(source, buffer, (int)got, arrivalNs);
+        } else if (got == 0 || (errno != EAGAIN && errno != EINTR)) {
+            // Hang-up or device error: stop polling the descriptor so a dead
+            // port does not spin; the source keeps getting idle callbacks.
+            BackendRemove(source);
+        }
+    }
+}
+
+#endif
+
+static DWORD WINAPI ReactorThread(LPVOID lpParam)
+{
+    (void)lpParam;
+
+    EnterCriticalSection(&g_reactor.lock);
+    while (!g_reactor.stopping) {
+        long long timeout = NextIdleTimeoutMs(SGSLrmClock_NowMs());
+        LeaveCriticalSection(&g_reactor.lock);
+
+        ReactorWait(timeout < 0 ? INFINITE : (DWORD)timeout); // returns with lock held
+        if (g_reactor.stopping) break;
+        DispatchIdleSources();
+    }
+    LeaveCriticalSection(&g_reactor.lock);
+    return 0;
+}
+
+SGSLrmStatus SGSLrmReactor_Register(SGSLrmReactorSource* source)
+{
+    if (!source || !source->transport || !source->onData || !SGSLrmTransport_IsOpen(source->transport)) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+
+    InitializeReactor();
+    if (!g_reactorBackendReady) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    bool onReactorThread = SGSLrmThread_IsCurrent(&g_reactor.thread);
+    if (!onReactorThread) EnterCriticalSection(&g_reactor.lifecycle);
+    EnterCriticalSection(&g_reactor.lock);
+
+    SGSLrmStatus status = SGS_LRM_SUCCESS;
+    if (source->registered) {
+        status = SGS_LRM_INVALID_PARAMETER;
+        goto cleanup;
+    }
+
+    if (!g_reactor.running) {
+        g_reactor.stopping = false;
+        if (!SGSLrmThread_Start(&g_reactor.thread, ReactorThread, NULL)) {
+            status = SGS_LRM_COMMUNICATION_ERROR;
+            goto cleanup;
+        }
+        g_reactor.running = true;
+    }
+
+    source->lastActivityMs = SGSLrmClock_NowMs();
+    source->registered = true;
+    status = BackendAdd(source);
+    if (status != SGS_LRM_SUCCESS) {
+        source->registered = false;
+        goto cleanup;
+    }
+
+    source->next = g_reactor.sources;
+    g_reactor.sources = source;
+    WakeReactor(); // Recompute the idle timeout
+
+cleanup:
+    LeaveCriticalSection(&g_reactor.lock);
+    if (!onReactorThread) LeaveCriticalSection(&g_reactor.lifecycle);
+    return status;
+}
+
+void SGSLrmReactor_Unregister(SGSLrmReactorSource* source)
+{
+    if (!source || !g_reactorInitialized) {
+        return;
+    }
+
+    bool onReactorThread = SGSLrmThread_IsCurrent(&g_reactor.thread);
+    if (!onReactorThread) EnterCriticalSection(&g_reactor.lifecycle);
+    EnterCriticalSection(&g_reactor.lock);
+
+    if (source->registered) {
+        source->registered = false;
+        for (SGSLrmReactorSource** link = &g_reactor.sources; *link; link = &(*link)->next) {
+            if (*link == source) {
+                *link = source->next;
+                break;
+            }
+        }
+        source->next = NULL;
+        BackendRemove(source);
+
+        // Wait out a callback in flight (and, on Win32, the cancelled read)
+        // so the caller may close the port or free the context afterwards.
+        if (!onReactorThread) {
+            while (g_reactor.dispatching == source || BackendBusy(source)) {
+                SleepConditionVariableCS(&g_reactor.dispatchDone, &g_reactor.lock, INFINITE);
+            }
+        }
+    }
+
+    bool stopThread = !onReactorThread && g_reactor.running && g_reactor.sources == NULL;
+    if (stopThread) {
+        g_reactor.stopping = true;
+        WakeReactor();
+    }
+    LeaveCriticalSection(&g_reactor.lock);
+
+    if (stopThread) {
+        SGSLrmThread_Join(&g_reactor.thread);
+        EnterCriticalSection(&g_reactor.lock);
+        g_reactor.running = false;
+        g_reactor.stopping = false;
+        LeaveCriticalSection(&g_reactor.lock);
+    }
+
+    if (!onReactorThread) LeaveCriticalSection(&g_reactor.lifecycle);
+}
+
+void SGSLrmReactor_SetIdleTimeout(SGSLrmReactorSource* source, unsigned int idleTimeoutMs)
+{
+    if (!source) {
+        return;
+    }
+    if (!g_reactorInitialized) {
+        source->idleTimeoutMs = idleTimeoutMs;
+        return;
+    }
+
+    EnterCriticalSection(&g_reactor.lock);
+    source->idleTimeoutMs = idleTimeoutMs;
+    if (source->registered) {
+        WakeReactor(); // Recompute the idle timeout
+    }
+    LeaveCriticalSection(&g_reactor.lock);
+}
+
+void SGSLrmReactor_WaitDispatch(SGSLrmReactorSource* source)
+{
+    if (!source || !g_reactorInitialized || SGSLrmThread_IsCurrent(&g_reactor.thread)) {
+        return;
+    }
+
+    EnterCriticalSection(&g_reactor.lock);
+    while (g_reactor.dispatching == source) {
+        SleepConditionVariableCS(&g_reactor.dispatchDone, &g_reactor.lock, INFINITE);
+    }
+    LeaveCriticalSection(&g_reactor.lock);
+}
+
+int SGSLrmReactor_ThreadCount(void)
+{
+    if (!g_reactorInitialized) {
+        return 0;
+    }
+    EnterCriticalSection(&g_reactor.lock);
+    int count = g_reactor.running ? 1 : 0;
+    LeaveCriticalSection(&g_reactor.lock);
+    return count;
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+
+// Internal I/O reactor.
+// One thread services the receive side of every registered port: epoll on
+// Linux, overlapped ReadFile + an I/O completion port on Windows. Bytes are
+// handed to the source's onData as soon as the driver delivers them, stamped
+// with SGSLrmClock_NowNs() taken the moment the read completed; onIdle
+// fires when a source has been silent for idleTimeoutMs. Both run on the
+// reactor thread, so they must not block.
+//
+// The thread is started by the first registration and stopped when the last
+// source unregisters. Sources are embedded in their owner (no allocation) and
+// must stay registered only while their transport is open.
+
+#include "SGSLrmTransport.h"
+#include "SGSLrmPlatform.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define SGS_LRM_REACTOR_BUFFER_SIZE 64
+
+typedef void (*SGSLrmReactorDataProc)(void* context, const unsigned char* data, int length, unsigned long long arrivalNs);
+typedef void (*SGSLrmReactorIdleProc)(void* context);
+
+typedef struct SGSLrmReactorSource {
+    SGSLrmTransport* transport;
+    SGSLrmReactorDataProc onData;
+    SGSLrmReactorIdleProc onIdle;
+    void* context;
+    unsigned int idleTimeoutMs;
+
+    // Reactor bookkeeping
+    struct SGSLrmReactorSource* next;
+    unsigned long long lastActivityMs;
+    volatile bool registered;
+#if defined(_WIN32)
+    OVERLAPPED overlapped;
+    volatile bool readPending;
+    unsigned char buffer[SGS_LRM_REACTOR_BUFFER_SIZE];
+#endif
+} SGSLrmReactorSource;
+
+// Starts delivering the transport's RX bytes to source->onData.
+SGSLrmStatus SGSLrmReactor_Register(SGSLrmReactorSource* source);
+
+// Stops delivery. On return no onData/onIdle for this source is running or
+// will run, unless called from inside one of them on the reactor thread.
+void SGSLrmReactor_Unregister(SGSLrmReactorSource* source);
+
+// Changes a source's idle period; a registered source re-arms with it at once.
+void SGSLrmReactor_SetIdleTimeout(SGSLrmReactorSource* source, unsigned int idleTimeoutMs);
+
+// Waits until no onData/onIdle for this source is running, leaving it
+// registered. Returns at once on the reactor thread.
+void SGSLrmReactor_WaitDispatch(SGSLrmReactorSource* source);
+
+// Number of threads the reactor currently runs (0 or 1); for diagnostics.
+int SGSLrmReactor_ThreadCount(void);
+
+#if defined(__cplusplus)
+}
+#endif
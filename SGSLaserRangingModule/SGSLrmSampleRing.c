@@ -0,0 +1,58 @@
+#include "SGSLrmSampleRing.h"
+#include "SGSLrmPlatform.h"
+#include <stddef.h>
+
+#define RING_MASK (SGS_LRM_SAMPLE_RING_CAPACITY - 1)
+
+// Compile-time layout checks (negative array size on failure; no
+// _Static_assert in MSVC's default C mode)
+#define RING_LAYOUT_CHECK(name, condition) typedef char name[(condition) ? 1 : -1]
+RING_LAYOUT_CHECK(HeadStartsALine, offsetof(SGSLrmSampleRing, head) == 0);
+RING_LAYOUT_CHECK(TailHasTheNextLine, offsetof(SGSLrmSampleRing, tail) == SGS_LRM_CACHE_LINE_SIZE);
+RING_LAYOUT_CHECK(SlotsStartALine, offsetof(SGSLrmSampleRing, slots) == 2 * SGS_LRM_CACHE_LINE_SIZE);
+
+void SGSLrmSampleRing_Init(SGSLrmSampleRing* ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->overflowCount = 0;
+}
+
+bool SGSLrmSampleRing_Push(SGSLrmSampleRing* ring, const SGSLrmSampleRecord* sample)
+{
+    unsigned int head = ring->head;
+    unsigned int tail = ring->tail;
+    SGSLrmFence_Acquire(); // The consumer is done with slots before tail
+
+    if (head - tail >= SGS_LRM_SAMPLE_RING_CAPACITY) {
+        ring->overflowCount++;
+        return false;
+    }
+
+    ring->slots[head & RING_MASK] = *sample;
+    SGSLrmFence_Release(); // Slot contents before the new head
+    ring->head = head + 1;
+    return true;
+}
+
+int SGSLrmSampleRing_PopBatch(SGSLrmSampleRing* ring, SGSLrmSampleRecord* buffer, int maxCount)
+{
+    unsigned int tail = ring->tail;
+    unsigned int head = ring->head;
+    SGSLrmFence_Acquire(); // Slots up to head are fully written
+
+    unsigned int available = head - tail;
+    unsigned int count = maxCount < 0 ? 0 : (unsigned int)maxCount;
+    if (count > available) count = available;
+
+    // At most two contiguous runs: up to the end of the array, then from 0
+    unsigned int start = tail & RING_MASK;
+    unsigned int first = SGS_LRM_SAMPLE_RING_CAPACITY - start;
+    if (first > count) first = count;
+    memcpy(buffer, &ring->slots[start], first * sizeof(SGSLrmSampleRecord));
+    memcpy(buffer + first, &ring->slots[0], (count - first) * sizeof(SGSLrmSampleRecord));
+
+    SGSLrmFence_Release(); // Done reading before the producer may reuse the slots
+    ring->tail = tail + count;
+    return (int)count;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Internal single-producer/single-consumer sample ring.
+// The producer is whoever publishes a measurement (always under the device
+// state lock, so there is one producer at a time); the consumer is the thread
+// calling SGSLrm_ReadSamples. Neither side takes a lock: head and tail are
+// owned by one side each and each starts its own cache line, wherever the
+// ring sits in its owner (the owner is aligned with it). When the ring is
+// full the newest sample is dropped and counted, so the producer never waits.
+
+#include "SGSLaserRangingModule.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define SGS_LRM_SAMPLE_RING_CAPACITY    256     // Power of two
+#define SGS_LRM_CACHE_LINE_SIZE         64
+
+#if defined(_MSC_VER)
+#define SGS_LRM_CACHE_ALIGNED           __declspec(align(SGS_LRM_CACHE_LINE_SIZE))
+#else
+#define SGS_LRM_CACHE_ALIGNED           __attribute__((aligned(SGS_LRM_CACHE_LINE_SIZE)))
+#endif
+
+// One published measurement as the ring holds it; SGSLrm_ReadSamples and
+// SGSLrm_ReadSamplesTenthMm each build their own layout from it.
+typedef struct {
+    unsigned long long sequence;
+    unsigned long long timestampMs;
+    int distanceTenthMm;                // Last successful distance when status is not SUCCESS
+    signed char status;                 // SGSLrmStatus; every code fits
+    unsigned char errorCode;            // 0..99
+    unsigned char resolution;           // SGSLrmResolution distanceTenthMm was reported at
+} SGSLrmSampleRecord;
+
+typedef struct {
+    // Producer side
+    SGS_LRM_CACHE_ALIGNED volatile unsigned int head;   // Next slot to write
+    unsigned long overflowCount;        // Samples dropped because the ring was full
+
+    // Consumer side
+    SGS_LRM_CACHE_ALIGNED volatile unsigned int tail;   // Next slot to read
+
+    SGS_LRM_CACHE_ALIGNED SGSLrmSampleRecord slots[SGS_LRM_SAMPLE_RING_CAPACITY];
+} SGSLrmSampleRing;
+
+// Only while neither side is active (handle creation).
+void SGSLrmSampleRing_Init(SGSLrmSampleRing* ring);
+
+// Producer: appends one sample; returns false (and counts it) when full.
+bool SGSLrmSampleRing_Push(SGSLrmSampleRing* ring, const SGSLrmSampleRecord* sample);
+
+// Consumer: moves up to maxCount of the oldest samples into buffer, returns how many.
+int SGSLrmSampleRing_PopBatch(SGSLrmSampleRing* ring, SGSLrmSampleRecord* buffer, int maxCount);
+
+#if defined(__cplusplus)
+}
+#endif
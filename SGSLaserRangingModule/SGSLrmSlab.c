@@ -0,0 +1,143 @@
+#include "SGSLrmSlab.h"
+#include <stdlib.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define INDEX_MASK          (((uintptr_t)1 << SGS_LRM_SLAB_INDEX_BITS) - 1)
+#define GENERATION_MASK     (UINTPTR_MAX >> SGS_LRM_SLAB_INDEX_BITS)   // 44 bits on 64-bit builds, 12 on 32-bit
+
+// Index of the first record in chunk k
+static int ChunkBase(int k)
+{
+    return SGS_LRM_SLAB_FIRST_CHUNK * ((1 << k) - 1);
+}
+
+static int ChunkRecords(int k)
+{
+    return SGS_LRM_SLAB_FIRST_CHUNK << k;
+}
+
+// Chunk holding index: floor(log2(index / FIRST_CHUNK + 1))
+static int ChunkOf(int index)
+{
+    unsigned int v = (unsigned int)(index / SGS_LRM_SLAB_FIRST_CHUNK + 1);
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanReverse(&bit, v);
+    return (int)bit;
+#else
+    return 31 - __builtin_clz(v);
+#endif
+}
+
+static uintptr_t MakeToken(int index, uintptr_t generation)
+{
+    return (generation << SGS_LRM_SLAB_INDEX_BITS) | (uintptr_t)index;
+}
+
+void SGSLrmSlab_Init(SGSLrmSlab* slab, size_t recordSize, SGSLrmSlabRecordProc construct, SGSLrmSlabRecordProc destruct)
+{
+    memset(slab, 0, sizeof(*slab));
+    slab->stride = (recordSize + SGS_LRM_CACHE_LINE_SIZE - 1) / SGS_LRM_CACHE_LINE_SIZE * SGS_LRM_CACHE_LINE_SIZE;
+    slab->construct = construct;
+    slab->destruct = destruct;
+    slab->freeHead = -1;
+}
+
+void SGSLrmSlab_Destroy(SGSLrmSlab* slab)
+{
+    int chunkCount = (int)slab->chunkCount;
+    slab->chunkCount = 0; // Nothing resolves from here on
+    for (int k = 0; k < chunkCount; ++k) {
+        if (slab->destruct) {
+            for (int i = 0; i < ChunkRecords(k); ++i) {
+                slab->destruct(slab->chunks[k] + (size_t)i * slab->stride);
+            }
+        }
+        SGSLrmMemory_FreeAligned(slab->chunks[k]);
+        free(slab->slots[k]);
+        slab->chunks[k] = NULL;
+        slab->slots[k] = NULL;
+    }
+    slab->freeHead = -1;
+    slab->used = 0;
+}
+
+// Adds the next chunk and puts its records on the free list, lowest index first
+static bool AddChunk(SGSLrmSlab* slab)
+{
+    int k = (int)slab->chunkCount;
+    if (k == SGS_LRM_SLAB_MAX_CHUNKS) return false;
+
+    int records = ChunkRecords(k);
+    unsigned char* chunk = (unsigned char*)SGSLrmMemory_AllocAligned((size_t)records * slab->stride, SGS_LRM_CACHE_LINE_SIZE);
+    SGSLrmSlabSlot* slots = (SGSLrmSlabSlot*)malloc((size_t)records * sizeof(SGSLrmSlabSlot));
+    if (!chunk || !slots) {
+        if (chunk) SGSLrmMemory_FreeAligned(chunk);
+        free(slots);
+        return false;
+    }
+
+    memset(chunk, 0, (size_t)records * slab->stride);
+    for (int i = 0; i < records; ++i) {
+        if (slab->construct) slab->construct(chunk + (size_t)i * slab->stride);
+        slots[i].next = i + 1 < records ? ChunkBase(k) + i + 1 : slab->freeHead;
+        slots[i].generation = 1;
+    }
+
+    slab->chunks[k] = chunk;
+    slab->slots[k] = slots;
+    slab->freeHead = ChunkBase(k);
+
+    // Lock-free readers see the count only once the chunk behind it is in place
+    SGSLrmFence_Release();
+    slab->chunkCount = k + 1;
+    return true;
+}
+
+void* SGSLrmSlab_Alloc(SGSLrmSlab* slab, uintptr_t* token)
+{
+    if (slab->freeHead < 0 && !AddChunk(slab)) {
+        return NULL;
+    }
+
+    int index = slab->freeHead;
+    int k = ChunkOf(index);
+    SGSLrmSlabSlot* slot = &slab->slots[k][index - ChunkBase(k)];
+    slab->freeHead = slot->next;
+    slab->used++;
+
+    *token = MakeToken(index, slot->generation);
+    return slab->chunks[k] + (size_t)(index - ChunkBase(k)) * slab->stride;
+}
+
+bool SGSLrmSlab_Free(SGSLrmSlab* slab, uintptr_t token)
+{
+    if (!SGSLrmSlab_Resolve(slab, token)) return false;
+
+    int index = (int)(token & INDEX_MASK);
+    int k = ChunkOf(index);
+    SGSLrmSlabSlot* slot = &slab->slots[k][index - ChunkBase(k)];
+
+    // Retire the generation first: from here on token resolves to nothing
+    uintptr_t next = (slot->generation + 1) & GENERATION_MASK;
+    slot->generation = next ? next : 1;
+    slot->next = slab->freeHead;
+    slab->freeHead = index;
+    slab->used--;
+    return true;
+}
+
+void* SGSLrmSlab_Resolve(const SGSLrmSlab* slab, uintptr_t token)
+{
+    int index = (int)(token & INDEX_MASK);
+    int chunkCount = (int)slab->chunkCount;
+    SGSLrmFence_Acquire();
+    if (index >= ChunkBase(chunkCount)) return NULL;
+
+    int k = ChunkOf(index);
+    int offset = index - ChunkBase(k);
+    if (slab->slots[k][offset].generation != token >> SGS_LRM_SLAB_INDEX_BITS) return NULL;
+    return slab->chunks[k] + (size_t)offset * slab->stride;
+}
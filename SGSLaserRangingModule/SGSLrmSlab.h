@@ -0,0 +1,73 @@
+#pragma once
+
+// Internal growable record registry (device and bus pools).
+// Records live in chunks that are allocated on demand and never move. Chunk
+// k holds SGS_LRM_SLAB_FIRST_CHUNK << k records, so a handful of chunks
+// covers thousands of records and an index maps to its chunk with one bit
+// scan. Every record starts on its own cache line and its stride is rounded
+// up to whole lines, so locks in neighbouring records never share a line.
+// Free records are kept on a LIFO list of indices: Alloc and Free are O(1).
+//
+// Records are named by tokens: slot index in the low SGS_LRM_SLAB_INDEX_BITS,
+// the slot's generation above them. Free bumps the generation, so a token
+// for a freed record stops resolving at once and never resolves again, even
+// after the slot is reused. Tokens are never 0.
+//
+// Records are constructed once, when their chunk is added, and destructed in
+// SGSLrmSlab_Destroy; Free leaves a record's contents (and its locks) alone.
+// Alloc/Free are not thread-safe: the owner serialises them (the pool lock).
+// Resolve takes no lock and may run concurrently with Alloc and Free.
+
+#include "SGSLrmPlatform.h"
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define SGS_LRM_SLAB_FIRST_CHUNK    16      // Records in chunk 0; each further chunk doubles
+#define SGS_LRM_SLAB_MAX_CHUNKS     16      // 16 * (2^16 - 1) records at most
+#define SGS_LRM_SLAB_INDEX_BITS     20      // Enough for every index; the rest of a token is generation
+
+#ifndef SGS_LRM_CACHE_LINE_SIZE
+#define SGS_LRM_CACHE_LINE_SIZE     64
+#endif
+
+typedef void (*SGSLrmSlabRecordProc)(void* record);
+
+typedef struct {
+    int next;                               // Next free index, -1 ends the list
+    volatile uintptr_t generation;          // Current generation, never 0
+} SGSLrmSlabSlot;
+
+typedef struct {
+    size_t stride;                          // Record size rounded up to whole cache lines
+    SGSLrmSlabRecordProc construct;         // Once per record when its chunk is added
+    SGSLrmSlabRecordProc destruct;          // Once per record in SGSLrmSlab_Destroy
+    unsigned char* chunks[SGS_LRM_SLAB_MAX_CHUNKS];
+    SGSLrmSlabSlot* slots[SGS_LRM_SLAB_MAX_CHUNKS];
+    volatile LONG chunkCount;               // Published after the chunk it counts
+    int freeHead;                           // -1 when every record is allocated
+    int used;
+} SGSLrmSlab;
+
+void SGSLrmSlab_Init(SGSLrmSlab* slab, size_t recordSize, SGSLrmSlabRecordProc construct, SGSLrmSlabRecordProc destruct);
+
+// Destructs every record and releases the chunks.
+void SGSLrmSlab_Destroy(SGSLrmSlab* slab);
+
+// Takes the most recently freed record, adding a chunk when none is free, and
+// stores its token. NULL when the chunk cannot be allocated or the slab is at
+// its limit.
+void* SGSLrmSlab_Alloc(SGSLrmSlab* slab, uintptr_t* token);
+
+// Retires token's generation and frees its record. False (and nothing done)
+// when the token no longer resolves.
+bool SGSLrmSlab_Free(SGSLrmSlab* slab, uintptr_t token);
+
+// Record named by token, or NULL when the token is stale or was never issued.
+void* SGSLrmSlab_Resolve(const SGSLrmSlab* slab, uintptr_t token);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,50 @@
+#include "SGSLrmTiming.h"
+#include <string.h>
+#include <math.h>
+
+void SGSLrmTiming_Init(SGSLrmTimingTracker* tracker)
+{
+    memset(tracker, 0, sizeof(*tracker));
+}
+
+void SGSLrmTiming_RecordFrame(SGSLrmTimingTracker* tracker, unsigned long long firstByteNs, unsigned long long lastByteNs)
+{
+    tracker->frames++;
+
+    unsigned long long transferNs = lastByteNs - firstByteNs;
+    tracker->transferSumNs += (double)transferNs;
+    if (transferNs > tracker->maxTransferNs) tracker->maxTransferNs = transferNs;
+
+    if (tracker->previousNs != 0 && lastByteNs >= tracker->previousNs) {
+        unsigned long long intervalNs = lastByteNs - tracker->previousNs;
+        tracker->intervals++;
+        double delta = (double)intervalNs - tracker->meanNs;
+        tracker->meanNs += delta / (double)tracker->intervals;
+        tracker->m2Ns += delta * ((double)intervalNs - tracker->meanNs);
+        if (tracker->intervals == 1 || intervalNs < tracker->minNs) tracker->minNs = intervalNs;
+        if (intervalNs > tracker->maxNs) tracker->maxNs = intervalNs;
+    }
+    tracker->previousNs = lastByteNs;
+}
+
+void SGSLrmTiming_Break(SGSLrmTimingTracker* tracker)
+{
+    tracker->previousNs = 0;
+}
+
+void SGSLrmTiming_GetStats(const SGSLrmTimingTracker* tracker, SGSLrmTimingStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->frames = tracker->frames;
+    stats->intervals = tracker->intervals;
+    if (tracker->intervals > 0) {
+        stats->meanIntervalUs = tracker->meanNs / 1000.0;
+        stats->jitterUs = tracker->intervals > 1 ? sqrt(tracker->m2Ns / (double)(tracker->intervals - 1)) / 1000.0 : 0.0;
+        stats->minIntervalUs = (double)tracker->minNs / 1000.0;
+        stats->maxIntervalUs = (double)tracker->maxNs / 1000.0;
+    }
+    if (tracker->frames > 0) {
+        stats->meanTransferUs = tracker->transferSumNs / (double)tracker->frames / 1000.0;
+        stats->maxTransferUs = (double)tracker->maxTransferNs / 1000.0;
+    }
+}
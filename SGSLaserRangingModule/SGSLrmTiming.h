@@ -0,0 +1,39 @@
+#pragma once
+
+// Internal RX timing tracker, one per device.
+// Fed the first-byte and checksum-byte stamps of every streamed frame; keeps
+// the frame-to-frame interval (Welford mean/variance, min, max) and the time
+// each frame took to come in. A dropout breaks the chain, so the gap it
+// leaves is not counted as one long interval.
+// Not thread-safe: the owner serialises access (the device state lock).
+
+#include "SGSLaserRangingModule.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned long frames;
+    unsigned long intervals;
+    unsigned long long previousNs;  // Checksum byte of the previous frame; 0 after a break
+    double meanNs;
+    double m2Ns;                    // Sum of squared deviations from meanNs
+    unsigned long long minNs;
+    unsigned long long maxNs;
+    double transferSumNs;
+    unsigned long long maxTransferNs;
+} SGSLrmTimingTracker;
+
+void SGSLrmTiming_Init(SGSLrmTimingTracker* tracker);
+
+void SGSLrmTiming_RecordFrame(SGSLrmTimingTracker* tracker, unsigned long long firstByteNs, unsigned long long lastByteNs);
+
+// A sample went missing: the next frame starts a new chain.
+void SGSLrmTiming_Break(SGSLrmTimingTracker* tracker);
+
+void SGSLrmTiming_GetStats(const SGSLrmTimingTracker* tracker, SGSLrmTimingStats* stats);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,107 @@
+#include "SGSLrmTracker.h"
+#include <string.h>
+#include <math.h>
+
+#define INITIAL_VELOCITY_STDDEV 10.0    // m/s; anything a conveyor or crane does is well inside
+
+void SGSLrmTracker_Init(SGSLrmTracker* tracker, const SGSLrmTrackerConfig* config)
+{
+    memset(tracker, 0, sizeof(*tracker));
+    if (config) {
+        tracker->config = *config;
+        tracker->enabled = true;
+    }
+}
+
+SGSLrmStatus SGSLrmTracker_Validate(const SGSLrmTrackerConfig* config)
+{
+    if (!(config->measurementNoiseM > 0.0) || !(config->accelerationNoise > 0.0) ||
+        config->maxCoastMs < 1 || config->maxCoastMs > 60000) {
+        return SGS_LRM_INVALID_PARAMETER;
+    }
+    return SGS_LRM_SUCCESS;
+}
+
+static bool Expired(const SGSLrmTracker* tracker, unsigned long long nowNs)
+{
+    return nowNs > tracker->timeNs && nowNs - tracker->timeNs > (unsigned long long)tracker->config.maxCoastMs * 1000000ULL;
+}
+
+// Time update: state and covariance carried forward by dt seconds
+static void Propagate(const SGSLrmTracker* tracker, double dt, double* distance, double* p00, double* p01, double* p11)
+{
+    double q = tracker->config.accelerationNoise * tracker->config.accelerationNoise;
+    double dt2 = dt * dt;
+    *distance = tracker->distance + dt * tracker->velocity;
+    *p00 = tracker->p00 + 2.0 * dt * tracker->p01 + dt2 * tracker->p11 + q * dt2 * dt2 / 4.0;
+    *p01 = tracker->p01 + dt * tracker->p11 + q * dt2 * dt / 2.0;
+    *p11 = tracker->p11 + q * dt2;
+}
+
+void SGSLrmTracker_Update(SGSLrmTracker* tracker, double distance, unsigned long long timeNs, unsigned long long sequence)
+{
+    double r = tracker->config.measurementNoiseM * tracker->config.measurementNoiseM;
+    if (!tracker->tracking || Expired(tracker, timeNs)) {
+        tracker->tracking = true;
+        tracker->timeNs = timeNs;
+        tracker->distance = distance;
+        tracker->velocity = 0.0;
+        tracker->p00 = r;
+        tracker->p01 = 0.0;
+        tracker->p11 = INITIAL_VELOCITY_STDDEV * INITIAL_VELOCITY_STDDEV;
+        tracker->innovation = 0.0;
+        tracker->sequence = sequence;
+        tracker->updates = 1;
+        return;
+    }
+
+    // A frame stamped no later than the last one is folded in at the same instant
+    double dt = timeNs > tracker->timeNs ? (double)(timeNs - tracker->timeNs) / 1e9 : 0.0;
+    double predicted, p00, p01, p11;
+    Propagate(tracker, dt, &predicted, &p00, &p01, &p11);
+
+    double innovation = distance - predicted;
+    double s = p00 + r;
+    double k0 = p00 / s;
+    double k1 = p01 / s;
+
+    tracker->distance = predicted + k0 * innovation;
+    tracker->velocity += k1 * innovation;
+    tracker->p00 = (1.0 - k0) * p00;
+    tracker->p01 = (1.0 - k0) * p01;
+    tracker->p11 = p11 - k1 * p01;
+    tracker->innovation = innovation;
+    if (timeNs > tracker->timeNs) tracker->timeNs = timeNs;
+    tracker->sequence = sequence;
+    tracker->updates++;
+}
+
+void SGSLrmTracker_Dropout(SGSLrmTracker* tracker, unsigned long long nowNs)
+{
+    tracker->dropouts++;
+    if (tracker->tracking && Expired(tracker, nowNs)) {
+        tracker->tracking = false;
+    }
+}
+
+SGSLrmStatus SGSLrmTracker_Predict(const SGSLrmTracker* tracker, unsigned long long atNs, SGSLrmTrackState* state)
+{
+    if (!tracker->tracking || Expired(tracker, atNs)) {
+        return SGS_LRM_NO_TRACK;
+    }
+
+    double dt = atNs > tracker->timeNs ? (double)(atNs - tracker->timeNs) / 1e9 : 0.0;
+    double distance, p00, p01, p11;
+    Propagate(tracker, dt, &distance, &p00, &p01, &p11);
+
+    state->timeNs = atNs > tracker->timeNs ? atNs : tracker->timeNs;
+    state->distance = distance;
+    state->velocity = tracker->velocity;
+    state->distanceStdDev = sqrt(p00);
+    state->velocityStdDev = sqrt(p11);
+    state->innovation = tracker->innovation;
+    state->sequence = tracker->sequence;
+    state->updates = tracker->updates;
+    state->dropouts = tracker->dropouts;
+    return SGS_LRM_SUCCESS;
+}
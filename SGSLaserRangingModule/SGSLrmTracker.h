@@ -0,0 +1,52 @@
+#pragma once
+
+// Internal per-device constant-velocity Kalman tracker.
+// State is distance (m) and velocity (m/s) with a 2x2 covariance. Readings
+// are placed in time by their checksum-byte RX stamp, so dt is the real gap
+// between frames rather than the nominal rate. Unmodelled acceleration enters
+// as discrete white noise (Q = sigma^2 [dt^4/4 dt^3/2; dt^3/2 dt^2]). A track
+// starts at the first reading with zero velocity and a wide velocity
+// variance. Dropouts (ERR frames, TIMEOUT samples) leave the state to coast;
+// one older than maxCoastMs ends the track and the next reading starts over.
+// Not thread-safe: the owner serialises access (the device state lock).
+
+#include "SGSLaserRangingModule.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct {
+    SGSLrmTrackerConfig config;
+    bool enabled;
+    bool tracking;
+    unsigned long long timeNs;      // Instant the state is for (last update)
+    double distance;
+    double velocity;
+    double p00, p01, p11;           // Covariance (symmetric)
+    double innovation;              // Last reading minus its prediction
+    unsigned long long sequence;    // Sample of the last update
+    unsigned long updates;          // Since the track started
+    unsigned long dropouts;         // Since SetTracker
+} SGSLrmTracker;
+
+// config already validated (SGSLrmTracker_Validate); NULL turns tracking off.
+void SGSLrmTracker_Init(SGSLrmTracker* tracker, const SGSLrmTrackerConfig* config);
+
+// SGS_LRM_INVALID_PARAMETER for a non-positive noise or maxCoastMs out of 1..60000.
+SGSLrmStatus SGSLrmTracker_Validate(const SGSLrmTrackerConfig* config);
+
+// Folds in a reading (metres) stamped timeNs.
+void SGSLrmTracker_Update(SGSLrmTracker* tracker, double distance, unsigned long long timeNs, unsigned long long sequence);
+
+// A sample that should have been a reading was not; nowNs ends the track if
+// it has coasted too long.
+void SGSLrmTracker_Dropout(SGSLrmTracker* tracker, unsigned long long nowNs);
+
+// The state propagated to atNs (earlier instants give the last update).
+// SGS_LRM_NO_TRACK when there is none or it has coasted past maxCoastMs.
+SGSLrmStatus SGSLrmTracker_Predict(const SGSLrmTracker* tracker, unsigned long long atNs, SGSLrmTrackState* state);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,512 @@
+﻿#include "SGSLrmTransport.h"
+#include "SGSLrmPlatform.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+void SGSLrmTransport_Init(SGSLrmTransport* transport, const SGSLrmTransportOps* ops)
+{
+    transport->ops = ops;
+    transport->native = SGS_LRM_TRANSPORT_INVALID;
+    transport->ioEvent = 0;
+    memset(&transport->timeouts, 0, sizeof(transport->timeouts));
+}
+
+// ===== Port enumeration =====
+
+#define MAX_LISTED_PORTS 256
+
+typedef struct {
+    char port[128];
+    char stableName[128];
+} SGSLrmPortEntry;
+
+static int ListPorts(SGSLrmPortEntry* entries, int maxEntries);
+
+// USB adapters first, then ACM, then on-board UARTs, as the old probe loop did
+static int PortRank(const char* port)
+{
+    if (strstr(port, "ttyUSB")) return 0;
+    if (strstr(port, "ttyACM")) return 1;
+    if (strstr(port, "ttyS")) return 3;
+    return 2;
+}
+
+// Length of port without its trailing number
+static size_t PrefixLength(const char* port)
+{
+    size_t n = strlen(port);
+    while (n > 0 && isdigit((unsigned char)port[n - 1])) --n;
+    return n;
+}
+
+static int ComparePorts(const void* a, const void* b)
+{
+    const char* x = ((const SGSLrmPortEntry*)a)->port;
+    const char* y = ((const SGSLrmPortEntry*)b)->port;
+
+    int rank = PortRank(x) - PortRank(y);
+    if (rank != 0) return rank;
+
+    size_t px = PrefixLength(x), py = PrefixLength(y);
+    int prefix = strncmp(x, y, px < py ? px : py);
+    if (prefix != 0 || px != py) return prefix != 0 ? prefix : (int)px - (int)py;
+
+    long nx = atol(x + px), ny = atol(y + py);
+    return nx < ny ? -1 : nx > ny;
+}
+
+void SGSLrmTransport_EnumPorts(SGSLrmPortVisitor visit, void* context)
+{
+    SGSLrmPortEntry* entries = (SGSLrmPortEntry*)malloc(MAX_LISTED_PORTS * sizeof(SGSLrmPortEntry));
+    if (!entries) return;
+
+    int count = ListPorts(entries, MAX_LISTED_PORTS);
+    qsort(entries, (size_t)count, sizeof(SGSLrmPortEntry), ComparePorts);
+    for (int i = 0; i < count; ++i) {
+        visit(entries[i].port, entries[i].stableName, context);
+    }
+    free(entries);
+}
+
+#if defined(_WIN32)
+
+// The serial port driver registers every port it creates here, Bluetooth and
+// virtual ones included; reading the key touches no device.
+static int ListPorts(SGSLrmPortEntry* entries, int maxEntries)
+{
+    HKEY key;
+    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "HARDWARE\\DEVICEMAP\\SERIALCOMM", 0, KEY_READ, &key) != ERROR_SUCCESS) {
+        return 0; // No serial ports at all
+    }
+
+    int count = 0;
+    for (DWORD i = 0; count < maxEntries; ++i) {
+        char valueName[256];
+        DWORD valueNameLength = sizeof(valueName);
+        BYTE data[64];
+        DWORD dataLength = sizeof(data) - 1;
+        DWORD type = 0;
+        LONG rc = RegEnumValueA(key, i, valueName, &valueNameLength, NULL, &type, data, &dataLength);
+        if (rc == ERROR_NO_MORE_ITEMS) break;
+        if (rc != ERROR_SUCCESS || type != REG_SZ) continue;
+
+        data[dataLength] = '\0';
+        strncpy_s(entries[count].port, sizeof(entries[count].port), (const char*)data, _TRUNCATE);
+        entries[count].stableName[0] = '\0';
+        count++;
+    }
+
+    RegCloseKey(key);
+    return count;
+}
+
+// ===== Win32 backend (CreateFileA / ReadFile / WriteFile) =====
+// The port is opened with FILE_FLAG_OVERLAPPED so the reactor can attach it to
+// its I/O completion port. Blocking reads/writes wait on ioEvent; the low bit
+// of hEvent keeps their completions out of the completion port.
+
+#define WIN32_PORT(t) ((HANDLE)(t)->native)
+
+static BOOL Win32_WaitIo(SGSLrmTransport* transport, BOOL started, OVERLAPPED* ov, DWORD* transferred)
+{
+    if (!started && GetLastError() != ERROR_IO_PENDING) {
+        return FALSE;
+    }
+    return GetOverlappedResult(WIN32_PORT(transport), ov, transferred, TRUE);
+}
+
+static SGSLrmStatus Win32_Open(SGSLrmTransport* transport, const char* portName)
+{
+    HANDLE hSerial = CreateFileA(portName,
+        GENERIC_READ | GENERIC_WRITE,
+        0,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+        NULL);
+
+    if (hSerial == INVALID_HANDLE_VALUE) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    HANDLE hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (hEvent == NULL) {
+        CloseHandle(hSerial);
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    // Configure COM port (9600, 8, N, 1)
+    DCB dcb = { 0 };
+    dcb.DCBlength = sizeof(DCB);
+    if (!GetCommState(hSerial, &dcb)) {
+        CloseHandle(hEvent);
+        CloseHandle(hSerial);
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    dcb.BaudRate = CBR_9600;
+    dcb.ByteSize = 8;
+    dcb.Parity = NOPARITY;
+    dcb.StopBits = ONESTOPBIT;
+    dcb.fBinary = TRUE;  // Binary mode is required
+    dcb.fParity = FALSE;  // No parity checking
+
+    if (!SetCommState(hSerial, &dcb)) {
+        CloseHandle(hEvent);
+        CloseHandle(hSerial);
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    transport->native = (intptr_t)hSerial;
+    transport->ioEvent = (intptr_t)hEvent;
+    return SGS_LRM_SUCCESS;
+}
+
+static void Win32_Close(SGSLrmTransport* transport)
+{
+    if (transport->native != SGS_LRM_TRANSPORT_INVALID) {
+        CloseHandle(WIN32_PORT(transport));
+        CloseHandle((HANDLE)transport->ioEvent);
+        transport->native = SGS_LRM_TRANSPORT_INVALID;
+        transport->ioEvent = 0;
+    }
+}
+
+static SGSLrmStatus Win32_Read(SGSLrmTransport* transport, unsigned char* buffer, int maxLength, int* bytesRead)
+{
+    OVERLAPPED ov = { 0 };
+    ov.hEvent = (HANDLE)(transport->ioEvent | 1);
+    DWORD got = 0;
+    BOOL started = ReadFile(WIN32_PORT(transport), buffer, (DWORD)maxLength, NULL, &ov);
+    if (!Win32_WaitIo(transport, started, &ov, &got)) {
+        *bytesRead = 0;
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    *bytesRead = (int)got;
+    return SGS_LRM_SUCCESS;
+}
+
+static SGSLrmStatus Win32_ReadWithin(SGSLrmTransport* transport, unsigned char* buffer, int maxLength, unsigned int timeoutMs, int* bytesRead)
+{
+    OVERLAPPED ov = { 0 };
+    ov.hEvent = (HANDLE)(transport->ioEvent | 1);
+    DWORD got = 0;
+    *bytesRead = 0;
+    if (!ReadFile(WIN32_PORT(transport), buffer, (DWORD)maxLength, NULL, &ov)) {
+        if (GetLastError() != ERROR_IO_PENDING) {
+            return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        if (WaitForSingleObject((HANDLE)transport->ioEvent, timeoutMs) == WAIT_TIMEOUT) {
+            CancelIoEx(WIN32_PORT(transport), &ov); // Completes the read with whatever arrived
+        }
+    }
+    if (!GetOverlappedResult(WIN32_PORT(transport), &ov, &got, TRUE) && GetLastError() != ERROR_OPERATION_ABORTED) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    *bytesRead = (int)got;
+    return SGS_LRM_SUCCESS;
+}
+
+static SGSLrmStatus Win32_Write(SGSLrmTransport* transport, const unsigned char* data, int length, int* bytesWritten)
+{
+    OVERLAPPED ov = { 0 };
+    ov.hEvent = (HANDLE)(transport->ioEvent | 1);
+    DWORD written = 0;
+    BOOL started = WriteFile(WIN32_PORT(transport), data, (DWORD)length, NULL, &ov);
+    if (!Win32_WaitIo(transport, started, &ov, &written)) {
+        *bytesWritten = 0;
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    *bytesWritten = (int)written;
+    return SGS_LRM_SUCCESS;
+}
+
+static SGSLrmStatus Win32_SetTimeouts(SGSLrmTransport* transport, const SGSLrmTransportTimeouts* t)
+{
+    COMMTIMEOUTS timeouts = { 0 };
+    timeouts.ReadIntervalTimeout = t->readIntervalMs;
+    timeouts.ReadTotalTimeoutConstant = t->readTotalConstantMs;
+    timeouts.ReadTotalTimeoutMultiplier = t->readTotalMultiplierMs;
+    if (t->readIntervalMs == SGS_LRM_READ_RETURN_ON_DATA) {
+        // Return immediately with whatever is buffered, or wait up to the constant for the first byte
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+    }
+    timeouts.WriteTotalTimeoutConstant = t->writeTotalConstantMs;
+    timeouts.WriteTotalTimeoutMultiplier = t->writeTotalMultiplierMs;
+
+    if (!SetCommTimeouts(WIN32_PORT(transport), &timeouts)) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    transport->timeouts = *t;
+    return SGS_LRM_SUCCESS;
+}
+
+const SGSLrmTransportOps g_sgsLrmWin32Transport = {
+    "win32",
+    Win32_Open,
+    Win32_Close,
+    Win32_Read,
+    Win32_ReadWithin,
+    Win32_Write,
+    Win32_SetTimeouts,
+};
+
+const SGSLrmTransportOps* SGSLrmTransport_Default(void)
+{
+    return &g_sgsLrmWin32Transport;
+}
+
+#else
+
+// ===== POSIX termios backend (/dev/ttyUSB*, /dev/ttyS*, ptys) =====
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
+#include <limits.h>
+
+#define TERMIOS_FD(t) ((int)(t)->native)
+
+// Last path component of a symlink target, e.g. "ttyUSB0" for "../../ttyUSB0"
+static const char* LinkBaseName(const char* path, char* target, size_t size)
+{
+    ssize_t n = readlink(path, target, size - 1);
+    if (n <= 0) return NULL;
+    target[n] = '\0';
+    const char* slash = strrchr(target, '/');
+    return slash ? slash + 1 : target;
+}
+
+// sysfs lists a tty under /sys/class/tty with a device link when hardware
+// backs it; virtual consoles and ptys have none. The 8250 driver registers
+// ttyS slots whether or not a UART is fitted, and those carry no other
+// driver.
+static int ListPorts(SGSLrmPortEntry* entries, int maxEntries)
+{
+    DIR* dir = opendir("/sys/class/tty");
+    if (!dir) return 0;
+
+    int count = 0;
+    struct dirent* entry;
+    while (count < maxEntries && (entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
+        if (name[0] == '.') continue;
+
+        char path[PATH_MAX], target[PATH_MAX];
+        snprintf(path, sizeof(path), "/sys/class/tty/%s/device", name);
+        if (access(path, F_OK) != 0) continue;
+
+        snprintf(path, sizeof(path), "/sys/class/tty/%s/device/driver", name);
+        const char* driver = LinkBaseName(path, target, sizeof(target));
+        if (driver && strcmp(driver, "serial8250") == 0) continue;
+
+        if (strlen(name) + 6 > sizeof(entries[count].port)) continue;
+        memcpy(entries[count].port, "/dev/", 5);
+        strncpy_s(entries[count].port + 5, sizeof(entries[count].port) - 5, name, _TRUNCATE);
+        if (access(entries[count].port, F_OK) != 0) continue;
+        entries[count].stableName[0] = '\0';
+        count++;
+    }
+    closedir(dir);
+
+    // udev's persistent names for USB adapters
+    dir = opendir("/dev/serial/by-id");
+    if (!dir) return count;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        char path[PATH_MAX], target[PATH_MAX];
+        snprintf(path, sizeof(path), "/dev/serial/by-id/%s", entry->d_name);
+        const char* base = LinkBaseName(path, target, sizeof(target));
+        if (!base) continue;
+
+        for (int i = 0; i < count; ++i) {
+            if (strcmp(entries[i].port + 5, base) == 0) { // Past "/dev/"
+                strncpy_s(entries[i].stableName, sizeof(entries[i].stableName), path, _TRUNCATE);
+                break;
+            }
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static SGSLrmStatus Termios_Open(SGSLrmTransport* transport, const char* portName)
+{
+    int fd = open(portName, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    // Same exclusivity as CreateFileA with share mode 0.
+#if defined(TIOCEXCL)
+    ioctl(fd, TIOCEXCL);
+#endif
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        close(fd);
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    // Configure tty (9600, 8, N, 1), raw mode
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B9600);
+    cfsetospeed(&tio, B9600);
+    tio.c_cflag &= ~(tcflag_t)(CSIZE | PARENB | CSTOPB);
+#if defined(CRTSCTS)
+    tio.c_cflag &= ~(tcflag_t)CRTSCTS;
+#endif
+    tio.c_cflag |= CS8 | CLOCAL | CREAD;
+    tio.c_iflag &= ~(tcflag_t)(IXON | IXOFF | IXANY);
+    // Reads are driven by poll(); never block inside read().
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        close(fd);
+        return SGS_LRM_COMMUNICATION_ERROR;
+    }
+    tcflush(fd, TCIOFLUSH);
+
+    transport->native = (intptr_t)fd;
+    return SGS_LRM_SUCCESS;
+}
+
+static void Termios_Close(SGSLrmTransport* transport)
+{
+    if (transport->native != SGS_LRM_TRANSPORT_INVALID) {
+        close(TERMIOS_FD(transport));
+        transport->native = SGS_LRM_TRANSPORT_INVALID;
+    }
+}
+
+// Emulates ReadFile under COMMTIMEOUTS: wait for the first byte up to the
+// total deadline, then keep collecting while bytes arrive within the interval.
+static SGSLrmStatus Termios_Read(SGSLrmTransport* transport, unsigned char* buffer, int maxLength, int* bytesRead)
+{
+    const SGSLrmTransportTimeouts* t = &transport->timeouts;
+    int fd = TERMIOS_FD(transport);
+    long long deadline = (long long)SGSLrmClock_NowMs() + t->readTotalConstantMs + (long long)t->readTotalMultiplierMs * maxLength;
+    int got = 0;
+
+    *bytesRead = 0;
+    while (got < maxLength) {
+        long long remaining = deadline - (long long)SGSLrmClock_NowMs();
+        if (remaining < 0) remaining = 0;
+        long long wait = remaining;
+        if (got > 0 && t->readIntervalMs > 0 && t->readIntervalMs < wait) {
+            wait = t->readIntervalMs;
+        }
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int rc = poll(&pfd, 1, (int)wait);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        if (rc == 0) break; // interval or total timeout
+        if (pfd.revents & (POLLERR | POLLNVAL)) return SGS_LRM_COMMUNICATION_ERROR;
+
+        ssize_t n = read(fd, buffer + got, (size_t)(maxLength - got));
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        if (n == 0) {
+            // POLLHUP with nothing buffered: peer went away
+            if (pfd.revents & POLLHUP) return got > 0 ? SGS_LRM_SUCCESS : SGS_LRM_COMMUNICATION_ERROR;
+            continue;
+        }
+        got += (int)n;
+        *bytesRead = got;
+        if (t->readIntervalMs == SGS_LRM_READ_RETURN_ON_DATA) break;
+    }
+    return SGS_LRM_SUCCESS;
+}
+
+static SGSLrmStatus Termios_ReadWithin(SGSLrmTransport* transport, unsigned char* buffer, int maxLength, unsigned int timeoutMs, int* bytesRead)
+{
+    int fd = TERMIOS_FD(transport);
+    long long deadline = (long long)SGSLrmClock_NowMs() + timeoutMs;
+
+    *bytesRead = 0;
+    for (;;) {
+        long long remaining = deadline - (long long)SGSLrmClock_NowMs();
+        if (remaining < 0) remaining = 0;
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int rc = poll(&pfd, 1, (int)remaining);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        if (rc == 0) return SGS_LRM_SUCCESS; // Deadline passed, nothing arrived
+        if (pfd.revents & (POLLERR | POLLNVAL)) return SGS_LRM_COMMUNICATION_ERROR;
+
+        ssize_t n = read(fd, buffer, (size_t)maxLength);
+        if (n > 0) {
+            *bytesRead = (int)n;
+            return SGS_LRM_SUCCESS;
+        }
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        if (pfd.revents & POLLHUP) return SGS_LRM_COMMUNICATION_ERROR;
+    }
+}
+
+static SGSLrmStatus Termios_Write(SGSLrmTransport* transport, const unsigned char* data, int length, int* bytesWritten)
+{
+    const SGSLrmTransportTimeouts* t = &transport->timeouts;
+    int fd = TERMIOS_FD(transport);
+    long long deadline = (long long)SGSLrmClock_NowMs() + t->writeTotalConstantMs + (long long)t->writeTotalMultiplierMs * length;
+    int sent = 0;
+
+    *bytesWritten = 0;
+    while (sent < length) {
+        ssize_t n = write(fd, data + sent, (size_t)(length - sent));
+        if (n > 0) {
+            sent += (int)n;
+            *bytesWritten = sent;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            return SGS_LRM_COMMUNICATION_ERROR;
+        }
+        long long remaining = deadline - (long long)SGSLrmClock_NowMs();
+        if (remaining <= 0) break;
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        poll(&pfd, 1, (int)remaining);
+    }
+    return SGS_LRM_SUCCESS;
+}
+
+static SGSLrmStatus Termios_SetTimeouts(SGSLrmTransport* transport, const SGSLrmTransportTimeouts* t)
+{
+    // Timeouts are applied per call in Termios_Read/Termios_Write.
+    transport->timeouts = *t;
+    return SGS_LRM_SUCCESS;
+}
+
+const SGSLrmTransportOps g_sgsLrmTermiosTransport = {
+    "termios",
+    Termios_Open,
+    Termios_Close,
+    Termios_Read,
+    Termios_ReadWithin,
+    Termios_Write,
+    Termios_SetTimeouts,
+};
+
+const SGSLrmTransportOps* SGSLrmTransport_Default(void)
+{
+    return &g_sgsLrmTermiosTransport;
+}
+
+#endif
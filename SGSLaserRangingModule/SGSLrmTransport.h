@@ -0,0 +1,85 @@
+﻿#pragma once
+
+// Internal serial transport interface.
+// SGSLrmDevice talks to the wire only through an SGSLrmTransport, so the
+// protocol code does not care whether the port is a Win32 COM handle or a
+// POSIX tty. Each backend is a static ops table; the native port handle lives
+// inline in the transport (no heap allocation, matching the device pool).
+
+#include "SGSLaserRangingModule.h"
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Mirrors COMMTIMEOUTS. A read waits up to
+// readTotalConstantMs + readTotalMultiplierMs * maxLength for data, and once
+// data has started arriving stops when the line is idle for readIntervalMs.
+// With readIntervalMs == SGS_LRM_READ_RETURN_ON_DATA a read returns as soon as
+// any bytes are available (MAXDWORD interval/multiplier on Win32).
+#define SGS_LRM_READ_RETURN_ON_DATA 0xFFFFFFFFu
+
+typedef struct {
+    unsigned int readIntervalMs;
+    unsigned int readTotalConstantMs;
+    unsigned int readTotalMultiplierMs;
+    unsigned int writeTotalConstantMs;
+    unsigned int writeTotalMultiplierMs;
+} SGSLrmTransportTimeouts;
+
+typedef struct SGSLrmTransport SGSLrmTransport;
+
+typedef struct {
+    const char* name;
+    // Opens the port at 9600 8N1, raw/binary mode.
+    SGSLrmStatus (*open)(SGSLrmTransport* transport, const char* portName);
+    void (*close)(SGSLrmTransport* transport);
+    // Returns SGS_LRM_SUCCESS with *bytesRead == 0 when the read timed out.
+    SGSLrmStatus (*read)(SGSLrmTransport* transport, unsigned char* buffer, int maxLength, int* bytesRead);
+    // Deadline read: returns as soon as any bytes are available, or with
+    // *bytesRead == 0 once timeoutMs has passed. Ignores the read timeouts.
+    SGSLrmStatus (*readWithin)(SGSLrmTransport* transport, unsigned char* buffer, int maxLength, unsigned int timeoutMs, int* bytesRead);
+    SGSLrmStatus (*write)(SGSLrmTransport* transport, const unsigned char* data, int length, int* bytesWritten);
+    SGSLrmStatus (*setTimeouts)(SGSLrmTransport* transport, const SGSLrmTransportTimeouts* timeouts);
+} SGSLrmTransportOps;
+
+struct SGSLrmTransport {
+    const SGSLrmTransportOps* ops;
+    intptr_t native;                    // HANDLE on Win32 (opened overlapped), file descriptor on POSIX
+    intptr_t ioEvent;                   // Win32: event for blocking reads/writes on the overlapped handle
+    SGSLrmTransportTimeouts timeouts;
+};
+
+#define SGS_LRM_TRANSPORT_INVALID ((intptr_t)-1)
+
+#if defined(_WIN32)
+extern const SGSLrmTransportOps g_sgsLrmWin32Transport;
+#else
+extern const SGSLrmTransportOps g_sgsLrmTermiosTransport;
+#endif
+
+// Backend used by SGSLrm_Connect on this platform.
+const SGSLrmTransportOps* SGSLrmTransport_Default(void);
+
+// Resets a transport to the closed state bound to the given backend.
+void SGSLrmTransport_Init(SGSLrmTransport* transport, const SGSLrmTransportOps* ops);
+
+static __inline bool SGSLrmTransport_IsOpen(const SGSLrmTransport* transport)
+{
+    return transport->ops != NULL && transport->native != SGS_LRM_TRANSPORT_INVALID;
+}
+
+// Serial ports the OS knows about, listed without opening any of them:
+// HKLM\HARDWARE\DEVICEMAP\SERIALCOMM on Win32, /sys/class/tty on Linux (legacy
+// 8250 slots with no UART behind them are skipped). stableName is the
+// /dev/serial/by-id link for the port, which survives re-plugging, or "" when
+// there is none. Ports are visited in natural order (COM2 before COM10; USB
+// adapters, then ACM, then on-board UARTs).
+typedef void (*SGSLrmPortVisitor)(const char* port, const char* stableName, void* context);
+
+void SGSLrmTransport_EnumPorts(SGSLrmPortVisitor visit, void* context);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,83 @@
+// Benchmark: cache sweep (SGSLrm_SweepCache) over eight pty modules on a line
+// emulated at 9600 baud. Each command/answer pair needs ~15.6 ms of wire time
+// (4 + 11 bytes); a sweep that sends every command as soon as the previous
+// answer completes should keep the line busy for nearly all of the sweep; what
+// is left is the simulator's own turnaround (it polls its pty every 1 ms).
+// The best sweep is checked: host load only ever stretches a sweep, so the
+// mean and worst utilisation are reported but not gated.
+//
+// Build (Linux): make bench_cache_sweep (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+
+static const int kModules = 8;
+static const int kSweeps = 20;
+
+int main()
+{
+    print_banner("Cache sweep at 9600 baud");
+
+    PtyModuleSimulator sim;
+    sim.baudRate = 9600;
+    int addresses[kModules];
+    for (int i = 0; i < kModules; ++i) {
+        addresses[i] = 0x80 + i;
+        sim.modules[addresses[i]].distance = 3.0 + i;
+    }
+    if (!sim.Start()) {
+        printf("pty allocation failed\n");
+        return 1;
+    }
+
+    SGSLrmBusHandle bus;
+    SGSLrm_OpenBus(sim.PortName(), &bus);
+
+    SGSLrmSweepStats stats;
+    check(SGSLrm_GetSweepStats(bus, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL stats rejected");
+    SGSLrm_GetSweepStats(bus, &stats);
+    check(stats.sweeps == 0, "no sweeps yet");
+
+    bool allOk = true;
+    double worstUtilisation = 1e9;
+    double sweepMsTotal = 0.0;
+    SGSLrmSyncResult results[kModules];
+    auto t0 = std::chrono::steady_clock::now();
+    for (int s = 0; s < kSweeps; ++s) {
+        allOk = SGSLrm_SweepCache(bus, addresses, kModules, results) == SGS_LRM_SUCCESS && allOk;
+        for (int i = 0; i < kModules; ++i) {
+            allOk = results[i].status == SGS_LRM_SUCCESS && fabs(results[i].distance - (3.0 + i)) < 1e-9 && allOk;
+        }
+        SGSLrm_GetSweepStats(bus, &stats);
+        if (stats.utilisation < worstUtilisation) worstUtilisation = stats.utilisation;
+        sweepMsTotal += stats.lastSweepMs;
+    }
+    double totalS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("%-28s %10d\n", "sweeps", (int)stats.sweeps);
+    printf("%-28s %10.2f\n", "last sweep ms", stats.lastSweepMs);
+    printf("%-28s %10.2f\n", "best sweep ms", stats.bestSweepMs);
+    printf("%-28s %10.2f\n", "wire time ms", stats.wireMs);
+    double meanUtilisation = stats.wireMs * kSweeps / sweepMsTotal;
+    printf("%-28s %9.1f%%\n", "utilisation (mean)", meanUtilisation * 100.0);
+    printf("%-28s %9.1f%%\n", "utilisation (worst)", worstUtilisation * 100.0);
+    printf("%-28s %10.2f\n", "achievable sweeps/s", stats.achievableHz);
+    printf("%-28s %10.2f\n\n", "measured sweeps/s", kSweeps / totalS);
+
+    check(allOk, "every sweep read all eight modules");
+    check(stats.sweeps == kSweeps && stats.lastCount == kModules, "sweeps counted");
+    check(fabs(stats.wireMs - kModules * 15 * 10 * 1000.0 / 9600) < 0.01, "wire time is 8 x 15 bytes at 9600 baud");
+    check(fabs(stats.achievableHz - 1000.0 / stats.wireMs) < 0.01, "achievable rate follows from the wire time");
+    check(stats.bestSweepMs <= stats.lastSweepMs && stats.lastSweepMs <= sweepMsTotal, "best sweep is the shortest");
+    double bestUtilisation = stats.wireMs / stats.bestSweepMs;
+    char what[96];
+    snprintf(what, sizeof(what), "line busy %.1f%% of the best sweep", bestUtilisation * 100.0);
+    check(bestUtilisation > 0.9 && bestUtilisation <= 1.0, what);
+
+    SGSLrm_CloseBus(bus);
+    sim.Stop();
+
+    return report_results();
+}
@@ -0,0 +1,232 @@
+// Benchmark: measurement-frame decoding (SGSLrm_DecodeMeasurement) against the
+// previous path, which copied the payload, validated it in a second pass and
+// converted it with strtod. The corpus mixes 1 mm and 0.1 mm readings, ERR-XX
+// frames and malformed payloads; both paths must agree on every frame, status
+// and value alike, and the single pass must be faster.
+//
+// Build (Linux): make bench_decode (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+static const int kFrames = 4096;
+static const int kPasses = 200;
+
+static unsigned char checksum(const unsigned char* data, int length)
+{
+    unsigned int sum = 0;
+    for (int i = 0; i < length; ++i) sum += data[i];
+    return (unsigned char)(0x100 - (sum & 0xFF));
+}
+
+// The decoder as it was before the single pass, checksum check added and its
+// ERR match tightened to what the frame parser accepts (response code, '-' padding)
+static SGSLrmStatus legacy_decode(const unsigned char* response, int length, double* distance, int* errorCode)
+{
+    if (length < 4 || response[length - 1] != checksum(response, length - 1)) return SGS_LRM_COMMUNICATION_ERROR;
+    if (response[1] != 0x06) return SGS_LRM_COMMUNICATION_ERROR;
+    if (!(response[2] == 0x82 || response[2] == 0x83 || response[2] == 0x87)) return SGS_LRM_COMMUNICATION_ERROR;
+
+    if (length >= 10 && length <= 12 &&
+        response[3] == 'E' && response[4] == 'R' && response[5] == 'R' && response[6] == '-' &&
+        isdigit(response[length - 3]) && isdigit(response[length - 2]) &&
+        strspn((const char*)&response[7], "-") >= (size_t)(length - 10)) {
+        *errorCode = (response[length - 3] - '0') * 10 + (response[length - 2] - '0');
+        return SGS_LRM_MEASUREMENT_ERROR;
+    }
+
+    *errorCode = 0;
+    int dataLength = length - 4;
+    if (dataLength < 3 || dataLength > 12) return SGS_LRM_COMMUNICATION_ERROR;
+
+    char distanceStr[16] = { 0 };
+    memcpy(distanceStr, &response[3], dataLength);
+    distanceStr[dataLength] = '\0';
+
+    int dotCount = 0; bool hasDigit = false;
+    for (int i = 0; i < dataLength; ++i) {
+        unsigned char c = (unsigned char)distanceStr[i];
+        if (c == '.') { if (++dotCount > 1) return SGS_LRM_COMMUNICATION_ERROR; }
+        else if (isdigit(c)) { hasDigit = true; }
+        else { return SGS_LRM_COMMUNICATION_ERROR; }
+    }
+    if (!hasDigit || distanceStr[0] == '.' || distanceStr[dataLength - 1] == '.') return SGS_LRM_COMMUNICATION_ERROR;
+
+    char* endp = NULL;
+    double val = strtod(distanceStr, &endp);
+    if (!endp || *endp != '\0' || isnan(val) || isinf(val) || val < 0.0 || val > 9999.9999)
+        return SGS_LRM_COMMUNICATION_ERROR;
+
+    *distance = val;
+    return SGS_LRM_SUCCESS;
+}
+
+static std::vector<unsigned char> frame(unsigned char response, const char* payload)
+{
+    std::vector<unsigned char> f = { 0x80, 0x06, response };
+    for (const char* p = payload; *p; ++p) f.push_back((unsigned char)*p);
+    f.push_back(checksum(f.data(), (int)f.size()));
+    return f;
+}
+
+static std::vector<std::vector<unsigned char>> corpus()
+{
+    static const char* kMalformed[] = {
+        "12.34.5", "1a2.345", ".123", "123.", "", "12", "ERR-X5", "10000.000", "-1.234", "1 2.345", "0x12.34",
+        "ERR-x716", "ERR-1-16", "ERR-+16", "ERR--+16", "ERR----16", "ERR16",
+    };
+    static const unsigned char kResponses[] = { 0x82, 0x83, 0x87 };
+
+    std::vector<std::vector<unsigned char>> frames;
+    srand(1);
+    for (int i = 0; i < kFrames; ++i) {
+        char payload[32];
+        int kind = i % 16;
+        unsigned char response = kResponses[i % 3];
+        int tenthMm = rand() % 800000;
+        if (kind < 7) {
+            snprintf(payload, sizeof(payload), i & 1 ? "%07.3f" : "%.3f", (tenthMm / 10) / 1000.0);
+        } else if (kind < 14) {
+            snprintf(payload, sizeof(payload), i & 1 ? "%08.4f" : "%.4f", tenthMm / 10000.0);
+        } else if (kind == 14) {
+            snprintf(payload, sizeof(payload), "ERR-%02d", 10 + rand() % 90);
+        } else {
+            snprintf(payload, sizeof(payload), "%s", kMalformed[(i / 16) % (sizeof(kMalformed) / sizeof(kMalformed[0]))]);
+        }
+        frames.push_back(frame(response, payload));
+    }
+    // Bad checksum; an ERR payload under a response code that carries none
+    frames[5].back() ^= 0x55;
+    frames[14] = frame(0x41, "ERR-16");
+    return frames;
+}
+
+void test_agreement(const std::vector<std::vector<unsigned char>>& frames)
+{
+    printf("Test 1: Both paths agree on the corpus...\n");
+
+    int mismatches = 0, valid = 0, errors = 0, malformed = 0;
+    for (const std::vector<unsigned char>& f : frames) {
+        double legacyDistance = -1.0, distance = -1.0;
+        int legacyCode = -1, code = -1, tenthMm = -1;
+        SGSLrmStatus legacy = legacy_decode(f.data(), (int)f.size(), &legacyDistance, &legacyCode);
+        SGSLrmStatus status = SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), &tenthMm, &distance, &code);
+        bool same = status == legacy;
+        if (same && status == SGS_LRM_SUCCESS) {
+            same = distance == legacyDistance && tenthMm == (int)llround(legacyDistance * SGS_LRM_UNITS_PER_METRE) && code == 0;
+        } else if (same && status == SGS_LRM_MEASUREMENT_ERROR) {
+            same = code == legacyCode;
+        }
+        if (!same) mismatches++;
+        valid += status == SGS_LRM_SUCCESS;
+        errors += status == SGS_LRM_MEASUREMENT_ERROR;
+        malformed += status == SGS_LRM_COMMUNICATION_ERROR;
+    }
+
+    char what[128];
+    snprintf(what, sizeof(what), "%d valid, %d ERR, %d malformed: %d mismatch%s", valid, errors, malformed, mismatches, mismatches == 1 ? "" : "es");
+    check(mismatches == 0 && valid > 0 && errors > 0 && malformed > 0, what);
+    printf("\n");
+}
+
+void test_edges()
+{
+    printf("Test 2: Edge cases...\n");
+
+    int tenthMm = -1;
+    double distance = -1.0;
+    int code = -1;
+    std::vector<unsigned char> f = frame(0x82, "9999.9999");
+    check(SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), &tenthMm, &distance, &code) == SGS_LRM_SUCCESS &&
+        tenthMm == 99999999 && distance == 9999.9999, "top of range exact in both forms");
+    f = frame(0x83, "0.0001");
+    check(SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), &tenthMm, NULL, NULL) == SGS_LRM_SUCCESS && tenthMm == 1, "one unit");
+    f = frame(0x87, "123");
+    check(SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), &tenthMm, NULL, NULL) == SGS_LRM_SUCCESS && tenthMm == 1230000, "whole metres");
+    f = frame(0x82, "1.23456");
+    check(SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), &tenthMm, NULL, NULL) == SGS_LRM_COMMUNICATION_ERROR, "finer than 0.1 mm rejected");
+    f = frame(0x82, "ERR--15");
+    check(SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), NULL, NULL, &code) == SGS_LRM_MEASUREMENT_ERROR && code == 15, "ERR--XX firmware variant");
+    f = frame(0x41, "ERR-x716");
+    check(SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), NULL, NULL, &code) == SGS_LRM_COMMUNICATION_ERROR, "ERR look-alike rejected");
+    f = frame(0x87, "ERR-x716");
+    SGSLrmStatus status = SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), NULL, NULL, &code);
+    f = frame(0x41, "ERR-16");
+    check(status == SGS_LRM_COMMUNICATION_ERROR &&
+        SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), NULL, NULL, &code) == SGS_LRM_COMMUNICATION_ERROR,
+        "ERR frame needs '-' padding and a measurement response code");
+    f = frame(0x82, "1.234");
+    f[1] = 0x04;
+    f.back() = checksum(f.data(), (int)f.size() - 1);
+    check(SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), NULL, NULL, NULL) == SGS_LRM_COMMUNICATION_ERROR, "not a measurement frame");
+    check(SGSLrm_DecodeMeasurement(NULL, 10, NULL, NULL, NULL) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_DecodeMeasurement(f.data(), 3, NULL, NULL, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL and short input rejected");
+    printf("\n");
+}
+
+template <typename Decode>
+static double ns_per_frame(const std::vector<std::vector<unsigned char>>& frames, Decode decode, long* sink)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < kPasses; ++pass) {
+        for (const std::vector<unsigned char>& f : frames) {
+            *sink += decode(f);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return ns / ((double)kPasses * frames.size());
+}
+
+void test_speed(const std::vector<std::vector<unsigned char>>& frames)
+{
+    printf("Test 3: Decode cost...\n");
+
+    long sink = 0;
+    auto legacy = [](const std::vector<unsigned char>& f) {
+        double distance = 0.0;
+        int code = 0;
+        return legacy_decode(f.data(), (int)f.size(), &distance, &code) + (long)distance + code;
+    };
+    auto single = [](const std::vector<unsigned char>& f) {
+        int tenthMm = 0, code = 0;
+        return SGSLrm_DecodeMeasurement(f.data(), (int)f.size(), &tenthMm, NULL, &code) + (long)tenthMm + code;
+    };
+
+    // Warm up, then take the best of three for each
+    ns_per_frame(frames, legacy, &sink);
+    ns_per_frame(frames, single, &sink);
+    double legacyNs = 1e9, singleNs = 1e9;
+    for (int round = 0; round < 3; ++round) {
+        legacyNs = fmin(legacyNs, ns_per_frame(frames, legacy, &sink));
+        singleNs = fmin(singleNs, ns_per_frame(frames, single, &sink));
+    }
+
+    printf("%-28s %10.1f\n", "copy+strtod ns/frame", legacyNs);
+    printf("%-28s %10.1f\n", "single pass ns/frame", singleNs);
+    printf("%-28s %9.1fx\n", "speed-up", legacyNs / singleNs);
+    printf("%-28s %10ld\n\n", "(checksum of results)", sink);
+
+    char what[96];
+    snprintf(what, sizeof(what), "single pass faster (%.1f vs %.1f ns)", singleNs, legacyNs);
+    check(singleNs < legacyNs, what);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Measurement frame decoding");
+
+    std::vector<std::vector<unsigned char>> frames = corpus();
+    test_agreement(frames);
+    test_edges();
+    test_speed(frames);
+
+    return report_results();
+}
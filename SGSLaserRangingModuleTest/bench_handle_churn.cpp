@@ -0,0 +1,208 @@
+// Benchmark: handle create/destroy churn on the growable device pool.
+// Creates 10,000 handles (far past the old 16-slot array), then times random
+// destroy/create pairs with 16 and with 10,000 handles live: the free list
+// makes both O(1), so churning 16 handles must cost the same whether the pool
+// holds 16 or 10,000. Churn spread over all 10,000 is reported as well; it is
+// slower only because each pair then touches a cold, multi-kilobyte record. Also
+// checks that handles are generation-tagged (a destroyed handle stays dead
+// after its slot is reused), that validation stays a few nanoseconds with the
+// pool at 10,000, and that threads can churn concurrently.
+//
+// Build (Linux): make bench_handle_churn (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+static const int kHandles = 10000;
+static const int kChurnPairs = 200000;
+
+static double elapsed_ns(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Destroys a random handle among the first `span` and creates a replacement,
+// kChurnPairs times. Returns ns per pair.
+static double churn(std::vector<SGSLrmHandle>& live, size_t span, bool& ok)
+{
+    uint32_t seed = 12345;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kChurnPairs; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        size_t victim = seed % span;
+        ok = SGSLrm_DestroyHandle(live[victim]) == SGS_LRM_SUCCESS && ok;
+        ok = SGSLrm_CreateHandle(&live[victim]) == SGS_LRM_SUCCESS && ok;
+    }
+    return elapsed_ns(t0) / kChurnPairs;
+}
+
+void test_growth(std::vector<SGSLrmHandle>& handles)
+{
+    printf("Test 1: 10,000 live handles...\n");
+
+    handles.resize(kHandles);
+    bool ok = true;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kHandles; ++i) {
+        ok = SGSLrm_CreateHandle(&handles[i]) == SGS_LRM_SUCCESS && ok;
+    }
+    double createNs = elapsed_ns(t0) / kHandles;
+
+    char what[96];
+    snprintf(what, sizeof(what), "all created, %.0f ns per create while growing", createNs);
+    check(ok, what);
+
+    std::set<SGSLrmHandle> unique(handles.begin(), handles.end());
+    check((int)unique.size() == kHandles, "every handle distinct");
+
+    bool valid = true;
+    for (SGSLrmHandle h : handles) {
+        bool connected = true;
+        valid = SGSLrm_IsConnected(h, &connected) == SGS_LRM_SUCCESS && !connected && valid;
+    }
+    check(valid, "every handle validates");
+    printf("\n");
+}
+
+void test_churn(std::vector<SGSLrmHandle>& handles)
+{
+    printf("Test 2: Destroy/create churn...\n");
+
+    // 16 live: the others are destroyed for this run and recreated after it
+    std::vector<SGSLrmHandle> rest(handles.begin() + 16, handles.end());
+    for (SGSLrmHandle h : rest) SGSLrm_DestroyHandle(h);
+    bool ok = true;
+    double smallNs = churn(handles, 16, ok);
+    for (SGSLrmHandle& h : rest) ok = SGSLrm_CreateHandle(&h) == SGS_LRM_SUCCESS && ok;
+    std::copy(rest.begin(), rest.end(), handles.begin() + 16);
+
+    double largeNs = churn(handles, 16, ok);
+    double spreadNs = churn(handles, handles.size(), ok);
+
+    printf("  %-34s %8.0f ns per destroy+create\n", "16 live", smallNs);
+    printf("  %-34s %8.0f ns per destroy+create\n", "10,000 live, churning 16", largeNs);
+    printf("  %-34s %8.0f ns per destroy+create\n", "10,000 live, churning all (cold)", spreadNs);
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d pairs per run, no failures", kChurnPairs);
+    check(ok, what);
+    snprintf(what, sizeof(what), "cost does not grow with the pool (%.2fx)", largeNs / smallNs);
+    check(largeNs < smallNs * 2.0, what);
+
+    SGSLrmHandle victim = handles[0];
+    SGSLrm_DestroyHandle(victim);
+    bool connected;
+    check(SGSLrm_IsConnected(victim, &connected) == SGS_LRM_INVALID_HANDLE, "destroyed handle rejected");
+    check(SGSLrm_DestroyHandle(victim) == SGS_LRM_INVALID_HANDLE, "second destroy rejected");
+    SGSLrm_CreateHandle(&handles[0]); // Reuses victim's slot
+    check(handles[0] != victim, "slot reused under a new handle");
+    check(SGSLrm_IsConnected(victim, &connected) == SGS_LRM_INVALID_HANDLE, "old handle still rejected after reuse");
+    check(SGSLrm_DestroyHandle(victim) == SGS_LRM_INVALID_HANDLE && SGSLrm_IsConnected(handles[0], &connected) == SGS_LRM_SUCCESS,
+        "destroying the old handle leaves the new one alone");
+
+    int dummy = 0;
+    uintptr_t topBit = (uintptr_t)1 << (sizeof(void*) * 8 - 1);
+    check(SGSLrm_IsConnected((SGSLrmHandle)&dummy, &connected) == SGS_LRM_INVALID_HANDLE, "pointer passed as a handle rejected");
+    check(SGSLrm_IsConnected((SGSLrmHandle)((uintptr_t)handles[1] ^ topBit), &connected) == SGS_LRM_INVALID_HANDLE, "forged generation rejected");
+    printf("\n");
+}
+
+void test_reuse(std::vector<SGSLrmHandle>& handles)
+{
+    printf("Test 3: Stale handles stay dead after their slots are reused...\n");
+
+    std::vector<SGSLrmHandle> before(handles);
+    for (SGSLrmHandle h : handles) SGSLrm_DestroyHandle(h);
+    bool ok = true;
+    for (int i = 0; i < kHandles; ++i) {
+        ok = SGSLrm_CreateHandle(&handles[i]) == SGS_LRM_SUCCESS && ok;
+    }
+    check(ok, "10,000 handles recreated in the freed slots");
+
+    int stale = 0, live = 0;
+    for (int i = 0; i < kHandles; ++i) {
+        bool connected;
+        if (SGSLrm_IsConnected(before[i], &connected) == SGS_LRM_SUCCESS) stale++;
+        if (SGSLrm_IsConnected(handles[i], &connected) == SGS_LRM_SUCCESS) live++;
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "%d of %d old handles still accepted", stale, kHandles);
+    check(stale == 0, what);
+    check(live == kHandles, "every new handle accepted");
+    printf("\n");
+}
+
+void test_validation_cost(std::vector<SGSLrmHandle>& handles)
+{
+    printf("Test 4: Validation cost with 10,000 handles live...\n");
+
+    // Snapshot reads are the cheapest call: validation plus a seqlock copy
+    const int kCalls = 2000000;
+    SGSLrmSnapshot snapshot;
+    SGSLrmHandle first = handles.front(), last = handles.back();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kCalls; ++i) SGSLrm_GetSnapshot(first, &snapshot);
+    double firstNs = elapsed_ns(t0) / kCalls;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kCalls; ++i) SGSLrm_GetSnapshot(last, &snapshot);
+    double lastNs = elapsed_ns(t0) / kCalls;
+
+    char what[96];
+    snprintf(what, sizeof(what), "GetSnapshot %.1f ns in the first chunk, %.1f ns in the last", firstNs, lastNs);
+    check(lastNs < firstNs * 1.5 + 5.0, what);
+    printf("\n");
+}
+
+void test_concurrent()
+{
+    printf("Test 5: Eight threads churning at once...\n");
+
+    const int kThreads = 8, kRounds = 20000;
+    std::atomic<int> errors{ 0 };
+    std::vector<std::thread> threads;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            SGSLrmHandle mine[4];
+            for (int r = 0; r < kRounds; ++r) {
+                for (SGSLrmHandle& h : mine) {
+                    if (SGSLrm_CreateHandle(&h) != SGS_LRM_SUCCESS) errors++;
+                }
+                for (SGSLrmHandle h : mine) {
+                    bool connected;
+                    if (SGSLrm_IsConnected(h, &connected) != SGS_LRM_SUCCESS) errors++;
+                    if (SGSLrm_DestroyHandle(h) != SGS_LRM_SUCCESS) errors++;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    double ns = elapsed_ns(t0) / (kThreads * kRounds * 4);
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d handles created and destroyed, %d errors (%.0f ns per pair)", kThreads * kRounds * 4, errors.load(), ns);
+    check(errors == 0, what);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Handle create/destroy churn");
+
+    std::vector<SGSLrmHandle> handles;
+    test_growth(handles);
+    test_churn(handles);
+    test_reuse(handles);
+    test_validation_cost(handles);
+    for (SGSLrmHandle h : handles) SGSLrm_DestroyHandle(h);
+    test_concurrent();
+
+    return report_results();
+}
@@ -0,0 +1,86 @@
+// Benchmark: command round-trip latency over a pty module.
+// Times SGSLrm_SingleMeasurement and SGSLrm_ReadCache round trips, then a
+// burst of config writes (each waits for the module's ack, which also ends
+// its turnaround). A pty has no baud rate, so the figures are pure library overhead:
+// on a 9600 baud line add ~4 ms for the command and ~12 ms for the response.
+//
+// Build (Linux): make bench_latency (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+static const int kRounds = 200;
+
+struct Latency {
+    double mean, p50, p99;
+};
+
+template <typename Call>
+static Latency measure(Call call)
+{
+    std::vector<double> ms;
+    for (int i = 0; i < kRounds; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        call();
+        ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    double sum = 0.0;
+    for (double v : ms) sum += v;
+    Latency l = { sum / ms.size(), ms[ms.size() / 2], ms[ms.size() * 99 / 100] };
+    return l;
+}
+
+int main()
+{
+    print_banner("Command round-trip latency");
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    bool allOk = true;
+    Latency single = measure([&] {
+        double d = 0.0;
+        allOk = SGSLrm_SingleMeasurement(handle, &d) == SGS_LRM_SUCCESS && fabs(d - 1.234) < 1e-9 && allOk;
+    });
+    Latency cache = measure([&] {
+        double d = 0.0;
+        allOk = SGSLrm_ReadCache(handle, &d) == SGS_LRM_SUCCESS && fabs(d - 1.234) < 1e-9 && allOk;
+    });
+
+    printf("%-20s %10s %10s %10s\n", "command", "mean ms", "p50 ms", "p99 ms");
+    printf("%-20s %10.3f %10.3f %10.3f\n", "SingleMeasurement", single.mean, single.p50, single.p99);
+    printf("%-20s %10.3f %10.3f %10.3f\n", "ReadCache", cache.mean, cache.p50, cache.p99);
+
+    // Config writes are acknowledged: the ack shows the module is ready, so the
+    // next write need not sit out a fixed turnaround
+    const int kWrites = 10;
+    long before = sim.commandsReceived;
+    bool acked = true;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kWrites; ++i) {
+        acked = SGSLrm_SetRange(handle, i % 2 ? SGS_LRM_RANGE_80M : SGS_LRM_RANGE_30M) == SGS_LRM_SUCCESS && acked;
+    }
+    double burstMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    printf("%-20s %10.3f ms for %d writes\n\n", "SetRange burst", burstMs, kWrites);
+
+    char what[96];
+    check(allOk, "every round trip succeeded");
+    snprintf(what, sizeof(what), "measurement round trip p50 %.3f ms (no fixed post-write sleep)", single.p50);
+    check(single.p50 < 5.0, what);
+    snprintf(what, sizeof(what), "%ld/%d config writes reached the module", sim.commandsReceived - before, kWrites);
+    check(sim.commandsReceived - before == kWrites, what);
+    check(acked, "every config write acknowledged");
+    check(burstMs < (kWrites - 1) * 10.0, "acks end the turnaround early (faster than wire time + turnaround)");
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
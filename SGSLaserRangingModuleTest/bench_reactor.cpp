@@ -0,0 +1,142 @@
+// Benchmark: 16 continuous-mode devices serviced by the I/O reactor.
+// The simulated modules run in a forked child so that the thread count and
+// CPU time measured here belong to the library alone. Each module streams
+// 0x83 frames at 20 Hz; the run reports library threads, CPU use, context
+// switches and delivered samples.
+//
+// Build (Linux): make bench_reactor (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <dirent.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+
+static const int kDevices = 16;
+static const int kFrequencyHz = 20;
+static const int kSeconds = 5;
+
+static std::atomic<long> g_samples{ 0 };
+static std::atomic<long> g_badSamples{ 0 };
+
+static void on_sample(SGSLrmHandle, double, SGSLrmStatus status, void*)
+{
+    if (status == SGS_LRM_SUCCESS) g_samples++;
+    else g_badSamples++;
+}
+
+static int thread_count()
+{
+    int count = 0;
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return -1;
+    while (struct dirent* e = readdir(dir)) {
+        if (e->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+static double cpu_seconds(const struct rusage& ru)
+{
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+// Child: play kDevices modules and print their pty names, one per line.
+static void run_simulators(int out, int in)
+{
+    std::vector<PtyModuleSimulator*> sims;
+    for (int i = 0; i < kDevices; ++i) {
+        PtyModuleSimulator* sim = new PtyModuleSimulator();
+        sim->modules[0x80].frequencyHz = kFrequencyHz;
+        sim->modules[0x80].distance = 1.0 + i;
+        if (!sim->Start()) _exit(1);
+        std::string line = std::string(sim->PortName()) + "\n";
+        if (write(out, line.data(), line.size()) != (ssize_t)line.size()) _exit(1);
+        sims.push_back(sim);
+    }
+    close(out);
+
+    char b;
+    while (read(in, &b, 1) > 0) {
+    } // Parent closed the pipe: done
+    for (PtyModuleSimulator* sim : sims) delete sim;
+    _exit(0);
+}
+
+int main()
+{
+    print_banner("Reactor benchmark: %d devices x %d Hz", kDevices, kFrequencyHz);
+
+    int names[2], control[2];
+    if (pipe(names) != 0 || pipe(control) != 0) return 1;
+    pid_t child = fork();
+    if (child == 0) {
+        close(names[0]);
+        close(control[1]);
+        run_simulators(names[1], control[0]);
+    }
+    close(names[1]);
+    close(control[0]);
+
+    std::vector<std::string> ports;
+    std::string line;
+    char c;
+    while ((int)ports.size() < kDevices && read(names[0], &c, 1) == 1) {
+        if (c == '\n') { ports.push_back(line); line.clear(); }
+        else line += c;
+    }
+    close(names[0]);
+    if ((int)ports.size() != kDevices) { printf("simulator start failed\n"); return 1; }
+
+    SGSLrmHandle handles[kDevices];
+    int connected = 0;
+    for (int i = 0; i < kDevices; ++i) {
+        SGSLrm_CreateHandle(&handles[i]);
+        if (SGSLrm_Connect(handles[i], ports[i].c_str()) == SGS_LRM_SUCCESS) connected++;
+        SGSLrm_SetMeasurementCallback(handles[i], on_sample, NULL);
+    }
+    check(connected == kDevices, "all devices connected");
+
+    int threadsBefore = thread_count();
+    for (int i = 0; i < kDevices; ++i) SGSLrm_StartContinuousMeasurement(handles[i]);
+
+    // Let the streams settle, then measure a steady-state window
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    int threadsStreaming = thread_count();
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    long samplesBefore = g_samples.load();
+    std::this_thread::sleep_for(std::chrono::seconds(kSeconds));
+    getrusage(RUSAGE_SELF, &after);
+    long samples = g_samples.load() - samplesBefore;
+
+    for (int i = 0; i < kDevices; ++i) SGSLrm_StopContinuousMeasurement(handles[i]);
+    int threadsAfter = thread_count();
+
+    double cpu = cpu_seconds(after) - cpu_seconds(before);
+    long wakeups = (after.ru_nvcsw - before.ru_nvcsw) + (after.ru_nivcsw - before.ru_nivcsw);
+    long expected = (long)kDevices * kFrequencyHz * kSeconds;
+
+    printf("Threads:   %d idle, %d streaming (%d added), %d after stop\n",
+        threadsBefore, threadsStreaming, threadsStreaming - threadsBefore, threadsAfter);
+    printf("CPU:       %.3f s over %d s (%.2f%% of one core)\n", cpu, kSeconds, cpu * 100.0 / kSeconds);
+    printf("Switches:  %ld (%.1f per sample)\n", wakeups, samples > 0 ? (double)wakeups / samples : 0.0);
+    printf("Samples:   %ld of ~%ld expected, %ld bad\n\n", samples, expected, g_badSamples.load());
+
+    check(threadsStreaming - threadsBefore == 1, "one reactor thread services all streams");
+    check(threadsAfter == threadsBefore, "reactor thread stops with the last stream");
+    check(samples >= expected * 9 / 10 && g_badSamples == 0, "all streams delivered at full rate");
+
+    for (int i = 0; i < kDevices; ++i) {
+        SGSLrm_Disconnect(handles[i]);
+        SGSLrm_DestroyHandle(handles[i]);
+    }
+    close(control[1]);
+    waitpid(child, NULL, 0);
+
+    return report_results();
+}
@@ -0,0 +1,294 @@
+// Pseudo-terminal backed laser module simulator (POSIX only).
+// The library opens the pty slave through its termios backend exactly like a
+// real /dev/ttyUSB*; this class plays one or more modules on the master side
+// and answers with frames as laid out in the communication agreement.
+
+#pragma once
+
+#if defined(_WIN32)
+#error "pty_module_simulator.h requires a POSIX system"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct SimulatedModule {
+    double distance = 1.234;     // metres
+    int resolution = 1;          // 1 = 1mm ("XXX.XXX"), 2 = 0.1mm ("XXX.XXXX")
+    int errorCode = 0;           // non-zero: answer measurements with "ERR-xx"
+    int responseDelayMs = 0;     // turnaround before the first response byte
+    int frequencyHz = 10;        // continuous mode frame rate
+    bool silent = false;         // never answer
+    bool configAcks = true;      // answer FA 04 xx with FA 04 8x CS
+    int rejectSubcommand = 0;    // answer FA 04 <this> with the failure code FA 84 8x 01 CS
+    std::string deviceId = "SGS-LRM-0000001A";  // 16 ASCII characters
+};
+
+class PtyModuleSimulator {
+public:
+    PtyModuleSimulator() {}
+    ~PtyModuleSimulator() { Stop(); }
+
+    // Module table; edit before Start() or under Lock() while running.
+    std::map<int, SimulatedModule> modules;
+
+    // Splits every outgoing frame into writes of this many bytes (0 = whole frame).
+    int chunkSize = 0;
+    int chunkGapMs = 0;
+
+    // Emulated line speed (0 = instant). Commands are handled, and frames
+    // delivered, only after their bytes would have crossed a real UART.
+    int baudRate = 0;
+
+    std::atomic<long> commandsReceived{ 0 };
+    std::atomic<long> framesSent{ 0 };
+
+    // Broadcast config subcommands received, oldest first; read under Lock().
+    std::vector<unsigned char> configLog;
+
+    bool Start()
+    {
+        master_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_ < 0 || grantpt(master_) != 0 || unlockpt(master_) != 0) return false;
+        const char* name = ptsname(master_);
+        if (!name) return false;
+        slaveName_ = name;
+        if (modules.empty()) modules[0x80] = SimulatedModule();
+        running_ = true;
+        thread_ = std::thread(&PtyModuleSimulator::Run, this);
+        return true;
+    }
+
+    void Stop()
+    {
+        running_ = false;
+        if (thread_.joinable()) thread_.join();
+        if (master_ >= 0) close(master_);
+        master_ = -1;
+    }
+
+    const char* PortName() const { return slaveName_.c_str(); }
+
+    // Writes raw bytes to the line as if a module had sent them unasked.
+    void Inject(const std::vector<unsigned char>& bytes)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (write(master_, bytes.data(), bytes.size()) < 0) return;
+    }
+    std::mutex& Lock() { return mutex_; }
+
+    static unsigned char Checksum(const unsigned char* data, size_t length)
+    {
+        unsigned int sum = 0;
+        for (size_t i = 0; i < length; ++i) sum += data[i];
+        return (unsigned char)(0x100 - (sum & 0xFF));
+    }
+
+    // Builds ADDR 06 <status> payload CS for a measurement or ERR frame.
+    static std::vector<unsigned char> MeasurementFrame(int address, unsigned char status, const SimulatedModule& m)
+    {
+        std::vector<unsigned char> frame = { (unsigned char)address, 0x06, status };
+        char payload[16];
+        if (m.errorCode != 0) {
+            snprintf(payload, sizeof(payload), "ERR-%02d", m.errorCode);
+        } else if (m.resolution == 2) {
+            snprintf(payload, sizeof(payload), "%08.4f", m.distance);
+        } else {
+            snprintf(payload, sizeof(payload), "%07.3f", m.distance);
+        }
+        frame.insert(frame.end(), payload, payload + strlen(payload));
+        frame.push_back(Checksum(frame.data(), frame.size()));
+        return frame;
+    }
+
+private:
+    void WireDelay(size_t bytes)
+    {
+        if (baudRate > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds((long long)bytes * 10 * 1000000 / baudRate));
+        }
+    }
+
+    void Send(const std::vector<unsigned char>& frame)
+    {
+        WireDelay(frame.size());
+        size_t step = chunkSize > 0 ? (size_t)chunkSize : frame.size();
+        for (size_t off = 0; off < frame.size(); off += step) {
+            size_t n = frame.size() - off < step ? frame.size() - off : step;
+            if (write(master_, frame.data() + off, n) < 0) return;
+            if (chunkGapMs > 0 && off + n < frame.size()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(chunkGapMs));
+            }
+        }
+        framesSent++;
+    }
+
+    static int CommandLength(const unsigned char* buf, size_t avail)
+    {
+        if (avail < 3) return 0;
+        if (buf[1] == 0x04) {
+            if (buf[2] == 0x02) return 4;              // ADDR 04 02 CS
+            if (buf[2] == 0x06) return 6;              // FA 04 06 SIGN VALUE CS
+            return 5;                                  // FA 04 SUB VALUE CS
+        }
+        if (buf[1] == 0x06) {
+            return buf[2] == 0x05 ? 5 : 4;             // laser control carries one data byte
+        }
+        return -1;
+    }
+
+    void Handle(const unsigned char* cmd, int length)
+    {
+        commandsReceived++;
+        std::lock_guard<std::mutex> guard(mutex_);
+        int addr = cmd[0];
+        unsigned char sub = cmd[2];
+
+        // Any command addressed to a streaming module stops its stream.
+        if (addr != 0xFA) streaming_.erase(addr);
+
+        if (cmd[1] == 0x04) {
+            if (addr == 0xFA) {
+                // Broadcast configuration: the (first) module answers.
+                auto it = modules.begin();
+                if (it == modules.end() || it->second.silent) return;
+                bool acks = it->second.configAcks;
+                int reject = it->second.rejectSubcommand;
+                if (sub == 0x01 && length == 5) {
+                    SimulatedModule m = it->second;
+                    modules.erase(it);
+                    modules[cmd[3]] = m;
+                }
+                if (sub == 0x0C && length == 5) {
+                    for (auto& kv : modules) kv.second.resolution = cmd[3];
+                }
+                configLog.push_back(sub);
+                if (acks && sub == reject) {
+                    std::vector<unsigned char> nak = { 0xFA, 0x84, (unsigned char)(0x80 | sub), 0x01 };
+                    nak.push_back(Checksum(nak.data(), nak.size()));
+                    Send(nak);
+                } else if (acks) {
+                    std::vector<unsigned char> ack = { 0xFA, 0x04, (unsigned char)(0x80 | sub) };
+                    ack.push_back(Checksum(ack.data(), ack.size()));
+                    Send(ack);
+                }
+            } else if (sub == 0x02) {
+                auto it = modules.find(addr);
+                if (it == modules.end() || it->second.silent) return;
+                std::vector<unsigned char> ack = { (unsigned char)addr, 0x04, 0x82 };
+                ack.push_back(Checksum(ack.data(), ack.size()));
+                Send(ack);
+            }
+            return;
+        }
+
+        if (addr == 0xFA) {
+            if (sub == 0x04) {
+                auto it = modules.begin();
+                if (it == modules.end() || it->second.silent) return;
+                std::vector<unsigned char> frame = { 0xFA, 0x06, 0x84 };
+                frame.insert(frame.end(), it->second.deviceId.begin(), it->second.deviceId.end());
+                frame.push_back(Checksum(frame.data(), frame.size()));
+                Send(frame);
+            }
+            // FA 06 06 FA: every module measures into its cache, no response.
+            if (sub == 0x06) {
+                for (auto& kv : modules) cached_[kv.first] = kv.second.distance;
+            }
+            return;
+        }
+
+        auto it = modules.find(addr);
+        if (it == modules.end() || it->second.silent) return;
+        SimulatedModule& m = it->second;
+        if (m.responseDelayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m.responseDelayMs));
+        }
+
+        switch (sub) {
+        case 0x02:
+            Send(MeasurementFrame(addr, 0x82, m));
+            break;
+        case 0x03:
+            streaming_[addr] = std::chrono::steady_clock::now();
+            break;
+        case 0x07: {
+            SimulatedModule snapshot = m;
+            auto c = cached_.find(addr);
+            if (c != cached_.end()) snapshot.distance = c->second;
+            Send(MeasurementFrame(addr, 0x87, snapshot));
+            break;
+        }
+        case 0x05: {
+            std::vector<unsigned char> frame = { (unsigned char)addr, 0x06, 0x85, 0x01 };
+            frame.push_back(Checksum(frame.data(), frame.size()));
+            Send(frame);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void Run()
+    {
+        std::vector<unsigned char> rx;
+        while (running_) {
+            struct pollfd pfd = { master_, POLLIN, 0 };
+            int rc = poll(&pfd, 1, 1);
+            if (rc > 0 && (pfd.revents & POLLIN)) {
+                unsigned char buf[256];
+                ssize_t n = read(master_, buf, sizeof(buf));
+                if (n > 0) rx.insert(rx.end(), buf, buf + n);
+            }
+
+            // Extract complete commands; drop bytes that cannot start one.
+            while (!rx.empty()) {
+                int len = CommandLength(rx.data(), rx.size());
+                if (len < 0) { rx.erase(rx.begin()); continue; }
+                if (len == 0 || rx.size() < (size_t)len) break;
+                if (Checksum(rx.data(), len - 1) != rx[len - 1]) {
+                    rx.erase(rx.begin());
+                    continue;
+                }
+                WireDelay(len);
+                Handle(rx.data(), len);
+                rx.erase(rx.begin(), rx.begin() + len);
+            }
+
+            // Continuous streams
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto& kv : streaming_) {
+                auto m = modules.find(kv.first);
+                if (m == modules.end()) continue;
+                auto period = std::chrono::microseconds(1000000 / (m->second.frequencyHz > 0 ? m->second.frequencyHz : 1));
+                if (now >= kv.second) {
+                    Send(MeasurementFrame(kv.first, 0x83, m->second));
+                    kv.second += period;
+                    if (kv.second < now) kv.second = now + period;
+                }
+            }
+        }
+    }
+
+    int master_ = -1;
+    std::string slaveName_;
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::mutex mutex_;
+    std::map<int, std::chrono::steady_clock::time_point> streaming_;
+    std::map<int, double> cached_;
+};
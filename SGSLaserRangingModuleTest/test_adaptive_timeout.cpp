@@ -0,0 +1,122 @@
+// Tests for adaptive response deadlines (SGSLrm_SetAdaptiveTimeout).
+// A pty module answers after a fixed delay; once enough answers are timed the
+// measurement deadline must shrink to multiplier x p99, so a dead sensor
+// fails fast. Timeouts must push the deadline back up, and SetRange must
+// restart learning.
+//
+// Build (Linux): make test_adaptive_timeout (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "../SGSLaserRangingModule/SGSLrmLatency.h"
+#include "test_common.h"
+#include <stdio.h>
+
+static void set_module(PtyModuleSimulator& sim, bool silent, int delayMs)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    sim.modules[0x80].silent = silent;
+    sim.modules[0x80].responseDelayMs = delayMs;
+}
+
+void test_tracker()
+{
+    printf("Test 1: Latency tracker...\n");
+
+    SGSLrmLatencyTracker t;
+    SGSLrmLatency_Init(&t);
+    for (int i = 1; i <= 100; ++i) SGSLrmLatency_Record(&t, (unsigned int)i);
+    check(t.p99Ms == 99 && t.maxMs == 100 && t.samples == 100, "p99 of 1..100 is 99");
+    check(t.ewmaMs > 90.0 && t.ewmaMs < 100.0, "EWMA follows recent samples");
+
+    for (int i = 0; i < 200; ++i) SGSLrmLatency_Record(&t, 10);
+    check(t.p99Ms == 10, "window forgets samples older than 128 responses");
+
+    SGSLrmLatency_RecordTimeout(&t, 500);
+    SGSLrmLatency_RecordTimeout(&t, 500);
+    check(t.timeouts == 2 && t.p99Ms == 500, "timeouts enter the window at their deadline");
+    printf("\n");
+}
+
+void test_api(SGSLrmHandle handle)
+{
+    printf("Test 2: Adaptive timeout API...\n");
+
+    SGSLrmAdaptiveTimeout cfg = { true, 3.0, 20, 1000 };
+    check(SGSLrm_SetAdaptiveTimeout(handle, SGS_LRM_COMMAND_CONTINUOUS, &cfg) == SGS_LRM_INVALID_PARAMETER, "CONTINUOUS rejected");
+    cfg.multiplier = 0.5;
+    check(SGSLrm_SetAdaptiveTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &cfg) == SGS_LRM_INVALID_PARAMETER, "multiplier below 1 rejected");
+    cfg.multiplier = 3.0;
+    cfg.floorMs = 2000;
+    check(SGSLrm_SetAdaptiveTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &cfg) == SGS_LRM_INVALID_PARAMETER, "floor above ceiling rejected");
+    check(SGSLrm_SetAdaptiveTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, NULL) == SGS_LRM_SUCCESS, "NULL disables");
+    check(SGSLrm_GetLatencyStats(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL stats rejected");
+    printf("\n");
+}
+
+void test_learning(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 3: Deadline learned from a 30 ms module...\n");
+
+    SGSLrmAdaptiveTimeout cfg = { true, 2.0, 20, 1000 };
+    SGSLrm_SetAdaptiveTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &cfg);
+    set_module(sim, false, 30);
+
+    SGSLrmLatencyStats stats;
+    double distance = 0.0;
+    for (int i = 0; i < 15; ++i) SGSLrm_SingleMeasurement(handle, &distance);
+    SGSLrm_GetLatencyStats(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &stats);
+    check(stats.samples == 15 && stats.currentTimeoutMs == 1000, "table deadline kept until 16 responses");
+
+    for (int i = 0; i < 15; ++i) SGSLrm_SingleMeasurement(handle, &distance);
+    SGSLrm_GetLatencyStats(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &stats);
+    char what[128];
+    // Scheduling only ever adds to the module's 30 ms, so bound p99 by what was observed
+    snprintf(what, sizeof(what), "ewma %.1f ms, p99 %d ms, max %d ms -> deadline %d ms", stats.ewmaMs, stats.p99Ms, stats.maxMs,
+        stats.currentTimeoutMs);
+    check(stats.ewmaMs >= 30.0 && stats.p99Ms >= 30 && stats.p99Ms <= stats.maxMs &&
+        stats.currentTimeoutMs == 2 * stats.p99Ms, what);
+
+    // Dead sensor: fails at the learned deadline, not after a second
+    set_module(sim, true, 0);
+    int learned = stats.currentTimeoutMs;
+    auto t0 = std::chrono::steady_clock::now();
+    SGSLrmStatus status = SGSLrm_SingleMeasurement(handle, &distance);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    snprintf(what, sizeof(what), "dead sensor timed out after %.0f ms", ms);
+    check(status == SGS_LRM_TIMEOUT && ms >= learned - 2 && ms < learned + 50, what);
+
+    // Repeated timeouts widen the deadline again, up to the ceiling
+    for (int i = 0; i < 3; ++i) SGSLrm_SingleMeasurement(handle, &distance);
+    SGSLrm_GetLatencyStats(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &stats);
+    snprintf(what, sizeof(what), "%lu timeouts widened the deadline to %d ms", stats.timeouts, stats.currentTimeoutMs);
+    check(stats.timeouts == 4 && stats.currentTimeoutMs > learned && stats.currentTimeoutMs <= 1000, what);
+
+    // New range, new latency profile
+    set_module(sim, false, 0);
+    SGSLrm_SetRange(handle, SGS_LRM_RANGE_80M);
+    SGSLrm_GetLatencyStats(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &stats);
+    check(stats.samples == 0 && stats.timeouts == 0 && stats.currentTimeoutMs == 1000, "SetRange restarts learning");
+
+    SGSLrm_SetAdaptiveTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, NULL);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Adaptive timeouts");
+
+    test_tracker();
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_api(handle);
+    test_learning(sim, handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
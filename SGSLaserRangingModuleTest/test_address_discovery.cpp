@@ -0,0 +1,201 @@
+// Tests for address discovery (SGSLrm_DiscoverAddresses).
+// Ten pty modules at scattered addresses, one reporting ERR-xx, share a line.
+// A full scan of all 255 addresses must find exactly those ten within seconds;
+// a warm call with the cache file must return the same set without touching
+// the line, and refresh must rescan. A lone module gets its ID read as well.
+//
+// Build (Linux): make test_address_discovery (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+
+static const int kAddresses[] = { 0x01, 0x10, 0x42, 0x80, 0x81, 0x82, 0x9A, 0xC8, 0xF9, 0xFF };
+static const int kModules = sizeof(kAddresses) / sizeof(kAddresses[0]);
+
+static double elapsed_ms(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static bool same_set(const SGSLrmDiscoveredModule* modules, int count)
+{
+    if (count != kModules) return false;
+    for (int i = 0; i < kModules; ++i) {
+        if (modules[i].address != kAddresses[i] || modules[i].deviceId[0] != '\0') return false;
+    }
+    return true;
+}
+
+void test_api(const char* port)
+{
+    printf("Test 1: Discovery API...\n");
+
+    SGSLrmDiscoveredModule modules[4];
+    int count = -1;
+    check(SGSLrm_DiscoverAddresses(NULL, NULL, modules, 4, &count, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL port rejected");
+    check(SGSLrm_DiscoverAddresses(port, NULL, NULL, 4, &count, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL output rejected");
+    check(SGSLrm_DiscoverAddresses(port, NULL, modules, 0, &count, NULL) == SGS_LRM_INVALID_PARAMETER, "zero capacity rejected");
+    check(SGSLrm_DiscoverAddresses(port, NULL, modules, 4, NULL, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL count rejected");
+
+    int broadcast = 0xFA;
+    SGSLrmDiscoveryOptions options = { &broadcast, 1, 0, NULL, false };
+    check(SGSLrm_DiscoverAddresses(port, &options, modules, 4, &count, NULL) == SGS_LRM_INVALID_PARAMETER, "broadcast candidate rejected");
+    int outOfRange = 256;
+    options.candidates = &outOfRange;
+    check(SGSLrm_DiscoverAddresses(port, &options, modules, 4, &count, NULL) == SGS_LRM_INVALID_PARAMETER, "address above 255 rejected");
+    options.candidates = kAddresses;
+    options.candidateCount = 0;
+    check(SGSLrm_DiscoverAddresses(port, &options, modules, 4, &count, NULL) == SGS_LRM_INVALID_PARAMETER, "empty candidate list rejected");
+    options.candidateCount = kModules;
+    options.probeTimeoutMs = 1001;
+    check(SGSLrm_DiscoverAddresses(port, &options, modules, 4, &count, NULL) == SGS_LRM_INVALID_PARAMETER, "probe deadline above 1 s rejected");
+    check(SGSLrm_DiscoverAddresses("/dev/does-not-exist", NULL, modules, 4, &count, NULL) != SGS_LRM_SUCCESS, "missing port fails");
+    printf("\n");
+}
+
+void test_full_scan(const char* port, const char* cacheFile)
+{
+    printf("Test 2: Full scan of a ten-module line...\n");
+
+    SGSLrmDiscoveredModule modules[32];
+    int count = 0;
+    bool fromCache = true;
+    SGSLrmDiscoveryOptions options = { NULL, 0, 0, cacheFile, false };
+    auto t0 = std::chrono::steady_clock::now();
+    SGSLrmStatus status = SGSLrm_DiscoverAddresses(port, &options, modules, 32, &count, &fromCache);
+    double ms = elapsed_ms(t0);
+
+    char what[128];
+    snprintf(what, sizeof(what), "%d modules found in %.1f s across 255 addresses", count, ms / 1000.0);
+    check(status == SGS_LRM_SUCCESS && !fromCache && ms < 10000.0, what);
+    check(same_set(modules, count), "exactly the modules on the line, in address order, ERR module included");
+    check(SGSLrm_DiscoverAddresses(port, &options, modules, 3, &count, NULL) == SGS_LRM_SUCCESS && count == 3 && modules[2].address == 0x42,
+        "at most maxCount returned");
+
+    // Found handles work at the addresses discovered
+    SGSLrmBusHandle bus;
+    SGSLrm_OpenBus(port, &bus);
+    SGSLrmHandle handle;
+    SGSLrm_CreateHandle(&handle);
+    double distance = 0.0;
+    check(SGSLrm_ConnectBus(handle, bus, 0xC8) == SGS_LRM_SUCCESS && SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS,
+        "discovered address answers a handle");
+    SGSLrm_CloseBus(bus);
+    SGSLrm_Disconnect(handle);
+    SGSLrm_DestroyHandle(handle);
+    printf("\n");
+}
+
+void test_cache(PtyModuleSimulator& sim, const char* cacheFile)
+{
+    printf("Test 3: Warm restart from the cache...\n");
+
+    long before = sim.commandsReceived;
+    SGSLrmDiscoveredModule modules[32];
+    int count = 0;
+    bool fromCache = false;
+    SGSLrmDiscoveryOptions options = { NULL, 0, 0, cacheFile, false };
+    auto t0 = std::chrono::steady_clock::now();
+    SGSLrmStatus status = SGSLrm_DiscoverAddresses(sim.PortName(), &options, modules, 32, &count, &fromCache);
+    double ms = elapsed_ms(t0);
+
+    char what[128];
+    snprintf(what, sizeof(what), "cached set returned in %.2f ms", ms);
+    check(status == SGS_LRM_SUCCESS && fromCache && ms < 50.0, what);
+    check(same_set(modules, count), "same set as the scan");
+    check(sim.commandsReceived == before, "nothing sent on the line");
+
+    // A second port shares the file without disturbing this one's line
+    FILE* file = fopen(cacheFile, "a");
+    fprintf(file, "/dev/other-port\t7 8=SGS-LRM-00000099\n");
+    fclose(file);
+    check(SGSLrm_DiscoverAddresses("/dev/other-port", &options, modules, 32, &count, &fromCache) == SGS_LRM_SUCCESS && fromCache &&
+        count == 2 && modules[1].address == 8 && strcmp(modules[1].deviceId, "SGS-LRM-00000099") == 0, "other port read from the same file");
+
+    // A hand-edited ID longer than the field is cut to fit, not trusted
+    file = fopen(cacheFile, "a");
+    fprintf(file, "/dev/long-id-port\t9=SGS-LRM-0123456789ABCDEF0123456789ABCDEF\n");
+    fclose(file);
+    check(SGSLrm_DiscoverAddresses("/dev/long-id-port", &options, modules, 32, &count, &fromCache) == SGS_LRM_SUCCESS && fromCache &&
+        count == 1 && strcmp(modules[0].deviceId, "SGS-LRM-0123456789ABCDEF0123456") == 0, "overlong cached ID truncated");
+
+    // The line changed: refresh rescans and rewrites
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules.erase(0x42);
+    }
+    options.candidates = kAddresses;
+    options.candidateCount = kModules;
+    options.refresh = true;
+    status = SGSLrm_DiscoverAddresses(sim.PortName(), &options, modules, 32, &count, &fromCache);
+    check(status == SGS_LRM_SUCCESS && !fromCache && count == kModules - 1, "refresh rescans");
+    options.refresh = false;
+    status = SGSLrm_DiscoverAddresses(sim.PortName(), &options, modules, 32, &count, &fromCache);
+    check(status == SGS_LRM_SUCCESS && fromCache && count == kModules - 1, "rescan replaced the cached set");
+    check(SGSLrm_DiscoverAddresses("/dev/other-port", &options, modules, 32, &count, &fromCache) == SGS_LRM_SUCCESS && fromCache && count == 2,
+        "other port's line kept");
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x42].distance = 2.0;
+    }
+    printf("\n");
+}
+
+void test_lone_module()
+{
+    printf("Test 4: A lone module gets its ID read...\n");
+
+    PtyModuleSimulator sim;
+    sim.modules[0x85].deviceId = "SGS-LRM-0000003C";
+    if (!sim.Start()) {
+        check(false, "pty allocation");
+        return;
+    }
+
+    int candidates[] = { 0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87 };
+    SGSLrmDiscoveryOptions options = { candidates, 8, 20, NULL, false };
+    SGSLrmDiscoveredModule modules[8];
+    int count = 0;
+    SGSLrmStatus status = SGSLrm_DiscoverAddresses(sim.PortName(), &options, modules, 8, &count, NULL);
+
+    char what[128];
+    snprintf(what, sizeof(what), "found 0x%02X with ID \"%s\"", count > 0 ? modules[0].address : 0, count > 0 ? modules[0].deviceId : "");
+    check(status == SGS_LRM_SUCCESS && count == 1 && modules[0].address == 0x85 && strcmp(modules[0].deviceId, "SGS-LRM-0000003C") == 0, what);
+
+    options.candidates = candidates + 6;
+    options.candidateCount = 2;
+    status = SGSLrm_DiscoverAddresses(sim.PortName(), &options, modules, 8, &count, NULL);
+    check(status == SGS_LRM_SUCCESS && count == 0, "empty candidate range finds nothing");
+    sim.Stop();
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Address discovery");
+
+    PtyModuleSimulator sim;
+    for (int i = 0; i < kModules; ++i) {
+        sim.modules[kAddresses[i]].distance = 1.0 + i;
+    }
+    sim.modules[0x82].errorCode = 15;
+    if (!sim.Start()) {
+        printf("pty allocation failed\n");
+        return 1;
+    }
+
+    char cacheFile[64];
+    snprintf(cacheFile, sizeof(cacheFile), "/tmp/sgslrm_discovery_%d.txt", (int)getpid());
+    remove(cacheFile);
+
+    test_api(sim.PortName());
+    test_full_scan(sim.PortName(), cacheFile);
+    test_cache(sim, cacheFile);
+    test_lone_module();
+
+    remove(cacheFile);
+    sim.Stop();
+
+    return report_results();
+}
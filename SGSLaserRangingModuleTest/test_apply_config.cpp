@@ -0,0 +1,226 @@
+// Tests for whole-profile configuration (SGSLrm_ApplyConfig / SGSLrm_GetConfig).
+// A pty module acknowledges every FA 04 write. Re-applying the profile must
+// send nothing, a changeover must send only the registers that changed, and
+// rejected or unanswered writes must be reported and left out of the shadow
+// so the next apply retries them. Acknowledged setters and applies made while
+// streaming keep the shadow current.
+//
+// Build (Linux): make test_apply_config (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+
+static double elapsed_ms(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Config subcommands the module received since the last call
+static std::vector<unsigned char> take_log(PtyModuleSimulator& sim)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    std::vector<unsigned char> log;
+    log.swap(sim.configLog);
+    return log;
+}
+
+static SGSLrmConfig profile()
+{
+    SGSLrmConfig config;
+    config.fields = SGS_LRM_CONFIG_ALL;
+    config.range = SGS_LRM_RANGE_30M;
+    config.resolution = SGS_LRM_RESOLUTION_1MM;
+    config.frequency = SGS_LRM_FREQUENCY_10HZ;
+    config.measurementIntervalMs = 0;
+    config.distanceCorrectionMm = -12;
+    config.startPosition = SGS_LRM_START_POSITION_TAIL;
+    config.autoMeasurement = false;
+    return config;
+}
+
+void test_api(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 1: ApplyConfig API...\n");
+
+    SGSLrmConfig config = profile();
+    check(SGSLrm_ApplyConfig(handle, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL config rejected");
+    check(SGSLrm_GetConfig(handle, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL output rejected");
+    config.fields = 0x80;
+    check(SGSLrm_ApplyConfig(handle, &config) == SGS_LRM_INVALID_PARAMETER, "unknown register rejected");
+    config = profile();
+    config.distanceCorrectionMm = 300;
+    check(SGSLrm_ApplyConfig(handle, &config) == SGS_LRM_INVALID_PARAMETER, "correction out of range rejected");
+    config = profile();
+    config.measurementIntervalMs = 500;
+    check(SGSLrm_ApplyConfig(handle, &config) == SGS_LRM_INVALID_PARAMETER, "interval between 0 and 1 s rejected");
+    check(take_log(sim).empty(), "nothing sent for a bad profile");
+
+    SGSLrmHandle unconnected;
+    SGSLrm_CreateHandle(&unconnected);
+    config = profile();
+    check(SGSLrm_ApplyConfig(unconnected, &config) == SGS_LRM_NOT_CONNECTED, "unconnected handle rejected");
+    SGSLrm_DestroyHandle(unconnected);
+
+    SGSLrm_GetConfig(handle, &config);
+    check(config.fields == 0, "shadow starts empty");
+    printf("\n");
+}
+
+void test_shadow(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 2: Only changed registers are written...\n");
+
+    SGSLrmConfig config = profile();
+    auto t0 = std::chrono::steady_clock::now();
+    SGSLrmStatus status = SGSLrm_ApplyConfig(handle, &config);
+    double firstMs = elapsed_ms(t0);
+    std::vector<unsigned char> log = take_log(sim);
+    char what[128];
+    snprintf(what, sizeof(what), "first apply wrote all %d registers in %.1f ms", (int)log.size(), firstMs);
+    check(status == SGS_LRM_SUCCESS && log.size() == 7, what);
+
+    SGSLrmConfig shadow;
+    SGSLrm_GetConfig(handle, &shadow);
+    check(shadow.fields == SGS_LRM_CONFIG_ALL && shadow.range == SGS_LRM_RANGE_30M && shadow.distanceCorrectionMm == -12 &&
+        shadow.frequency == SGS_LRM_FREQUENCY_10HZ, "shadow holds the acknowledged profile");
+
+    t0 = std::chrono::steady_clock::now();
+    status = SGSLrm_ApplyConfig(handle, &config);
+    double againMs = elapsed_ms(t0);
+    snprintf(what, sizeof(what), "same profile again: nothing written (%.2f ms)", againMs);
+    check(status == SGS_LRM_SUCCESS && take_log(sim).empty() && againMs < 2.0, what);
+
+    // Job changeover: two registers differ
+    config.range = SGS_LRM_RANGE_80M;
+    config.frequency = SGS_LRM_FREQUENCY_20HZ;
+    t0 = std::chrono::steady_clock::now();
+    status = SGSLrm_ApplyConfig(handle, &config);
+    double changeMs = elapsed_ms(t0);
+    log = take_log(sim);
+    snprintf(what, sizeof(what), "changeover wrote range and frequency only (%.1f ms)", changeMs);
+    check(status == SGS_LRM_SUCCESS && log == std::vector<unsigned char>({ 0x09, 0x0A }), what);
+
+    config.fields = SGS_LRM_CONFIG_RANGE;
+    check(SGSLrm_ApplyConfig(handle, &config) == SGS_LRM_SUCCESS && take_log(sim).empty(), "subset of an unchanged profile writes nothing");
+
+    // 1 s and 2 s are the same register value (01)
+    config.fields = SGS_LRM_CONFIG_INTERVAL;
+    config.measurementIntervalMs = 1000;
+    SGSLrm_ApplyConfig(handle, &config);
+    take_log(sim);
+    config.measurementIntervalMs = 2000;
+    check(SGSLrm_ApplyConfig(handle, &config) == SGS_LRM_SUCCESS && take_log(sim).empty(), "values encoding to the same byte write nothing");
+    config.measurementIntervalMs = 0;
+    SGSLrm_ApplyConfig(handle, &config);
+    take_log(sim);
+
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS, "measurement right after the changeover is clean");
+    printf("\n");
+}
+
+void test_failures(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 3: Rejected and unanswered writes...\n");
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].rejectSubcommand = 0x0A;
+    }
+    SGSLrmConfig config = profile();
+    config.range = SGS_LRM_RANGE_50M;
+    config.frequency = SGS_LRM_FREQUENCY_5HZ;
+    SGSLrmStatus status = SGSLrm_ApplyConfig(handle, &config);
+    take_log(sim);
+
+    SGSLrmConfig shadow;
+    SGSLrm_GetConfig(handle, &shadow);
+    check(status == SGS_LRM_CONFIG_REJECTED, "rejected write reported");
+    check(!(shadow.fields & SGS_LRM_CONFIG_FREQUENCY), "rejected register dropped from the shadow");
+    check((shadow.fields & SGS_LRM_CONFIG_RANGE) && shadow.range == SGS_LRM_RANGE_50M, "accepted register kept");
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].rejectSubcommand = 0;
+    }
+    status = SGSLrm_ApplyConfig(handle, &config);
+    check(status == SGS_LRM_SUCCESS && take_log(sim) == std::vector<unsigned char>({ 0x0A }), "next apply retries only the rejected register");
+
+    // No acks at all: every write times out together, not one after another
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].configAcks = false;
+    }
+    config.range = SGS_LRM_RANGE_5M;
+    config.resolution = SGS_LRM_RESOLUTION_100UM;
+    config.startPosition = SGS_LRM_START_POSITION_TOP;
+    auto t0 = std::chrono::steady_clock::now();
+    status = SGSLrm_ApplyConfig(handle, &config);
+    double ms = elapsed_ms(t0);
+    SGSLrm_GetConfig(handle, &shadow);
+    char what[128];
+    snprintf(what, sizeof(what), "three unanswered writes time out in %.0f ms", ms);
+    check(status == SGS_LRM_TIMEOUT && ms < 200.0, what);
+    check(!(shadow.fields & (SGS_LRM_CONFIG_RANGE | SGS_LRM_CONFIG_RESOLUTION | SGS_LRM_CONFIG_START_POSITION)), "unanswered registers unknown");
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].configAcks = true;
+    }
+    take_log(sim);
+    status = SGSLrm_ApplyConfig(handle, &config);
+    check(status == SGS_LRM_SUCCESS && take_log(sim).size() == 3, "and are written again");
+    printf("\n");
+}
+
+void test_setters(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 4: Single setters and streaming...\n");
+
+    SGSLrmConfig config;
+    SGSLrm_GetConfig(handle, &config);
+    config.fields = SGS_LRM_CONFIG_ALL;
+    check(SGSLrm_SetFrequency(handle, SGS_LRM_FREQUENCY_20HZ) == SGS_LRM_SUCCESS, "setter acknowledged");
+    SGSLrmConfig shadow;
+    SGSLrm_GetConfig(handle, &shadow);
+    check((shadow.fields & SGS_LRM_CONFIG_FREQUENCY) && shadow.frequency == SGS_LRM_FREQUENCY_20HZ, "setter updates the shadow");
+    take_log(sim);
+    check(SGSLrm_ApplyConfig(handle, &config) == SGS_LRM_SUCCESS && take_log(sim) == std::vector<unsigned char>({ 0x0A }),
+        "apply writes back only what the setter changed");
+
+    // The reactor reads the acks while the line streams
+    SGSLrm_StartContinuousMeasurement(handle);
+    config.range = SGS_LRM_RANGE_10M;
+    check(SGSLrm_ApplyConfig(handle, &config) == SGS_LRM_SUCCESS, "apply while streaming returns once written");
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    check(take_log(sim) == std::vector<unsigned char>({ 0x09 }), "only the change went out");
+    unsigned int pending = 1, failed = 1;
+    SGSLrm_GetConfigStatus(handle, &pending, &failed);
+    SGSLrm_GetConfig(handle, &shadow);
+    check(pending == 0 && failed == 0 && (shadow.fields & SGS_LRM_CONFIG_RANGE) && shadow.range == SGS_LRM_RANGE_10M,
+        "its ack settles it in the shadow");
+    SGSLrm_StopContinuousMeasurement(handle);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Config shadow and ApplyConfig");
+
+    PtyModuleSimulator sim;
+    sim.baudRate = 9600;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+    take_log(sim);
+
+    test_api(sim, handle);
+    test_shadow(sim, handle);
+    test_failures(sim, handle);
+    test_setters(sim, handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
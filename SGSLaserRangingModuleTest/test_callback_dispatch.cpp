@@ -0,0 +1,307 @@
+// Tests for queued callback dispatch (SGSLrm_SetCallbackMode).
+// Part 1 drives SGSLrmDispatcher directly: per-handle ordering across the
+// worker pool, drop-oldest overflow, coalescing, and worker lifetime.
+// Part 2 (POSIX) streams from a pty module with a slow callback and checks
+// that reception keeps its 20 Hz cadence only in QUEUED mode.
+//
+// Build (Linux): make test_callback_dispatch (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "../SGSLaserRangingModule/SGSLrmDispatcher.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Spins until pred() holds or timeoutMs elapses.
+template <typename Pred>
+static bool wait_for(Pred pred, int timeoutMs = 2000)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// ---- Part 1: dispatcher ----
+
+// Posts a double-callback item carrying distance metres
+static bool post(SGSLrmDispatchQueue* queue, SGSLrm_MeasurementCallback callback, void* userdata, double distance, SGSLrmStatus status)
+{
+    SGSLrmDispatchItem item;
+    memset(&item, 0, sizeof(item));
+    item.callback = callback;
+    item.userdata = userdata;
+    item.measurement.distance = distance;
+    item.measurement.distanceTenthMm = (int)(distance * SGS_LRM_UNITS_PER_METRE);
+    item.measurement.status = status;
+    return SGSLrmDispatcher_Post(queue, &item);
+}
+
+struct OrderProbe {
+    std::atomic<int> running{ 0 };
+    std::atomic<bool> overlapped{ false };
+    std::atomic<bool> outOfOrder{ false };
+    std::atomic<int> received{ 0 };
+    double last = -1.0;
+};
+
+static void order_callback(SGSLrmHandle, double distance, SGSLrmStatus, void* userdata)
+{
+    OrderProbe* probe = (OrderProbe*)userdata;
+    if (probe->running.fetch_add(1) != 0) probe->overlapped = true;
+    if (distance <= probe->last) probe->outOfOrder = true;
+    probe->last = distance;
+    probe->running--;
+    probe->received++;
+}
+
+void test_ordering()
+{
+    printf("Test 1: Per-handle order across the worker pool...\n");
+
+    const int kQueues = 4, kPosts = 2000;
+    static SGSLrmDispatchQueue queues[kQueues];
+    OrderProbe probes[kQueues];
+    SGSLrmCallbackPolicy policy = {};
+    for (int q = 0; q < kQueues; ++q) {
+        SGSLrmDispatchQueue_Init(&queues[q], &queues[q]);
+        SGSLrmDispatcher_Attach(&queues[q], &policy);
+    }
+    check(SGSLrmDispatcher_ThreadCount() == SGS_LRM_DISPATCH_WORKERS, "worker pool started by first attach");
+
+    std::vector<std::thread> producers;
+    for (int q = 0; q < kQueues; ++q) {
+        producers.emplace_back([&, q] {
+            for (int i = 0; i < kPosts; ++i) {
+                while (true) {
+                    SGSLrmCallbackStats stats;
+                    SGSLrmDispatcher_GetStats(&queues[q], &stats);
+                    if (stats.queueDepth < SGS_LRM_CALLBACK_QUEUE_MAX) break; // Lossless for this test
+                    std::this_thread::yield();
+                }
+                post(&queues[q], order_callback, &probes[q], i, SGS_LRM_SUCCESS);
+            }
+        });
+    }
+    for (auto& th : producers) th.join();
+
+    bool all = wait_for([&] {
+        for (int q = 0; q < kQueues; ++q) if (probes[q].received < kPosts) return false;
+        return true;
+    });
+    bool ordered = true, exclusive = true;
+    for (int q = 0; q < kQueues; ++q) {
+        ordered = ordered && !probes[q].outOfOrder;
+        exclusive = exclusive && !probes[q].overlapped;
+    }
+    check(all, "every posted sample delivered");
+    check(ordered, "each handle's samples delivered in order");
+    check(exclusive, "never two callbacks of one handle at once");
+
+    for (int q = 0; q < kQueues; ++q) SGSLrmDispatcher_Detach(&queues[q]);
+    check(SGSLrmDispatcher_ThreadCount() == 0, "worker pool stopped by last detach");
+    printf("\n");
+}
+
+// Callback that parks the worker until the test opens the gate.
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+    std::atomic<int> entered{ 0 };
+    std::vector<double> seen;
+};
+
+static void gated_callback(SGSLrmHandle, double distance, SGSLrmStatus, void* userdata)
+{
+    Gate* gate = (Gate*)userdata;
+    std::unique_lock<std::mutex> guard(gate->mutex);
+    gate->seen.push_back(distance);
+    gate->entered++;
+    gate->cv.wait(guard, [&] { return gate->open; });
+}
+
+static void open_gate(Gate& gate)
+{
+    std::lock_guard<std::mutex> guard(gate.mutex);
+    gate.open = true;
+    gate.cv.notify_all();
+}
+
+void test_overflow_and_coalesce()
+{
+    printf("Test 2: Bounded depth drops oldest, coalescing keeps newest...\n");
+
+    static SGSLrmDispatchQueue queue;
+    SGSLrmDispatchQueue_Init(&queue, &queue);
+
+    {
+        Gate gate;
+        SGSLrmCallbackPolicy policy = {};
+        policy.maxQueueDepth = 8;
+        SGSLrmDispatcher_Attach(&queue, &policy);
+
+        post(&queue, gated_callback, &gate, 0, SGS_LRM_SUCCESS);
+        wait_for([&] { return gate.entered == 1; });   // Worker now blocked on sample 0
+        for (int i = 1; i <= 13; ++i) post(&queue, gated_callback, &gate, i, SGS_LRM_SUCCESS);
+
+        SGSLrmCallbackStats stats;
+        SGSLrmDispatcher_GetStats(&queue, &stats);
+        check(stats.queueDepth == 8 && stats.maxQueueDepthSeen == 8, "queue capped at maxQueueDepth");
+        check(stats.dropped == 5, "5 oldest pending samples dropped");
+
+        open_gate(gate);
+        wait_for([&] { SGSLrmDispatcher_GetStats(&queue, &stats); return stats.delivered == 9; });
+        std::lock_guard<std::mutex> guard(gate.mutex);
+        bool newest = gate.seen.size() == 9 && gate.seen[1] == 6 && gate.seen[8] == 13;
+        check(newest, "samples 6..13 delivered after the blocked one");
+    }
+
+    SGSLrmDispatcher_Detach(&queue);
+    SGSLrmDispatchQueue_Init(&queue, &queue);
+
+    {
+        Gate gate;
+        SGSLrmCallbackPolicy policy = {};
+        policy.coalesce = true;
+        SGSLrmDispatcher_Attach(&queue, &policy);
+
+        post(&queue, gated_callback, &gate, 0, SGS_LRM_SUCCESS);
+        wait_for([&] { return gate.entered == 1; });
+        for (int i = 1; i <= 10; ++i) post(&queue, gated_callback, &gate, i, SGS_LRM_SUCCESS);
+
+        SGSLrmCallbackStats stats;
+        SGSLrmDispatcher_GetStats(&queue, &stats);
+        check(stats.queueDepth == 1 && stats.coalesced == 9 && stats.dropped == 0, "9 stale samples coalesced, 1 pending");
+
+        open_gate(gate);
+        wait_for([&] { SGSLrmDispatcher_GetStats(&queue, &stats); return stats.delivered == 2; });
+        std::lock_guard<std::mutex> guard(gate.mutex);
+        check(gate.seen.size() == 2 && gate.seen[1] == 10, "only the newest sample delivered");
+    }
+
+    SGSLrmDispatcher_Detach(&queue);
+    check(!post(&queue, gated_callback, NULL, 0, SGS_LRM_SUCCESS), "post to a detached queue refused");
+    printf("\n");
+}
+
+static std::atomic<bool> g_slowRunning{ false };
+
+static void slow_callback(SGSLrmHandle, double, SGSLrmStatus, void*)
+{
+    g_slowRunning = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    g_slowRunning = false;
+}
+
+void test_cancel_waits()
+{
+    printf("Test 3: Cancel discards pending and waits for the running callback...\n");
+
+    static SGSLrmDispatchQueue queue;
+    SGSLrmDispatchQueue_Init(&queue, &queue);
+    SGSLrmCallbackPolicy policy = {};
+    SGSLrmDispatcher_Attach(&queue, &policy);
+
+    for (int i = 0; i < 5; ++i) post(&queue, slow_callback, NULL, i, SGS_LRM_SUCCESS);
+    wait_for([&] { return g_slowRunning.load(); });
+    SGSLrmDispatcher_Cancel(&queue);
+    bool idle = !g_slowRunning;
+
+    SGSLrmCallbackStats stats;
+    SGSLrmDispatcher_GetStats(&queue, &stats);
+    check(idle, "no callback running after Cancel");
+    check(stats.delivered == 1 && stats.dropped == 4 && stats.queueDepth == 0, "4 pending samples discarded");
+
+    SGSLrmDispatcher_Detach(&queue);
+    printf("\n");
+}
+
+// ---- Part 2: end to end ----
+
+#if !defined(_WIN32)
+
+// Largest gap between consecutive published samples over a 1.5 s stream
+// while the callback takes 150 ms per sample.
+static unsigned long long stream_with_slow_callback(PtyModuleSimulator& sim, SGSLrmCallbackMode mode,
+    const SGSLrmCallbackPolicy* policy, SGSLrmCallbackStats* stats, int* samples)
+{
+    SGSLrmHandle handle;
+    SGSLrm_CreateHandle(&handle);
+    SGSLrm_Connect(handle, sim.PortName());
+    SGSLrm_SetCallbackMode(handle, mode, policy);
+    SGSLrm_SetMeasurementCallback(handle, [](SGSLrmHandle, double, SGSLrmStatus, void*) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150)); // e.g. a database insert
+    }, NULL);
+
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    SGSLrm_GetCallbackStats(handle, stats);
+    SGSLrm_StopContinuousMeasurement(handle);
+
+    SGSLrmSample buffer[256];
+    int count = 0;
+    SGSLrm_ReadSamples(handle, buffer, 256, &count);
+    unsigned long long maxGap = 0;
+    for (int i = 2; i < count; ++i) { // The first frame is paced by the module, not by us
+        unsigned long long gap = buffer[i].timestampMs - buffer[i - 1].timestampMs;
+        if (gap > maxGap) maxGap = gap;
+    }
+    *samples = count;
+
+    SGSLrm_Disconnect(handle);
+    SGSLrm_DestroyHandle(handle);
+    return maxGap;
+}
+
+void test_slow_callback_stream()
+{
+    printf("Test 4: Slow callback vs a 20 Hz stream...\n");
+
+    PtyModuleSimulator sim;
+    sim.modules[0x80].frequencyHz = 20;
+    if (!sim.Start()) { check(false, "pty allocated"); return; }
+
+    SGSLrmCallbackStats stats;
+    int samples = 0;
+    char what[128];
+
+    unsigned long long inlineGap = stream_with_slow_callback(sim, SGS_LRM_CALLBACK_INLINE, NULL, &stats, &samples);
+    snprintf(what, sizeof(what), "INLINE: reception stalls behind the callback (max gap %llu ms)", inlineGap);
+    check(inlineGap >= 100, what);
+
+    SGSLrmCallbackPolicy policy = {};
+    policy.maxQueueDepth = 4;
+    unsigned long long queuedGap = stream_with_slow_callback(sim, SGS_LRM_CALLBACK_QUEUED, &policy, &stats, &samples);
+    snprintf(what, sizeof(what), "QUEUED: %d samples, max gap %llu ms", samples, queuedGap);
+    check(samples >= 25 && queuedGap < 100, what);
+    snprintf(what, sizeof(what), "counters: %lu delivered, %lu dropped, depth %d (max %d)",
+        stats.delivered, stats.dropped, stats.queueDepth, stats.maxQueueDepthSeen);
+    check(stats.delivered >= 5 && stats.dropped > 0 && stats.maxQueueDepthSeen == 4, what);
+    check(SGSLrmDispatcher_ThreadCount() == 0, "workers released with the handle");
+
+    sim.Stop();
+    printf("\n");
+}
+#endif
+
+int main()
+{
+    print_banner("Callback dispatch");
+
+    test_ordering();
+    test_overflow_and_coalesce();
+    test_cancel_waits();
+#if !defined(_WIN32)
+    test_slow_callback_stream();
+#endif
+
+    return report_results();
+}
@@ -0,0 +1,155 @@
+// Tests for per-command response deadlines (SGSLrm_SetCommandTimeout).
+// A silent pty module must fail each command after its own deadline rather
+// than a flat second; a slow but live module must be answered as soon as its
+// frame completes, not when the deadline runs out.
+//
+// Build (Linux): make test_command_timeout (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+
+template <typename Call>
+static double elapsed_ms(Call call)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    call();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void set_module(PtyModuleSimulator& sim, bool silent, int delayMs)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    sim.modules[0x80].silent = silent;
+    sim.modules[0x80].responseDelayMs = delayMs;
+}
+
+void test_api(SGSLrmHandle handle)
+{
+    printf("Test 1: Timeout table API...\n");
+
+    int ms = 0;
+    SGSLrm_GetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, &ms);
+    check(ms == 50, "read cache defaults to 50 ms");
+    SGSLrm_GetCommandTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, &ms);
+    check(ms == 1000, "single measurement defaults to 1000 ms");
+
+    check(SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_COUNT, 100) == SGS_LRM_INVALID_PARAMETER, "unknown command rejected");
+    check(SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, -1) == SGS_LRM_INVALID_PARAMETER, "negative timeout rejected");
+    check(SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, 60001) == SGS_LRM_INVALID_PARAMETER, "timeout above 60 s rejected");
+    check(SGSLrm_GetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL output rejected");
+
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, 250);
+    SGSLrm_GetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, &ms);
+    check(ms == 250, "override stored");
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, 0);
+    SGSLrm_GetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, &ms);
+    check(ms == 50, "0 restores the default");
+    printf("\n");
+}
+
+void test_dead_sensor(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 2: A dead sensor fails each command at its own deadline...\n");
+
+    set_module(sim, true, 0);
+    char what[96];
+    double distance = 0.0;
+    SGSLrmStatus status = SGS_LRM_SUCCESS;
+
+    double ms = elapsed_ms([&] { status = SGSLrm_ReadCache(handle, &distance); });
+    snprintf(what, sizeof(what), "ReadCache timed out after %.0f ms", ms);
+    check(status == SGS_LRM_TIMEOUT && ms >= 45 && ms < 150, what);
+
+    char id[32];
+    ms = elapsed_ms([&] { status = SGSLrm_ReadDeviceID(handle, id, sizeof(id)); });
+    snprintf(what, sizeof(what), "ReadDeviceID timed out after %.0f ms", ms);
+    check(status == SGS_LRM_TIMEOUT && ms >= 75 && ms < 200, what);
+
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, 200);
+    ms = elapsed_ms([&] { status = SGSLrm_SingleMeasurement(handle, &distance); });
+    snprintf(what, sizeof(what), "SingleMeasurement with a 200 ms override timed out after %.0f ms", ms);
+    check(status == SGS_LRM_TIMEOUT && ms >= 195 && ms < 300, what);
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, 0);
+
+    set_module(sim, false, 0);
+    printf("\n");
+}
+
+void test_slow_sensor(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 3: A slow sensor is answered when its frame completes...\n");
+
+    set_module(sim, false, 120);
+    char what[96];
+    double distance = 0.0;
+    SGSLrmStatus status = SGS_LRM_TIMEOUT;
+
+    double ms = elapsed_ms([&] { status = SGSLrm_ReadCache(handle, &distance); });
+    snprintf(what, sizeof(what), "120 ms cache answer misses the 50 ms default (%.0f ms)", ms);
+    check(status == SGS_LRM_TIMEOUT && ms < 150, what);
+    // The late cache answer is still buffered; a measurement skips past it
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS, "late answer discarded by the next transaction");
+
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, 2000);
+    ms = elapsed_ms([&] { status = SGSLrm_ReadCache(handle, &distance); });
+    snprintf(what, sizeof(what), "with a 2 s deadline it returns in %.0f ms", ms);
+    check(status == SGS_LRM_SUCCESS && fabs(distance - 1.234) < 1e-9 && ms >= 115 && ms < 300, what);
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_READ_CACHE, 0);
+
+    set_module(sim, false, 0);
+    printf("\n");
+}
+
+static std::atomic<int> g_timeouts{ 0 };
+static std::atomic<long long> g_firstTimeoutMs{ 0 };
+
+void test_continuous_deadline(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 4: CONTINUOUS deadline paces TIMEOUT samples...\n");
+
+    set_module(sim, true, 0);
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_CONTINUOUS, 150);
+    static std::chrono::steady_clock::time_point s_start;
+    s_start = std::chrono::steady_clock::now();
+    SGSLrm_SetMeasurementCallback(handle, [](SGSLrmHandle, double, SGSLrmStatus status, void*) {
+        if (status != SGS_LRM_TIMEOUT) return;
+        if (g_timeouts++ == 0) {
+            g_firstTimeoutMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - s_start).count();
+        }
+    }, NULL);
+
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    SGSLrm_StopContinuousMeasurement(handle);
+    SGSLrm_SetMeasurementCallback(handle, NULL, NULL);
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_CONTINUOUS, 0);
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d TIMEOUT samples in 700 ms, first after %lld ms", g_timeouts.load(), g_firstTimeoutMs.load());
+    check(g_timeouts >= 3 && g_firstTimeoutMs >= 140 && g_firstTimeoutMs < 300, what);
+
+    set_module(sim, false, 0);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Per-command timeouts");
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_api(handle);
+    test_dead_sensor(sim, handle);
+    test_slow_sensor(sim, handle);
+    test_continuous_deadline(sim, handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
@@ -0,0 +1,67 @@
+// Scaffolding shared by the POSIX test and benchmark programs: the pass/fail
+// count, the banner and summary around a run, and a handle connected to a
+// simulated module. The Makefile next to this file builds every program;
+// `make check` runs them all.
+
+#pragma once
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+static int g_failures = 0;
+
+static inline void check(bool ok, const char* what)
+{
+    printf("  %s %s\n", ok ? "✓" : "❌", what);
+    if (!ok) g_failures++;
+}
+
+static inline void print_banner(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    printf("========================================\n");
+    vprintf(format, args);
+    printf("\n========================================\n\n");
+    va_end(args);
+}
+
+// Prints the summary; returns the program's exit code
+static inline int report_results()
+{
+    printf("========================================\n");
+    printf("%s (%d failure%s)\n", g_failures == 0 ? "All Tests Passed" : "Tests FAILED", g_failures, g_failures == 1 ? "" : "s");
+    printf("========================================\n");
+    return g_failures == 0 ? 0 : 1;
+}
+
+#if !defined(_WIN32)
+#include "pty_module_simulator.h"
+
+// Starts sim (set its modules up first) and connects a new handle to it;
+// false, with the reason printed, when either fails
+static inline bool connect_simulated(PtyModuleSimulator& sim, SGSLrmHandle* handle)
+{
+    if (!sim.Start()) {
+        printf("pty allocation failed\n");
+        return false;
+    }
+
+    SGSLrm_CreateHandle(handle);
+    if (SGSLrm_Connect(*handle, sim.PortName()) != SGS_LRM_SUCCESS) {
+        printf("connect failed\n");
+        SGSLrm_DestroyHandle(*handle);
+        sim.Stop();
+        return false;
+    }
+    return true;
+}
+
+static inline void disconnect_simulated(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    SGSLrm_Disconnect(handle);
+    SGSLrm_DestroyHandle(handle);
+    sim.Stop();
+}
+#endif
@@ -0,0 +1,211 @@
+// Tests for acknowledged config writes.
+// Every FA 04 setter must read its FA 04 8X ack: a rejection is reported as
+// SGS_LRM_CONFIG_REJECTED and a missing ack as SGS_LRM_TIMEOUT, and no ack is
+// left on the line for the next measurement to trip over. While the line
+// streams the writes are queued and settled by the reactor, with failures
+// reported per register by SGSLrm_GetConfigStatus.
+//
+// Build (Linux): make test_config_acks (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+#include <functional>
+
+static double elapsed_ms(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+struct Setter {
+    const char* name;
+    unsigned char subcommand;
+    unsigned int field;
+    std::function<SGSLrmStatus(SGSLrmHandle)> call;
+};
+
+static std::vector<Setter> setters()
+{
+    return {
+        { "SetRange", 0x09, SGS_LRM_CONFIG_RANGE, [](SGSLrmHandle h) { return SGSLrm_SetRange(h, SGS_LRM_RANGE_50M); } },
+        { "SetResolution", 0x0C, SGS_LRM_CONFIG_RESOLUTION, [](SGSLrmHandle h) { return SGSLrm_SetResolution(h, SGS_LRM_RESOLUTION_1MM); } },
+        { "SetFrequency", 0x0A, SGS_LRM_CONFIG_FREQUENCY, [](SGSLrmHandle h) { return SGSLrm_SetFrequency(h, SGS_LRM_FREQUENCY_10HZ); } },
+        { "SetMeasurementInterval", 0x05, SGS_LRM_CONFIG_INTERVAL, [](SGSLrmHandle h) { return SGSLrm_SetMeasurementInterval(h, 0); } },
+        { "SetDistanceCorrection", 0x06, SGS_LRM_CONFIG_CORRECTION, [](SGSLrmHandle h) { return SGSLrm_SetDistanceCorrection(h, -3); } },
+        { "SetStartPosition", 0x08, SGS_LRM_CONFIG_START_POSITION, [](SGSLrmHandle h) { return SGSLrm_SetStartPosition(h, SGS_LRM_START_POSITION_TAIL); } },
+        { "SetAutoMeasurement", 0x0D, SGS_LRM_CONFIG_AUTO_MEASUREMENT, [](SGSLrmHandle h) { return SGSLrm_SetAutoMeasurement(h, false); } },
+    };
+}
+
+static void set_module(PtyModuleSimulator& sim, int address, bool acks, int reject)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    sim.modules[address].configAcks = acks;
+    sim.modules[address].rejectSubcommand = reject;
+}
+
+void test_setters(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 1: Every setter reads its ack...\n");
+
+    bool accepted = true, rejected = true, timedOut = true, reported = true;
+    double slowestMs = 0.0;
+    for (const Setter& setter : setters()) {
+        accepted = setter.call(handle) == SGS_LRM_SUCCESS && accepted;
+
+        set_module(sim, 0x80, true, setter.subcommand);
+        rejected = setter.call(handle) == SGS_LRM_CONFIG_REJECTED && rejected;
+        unsigned int pending = 0, failed = 0;
+        SGSLrm_GetConfigStatus(handle, &pending, &failed);
+        reported = pending == 0 && failed == setter.field && reported;
+
+        set_module(sim, 0x80, false, 0);
+        auto t0 = std::chrono::steady_clock::now();
+        timedOut = setter.call(handle) == SGS_LRM_TIMEOUT && timedOut;
+        slowestMs = std::max(slowestMs, elapsed_ms(t0));
+
+        set_module(sim, 0x80, true, 0);
+        accepted = setter.call(handle) == SGS_LRM_SUCCESS && accepted;
+        SGSLrm_GetConfigStatus(handle, &pending, &failed);
+        reported = failed == 0 && reported;
+    }
+
+    char what[128];
+    check(accepted, "acknowledged writes succeed");
+    check(rejected, "failure code reported as CONFIG_REJECTED");
+    snprintf(what, sizeof(what), "missing ack reported as TIMEOUT (slowest %.0f ms)", slowestMs);
+    check(timedOut && slowestMs < 200.0, what);
+    check(reported, "failed register named until a later write of it is acknowledged");
+
+    unsigned int pending, failed;
+    check(SGSLrm_GetConfigStatus(handle, NULL, &failed) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_GetConfigStatus(handle, &pending, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL outputs rejected");
+    printf("\n");
+}
+
+void test_read_path(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 2: No stale acks on the read path...\n");
+
+    // Each reconfiguration is followed at once by a measurement
+    const int kRounds = 100;
+    int clean = 0;
+    for (int i = 0; i < kRounds; ++i) {
+        SGSLrm_SetRange(handle, i % 2 ? SGS_LRM_RANGE_80M : SGS_LRM_RANGE_30M);
+        SGSLrm_SetFrequency(handle, i % 2 ? SGS_LRM_FREQUENCY_20HZ : SGS_LRM_FREQUENCY_10HZ);
+        double distance = 0.0;
+        if (SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS && fabs(distance - 1.234) < 1e-9) clean++;
+    }
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d/%d first measurements after a reconfiguration clean", clean, kRounds);
+    check(clean == kRounds, what);
+
+    // A rejected write leaves nothing behind either
+    set_module(sim, 0x80, true, 0x09);
+    SGSLrm_SetRange(handle, SGS_LRM_RANGE_5M);
+    set_module(sim, 0x80, true, 0);
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS && fabs(distance - 1.234) < 1e-9, "clean after a rejection");
+    printf("\n");
+}
+
+void test_address(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 3: SetAddress waits for its ack...\n");
+
+    double distance = 0.0;
+    check(SGSLrm_SetAddress(handle, 0x90) == SGS_LRM_SUCCESS && SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS,
+        "acknowledged: the handle follows the module");
+
+    set_module(sim, 0x90, false, 0);
+    check(SGSLrm_SetAddress(handle, 0x91) == SGS_LRM_TIMEOUT, "unanswered: TIMEOUT");
+    {
+        // The module moved anyway; move it back under the address the handle kept
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x90] = sim.modules[0x91];
+        sim.modules.erase(0x91);
+        sim.modules[0x90].configAcks = true;
+    }
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS, "handle kept its address");
+
+    SGSLrm_StartContinuousMeasurement(handle);
+    check(SGSLrm_SetAddress(handle, 0x80) == SGS_LRM_INVALID_PARAMETER, "refused while streaming");
+    SGSLrm_StopContinuousMeasurement(handle);
+    check(SGSLrm_SetAddress(handle, 0x80) == SGS_LRM_SUCCESS, "moved back");
+    printf("\n");
+}
+
+void test_streaming(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 4: Writes queued while streaming...\n");
+
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Several writes in flight before any ack is read
+    auto t0 = std::chrono::steady_clock::now();
+    bool sent = SGSLrm_SetRange(handle, SGS_LRM_RANGE_80M) == SGS_LRM_SUCCESS;
+    sent = SGSLrm_SetFrequency(handle, SGS_LRM_FREQUENCY_20HZ) == SGS_LRM_SUCCESS && sent;
+    sent = SGSLrm_SetStartPosition(handle, SGS_LRM_START_POSITION_TOP) == SGS_LRM_SUCCESS && sent;
+    double ms = elapsed_ms(t0);
+    char what[128];
+    snprintf(what, sizeof(what), "three writes queued in %.1f ms", ms);
+    check(sent && ms < 50.0, what);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    unsigned int pending = 1, failed = 1;
+    SGSLrm_GetConfigStatus(handle, &pending, &failed);
+    SGSLrmConfig shadow;
+    SGSLrm_GetConfig(handle, &shadow);
+    check(pending == 0 && failed == 0, "the reactor settled every ack");
+    check(shadow.range == SGS_LRM_RANGE_80M && shadow.frequency == SGS_LRM_FREQUENCY_20HZ &&
+        shadow.startPosition == SGS_LRM_START_POSITION_TOP, "shadow holds the queued values");
+
+    // One rejected, one unanswered
+    set_module(sim, 0x80, true, 0x0A);
+    SGSLrm_SetFrequency(handle, SGS_LRM_FREQUENCY_5HZ);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    set_module(sim, 0x80, false, 0);
+    SGSLrm_SetRange(handle, SGS_LRM_RANGE_10M);
+    SGSLrm_GetConfigStatus(handle, &pending, &failed);
+    check(pending == SGS_LRM_CONFIG_RANGE && failed == SGS_LRM_CONFIG_FREQUENCY, "rejection surfaced, missing ack still pending");
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    SGSLrm_GetConfigStatus(handle, &pending, &failed);
+    SGSLrm_GetConfig(handle, &shadow);
+    check(pending == 0 && failed == (SGS_LRM_CONFIG_RANGE | SGS_LRM_CONFIG_FREQUENCY), "missing ack surfaced after its deadline");
+    check(!(shadow.fields & (SGS_LRM_CONFIG_RANGE | SGS_LRM_CONFIG_FREQUENCY)), "both unknown in the shadow");
+
+    set_module(sim, 0x80, true, 0);
+    SGSLrm_SetRange(handle, SGS_LRM_RANGE_10M);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    SGSLrm_GetConfigStatus(handle, &pending, &failed);
+    check(failed == SGS_LRM_CONFIG_FREQUENCY, "rewrite clears its register");
+
+    SGSLrm_StopContinuousMeasurement(handle);
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS, "transactions resume cleanly");
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Acknowledged config writes");
+
+    PtyModuleSimulator sim;
+    sim.baudRate = 9600;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_setters(sim, handle);
+    test_read_path(sim, handle);
+    test_address(sim, handle);
+    test_streaming(sim, handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
@@ -0,0 +1,290 @@
+// Tests for the per-handle filter pipeline (SGSLrm_SetFilter).
+// The two-heap sliding median must agree with a sorted copy of the window for
+// every window size and input, and cost less than sorting; the Hampel stage
+// must replace spikes but follow a real step; and on a pty module the
+// pipeline must sit between the parser and everything that publishes, with
+// the raw reading still available.
+//
+// Build (Linux): make test_filter (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "../SGSLaserRangingModule/SGSLrmFilter.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <deque>
+
+static int sorted_median(const std::deque<int>& window)
+{
+    std::vector<int> sorted(window.begin(), window.end());
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    if (n & 1) return sorted[n / 2];
+    return sorted[n / 2 - 1] + (sorted[n / 2] - sorted[n / 2 - 1]) / 2;
+}
+
+static SGSLrmFilterConfig no_filter()
+{
+    SGSLrmFilterConfig config;
+    memset(&config, 0, sizeof(config));
+    return config;
+}
+
+void test_mediator()
+{
+    printf("Test 1: Sliding median against a sorted window...\n");
+
+    srand(7);
+    int mismatches = 0;
+    long checked = 0;
+    for (int window = 1; window <= SGS_LRM_FILTER_WINDOW_MAX; ++window) {
+        for (int range : { 4, 1000, 2000000 }) {  // Many ties, some, almost none
+            SGSLrmMediator m;
+            SGSLrmMediator_Init(&m, window);
+            std::deque<int> reference;
+            for (int i = 0; i < 1500; ++i) {
+                int v = rand() % range;
+                SGSLrmMediator_Insert(&m, v);
+                reference.push_back(v);
+                if ((int)reference.size() > window) reference.pop_front();
+                if (SGSLrmMediator_Median(&m) != sorted_median(reference)) mismatches++;
+                checked++;
+            }
+        }
+    }
+
+    char what[96];
+    snprintf(what, sizeof(what), "windows 1..%d, %ld medians, %d mismatches", SGS_LRM_FILTER_WINDOW_MAX, checked, mismatches);
+    check(mismatches == 0, what);
+
+    // Monotonic runs exercise the heaps' worst paths
+    SGSLrmMediator m;
+    SGSLrmMediator_Init(&m, 9);
+    std::deque<int> reference;
+    bool ok = true;
+    for (int i = 0; i < 200; ++i) {
+        int v = i < 100 ? i : 200 - i;
+        SGSLrmMediator_Insert(&m, v);
+        reference.push_back(v);
+        if (reference.size() > 9) reference.pop_front();
+        ok = SGSLrmMediator_Median(&m) == sorted_median(reference) && ok;
+    }
+    check(ok, "rising then falling input");
+    printf("\n");
+}
+
+void test_cost()
+{
+    printf("Test 2: Median cost per reading...\n");
+
+    const int kReadings = 200000;
+    std::vector<int> input(kReadings);
+    srand(3);
+    for (int& v : input) v = 12340 + rand() % 50;
+
+    long sink = 0;
+    printf("%-8s %14s %14s\n", "window", "mediator ns", "sort ns");
+    double mediatorNs63 = 0.0, sortNs63 = 0.0;
+    for (int window : { 7, 31, 63 }) {
+        SGSLrmMediator m;
+        SGSLrmMediator_Init(&m, window);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int v : input) {
+            SGSLrmMediator_Insert(&m, v);
+            sink += SGSLrmMediator_Median(&m);
+        }
+        double mediatorNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / kReadings;
+
+        std::deque<int> ring;
+        std::vector<int> scratch;
+        t0 = std::chrono::steady_clock::now();
+        for (int v : input) {
+            ring.push_back(v);
+            if ((int)ring.size() > window) ring.pop_front();
+            scratch.assign(ring.begin(), ring.end());
+            std::sort(scratch.begin(), scratch.end());
+            sink += scratch[scratch.size() / 2];
+        }
+        double sortNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / kReadings;
+        printf("%-8d %14.1f %14.1f\n", window, mediatorNs, sortNs);
+        mediatorNs63 = mediatorNs;
+        sortNs63 = sortNs;
+    }
+    printf("(checksum %ld)\n", sink);
+
+    char what[96];
+    snprintf(what, sizeof(what), "63-wide window: %.1f ns per reading, sorting takes %.1f", mediatorNs63, sortNs63);
+    check(mediatorNs63 < sortNs63, what);
+    printf("\n");
+}
+
+void test_stages()
+{
+    printf("Test 3: Pipeline stages...\n");
+
+    SGSLrmFilterConfig config = no_filter();
+    config.hampelWindow = 4;
+    config.hampelThreshold = 3.0;
+    check(SGSLrmFilter_Validate(&config) == SGS_LRM_INVALID_PARAMETER, "even Hampel window rejected");
+    config.hampelWindow = 5;
+    config.hampelThreshold = 0.0;
+    check(SGSLrmFilter_Validate(&config) == SGS_LRM_INVALID_PARAMETER, "zero threshold rejected");
+    config = no_filter();
+    config.medianWindow = SGS_LRM_FILTER_WINDOW_MAX + 1;
+    check(SGSLrmFilter_Validate(&config) == SGS_LRM_INVALID_PARAMETER, "oversized window rejected");
+
+    // Hampel: noise kept, a spike replaced, a step followed
+    SGSLrmFilter filter;
+    config = no_filter();
+    config.hampelWindow = 7;
+    config.hampelThreshold = 3.0;
+    SGSLrmFilter_Init(&filter, &config);
+    static const int noise[] = { 10000, 10003, 9998, 10001, 9999, 10002, 10000, 10001 };
+    bool kept = true;
+    for (int v : noise) kept = SGSLrmFilter_Apply(&filter, v) == v && kept;
+    check(kept, "noise passes unchanged");
+    int spike = SGSLrmFilter_Apply(&filter, 25000);
+    check(spike == 10001 && filter.stats.rejected == 1, "spike replaced by the window median");
+
+    int out = 0;
+    int steps = 0;
+    while (steps < 10 && (out = SGSLrmFilter_Apply(&filter, 20000)) != 20000) steps++;
+    char what[96];
+    snprintf(what, sizeof(what), "step to 2 m followed after %d held readings", steps);
+    check(out == 20000 && steps <= 3, what);
+
+    // A flat window has MAD 0: the floor keeps 1 mm quantisation from counting as outliers
+    config.hampelFloorTenthMm = 20;
+    SGSLrmFilter_Init(&filter, &config);
+    for (int i = 0; i < 7; ++i) SGSLrmFilter_Apply(&filter, 5000);
+    check(SGSLrmFilter_Apply(&filter, 5010) == 5010 && SGSLrmFilter_Apply(&filter, 5100) == 5000, "floor: 1 mm kept, 10 mm replaced");
+
+    // Median then average
+    config = no_filter();
+    config.medianWindow = 3;
+    config.averageWindow = 4;
+    SGSLrmFilter_Init(&filter, &config);
+    static const int input[] = { 100, 300, 200, 9000, 400, 500 };
+    static const int expected[] = { 100, 150, 167, 200, 275, 350 };   // medians 100 200 200 300 400 500
+    bool chained = true;
+    for (int i = 0; i < 6; ++i) chained = SGSLrmFilter_Apply(&filter, input[i]) == expected[i] && chained;
+    check(chained, "median feeds the average, rounded to the nearest unit");
+
+    SGSLrmFilter_Init(&filter, NULL);
+    check(!SGSLrmFilter_IsEnabled(&filter) && SGSLrmFilter_Apply(&filter, 1234) == 1234, "no config: pass-through");
+    printf("\n");
+}
+
+static void set_module(PtyModuleSimulator& sim, double distance, int errorCode)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    sim.modules[0x80].distance = distance;
+    sim.modules[0x80].errorCode = errorCode;
+}
+
+struct Stream {
+    std::mutex mutex;
+    std::vector<SGSLrmMeasurementEx> received;
+};
+
+static void ex_callback(SGSLrmHandle, const SGSLrmMeasurementEx* measurement, void* userdata)
+{
+    Stream* stream = (Stream*)userdata;
+    std::lock_guard<std::mutex> guard(stream->mutex);
+    stream->received.push_back(*measurement);
+}
+
+void test_handle(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 4: Pipeline on a handle...\n");
+
+    SGSLrmFilterConfig config = no_filter();
+    config.hampelWindow = 9;
+    check(SGSLrm_SetFilter(handle, &config) == SGS_LRM_INVALID_PARAMETER, "invalid config rejected");
+    check(SGSLrm_SetFilter(NULL, NULL) == SGS_LRM_INVALID_HANDLE, "NULL handle rejected");
+    check(SGSLrm_GetFilterStats(handle, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL stats output rejected");
+
+    config.hampelThreshold = 3.0;
+    config.hampelFloorTenthMm = 10;
+    check(SGSLrm_SetFilter(handle, &config) == SGS_LRM_SUCCESS, "Hampel 9 set");
+
+    static const double readings[] = { 1.234, 1.235, 1.233, 1.234, 1.236, 1.234, 1.232, 1.235, 1.234 };
+    int tenthMm = 0;
+    for (double r : readings) {
+        set_module(sim, r, 0);
+        SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, NULL);
+    }
+
+    // A reflection, then a hardware error, then a normal reading
+    set_module(sim, 7.777, 0);
+    SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, NULL);
+    SGSLrmSnapshot snapshot;
+    SGSLrm_GetSnapshot(handle, &snapshot);
+    check(tenthMm == 12340 && snapshot.distanceTenthMm == 12340 && snapshot.rawDistanceTenthMm == 77770,
+        "spike published as the median, raw reading kept");
+    double distance = 0.0;
+    SGSLrm_GetLastMeasurement(handle, &distance);
+    check(distance == 1.234, "GetLastMeasurement is filtered");
+
+    set_module(sim, 1.0, 16);
+    check(SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, NULL) == SGS_LRM_MEASUREMENT_ERROR, "error frame reported");
+    set_module(sim, 1.236, 0);
+    SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, NULL);
+    SGSLrmFilterStats stats;
+    SGSLrm_GetFilterStats(handle, &stats);
+    check(tenthMm == 12360 && stats.filtered == 11 && stats.rejected == 1, "error bypassed the filter: 11 filtered, 1 rejected");
+
+    // Streaming: callbacks and samples carry the filtered value
+    config = no_filter();
+    config.medianWindow = 5;
+    SGSLrm_SetFilter(handle, &config);
+    Stream stream;
+    SGSLrm_SetMeasurementCallbackEx(handle, ex_callback, &stream);
+    set_module(sim, 2.0, 0);
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(450));
+    set_module(sim, 9.0, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    set_module(sim, 2.0, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    SGSLrm_StopContinuousMeasurement(handle);
+    SGSLrm_SetMeasurementCallbackEx(handle, NULL, NULL);
+
+    std::lock_guard<std::mutex> guard(stream.mutex);
+    bool sawSpike = false, smoothed = stream.received.size() >= 6;
+    for (const SGSLrmMeasurementEx& m : stream.received) {
+        if (m.rawDistanceTenthMm == 90000) sawSpike = true;
+        smoothed = m.distanceTenthMm == 20000 && smoothed;
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "%d streamed samples all 2 m, spike seen only raw", (int)stream.received.size());
+    check(sawSpike && smoothed, what);
+
+    SGSLrm_SetFilter(handle, NULL);
+    set_module(sim, 3.0, 0);
+    SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, NULL);
+    check(tenthMm == 30000, "filter removed");
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Filter pipeline");
+
+    test_mediator();
+    test_cost();
+    test_stages();
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_handle(sim, handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
@@ -0,0 +1,247 @@
+// Tests for the incremental frame parser (SGSLrmFrameParser).
+// Part 1 feeds byte streams straight into the parser: split frames, merged
+// frames, garbage between frames, both resolutions, ERR and ack frames.
+// Part 2 (POSIX) runs the library against a pty module that dribbles its
+// frames out in small chunks and streams continuous 0x83 frames at 20 Hz.
+//
+// Build (Linux): make test_frame_parser (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "../SGSLaserRangingModule/SGSLrmFrameParser.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+static unsigned char checksum(const std::vector<unsigned char>& bytes)
+{
+    unsigned int sum = 0;
+    for (unsigned char b : bytes) sum += b;
+    return (unsigned char)(0x100 - (sum & 0xFF));
+}
+
+static std::vector<unsigned char> frame(std::vector<unsigned char> head, const char* ascii)
+{
+    head.insert(head.end(), ascii, ascii + strlen(ascii));
+    head.push_back(checksum(head));
+    return head;
+}
+
+// Feeds the whole stream in chunks of chunkSize and collects emitted frames.
+// Each chunk is stamped with its offset, so frames tell where they started and ended.
+static std::vector<SGSLrmFrame> feed(SGSLrmFrameParser* parser, const std::vector<unsigned char>& stream, int chunkSize)
+{
+    std::vector<SGSLrmFrame> out;
+    for (size_t off = 0; off < stream.size(); off += chunkSize) {
+        int n = (int)std::min(stream.size() - off, (size_t)chunkSize);
+        int used = 0;
+        for (;;) {
+            int consumed = 0;
+            SGSLrmFrame f;
+            bool got = SGSLrmFrameParser_Feed(parser, stream.data() + off + used, n - used, off, &consumed, &f);
+            used += consumed;
+            if (!got) break; // all n bytes consumed
+            out.push_back(f);
+        }
+    }
+    SGSLrmFrame f;
+    int consumed = 0;
+    while (SGSLrmFrameParser_Feed(parser, NULL, 0, 0, &consumed, &f)) out.push_back(f);
+    return out;
+}
+
+void test_split_and_merged()
+{
+    printf("Test 1: Split and merged frames...\n");
+
+    std::vector<unsigned char> stream;
+    std::vector<unsigned char> a = frame({ 0x80, 0x06, 0x83 }, "001.234");
+    std::vector<unsigned char> b = frame({ 0x80, 0x06, 0x83 }, "001.235");
+    std::vector<unsigned char> ack = frame({ 0xFA, 0x04, 0x89 }, "");
+    stream.insert(stream.end(), a.begin(), a.end());
+    stream.insert(stream.end(), ack.begin(), ack.end());
+    stream.insert(stream.end(), b.begin(), b.end());
+
+    const int chunkSizes[] = { 1, 3, 7, 64 };
+    for (int chunk : chunkSizes) {
+        SGSLrmFrameParser parser;
+        SGSLrmFrameParser_Init(&parser, SGS_LRM_RESOLUTION_1MM);
+        std::vector<SGSLrmFrame> frames = feed(&parser, stream, chunk);
+        char what[96];
+        snprintf(what, sizeof(what), "chunk=%d: 3 frames (0x83, ack, 0x83), nothing discarded", chunk);
+        check(frames.size() == 3 &&
+              frames[0].type == SGS_LRM_FRAME_MEASUREMENT && frames[0].length == 11 &&
+              frames[1].type == SGS_LRM_FRAME_CONFIG_ACK && frames[1].length == 4 &&
+              frames[2].type == SGS_LRM_FRAME_MEASUREMENT && memcmp(frames[2].data, b.data(), b.size()) == 0 &&
+              parser.discardedBytes == 0, what);
+    }
+    printf("\n");
+}
+
+void test_emit_on_checksum()
+{
+    printf("Test 2: Frame emitted on its checksum byte...\n");
+
+    SGSLrmFrameParser parser;
+    SGSLrmFrameParser_Init(&parser, SGS_LRM_RESOLUTION_1MM);
+    std::vector<unsigned char> f = frame({ 0x80, 0x06, 0x82 }, "012.345");
+    SGSLrmFrame out;
+    int consumed = 0;
+    check(!SGSLrmFrameParser_Feed(&parser, f.data(), 10, 1000, &consumed, &out) && consumed == 10, "no frame before CS");
+    check(SGSLrmFrameParser_Feed(&parser, f.data() + 10, 1, 2000, &consumed, &out) && out.length == 11, "frame on CS byte");
+    check(out.firstByteNs == 1000 && out.lastByteNs == 2000, "stamped with the first byte's and the CS byte's chunk");
+    printf("\n");
+}
+
+void test_resync()
+{
+    printf("Test 3: Resynchronisation past garbage and corruption...\n");
+
+    SGSLrmFrameParser parser;
+    SGSLrmFrameParser_Init(&parser, SGS_LRM_RESOLUTION_1MM);
+
+    std::vector<unsigned char> stream = { 0x00, 0x06, 0x33, 0xFF, 0x80 };
+    std::vector<unsigned char> bad = frame({ 0x80, 0x06, 0x82 }, "001.234");
+    bad[5] ^= 0x01; // corrupt a payload digit -> checksum fails
+    std::vector<unsigned char> good = frame({ 0x80, 0x06, 0x82 }, "002.000");
+    stream.insert(stream.end(), bad.begin(), bad.end());
+    stream.insert(stream.end(), good.begin(), good.end());
+
+    std::vector<SGSLrmFrame> frames = feed(&parser, stream, 5);
+    check(frames.size() == 1 && memcmp(frames[0].data, good.data(), good.size()) == 0, "only the good frame emitted");
+    check(parser.discardedBytes == 5 + bad.size(), "garbage and corrupted frame counted as discarded");
+    printf("\n");
+}
+
+void test_frame_types()
+{
+    printf("Test 4: Frame types and lengths...\n");
+
+    SGSLrmFrameParser parser;
+    SGSLrmFrameParser_Init(&parser, SGS_LRM_RESOLUTION_100UM);
+
+    std::vector<unsigned char> stream;
+    std::vector<std::vector<unsigned char>> frames = {
+        frame({ 0x80, 0x06, 0x82 }, "012.3456"),            // 0.1 mm
+        frame({ 0x80, 0x06, 0x83 }, "ERR-16"),              // 10-byte ERR
+        frame({ 0x80, 0x06, 0x82 }, "ERR--15"),             // dash-padded ERR
+        frame({ 0xFA, 0x06, 0x84 }, "SGS-LRM-0000001A"),    // device ID
+        frame({ 0x80, 0x06, 0x85 }, "\x01"),                // laser ack
+        frame({ 0x80, 0x04, 0x82 }, ""),                    // shutdown ack
+        frame({ 0xFA, 0x84, 0x89 }, "\x01"),                // config failure
+    };
+    for (auto& f : frames) stream.insert(stream.end(), f.begin(), f.end());
+
+    std::vector<SGSLrmFrame> out = feed(&parser, stream, 4);
+    const SGSLrmFrameType types[] = {
+        SGS_LRM_FRAME_MEASUREMENT, SGS_LRM_FRAME_HW_ERROR, SGS_LRM_FRAME_HW_ERROR, SGS_LRM_FRAME_DEVICE_ID,
+        SGS_LRM_FRAME_LASER, SGS_LRM_FRAME_CONFIG_ACK, SGS_LRM_FRAME_CONFIG_NAK,
+    };
+    bool ok = out.size() == frames.size();
+    for (size_t i = 0; ok && i < out.size(); ++i) {
+        ok = out[i].type == types[i] && out[i].length == (int)frames[i].size();
+    }
+    check(ok, "all seven frame types recognised with correct lengths");
+    check(parser.discardedBytes == 0, "nothing discarded");
+    printf("\n");
+}
+
+void test_resolution_ambiguity()
+{
+    printf("Test 5: 1 mm frame whose checksum is an ASCII digit...\n");
+
+    // Find a 1 mm frame whose CS falls in '0'..'9' (not possible at ADDR 0x80,
+    // but it is at other module addresses)
+    std::vector<unsigned char> f;
+    for (int addr = 1; addr < 0xFA; ++addr) {
+        f = frame({ (unsigned char)addr, 0x06, 0x82 }, "001.234");
+        if (f[10] >= '0' && f[10] <= '9') break;
+    }
+
+    SGSLrmFrameParser parser;
+    SGSLrmFrameParser_Init(&parser, SGS_LRM_RESOLUTION_1MM);
+    std::vector<SGSLrmFrame> out = feed(&parser, f, 64);
+    check(out.size() == 1 && out[0].length == 11, "emitted immediately when 1 mm is expected");
+
+    SGSLrmFrameParser_Init(&parser, SGS_LRM_RESOLUTION_100UM);
+    out = feed(&parser, f, 64);
+    check(out.empty(), "held back when 0.1 mm is expected");
+    SGSLrmFrame flushed;
+    check(SGSLrmFrameParser_Flush(&parser, &flushed) && flushed.length == 11, "released by Flush on idle line");
+    check(parser.resolution == SGS_LRM_RESOLUTION_1MM, "parser learned 1 mm resolution");
+    printf("\n");
+}
+
+#if !defined(_WIN32)
+#include <atomic>
+
+static std::atomic<int> g_samples{ 0 };
+static std::atomic<int> g_badSamples{ 0 };
+
+static void on_sample(SGSLrmHandle, double distance, SGSLrmStatus status, void*)
+{
+    if (status == SGS_LRM_SUCCESS && fabs(distance - 3.21) < 1e-9) g_samples++;
+    else if (status != SGS_LRM_TIMEOUT) g_badSamples++;
+}
+
+void test_chunked_wire()
+{
+    printf("Test 6: Library over a pty with chunked frames...\n");
+
+    PtyModuleSimulator sim;
+    sim.chunkSize = 3;
+    sim.chunkGapMs = 2;
+    sim.modules[0x80].distance = 3.21;
+    sim.modules[0x80].frequencyHz = 20;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) { check(false, "connected"); return; }
+
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS && fabs(distance - 3.21) < 1e-9,
+        "single measurement reassembled from 3-byte chunks");
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].errorCode = 16;
+    }
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_MEASUREMENT_ERROR, "10-byte ERR-16 frame reported");
+    int code = 0;
+    SGSLrm_GetMeasurementError(handle, &code);
+    check(code == 16, "error code 16 stored");
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].errorCode = 0;
+    }
+
+    sim.chunkSize = 0;
+    SGSLrm_SetMeasurementCallback(handle, on_sample, NULL);
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    SGSLrm_StopContinuousMeasurement(handle);
+
+    char what[96];
+    snprintf(what, sizeof(what), "continuous 20 Hz: %d samples in 1 s, %d bad", g_samples.load(), g_badSamples.load());
+    check(g_samples >= 18 && g_badSamples == 0, what);
+
+    disconnect_simulated(sim, handle);
+    printf("\n");
+}
+#endif
+
+int main()
+{
+    print_banner("Streaming frame parser");
+
+    test_split_and_merged();
+    test_emit_on_checksum();
+    test_resync();
+    test_frame_types();
+    test_resolution_ambiguity();
+#if !defined(_WIN32)
+    test_chunked_wire();
+#endif
+
+    return report_results();
+}
@@ -0,0 +1,254 @@
+// Tests for RX timestamps (SGSLrm_SetMeasurementCallbackEx / SGSLrm_GetTimingStats).
+// A pty module writes each frame in chunks a few milliseconds apart. Every
+// frame must carry the stamps of its first and checksum bytes, taken before
+// any lock or queue: a slow queued callback sees the module's frame rate in
+// the stamps, not its own. Sequence numbers must follow the snapshot's, and
+// the timing statistics must be consistent with the stream (the jitter itself
+// depends on the host and is only reported).
+//
+// Build (Linux): make test_frame_timestamps (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+
+static unsigned long long clock_ns()
+{
+    unsigned long long now = 0;
+    SGSLrm_GetClockNs(&now);
+    return now;
+}
+
+static void drain(SGSLrmHandle handle)
+{
+    SGSLrmSample samples[64];
+    int count = 0;
+    do {
+        SGSLrm_ReadSamples(handle, samples, 64, &count);
+    } while (count > 0);
+}
+
+void test_api(SGSLrmHandle handle)
+{
+    printf("Test 1: Timestamp API...\n");
+
+    SGSLrmTimingStats stats;
+    check(SGSLrm_GetClockNs(NULL) == SGS_LRM_INVALID_PARAMETER, "NULL clock output rejected");
+    check(SGSLrm_GetTimingStats(handle, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL stats output rejected");
+    check(SGSLrm_GetTimingStats(NULL, &stats) == SGS_LRM_INVALID_HANDLE &&
+        SGSLrm_SetMeasurementCallbackEx(NULL, NULL, NULL) == SGS_LRM_INVALID_HANDLE, "NULL handle rejected");
+    SGSLrm_GetTimingStats(handle, &stats);
+    check(stats.frames == 0 && stats.intervals == 0, "fresh handle has no timing");
+
+    unsigned long long a = clock_ns();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    unsigned long long b = clock_ns();
+    check(b - a >= 5000000ULL && b - a < 100000000ULL, "clock counts nanoseconds");
+    printf("\n");
+}
+
+void test_transactions(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 2: Transaction answers are stamped...\n");
+
+    unsigned long long before = clock_ns();
+    double distance = 0.0;
+    SGSLrmStatus status = SGSLrm_SingleMeasurement(handle, &distance);
+    unsigned long long after = clock_ns();
+
+    SGSLrmSnapshot snapshot;
+    SGSLrm_GetSnapshot(handle, &snapshot);
+    double transferMs = (snapshot.lastByteNs - snapshot.firstByteNs) / 1e6;
+    char what[128];
+    snprintf(what, sizeof(what), "first byte to checksum byte %.1f ms (frame written in 3 chunks, 4 ms apart)", transferMs);
+    check(status == SGS_LRM_SUCCESS && before < snapshot.firstByteNs && snapshot.lastByteNs <= after, "stamps fall inside the call");
+    check(transferMs >= 7.0 && transferMs < 50.0, what);
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].errorCode = 16;
+    }
+    status = SGSLrm_SingleMeasurement(handle, &distance);
+    SGSLrm_GetSnapshot(handle, &snapshot);
+    check(status == SGS_LRM_MEASUREMENT_ERROR && snapshot.firstByteNs > after, "ERR frames are stamped too");
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].errorCode = 0;
+        sim.modules[0x80].silent = true;
+    }
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, 50);
+    status = SGSLrm_SingleMeasurement(handle, &distance);
+    SGSLrm_GetSnapshot(handle, &snapshot);
+    check(status == SGS_LRM_TIMEOUT && snapshot.firstByteNs == 0 && snapshot.lastByteNs == 0, "a timeout has no stamps");
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, 0);
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].silent = false;
+    }
+    drain(handle);
+    printf("\n");
+}
+
+struct Stream {
+    std::mutex mutex;
+    std::vector<SGSLrmMeasurementEx> received;
+    std::vector<unsigned long long> calledNs;
+    int sleepMs = 0;
+    std::atomic<int> doubles{ 0 };
+};
+
+static void ex_callback(SGSLrmHandle, const SGSLrmMeasurementEx* measurement, void* userdata)
+{
+    Stream* stream = (Stream*)userdata;
+    {
+        std::lock_guard<std::mutex> guard(stream->mutex);
+        stream->received.push_back(*measurement);
+        stream->calledNs.push_back(clock_ns());
+    }
+    if (stream->sleepMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(stream->sleepMs));
+}
+
+static void double_callback(SGSLrmHandle, double, SGSLrmStatus, void* userdata)
+{
+    ((Stream*)userdata)->doubles++;
+}
+
+static double mean_gap_ms(const std::vector<unsigned long long>& stamps)
+{
+    if (stamps.size() < 2) return 0.0;
+    return (stamps.back() - stamps.front()) / 1e6 / (stamps.size() - 1);
+}
+
+void test_stream(PtyModuleSimulator& sim, SGSLrmHandle handle, SGSLrmCallbackMode mode)
+{
+    bool queued = mode == SGS_LRM_CALLBACK_QUEUED;
+    printf("Test %d: Extended callback (%s)...\n", queued ? 4 : 3, queued ? "queued, 35 ms callback" : "inline");
+
+    Stream stream;
+    stream.sleepMs = queued ? 35 : 0;
+    SGSLrm_SetCallbackMode(handle, mode, NULL);
+    SGSLrm_SetMeasurementCallbackEx(handle, ex_callback, &stream);
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    SGSLrm_StopContinuousMeasurement(handle);
+
+    SGSLrmTimingStats stats;
+    SGSLrm_GetTimingStats(handle, &stats);
+    SGSLrmSnapshot snapshot;
+    SGSLrm_GetSnapshot(handle, &snapshot);
+    SGSLrm_SetCallbackMode(handle, SGS_LRM_CALLBACK_INLINE, NULL);
+
+    std::vector<SGSLrmMeasurementEx> got;
+    std::vector<unsigned long long> calledNs;
+    {
+        std::lock_guard<std::mutex> guard(stream.mutex);
+        got = stream.received;
+        calledNs = stream.calledNs;
+    }
+    bool consistent = got.size() >= 5;
+    std::vector<unsigned long long> stamps;
+    for (size_t i = 0; consistent && i < got.size(); ++i) {
+        const SGSLrmMeasurementEx& m = got[i];
+        consistent = m.status == SGS_LRM_SUCCESS && m.distanceTenthMm == 12340 && m.distance == 1.234 &&
+            m.firstByteNs != 0 && m.firstByteNs <= m.lastByteNs && m.lastByteNs <= calledNs[i] &&
+            (i == 0 || (m.sequence == got[i - 1].sequence + 1 && m.lastByteNs > got[i - 1].lastByteNs));
+        stamps.push_back(m.lastByteNs);
+    }
+    char what[160];
+    snprintf(what, sizeof(what), "%d samples: consecutive sequence, stamps ordered and taken before the call", (int)got.size());
+    check(consistent, what);
+    if (queued) {
+        check(got.back().sequence <= snapshot.sequence, "sequence numbered like the snapshot");
+    } else {
+        check(got.back().sequence == snapshot.sequence, "sequence numbered like the snapshot");
+    }
+
+    double stampGapMs = mean_gap_ms(stamps);
+    double callGapMs = mean_gap_ms(calledNs);
+    // The module cannot write faster than 50 Hz; how much slower is up to the host
+    snprintf(what, sizeof(what), "stamps %.1f ms apart at 50 Hz, callbacks %.1f ms apart", stampGapMs, callGapMs);
+    check(stampGapMs > 17.0 && (!queued || callGapMs > 30.0), what);
+
+    // Interval and jitter figures measure the host's scheduling too: reported, not bounded.
+    // A frame goes out in 3 chunks with 2 gaps; reads may merge chunks, never split a gap.
+    double chunkGapUs = sim.chunkGapMs * 1000.0;
+    snprintf(what, sizeof(what), "stats: %lu frames, interval %.1f ms (%.1f..%.1f), jitter %.2f ms, transfer %.1f ms (max %.1f)",
+        stats.frames, stats.meanIntervalUs / 1000.0, stats.minIntervalUs / 1000.0, stats.maxIntervalUs / 1000.0,
+        stats.jitterUs / 1000.0, stats.meanTransferUs / 1000.0, stats.maxTransferUs / 1000.0);
+    check(stats.frames >= got.size() && stats.intervals == stats.frames - 1 &&
+        stats.minIntervalUs <= stats.meanIntervalUs && stats.meanIntervalUs <= stats.maxIntervalUs && stats.jitterUs >= 0.0 &&
+        stats.meanTransferUs >= chunkGapUs && stats.maxTransferUs >= 2 * chunkGapUs &&
+        stats.maxTransferUs >= stats.meanTransferUs, what);
+
+    // The double callback replaces the extended one
+    SGSLrm_SetMeasurementCallback(handle, double_callback, &stream);
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    SGSLrm_StopContinuousMeasurement(handle);
+    SGSLrm_SetMeasurementCallback(handle, NULL, NULL);
+    {
+        std::lock_guard<std::mutex> guard(stream.mutex);
+        check(stream.received.size() == got.size() && stream.doubles > 0, "extended callback replaced");
+    }
+
+    SGSLrm_GetTimingStats(handle, &stats);
+    check(stats.frames > 0 && stats.frames < 10, "stats restart with the stream");
+    drain(handle);
+    printf("\n");
+}
+
+void test_dropouts(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 5: A dropout breaks the interval chain...\n");
+
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_CONTINUOUS, 60);
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    // 5 Hz: every gap outlasts the 60 ms deadline
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].frequencyHz = 5;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(450));
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].frequencyHz = 50;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    SGSLrm_StopContinuousMeasurement(handle);
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_CONTINUOUS, 0);
+
+    SGSLrmTimingStats stats;
+    SGSLrm_GetTimingStats(handle, &stats);
+    char what[128];
+    snprintf(what, sizeof(what), "%lu frames, %lu intervals, longest %.1f ms", stats.frames, stats.intervals, stats.maxIntervalUs / 1000.0);
+    check(stats.intervals + 2 <= stats.frames && stats.maxIntervalUs < 60000.0, what);
+    drain(handle);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("RX timestamps and jitter");
+
+    PtyModuleSimulator sim;
+    sim.modules[0x80].frequencyHz = 50;
+    sim.chunkSize = 4;
+    sim.chunkGapMs = 4;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_api(handle);
+    test_transactions(sim, handle);
+    test_stream(sim, handle, SGS_LRM_CALLBACK_INLINE);
+    test_stream(sim, handle, SGS_LRM_CALLBACK_QUEUED);
+    test_dropouts(sim, handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
@@ -0,0 +1,147 @@
+// Contention test: status getters must not wait on the UART.
+// A measurement is left blocking on a module that never answers (and then on
+// one that answers slowly with ERR-16) while the main thread calls
+// GetLastMeasurement / IsConnected / GetLaserStatus in a tight loop. The
+// slowest getter call must stay far below the 1000 ms response timeout.
+//
+// Build (Linux): make test_lock_contention (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+
+struct GetterStats {
+    long calls = 0;
+    double maxMs = 0.0;
+};
+
+// Hammers the getters until the measurement thread reports completion.
+static GetterStats hammer_getters(SGSLrmHandle handle, std::atomic<bool>& done)
+{
+    GetterStats stats;
+    while (!done) {
+        auto t0 = std::chrono::steady_clock::now();
+        double last = 0.0;
+        bool connected = false, laser = false;
+        SGSLrm_GetLastMeasurement(handle, &last);
+        SGSLrm_IsConnected(handle, &connected);
+        SGSLrm_GetLaserStatus(handle, &laser);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (ms > stats.maxMs) stats.maxMs = ms;
+        stats.calls++;
+    }
+    return stats;
+}
+
+void test_getters_during_timeout(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 1: Getters while a measurement times out...\n");
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].silent = true;
+    }
+
+    std::atomic<bool> done{ false };
+    SGSLrmStatus measureStatus = SGS_LRM_SUCCESS;
+    double measureMs = 0.0;
+    std::thread measurer([&] {
+        auto t0 = std::chrono::steady_clock::now();
+        double distance = 0.0;
+        measureStatus = SGSLrm_SingleMeasurement(handle, &distance);
+        measureMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        done = true;
+    });
+    GetterStats stats = hammer_getters(handle, done);
+    measurer.join();
+
+    char what[128];
+    snprintf(what, sizeof(what), "measurement timed out after %.0f ms", measureMs);
+    check(measureStatus == SGS_LRM_TIMEOUT && measureMs >= 900, what);
+    snprintf(what, sizeof(what), "%ld getter rounds, slowest %.3f ms", stats.calls, stats.maxMs);
+    check(stats.calls > 1000 && stats.maxMs < 50.0, what);
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].silent = false;
+    }
+    printf("\n");
+}
+
+void test_getters_during_slow_error(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 2: Getters while a slow module answers ERR-16...\n");
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].errorCode = 16;
+        sim.modules[0x80].responseDelayMs = 600;
+    }
+
+    std::atomic<bool> done{ false };
+    SGSLrmStatus measureStatus = SGS_LRM_SUCCESS;
+    std::thread measurer([&] {
+        double distance = 0.0;
+        measureStatus = SGSLrm_SingleMeasurement(handle, &distance);
+        done = true;
+    });
+    GetterStats stats = hammer_getters(handle, done);
+    measurer.join();
+
+    check(measureStatus == SGS_LRM_MEASUREMENT_ERROR, "ERR-16 reported");
+    int code = 0;
+    SGSLrm_GetMeasurementError(handle, &code);
+    check(code == 16, "error code stored");
+    char what[128];
+    snprintf(what, sizeof(what), "%ld getter rounds, slowest %.3f ms", stats.calls, stats.maxMs);
+    check(stats.calls > 1000 && stats.maxMs < 50.0, what);
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].errorCode = 0;
+        sim.modules[0x80].responseDelayMs = 0;
+    }
+    printf("\n");
+}
+
+void test_transactions_serialised(SGSLrmHandle handle)
+{
+    printf("Test 3: Concurrent transactions on one port stay serialised...\n");
+
+    std::atomic<int> ok{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10; ++i) {
+                double distance = 0.0;
+                if (SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS && fabs(distance - 1.234) < 1e-9) ok++;
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d/40 interleaved measurements matched their responses", ok.load());
+    check(ok == 40, what);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Device lock contention");
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_getters_during_timeout(sim, handle);
+    test_getters_during_slow_error(sim, handle);
+    test_transactions_serialised(handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
@@ -0,0 +1,226 @@
+// Tests for the multi-drop bus (SGSLrm_OpenBus / SGSLrm_ConnectBus).
+// Ten pty modules at 0x80-0x89 share one line. Every handle must get its own
+// module's answer, concurrent callers must take turns on the wire, streamed
+// frames must reach the handle whose address they carry, and the port must
+// be opened once and closed with its last user.
+//
+// Build (Linux): make test_multidrop_bus (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+#include <dirent.h>
+
+static const int kModules = 10;
+
+static double distance_of(int i)
+{
+    return 1.0 + 0.5 * i;
+}
+
+// Descriptors this process holds on the pty slave
+static int open_count(const char* path)
+{
+    int count = 0;
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) return -1;
+    while (struct dirent* entry = readdir(dir)) {
+        char link[300], target[256];
+        snprintf(link, sizeof(link), "/proc/self/fd/%s", entry->d_name);
+        ssize_t n = readlink(link, target, sizeof(target) - 1);
+        if (n <= 0) continue;
+        target[n] = '\0';
+        if (strcmp(target, path) == 0) count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+void test_api(PtyModuleSimulator& sim)
+{
+    printf("Test 1: Bus API...\n");
+
+    SGSLrmBusHandle bus = NULL;
+    check(SGSLrm_OpenBus(NULL, &bus) == SGS_LRM_INVALID_PARAMETER, "NULL port rejected");
+    check(SGSLrm_OpenBus(sim.PortName(), NULL) == SGS_LRM_INVALID_PARAMETER, "NULL output rejected");
+    check(SGSLrm_OpenBus("/dev/does-not-exist", &bus) != SGS_LRM_SUCCESS, "missing port fails");
+    check(SGSLrm_OpenBus(sim.PortName(), &bus) == SGS_LRM_SUCCESS, "bus opened");
+
+    SGSLrmHandle a, b;
+    SGSLrm_CreateHandle(&a);
+    SGSLrm_CreateHandle(&b);
+    check(SGSLrm_ConnectBus(a, bus, 0xFA) == SGS_LRM_INVALID_PARAMETER, "broadcast address rejected");
+    check(SGSLrm_ConnectBus(a, NULL, 0x80) == SGS_LRM_INVALID_HANDLE, "NULL bus rejected");
+    check(SGSLrm_ConnectBus(a, bus, 0x80) == SGS_LRM_SUCCESS, "first handle attached");
+    check(SGSLrm_ConnectBus(b, bus, 0x80) == SGS_LRM_INVALID_PARAMETER, "duplicate address rejected");
+    check(SGSLrm_ConnectBus(a, bus, 0x81) == SGS_LRM_INVALID_PARAMETER, "connected handle rejected");
+    check(SGSLrm_SetAddress(a, 0x85) == SGS_LRM_INVALID_PARAMETER, "broadcast re-addressing refused on a shared line");
+    SGSLrmConfig config = {};
+    config.fields = SGS_LRM_CONFIG_RANGE;
+    config.range = SGS_LRM_RANGE_80M;
+    check(SGSLrm_ApplyConfig(a, &config) == SGS_LRM_INVALID_PARAMETER, "broadcast config writes refused on a shared line");
+    bool refused = SGSLrm_SetRange(a, SGS_LRM_RANGE_80M) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_SetResolution(a, SGS_LRM_RESOLUTION_1MM) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_SetFrequency(a, SGS_LRM_FREQUENCY_10HZ) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_SetMeasurementInterval(a, 0) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_SetDistanceCorrection(a, -3) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_SetStartPosition(a, SGS_LRM_START_POSITION_TAIL) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_SetAutoMeasurement(a, false) == SGS_LRM_INVALID_PARAMETER;
+    check(refused, "every config setter refused on a shared line");
+
+    // The port outlives the bus handle while a module handle uses it
+    check(SGSLrm_CloseBus(bus) == SGS_LRM_SUCCESS, "bus closed");
+    check(SGSLrm_CloseBus(bus) == SGS_LRM_INVALID_HANDLE, "second close rejected");
+    check(SGSLrm_ConnectBus(b, bus, 0x81) == SGS_LRM_INVALID_HANDLE, "closed bus takes no new handles");
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(a, &distance) == SGS_LRM_SUCCESS && fabs(distance - distance_of(0)) < 1e-9, "attached handle still measures");
+    check(open_count(sim.PortName()) == 1, "port still open");
+    SGSLrm_Disconnect(a);
+    check(open_count(sim.PortName()) == 0, "last disconnect closed the port");
+
+    // The freed slot goes to the next bus under a new handle
+    SGSLrmBusHandle reopened = NULL;
+    SGSLrm_OpenBus(sim.PortName(), &reopened);
+    check(reopened != bus && SGSLrm_ConnectBus(b, bus, 0x81) == SGS_LRM_INVALID_HANDLE, "stale bus handle rejected after its slot is reused");
+    check(SGSLrm_CloseBus(bus) == SGS_LRM_INVALID_HANDLE && SGSLrm_CloseBus(reopened) == SGS_LRM_SUCCESS, "closing the stale handle leaves the new bus alone");
+
+    SGSLrm_DestroyHandle(a);
+    SGSLrm_DestroyHandle(b);
+    printf("\n");
+}
+
+void test_addressing(SGSLrmHandle* handles, const char* port)
+{
+    printf("Test 2: Ten modules on one port...\n");
+
+    check(open_count(port) == 1, "one descriptor for ten handles");
+
+    bool ok = true;
+    for (int i = 0; i < kModules; ++i) {
+        double distance = 0.0;
+        ok = SGSLrm_SingleMeasurement(handles[i], &distance) == SGS_LRM_SUCCESS && fabs(distance - distance_of(i)) < 1e-9 && ok;
+        ok = SGSLrm_ReadCache(handles[i], &distance) == SGS_LRM_SUCCESS && fabs(distance - distance_of(i)) < 1e-9 && ok;
+    }
+    check(ok, "every handle reads its own module");
+    printf("\n");
+}
+
+void test_concurrent(SGSLrmHandle* handles)
+{
+    printf("Test 3: Concurrent transactions take turns on the line...\n");
+
+    const int kRounds = 20;
+    std::atomic<int> wrong{ 0 };
+    std::vector<std::thread> threads;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kModules; ++i) {
+        threads.emplace_back([&, i] {
+            for (int r = 0; r < kRounds; ++r) {
+                double distance = 0.0;
+                if (SGSLrm_SingleMeasurement(handles[i], &distance) != SGS_LRM_SUCCESS || fabs(distance - distance_of(i)) > 1e-9) {
+                    wrong++;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d transactions from %d threads, %d wrong (%.0f ms)", kModules * kRounds, kModules, wrong.load(), ms);
+    check(wrong == 0, what);
+    printf("\n");
+}
+
+static std::atomic<int> g_samples[kModules];
+static std::atomic<int> g_misrouted{ 0 };
+
+static void on_sample(SGSLrmHandle, double distance, SGSLrmStatus status, void* userdata)
+{
+    int i = (int)(intptr_t)userdata;
+    if (status != SGS_LRM_SUCCESS) return;
+    if (fabs(distance - distance_of(i)) > 1e-9) g_misrouted++;
+    g_samples[i]++;
+}
+
+void test_streaming(SGSLrmHandle* handles)
+{
+    printf("Test 4: Streams from several modules share one reader...\n");
+
+    const int streaming[] = { 1, 4, 7 };
+    for (int i : streaming) {
+        g_samples[i] = 0;
+        SGSLrm_SetMeasurementCallback(handles[i], on_sample, (void*)(intptr_t)i);
+        SGSLrm_StartContinuousMeasurement(handles[i]);
+    }
+
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handles[0], &distance) == SGS_LRM_INVALID_PARAMETER, "transactions refused while the line streams");
+
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    bool all = true;
+    for (int i : streaming) all = g_samples[i] >= 3 && all;
+    char what[96];
+    snprintf(what, sizeof(what), "samples %d/%d/%d at 10 Hz, %d misrouted", g_samples[1].load(), g_samples[4].load(), g_samples[7].load(), g_misrouted.load());
+    check(all && g_misrouted == 0, what);
+
+    // Stopping one leaves the others flowing
+    SGSLrm_StopContinuousMeasurement(handles[4]);
+    int stopped = g_samples[4];
+    int before = g_samples[1];
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    check(g_samples[4] == stopped, "no callbacks after stop");
+    check(g_samples[1] > before, "other streams continue");
+
+    SGSLrm_StopContinuousMeasurement(handles[1]);
+    SGSLrm_StopContinuousMeasurement(handles[7]);
+    for (int i : streaming) SGSLrm_SetMeasurementCallback(handles[i], NULL, NULL);
+
+    // Stale stream frames still in flight are skipped by the next transaction
+    check(SGSLrm_SingleMeasurement(handles[0], &distance) == SGS_LRM_SUCCESS && fabs(distance - distance_of(0)) < 1e-9, "transactions resume after the last stop");
+    check(SGSLrm_SingleMeasurement(handles[4], &distance) == SGS_LRM_SUCCESS && fabs(distance - distance_of(4)) < 1e-9, "streamed module answers again");
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Multi-drop bus");
+
+    PtyModuleSimulator sim;
+    for (int i = 0; i < kModules; ++i) {
+        sim.modules[0x80 + i].distance = distance_of(i);
+    }
+    if (!sim.Start()) {
+        printf("pty allocation failed\n");
+        return 1;
+    }
+
+    test_api(sim);
+
+    SGSLrmBusHandle bus;
+    SGSLrmHandle handles[kModules];
+    SGSLrm_OpenBus(sim.PortName(), &bus);
+    for (int i = 0; i < kModules; ++i) {
+        SGSLrm_CreateHandle(&handles[i]);
+        if (SGSLrm_ConnectBus(handles[i], bus, 0x80 + i) != SGS_LRM_SUCCESS) {
+            printf("connect failed\n");
+            return 1;
+        }
+    }
+
+    test_addressing(handles, sim.PortName());
+    test_concurrent(handles);
+    test_streaming(handles);
+
+    SGSLrm_CloseBus(bus);
+    for (int i = 0; i < kModules; ++i) {
+        SGSLrm_Disconnect(handles[i]);
+        SGSLrm_DestroyHandle(handles[i]);
+    }
+    check(open_count(sim.PortName()) == 0, "port closed after the last handle");
+    sim.Stop();
+
+    return report_results();
+}
@@ -49,8 +49,8 @@ void test_device_pool() {
     }
     printf("\n");
     
-    // Test 3: Test handle limits (16 max)
-    printf("Test 3: Testing device pool limits (max 16 devices)...\n");
+    // Test 3: Grow past the first chunk (16 slots)
+    printf("Test 3: Growing the device pool past 16 devices...\n");
     SGSLrmHandle extraHandles[12];
     int created = 0;
     for (int i = 0; i < 12; i++) {
@@ -62,8 +62,8 @@ void test_device_pool() {
             break;
         }
     }
-    if (created == 11) {
-        printf("  ✓ Successfully created all 16 devices (pool limit)\n");
+    if (created == 12) {
+        printf("  ✓ Successfully created 17 devices, past the old 16-slot limit\n");
     }
     printf("\n");
     
@@ -197,7 +197,7 @@ int main() {
     printf("✅ No SGSLrm_Initialize() needed\n");
     printf("✅ No SGSLrm_Finalize() needed\n");
     printf("✅ Global device pool (no heap allocation)\n");
-    printf("✅ Supports up to 16 devices simultaneously\n");
+    printf("✅ Pool grows on demand (thousands of devices)\n");
     printf("✅ Thread-safe with per-device locks\n");
     printf("✅ Automatic pool initialization on first use\n\n");
     
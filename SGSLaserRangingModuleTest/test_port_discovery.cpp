@@ -0,0 +1,132 @@
+// Tests for port discovery (SGSLrm_EnumComPorts / SGSLrm_ProbeComPorts).
+// Enumeration must come from the OS device list without opening anything, so
+// it returns in milliseconds. Probing must open every port at once: a live
+// module, a silent module and a missing port all resolve within one deadline,
+// each with its own status.
+//
+// Build (Linux): make test_port_discovery (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+
+static double elapsed_ms(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void test_enum()
+{
+    printf("Test 1: Enumeration opens nothing...\n");
+
+    char list[4096];
+    check(SGSLrm_EnumComPorts(NULL, sizeof(list)) == SGS_LRM_INVALID_PARAMETER, "NULL buffer rejected");
+    check(SGSLrm_EnumComPorts(list, 0) == SGS_LRM_INVALID_PARAMETER, "empty buffer rejected");
+
+    auto t0 = std::chrono::steady_clock::now();
+    SGSLrmStatus status = SGSLrm_EnumComPorts(list, sizeof(list));
+    double ms = elapsed_ms(t0);
+
+    char what[160];
+    snprintf(what, sizeof(what), "listed in %.2f ms: \"%.80s\"", ms, list);
+    check(status == SGS_LRM_SUCCESS && ms < 50.0, what);
+
+    char tiny[2] = "x";
+    check(SGSLrm_EnumComPorts(tiny, sizeof(tiny)) == SGS_LRM_SUCCESS && tiny[0] == '\0', "names that do not fit are left out");
+    printf("\n");
+}
+
+void test_api()
+{
+    printf("Test 2: Probe API...\n");
+
+    SGSLrmPortProbe results[4];
+    int count = -1;
+    check(SGSLrm_ProbeComPorts(NULL, 100, NULL, 4, &count) == SGS_LRM_INVALID_PARAMETER, "NULL results rejected");
+    check(SGSLrm_ProbeComPorts(NULL, 100, results, 0, &count) == SGS_LRM_INVALID_PARAMETER, "zero capacity rejected");
+    check(SGSLrm_ProbeComPorts(NULL, 100, results, 4, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL count rejected");
+    check(SGSLrm_ProbeComPorts(NULL, 0, results, 4, &count) == SGS_LRM_INVALID_PARAMETER, "zero deadline rejected");
+    check(SGSLrm_ProbeComPorts(NULL, 60001, results, 4, &count) == SGS_LRM_INVALID_PARAMETER, "deadline above 60 s rejected");
+    check(SGSLrm_ProbeComPorts("", 100, results, 4, &count) == SGS_LRM_SUCCESS && count == 0, "empty list probes nothing");
+    printf("\n");
+}
+
+void test_probe(const char* live, const char* silent)
+{
+    printf("Test 3: Three ports probed in parallel...\n");
+
+    const int kDeadlineMs = 300;
+    char list[512];
+    snprintf(list, sizeof(list), "%s;%s;/dev/does-not-exist", live, silent);
+
+    SGSLrmPortProbe results[8];
+    int count = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    SGSLrmStatus status = SGSLrm_ProbeComPorts(list, kDeadlineMs, results, 8, &count);
+    double ms = elapsed_ms(t0);
+
+    check(status == SGS_LRM_SUCCESS && count == 3, "three results");
+    check(strcmp(results[0].port, live) == 0 && strcmp(results[2].port, "/dev/does-not-exist") == 0, "results in list order");
+
+    char what[160];
+    snprintf(what, sizeof(what), "live module answered \"%s\"", results[0].deviceId);
+    check(results[0].status == SGS_LRM_SUCCESS && strcmp(results[0].deviceId, "SGS-LRM-0000002B") == 0, what);
+    check(results[1].status == SGS_LRM_TIMEOUT && results[1].deviceId[0] == '\0', "silent module timed out");
+    check(results[2].status == SGS_LRM_COMMUNICATION_ERROR, "missing port failed to open");
+
+    // Sequential probing would cost a deadline per silent port
+    snprintf(what, sizeof(what), "whole probe took %.0f ms for a %d ms deadline", ms, kDeadlineMs);
+    check(ms >= kDeadlineMs - 2 && ms < kDeadlineMs + 100, what);
+
+    t0 = std::chrono::steady_clock::now();
+    status = SGSLrm_ProbeComPorts(live, kDeadlineMs, results, 8, &count);
+    ms = elapsed_ms(t0);
+    snprintf(what, sizeof(what), "all answered: returned after %.0f ms, not at the deadline", ms);
+    check(status == SGS_LRM_SUCCESS && count == 1 && results[0].status == SGS_LRM_SUCCESS && ms < kDeadlineMs / 2, what);
+
+    check(SGSLrm_ProbeComPorts(list, kDeadlineMs, results, 2, &count) == SGS_LRM_SUCCESS && count == 2, "at most maxCount ports probed");
+    printf("\n");
+}
+
+void test_reuse(const char* live)
+{
+    printf("Test 4: Probed ports are released...\n");
+
+    SGSLrmPortProbe result;
+    int count = 0;
+    SGSLrm_ProbeComPorts(live, 200, &result, 1, &count);
+
+    SGSLrmHandle handle;
+    SGSLrm_CreateHandle(&handle);
+    check(SGSLrm_Connect(handle, live) == SGS_LRM_SUCCESS, "probed port connects");
+    char deviceId[32];
+    check(SGSLrm_ReadDeviceID(handle, deviceId, sizeof(deviceId)) == SGS_LRM_SUCCESS && strcmp(deviceId, result.deviceId) == 0,
+        "handle reads the probed ID");
+    SGSLrm_Disconnect(handle);
+    SGSLrm_DestroyHandle(handle);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Port discovery");
+
+    test_enum();
+    test_api();
+
+    PtyModuleSimulator live, silent;
+    live.modules[0x80].deviceId = "SGS-LRM-0000002B";
+    silent.modules[0x80].silent = true;
+    if (!live.Start() || !silent.Start()) {
+        printf("pty allocation failed\n");
+        return 1;
+    }
+
+    test_probe(live.PortName(), silent.PortName());
+    test_reuse(live.PortName());
+
+    live.Stop();
+    silent.Stop();
+
+    return report_results();
+}
@@ -0,0 +1,115 @@
+// End-to-end test of the POSIX termios transport against a pty pair.
+// The library connects to the pty slave exactly as it would to /dev/ttyUSB0;
+// PtyModuleSimulator answers on the master side.
+//
+// Build (Linux): make test_posix_transport (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+
+void test_connect_and_measure(PtyModuleSimulator& sim)
+{
+    printf("Test 1: Connect over termios and measure...\n");
+
+    SGSLrmHandle handle;
+    check(SGSLrm_CreateHandle(&handle) == SGS_LRM_SUCCESS, "handle created");
+    check(SGSLrm_Connect(handle, sim.PortName()) == SGS_LRM_SUCCESS, "connected to pty slave");
+
+    bool connected = false;
+    SGSLrm_IsConnected(handle, &connected);
+    check(connected, "IsConnected reports true");
+
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS, "single measurement succeeded");
+    check(fabs(distance - 1.234) < 1e-9, "distance decoded as 1.234 m");
+
+    double last = 0.0;
+    SGSLrm_GetLastMeasurement(handle, &last);
+    check(last == distance, "last measurement updated");
+
+    char deviceId[32] = { 0 };
+    check(SGSLrm_ReadDeviceID(handle, deviceId, sizeof(deviceId)) == SGS_LRM_SUCCESS, "device ID read");
+    check(strcmp(deviceId, "SGS-LRM-0000001A") == 0, "device ID matches");
+
+    check(SGSLrm_LaserOn(handle) == SGS_LRM_SUCCESS, "laser on sent");
+    bool laserOn = false;
+    SGSLrm_GetLaserStatus(handle, &laserOn);
+    check(laserOn, "laser status tracked");
+
+    check(SGSLrm_Disconnect(handle) == SGS_LRM_SUCCESS, "disconnected");
+    check(SGSLrm_DestroyHandle(handle) == SGS_LRM_SUCCESS, "handle destroyed");
+    printf("\n");
+}
+
+void test_error_and_cache(PtyModuleSimulator& sim)
+{
+    printf("Test 2: Broadcast + cache, 0.1mm resolution, timeouts...\n");
+
+    SGSLrmHandle handle;
+    SGSLrm_CreateHandle(&handle);
+    check(SGSLrm_Connect(handle, sim.PortName()) == SGS_LRM_SUCCESS, "connected");
+
+    double distance = 0.0;
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].resolution = 2;
+        sim.modules[0x80].distance = 12.3456;
+    }
+    check(SGSLrm_BroadcastMeasurement(handle) == SGS_LRM_SUCCESS, "broadcast measurement sent");
+    check(SGSLrm_ReadCache(handle, &distance) == SGS_LRM_SUCCESS, "cache read");
+    check(fabs(distance - 12.3456) < 1e-9, "0.1mm cache value decoded");
+
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].silent = true;
+    }
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_TIMEOUT, "silent module times out");
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].silent = false;
+        sim.modules[0x80].resolution = 1;
+        sim.modules[0x80].distance = 1.234;
+    }
+
+    check(SGSLrm_Shutdown(handle) == SGS_LRM_SUCCESS, "shutdown acknowledged");
+
+    SGSLrm_Disconnect(handle);
+    SGSLrm_DestroyHandle(handle);
+    printf("\n");
+}
+
+void test_open_failures()
+{
+    printf("Test 3: Open failures...\n");
+
+    SGSLrmHandle handle;
+    SGSLrm_CreateHandle(&handle);
+    check(SGSLrm_Connect(handle, "/dev/does-not-exist") == SGS_LRM_COMMUNICATION_ERROR, "missing device rejected");
+    bool connected = true;
+    SGSLrm_IsConnected(handle, &connected);
+    check(!connected, "handle stays disconnected");
+    SGSLrm_DestroyHandle(handle);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("POSIX termios transport (pty pair)");
+
+    PtyModuleSimulator sim;
+    if (!sim.Start()) {
+        printf("❌ Could not allocate a pty pair\n");
+        return 1;
+    }
+    printf("Simulated module on %s\n\n", sim.PortName());
+
+    test_connect_and_measure(sim);
+    test_error_and_cache(sim);
+    test_open_failures();
+
+    sim.Stop();
+
+    return report_results();
+}
@@ -0,0 +1,214 @@
+// Tests for the transaction prologue that drains stale input (SGSLrm_GetRxStats).
+// A read that timed out leaves its late answer on the line; without the drain
+// the next SingleMeasurement takes it for its own. Junk, stray acks and
+// partial frames must be discarded and counted, measurement frames among them
+// published to the handle they are addressed to, and a clean line must not
+// be charged a drain. Bus-wide sweeps read answers off the line too and must
+// drain the same way.
+//
+// Build (Linux): make test_rx_drain (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+
+static SGSLrmRxStats rx_stats(SGSLrmHandle handle)
+{
+    SGSLrmRxStats stats;
+    memset(&stats, 0, sizeof(stats));
+    SGSLrm_GetRxStats(handle, &stats);
+    return stats;
+}
+
+static void set_module(PtyModuleSimulator& sim, int address, double distance, int delayMs)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    sim.modules[address].distance = distance;
+    sim.modules[address].responseDelayMs = delayMs;
+}
+
+void test_api(SGSLrmHandle handle)
+{
+    printf("Test 1: RX stats API...\n");
+
+    check(SGSLrm_GetRxStats(handle, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL output rejected");
+    SGSLrmRxStats stats = rx_stats(handle);
+    check(stats.drains == 0 && stats.discardedBytes == 0 && stats.discardedFrames == 0 && stats.salvagedFrames == 0, "fresh handle counts nothing");
+
+    const int kRounds = 100;
+    bool ok = true;
+    for (int i = 0; i < kRounds; ++i) {
+        double distance = 0.0;
+        ok = SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS && ok;
+    }
+    check(ok && rx_stats(handle).drains == 0, "clean line: no drain charged over 100 transactions");
+    printf("\n");
+}
+
+void test_late_answer(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 2: A late answer is not taken for the next one...\n");
+
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, 50);
+    set_module(sim, 0x80, 2.0, 150);
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_TIMEOUT, "slow answer times out");
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));  // ...and then arrives
+
+    SGSLrmSample samples[8];
+    int count = 0;
+    do {
+        SGSLrm_ReadSamples(handle, samples, 8, &count);
+    } while (count > 0);
+
+    set_module(sim, 0x80, 3.0, 0);
+    SGSLrmStatus status = SGSLrm_SingleMeasurement(handle, &distance);
+    char what[96];
+    snprintf(what, sizeof(what), "next measurement reads %.3f, the new answer", distance);
+    check(status == SGS_LRM_SUCCESS && fabs(distance - 3.0) < 1e-9, what);
+
+    SGSLrm_ReadSamples(handle, samples, 8, &count);
+    check(count == 2 && fabs(samples[0].distance - 2.0) < 1e-9 && samples[0].status == SGS_LRM_SUCCESS &&
+        fabs(samples[1].distance - 3.0) < 1e-9, "late reading salvaged as a sample before the new one");
+
+    SGSLrmRxStats stats = rx_stats(handle);
+    check(stats.drains == 1 && stats.salvagedFrames == 1 && stats.discardedFrames == 0 && stats.discardedBytes == 0,
+        "counted as one drain, one salvaged frame");
+    SGSLrm_SetCommandTimeout(handle, SGS_LRM_COMMAND_SINGLE_MEASUREMENT, 0);
+    printf("\n");
+}
+
+void test_junk(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 3: Junk, stray acks and partial frames are discarded...\n");
+
+    SGSLrmRxStats before = rx_stats(handle);
+    std::vector<unsigned char> junk = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+    std::vector<unsigned char> ack = { 0xFA, 0x04, 0x89 };
+    ack.push_back(PtyModuleSimulator::Checksum(ack.data(), ack.size()));
+    std::vector<unsigned char> partial = { 0x80, 0x06, 0x82, '0', '0' };
+    std::vector<unsigned char> all(junk);
+    all.insert(all.end(), ack.begin(), ack.end());
+    all.insert(all.end(), partial.begin(), partial.end());
+    sim.Inject(all);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(handle, &distance) == SGS_LRM_SUCCESS && fabs(distance - 3.0) < 1e-9, "measurement clean");
+
+    SGSLrmRxStats stats = rx_stats(handle);
+    char what[128];
+    snprintf(what, sizeof(what), "%lu bytes and %lu frame discarded", stats.discardedBytes - before.discardedBytes,
+        stats.discardedFrames - before.discardedFrames);
+    check(stats.drains == before.drains + 1 && stats.discardedBytes - before.discardedBytes == all.size() &&
+        stats.discardedFrames - before.discardedFrames == 1 && stats.salvagedFrames == before.salvagedFrames, what);
+    printf("\n");
+}
+
+void test_salvage_other_handle()
+{
+    printf("Test 4: Stale frames reach the handle they are addressed to...\n");
+
+    PtyModuleSimulator sim;
+    sim.modules[0x80].distance = 1.0;
+    sim.modules[0x81].distance = 2.0;
+    if (!sim.Start()) {
+        check(false, "pty allocation");
+        return;
+    }
+
+    SGSLrmBusHandle bus;
+    SGSLrm_OpenBus(sim.PortName(), &bus);
+    SGSLrmHandle a, b;
+    SGSLrm_CreateHandle(&a);
+    SGSLrm_CreateHandle(&b);
+    SGSLrm_ConnectBus(a, bus, 0x80);
+    SGSLrm_ConnectBus(b, bus, 0x81);
+
+    SimulatedModule late;
+    late.distance = 9.876;
+    std::vector<unsigned char> frame = PtyModuleSimulator::MeasurementFrame(0x81, 0x82, late);
+    SimulatedModule failed;
+    failed.errorCode = 15;
+    std::vector<unsigned char> error = PtyModuleSimulator::MeasurementFrame(0x99, 0x82, failed);
+    frame.insert(frame.end(), error.begin(), error.end());
+    sim.Inject(frame);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    double distance = 0.0;
+    check(SGSLrm_SingleMeasurement(a, &distance) == SGS_LRM_SUCCESS && fabs(distance - 1.0) < 1e-9, "handle A reads its own module");
+
+    SGSLrmSnapshot snapshot;
+    SGSLrm_GetSnapshot(b, &snapshot);
+    check(snapshot.status == SGS_LRM_SUCCESS && fabs(snapshot.distance - 9.876) < 1e-9, "handle B got the frame addressed to it");
+
+    SGSLrmRxStats stats = rx_stats(a);
+    check(stats.salvagedFrames == 1 && stats.discardedFrames == 1 && stats.discardedBytes == error.size(),
+        "frame for an address nobody holds discarded");
+    check(rx_stats(b).drains == 0, "counted against the handle that drained");
+
+    SGSLrm_CloseBus(bus);
+    SGSLrm_Disconnect(a);
+    SGSLrm_Disconnect(b);
+    SGSLrm_DestroyHandle(a);
+    SGSLrm_DestroyHandle(b);
+    sim.Stop();
+    printf("\n");
+}
+
+void test_sweep_late_answer()
+{
+    printf("Test 5: A late cache answer is not taken by the next sweep...\n");
+
+    PtyModuleSimulator sim;
+    sim.modules[0x80].distance = 1.0;
+    sim.modules[0x81].distance = 2.0;
+    sim.modules[0x81].responseDelayMs = 150;
+    if (!sim.Start()) {
+        check(false, "pty allocation");
+        return;
+    }
+
+    SGSLrmBusHandle bus;
+    SGSLrm_OpenBus(sim.PortName(), &bus);
+    const int addresses[2] = { 0x80, 0x81 };
+    SGSLrmSyncResult results[2];
+    check(SGSLrm_SweepCache(bus, addresses, 2, results) == SGS_LRM_SUCCESS &&
+        results[0].status == SGS_LRM_SUCCESS && results[1].status == SGS_LRM_TIMEOUT, "slow module misses its 50 ms deadline");
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));  // ...and its ADDR 06 87 answer arrives
+
+    // The slow module first, so the stale frame is waiting for its own address
+    set_module(sim, 0x81, 3.0, 0);
+    const int reversed[2] = { 0x81, 0x80 };
+    SGSLrm_SweepCache(bus, reversed, 2, results);
+    char what[96];
+    snprintf(what, sizeof(what), "next sweep reads %.3f, the new answer", results[0].distance);
+    check(results[0].status == SGS_LRM_SUCCESS && fabs(results[0].distance - 3.0) < 1e-9 &&
+        results[1].status == SGS_LRM_SUCCESS && fabs(results[1].distance - 1.0) < 1e-9, what);
+
+    SGSLrm_CloseBus(bus);
+    sim.Stop();
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Stale input drain");
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_api(handle);
+    test_late_answer(sim, handle);
+    test_junk(sim, handle);
+    test_salvage_other_handle();
+    test_sweep_late_answer();
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
@@ -0,0 +1,182 @@
+// Tests for the per-device sample ring and SGSLrm_ReadSamples.
+// Part 1 drives SGSLrmSampleRing directly: batching, wrap-around, overflow,
+// and a producer/consumer stress run with no lock between the two threads.
+// Part 2 (POSIX) streams from a pty module and drains samples in bulk.
+//
+// Build (Linux): make test_sample_ring (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "../SGSLaserRangingModule/SGSLrmSampleRing.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static SGSLrmSampleRecord sample(unsigned long long seq)
+{
+    SGSLrmSampleRecord s;
+    s.sequence = seq;
+    s.timestampMs = seq * 50;
+    s.distanceTenthMm = (int)(seq * 10);
+    s.status = SGS_LRM_SUCCESS;
+    s.errorCode = 0;
+    s.resolution = SGS_LRM_RESOLUTION_1MM;
+    return s;
+}
+
+static SGSLrmSampleRing g_ring;
+
+void test_batch_and_wrap()
+{
+    printf("Test 1: Batch drain and wrap-around...\n");
+
+    SGSLrmSampleRing_Init(&g_ring);
+    SGSLrmSampleRecord out[SGS_LRM_SAMPLE_RING_CAPACITY];
+    check(SGSLrmSampleRing_PopBatch(&g_ring, out, 16) == 0, "empty ring drains nothing");
+
+    // Advance the indices so the next batch straddles the end of the array
+    unsigned long long seq = 1;
+    for (int i = 0; i < 200; ++i) {
+        SGSLrmSampleRecord s = sample(seq++);
+        SGSLrmSampleRing_Push(&g_ring, &s);
+    }
+    check(SGSLrmSampleRing_PopBatch(&g_ring, out, 200) == 200, "200 samples drained in one call");
+
+    for (int i = 0; i < 100; ++i) {
+        SGSLrmSampleRecord s = sample(seq++);
+        SGSLrmSampleRing_Push(&g_ring, &s);
+    }
+    int n1 = SGSLrmSampleRing_PopBatch(&g_ring, out, 30);
+    int n2 = SGSLrmSampleRing_PopBatch(&g_ring, out + 30, 100);
+    bool ordered = n1 == 30 && n2 == 70;
+    for (int i = 0; ordered && i < 100; ++i) ordered = out[i].sequence == 201ULL + i;
+    check(ordered, "wrapped batch returned in order, split across calls");
+    printf("\n");
+}
+
+void test_overflow()
+{
+    printf("Test 2: Overflow drops newest and counts...\n");
+
+    SGSLrmSampleRing_Init(&g_ring);
+    int accepted = 0;
+    for (int i = 0; i < SGS_LRM_SAMPLE_RING_CAPACITY + 10; ++i) {
+        SGSLrmSampleRecord s = sample(i + 1);
+        if (SGSLrmSampleRing_Push(&g_ring, &s)) accepted++;
+    }
+    check(accepted == SGS_LRM_SAMPLE_RING_CAPACITY, "ring accepts exactly its capacity");
+    check(g_ring.overflowCount == 10, "10 overflowed samples counted");
+
+    SGSLrmSampleRecord out[SGS_LRM_SAMPLE_RING_CAPACITY];
+    int n = SGSLrmSampleRing_PopBatch(&g_ring, out, SGS_LRM_SAMPLE_RING_CAPACITY);
+    check(n == SGS_LRM_SAMPLE_RING_CAPACITY && out[0].sequence == 1 && out[n - 1].sequence == SGS_LRM_SAMPLE_RING_CAPACITY,
+        "oldest samples kept");
+    printf("\n");
+}
+
+void test_concurrent()
+{
+    printf("Test 3: Producer/consumer stress...\n");
+
+    SGSLrmSampleRing_Init(&g_ring);
+    const unsigned long long total = 2000000;
+    std::atomic<bool> done{ false };
+
+    std::thread producer([&] {
+        for (unsigned long long seq = 1; seq <= total; ++seq) {
+            SGSLrmSampleRecord s = sample(seq);
+            SGSLrmSampleRing_Push(&g_ring, &s);
+        }
+        done = true;
+    });
+
+    unsigned long long received = 0, last = 0;
+    bool ordered = true, intact = true;
+    SGSLrmSampleRecord out[64];
+    for (;;) {
+        bool finished = done;
+        int n = SGSLrmSampleRing_PopBatch(&g_ring, out, 64);
+        for (int i = 0; i < n; ++i) {
+            if (out[i].sequence <= last) ordered = false;
+            if (out[i].timestampMs != out[i].sequence * 50 || out[i].distanceTenthMm != (int)(out[i].sequence * 10)) intact = false;
+            last = out[i].sequence;
+        }
+        received += n;
+        if (finished && n == 0) break;
+    }
+    producer.join();
+
+    char what[128];
+    snprintf(what, sizeof(what), "%llu received + %lu overflowed == %llu produced", received, g_ring.overflowCount, total);
+    check(received + g_ring.overflowCount == total, what);
+    check(ordered, "sequence strictly increasing");
+    check(intact, "no torn records");
+    printf("\n");
+}
+
+#if !defined(_WIN32)
+void test_read_samples()
+{
+    printf("Test 4: ReadSamples over a 20 Hz stream...\n");
+
+    PtyModuleSimulator sim;
+    sim.modules[0x80].frequencyHz = 20;
+    sim.modules[0x80].distance = 4.321;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) { check(false, "connected"); return; }
+
+    SGSLrmSample buffer[64];
+    int count = -1;
+    check(SGSLrm_ReadSamples(handle, buffer, 64, &count) == SGS_LRM_SUCCESS && count == 0, "nothing queued before streaming");
+    check(SGSLrm_ReadSamples(handle, NULL, 64, &count) == SGS_LRM_INVALID_PARAMETER, "NULL buffer rejected");
+
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::vector<SGSLrmSample> all;
+    for (int round = 0; round < 4; ++round) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(400)); // Consumer jitter
+        SGSLrm_ReadSamples(handle, buffer, 64, &count);
+        all.insert(all.end(), buffer, buffer + count);
+    }
+    SGSLrm_StopContinuousMeasurement(handle);
+
+    bool contiguous = !all.empty();
+    for (size_t i = 1; contiguous && i < all.size(); ++i) {
+        contiguous = all[i].sequence == all[i - 1].sequence + 1 && all[i].timestampMs >= all[i - 1].timestampMs;
+    }
+    bool values = true;
+    for (const SGSLrmSample& s : all) values = values && s.status == SGS_LRM_SUCCESS && fabs(s.distance - 4.321) < 1e-9;
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d samples drained in 4 bulk reads", (int)all.size());
+    check(all.size() >= 28, what);
+    check(contiguous, "sequence numbers contiguous, timestamps monotonic");
+    check(values, "distance and status intact");
+
+    unsigned long dropped = 99;
+    SGSLrm_GetSampleOverflow(handle, &dropped);
+    check(dropped == 0, "no overflow");
+
+    SGSLrmSnapshot snap;
+    SGSLrm_GetSnapshot(handle, &snap);
+    check(snap.sequence == all.back().sequence, "last sample matches snapshot");
+
+    disconnect_simulated(sim, handle);
+    printf("\n");
+}
+#endif
+
+int main()
+{
+    print_banner("Sample ring");
+
+    test_batch_and_wrap();
+    test_overflow();
+    test_concurrent();
+#if !defined(_WIN32)
+    test_read_samples();
+#endif
+
+    return report_results();
+}
@@ -0,0 +1,194 @@
+// Tests for the integer measurement APIs (SGSLrm_*TenthMm).
+// A pty module answers at 1 mm and at 0.1 mm resolution. Every integer
+// variant must return the payload as an exact count of 0.1 mm units with the
+// resolution it was written at, agree bit for bit with its double twin, and
+// the half-size sample record must carry the same queue.
+//
+// Build (Linux): make test_tenth_mm (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <atomic>
+
+static void set_module(PtyModuleSimulator& sim, double distance, int errorCode)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    sim.modules[0x80].distance = distance;
+    sim.modules[0x80].errorCode = errorCode;
+}
+
+static void drain(SGSLrmHandle handle)
+{
+    SGSLrmSampleTenthMm samples[64];
+    int count = 0;
+    do {
+        SGSLrm_ReadSamplesTenthMm(handle, samples, 64, &count);
+    } while (count > 0);
+}
+
+void test_api(SGSLrmHandle handle)
+{
+    printf("Test 1: Integer API...\n");
+
+    int tenthMm = 0;
+    SGSLrmSampleTenthMm sample;
+    int count = 0;
+    check(SGSLrm_SingleMeasurementTenthMm(handle, NULL, NULL) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_GetLastMeasurementTenthMm(handle, NULL, NULL) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_ReadCacheTenthMm(handle, NULL, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL distance rejected");
+    check(SGSLrm_ReadSamplesTenthMm(handle, NULL, 1, &count) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_ReadSamplesTenthMm(handle, &sample, 0, &count) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_ReadSamplesTenthMm(handle, &sample, 1, NULL) == SGS_LRM_INVALID_PARAMETER, "bad sample buffer rejected");
+    check(SGSLrm_GetLastMeasurementTenthMm(NULL, &tenthMm, NULL) == SGS_LRM_INVALID_HANDLE, "NULL handle rejected");
+
+    char what[96];
+    snprintf(what, sizeof(what), "sample record is %d bytes, half of %d", (int)sizeof(SGSLrmSampleTenthMm), (int)sizeof(SGSLrmSample));
+    check(sizeof(SGSLrmSampleTenthMm) * 2 == sizeof(SGSLrmSample), what);
+    printf("\n");
+}
+
+void test_resolutions(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 2: Exact at both resolutions...\n");
+
+    set_module(sim, 12.345, 0);
+    int tenthMm = 0;
+    SGSLrmResolution resolution = -1;
+    check(SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, &resolution) == SGS_LRM_SUCCESS &&
+        tenthMm == 123450 && resolution == SGS_LRM_RESOLUTION_1MM, "1 mm reading: 123450 units at 1 mm");
+    double distance = 0.0;
+    SGSLrm_SingleMeasurement(handle, &distance);
+    check(distance == 123450 / (double)SGS_LRM_UNITS_PER_METRE, "double form is the same count in metres");
+
+    check(SGSLrm_SetResolution(handle, SGS_LRM_RESOLUTION_100UM) == SGS_LRM_SUCCESS, "module switched to 0.1 mm");
+    set_module(sim, 7.0401, 0);
+    check(SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, &resolution) == SGS_LRM_SUCCESS &&
+        tenthMm == 70401 && resolution == SGS_LRM_RESOLUTION_100UM, "0.1 mm reading: 70401 units at 0.1 mm");
+    set_module(sim, 0.0003, 0);
+    check(SGSLrm_ReadCacheTenthMm(handle, &tenthMm, NULL) == SGS_LRM_SUCCESS && tenthMm == 3, "cache read, resolution not asked for");
+
+    SGSLrmSnapshot snapshot;
+    SGSLrm_GetSnapshot(handle, &snapshot);
+    check(SGSLrm_GetLastMeasurementTenthMm(handle, &tenthMm, &resolution) == SGS_LRM_SUCCESS && tenthMm == 3 &&
+        resolution == SGS_LRM_RESOLUTION_100UM && snapshot.distanceTenthMm == 3 && snapshot.distance == 0.0003,
+        "last measurement and snapshot agree");
+
+    // A hardware error keeps the last good reading
+    set_module(sim, 1.0, 16);
+    check(SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, &resolution) == SGS_LRM_MEASUREMENT_ERROR, "ERR frame reported");
+    check(SGSLrm_GetLastMeasurementTenthMm(handle, &tenthMm, NULL) == SGS_LRM_SUCCESS && tenthMm == 3, "last good reading kept");
+    set_module(sim, 1.0, 0);
+    printf("\n");
+}
+
+void test_samples(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 3: Half-size samples...\n");
+
+    drain(handle);
+    const int kReadings = 100;
+    for (int i = 0; i < kReadings; ++i) {
+        set_module(sim, (i + 1) / 10000.0, i % 10 == 9 ? 15 : 0);
+        int tenthMm;
+        SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, NULL);
+    }
+
+    SGSLrmSnapshot snapshot;
+    SGSLrm_GetSnapshot(handle, &snapshot);
+    SGSLrmSampleTenthMm samples[kReadings];
+    int count = 0;
+    SGSLrm_ReadSamplesTenthMm(handle, samples, kReadings, &count);
+
+    bool intact = count == kReadings;
+    for (int i = 0; intact && i < count; ++i) {
+        bool failed = i % 10 == 9;
+        intact = samples[i].sequence == (unsigned int)(snapshot.sequence - kReadings + 1 + i) &&
+            samples[i].status == (failed ? SGS_LRM_MEASUREMENT_ERROR : SGS_LRM_SUCCESS) &&
+            samples[i].errorCode == (failed ? 15 : 0) &&
+            samples[i].distanceTenthMm == (failed ? i : i + 1) &&
+            samples[i].resolution == SGS_LRM_RESOLUTION_100UM;
+    }
+    check(intact, "100 samples: sequence, status, error code and exact distance");
+    check(samples[count - 1].timestampMs == (unsigned int)snapshot.timestampMs, "timestamp is the low 32 bits");
+
+    // Both variants drain one queue
+    set_module(sim, 2.5, 0);
+    int tenthMm = 0;
+    SGSLrm_SingleMeasurementTenthMm(handle, &tenthMm, NULL);
+    SGSLrmSample wide;
+    SGSLrm_ReadSamples(handle, &wide, 1, &count);
+    SGSLrm_ReadSamplesTenthMm(handle, samples, kReadings, &count);
+    check(tenthMm == 25000 && wide.distance == 2.5 && count == 0, "a sample read one way is gone the other");
+    printf("\n");
+}
+
+struct Received {
+    std::atomic<int> integer{ 0 };
+    std::atomic<int> doubles{ 0 };
+    std::atomic<bool> exact{ true };
+};
+
+static void integer_callback(SGSLrmHandle, int distanceTenthMm, SGSLrmResolution resolution, SGSLrmStatus status, void* userdata)
+{
+    Received* received = (Received*)userdata;
+    if (status != SGS_LRM_SUCCESS || distanceTenthMm != 54321 || resolution != SGS_LRM_RESOLUTION_100UM) received->exact = false;
+    received->integer++;
+}
+
+static void double_callback(SGSLrmHandle, double distance, SGSLrmStatus status, void* userdata)
+{
+    Received* received = (Received*)userdata;
+    if (status != SGS_LRM_SUCCESS || distance != 5.4321) received->exact = false;
+    received->doubles++;
+}
+
+void test_callback(PtyModuleSimulator& sim, SGSLrmHandle handle, SGSLrmCallbackMode mode)
+{
+    printf("Test %d: Integer callback (%s)...\n", mode == SGS_LRM_CALLBACK_INLINE ? 4 : 5,
+        mode == SGS_LRM_CALLBACK_INLINE ? "inline" : "queued");
+
+    set_module(sim, 5.4321, 0);
+    Received received;
+    SGSLrm_SetCallbackMode(handle, mode, NULL);
+    SGSLrm_SetMeasurementCallbackTenthMm(handle, integer_callback, &received);
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // Setting the double callback replaces the integer one
+    SGSLrm_SetMeasurementCallback(handle, double_callback, &received);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int integerSeen = received.integer;
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    SGSLrm_StopContinuousMeasurement(handle);
+    SGSLrm_SetMeasurementCallback(handle, NULL, NULL);
+    SGSLrm_SetCallbackMode(handle, SGS_LRM_CALLBACK_INLINE, NULL);
+
+    char what[128];
+    snprintf(what, sizeof(what), "%d integer then %d double callbacks, values exact", integerSeen, (int)received.doubles);
+    check(integerSeen > 0 && received.doubles > 0 && received.exact, what);
+    check(received.integer == integerSeen, "integer callback replaced");
+    drain(handle);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Integer 0.1 mm measurement APIs");
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_api(handle);
+    test_resolutions(sim, handle);
+    test_samples(sim, handle);
+    test_callback(sim, handle, SGS_LRM_CALLBACK_INLINE);
+    test_callback(sim, handle, SGS_LRM_CALLBACK_QUEUED);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}
@@ -0,0 +1,274 @@
+// Tests for the per-handle constant-velocity tracker (SGSLrm_SetTracker).
+// Fed a noisy ramp, the Kalman filter must settle on the true velocity and
+// beat the raw noise on distance; dropouts must coast the track and, past
+// maxCoastMs, end it; predictions between samples must follow the target.
+// On a pty module streaming a moving target the track must come from the
+// RX stamps, count ERR frames as dropouts and ride along in the Ex callback.
+//
+// Build (Linux): make test_tracker (make check builds and runs every program)
+
+#include "../SGSLaserRangingModule/SGSLaserRangingModule.h"
+#include "../SGSLaserRangingModule/SGSLrmTracker.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <math.h>
+#include <atomic>
+#include <random>
+
+static const unsigned long long kMs = 1000000ULL;
+
+static SGSLrmTrackerConfig tracker_config(double noise, double acceleration, int maxCoastMs)
+{
+    SGSLrmTrackerConfig config;
+    config.measurementNoiseM = noise;
+    config.accelerationNoise = acceleration;
+    config.maxCoastMs = maxCoastMs;
+    return config;
+}
+
+static void set_module(PtyModuleSimulator& sim, double distance, int errorCode)
+{
+    std::lock_guard<std::mutex> guard(sim.Lock());
+    sim.modules[0x80].distance = distance;
+    sim.modules[0x80].errorCode = errorCode;
+}
+
+void test_convergence()
+{
+    printf("Test 1: Noisy ramp...\n");
+
+    SGSLrmTrackerConfig bad = tracker_config(0.0, 0.5, 500);
+    check(SGSLrmTracker_Validate(&bad) == SGS_LRM_INVALID_PARAMETER, "zero measurement noise rejected");
+    bad = tracker_config(0.001, 0.5, 0);
+    check(SGSLrmTracker_Validate(&bad) == SGS_LRM_INVALID_PARAMETER, "maxCoastMs 0 rejected");
+
+    SGSLrmTrackerConfig config = tracker_config(0.001, 0.2, 500);
+    SGSLrmTracker tracker;
+    SGSLrmTracker_Init(&tracker, &config);
+    SGSLrmTrackState state;
+    check(SGSLrmTracker_Predict(&tracker, 0, &state) == SGS_LRM_NO_TRACK, "no track before the first reading");
+
+    // 0.5 m/s away from 2 m, 20 Hz with jitter, 1 mm noise
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, 0.001);
+    std::uniform_int_distribution<int> jitter(-5, 5);
+    unsigned long long t = 1000 * kMs;
+    double rawSq = 0.0, filteredSq = 0.0;
+    int settled = 0;
+    for (int i = 0; i < 200; ++i) {
+        t += (50 + jitter(rng)) * kMs;
+        double truth = 2.0 + 0.5 * (double)(t - 1000 * kMs) / 1e9;
+        double reading = truth + noise(rng);
+        SGSLrmTracker_Update(&tracker, reading, t, i);
+        if (i >= 50) {
+            rawSq += (reading - truth) * (reading - truth);
+            filteredSq += (tracker.distance - truth) * (tracker.distance - truth);
+            settled++;
+        }
+    }
+
+    SGSLrmTracker_Predict(&tracker, t, &state);
+    char what[128];
+    snprintf(what, sizeof(what), "velocity %.4f m/s (+/- %.4f), truth 0.5", state.velocity, state.velocityStdDev);
+    check(fabs(state.velocity - 0.5) < 0.01 && state.velocityStdDev < 0.02, what);
+    double rawRms = sqrt(rawSq / settled), filteredRms = sqrt(filteredSq / settled);
+    snprintf(what, sizeof(what), "distance error %.3f mm RMS against %.3f mm raw", filteredRms * 1e3, rawRms * 1e3);
+    check(filteredRms < rawRms, what);
+    check(state.updates == 200 && state.sequence == 199 && state.dropouts == 0, "200 updates, last sequence 199");
+    printf("\n");
+}
+
+void test_dropouts()
+{
+    printf("Test 2: Dropouts coast, then end the track...\n");
+
+    SGSLrmTrackerConfig config = tracker_config(0.001, 0.2, 300);
+    SGSLrmTracker tracker;
+    SGSLrmTracker_Init(&tracker, &config);
+    unsigned long long t = 0;
+    for (int i = 0; i < 100; ++i) {
+        t += 20 * kMs;
+        SGSLrmTracker_Update(&tracker, 1.0 - 0.3 * (double)t / 1e9, t, i);
+    }
+    unsigned long long last = t;
+
+    // Four missed samples: still tracking, the prediction carries on and widens
+    SGSLrmTrackState before, coasted;
+    SGSLrmTracker_Predict(&tracker, last, &before);
+    for (int i = 1; i <= 4; ++i) SGSLrmTracker_Dropout(&tracker, last + i * 20 * kMs);
+    check(SGSLrmTracker_Predict(&tracker, last + 80 * kMs, &coasted) == SGS_LRM_SUCCESS, "track survives 80 ms of dropouts");
+    double truth = 1.0 - 0.3 * (double)(last + 80 * kMs) / 1e9;
+    char what[128];
+    snprintf(what, sizeof(what), "coasted to %.4f m (truth %.4f), sigma %.2f -> %.2f mm", coasted.distance, truth,
+        before.distanceStdDev * 1e3, coasted.distanceStdDev * 1e3);
+    check(fabs(coasted.distance - truth) < 0.002 && coasted.distanceStdDev > before.distanceStdDev &&
+        coasted.dropouts == 4, what);
+
+    // Past maxCoastMs the track is gone, and the next reading starts a new one
+    check(SGSLrmTracker_Predict(&tracker, last + 301 * kMs, &coasted) == SGS_LRM_NO_TRACK, "prediction past maxCoastMs refused");
+    SGSLrmTracker_Dropout(&tracker, last + 320 * kMs);
+    check(!tracker.tracking, "dropout past maxCoastMs ends the track");
+    SGSLrmTracker_Update(&tracker, 5.0, last + 340 * kMs, 500);
+    SGSLrmTrackState fresh;
+    SGSLrmTracker_Predict(&tracker, last + 340 * kMs, &fresh);
+    check(fresh.distance == 5.0 && fresh.velocity == 0.0 && fresh.updates == 1 && fresh.dropouts == 5,
+        "next reading starts a new track at rest; dropouts kept");
+    printf("\n");
+}
+
+void test_between_samples()
+{
+    printf("Test 3: 100 Hz predictions between 20 Hz samples...\n");
+
+    SGSLrmTrackerConfig config = tracker_config(0.001, 0.2, 500);
+    SGSLrmTracker tracker;
+    SGSLrmTracker_Init(&tracker, &config);
+    std::mt19937 rng(11);
+    std::normal_distribution<double> noise(0.0, 0.001);
+
+    double predictedSq = 0.0, heldSq = 0.0, held = 0.0;
+    int ticks = 0;
+    unsigned long long next = 0;
+    for (unsigned long long t = 0; t <= 4000 * kMs; t += 10 * kMs) {
+        double truth = 3.0 + 0.8 * (double)t / 1e9;
+        if (t >= next) {
+            held = truth + noise(rng);
+            SGSLrmTracker_Update(&tracker, held, t, t / (50 * kMs));
+            next += 50 * kMs;
+        } else if (t > 2000 * kMs) {
+            // The control loop's tick: ask for the state now, not at the last reading
+            SGSLrmTrackState state;
+            SGSLrmTracker_Predict(&tracker, t, &state);
+            predictedSq += (state.distance - truth) * (state.distance - truth);
+            heldSq += (held - truth) * (held - truth);
+            ticks++;
+        }
+    }
+
+    // Holding the last reading lags by up to 40 mm at this speed
+    double predictedRms = sqrt(predictedSq / ticks), heldRms = sqrt(heldSq / ticks);
+    char what[128];
+    snprintf(what, sizeof(what), "predicted %.3f mm RMS against %.3f mm for the last reading held", predictedRms * 1e3, heldRms * 1e3);
+    check(predictedRms < 0.0015 && predictedRms * 10 < heldRms, what);
+    printf("\n");
+}
+
+struct Stream {
+    std::atomic<int> received{ 0 };
+    std::atomic<int> tracked{ 0 };
+    std::atomic<int> sane{ 0 };
+};
+
+static void ex_callback(SGSLrmHandle, const SGSLrmMeasurementEx* m, void* userdata)
+{
+    Stream* stream = (Stream*)userdata;
+    stream->received++;
+    if (m->tracked) {
+        stream->tracked++;
+        if (m->status == SGS_LRM_SUCCESS && fabs(m->trackDistance - m->distance) < 0.01 &&
+            fabs(m->innovation) < 0.01 && fabs(m->trackVelocity - 0.5) < 0.15) {
+            stream->sane++;
+        }
+    }
+}
+
+void test_handle(PtyModuleSimulator& sim, SGSLrmHandle handle)
+{
+    printf("Test 4: Tracking a streaming module...\n");
+
+    SGSLrmTrackerConfig config = tracker_config(0.0, 0.5, 500);
+    SGSLrmTrackState state;
+    check(SGSLrm_SetTracker(handle, &config) == SGS_LRM_INVALID_PARAMETER, "invalid config rejected");
+    check(SGSLrm_SetTracker(NULL, NULL) == SGS_LRM_INVALID_HANDLE, "NULL handle rejected");
+    check(SGSLrm_GetTrack(handle, NULL) == SGS_LRM_INVALID_PARAMETER &&
+        SGSLrm_PredictTrack(handle, 0, NULL) == SGS_LRM_INVALID_PARAMETER, "NULL state rejected");
+    check(SGSLrm_GetTrack(handle, &state) == SGS_LRM_NO_TRACK, "tracker off: no track");
+
+    config = tracker_config(0.001, 0.5, 500);
+    check(SGSLrm_SetTracker(handle, &config) == SGS_LRM_SUCCESS, "tracker set");
+    {
+        std::lock_guard<std::mutex> guard(sim.Lock());
+        sim.modules[0x80].frequencyHz = 50;
+    }
+
+    // Target moving away at 0.5 m/s
+    std::atomic<bool> moving{ true };
+    std::atomic<int> errorCode{ 0 };
+    auto start = std::chrono::steady_clock::now();
+    std::thread mover([&]() {
+        while (moving) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            set_module(sim, 1.0 + 0.5 * elapsed, errorCode);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    Stream stream;
+    SGSLrm_SetMeasurementCallbackEx(handle, ex_callback, &stream);
+    SGSLrm_StartContinuousMeasurement(handle);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+    check(SGSLrm_GetTrack(handle, &state) == SGS_LRM_SUCCESS, "track established");
+    char what[128];
+    snprintf(what, sizeof(what), "velocity %.3f m/s after %lu readings", state.velocity, state.updates);
+    check(fabs(state.velocity - 0.5) < 0.1 && state.updates > 20, what);
+
+    // 100 Hz control loop asking between samples
+    bool follows = true;
+    double worstUs = 0.0;
+    for (int i = 0; i < 20; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        SGSLrmStatus status = SGSLrm_PredictTrack(handle, 0, &state);
+        worstUs = fmax(worstUs, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        double truth = 1.0 + 0.5 * std::chrono::duration<double>(t0 - start).count();
+        follows = status == SGS_LRM_SUCCESS && fabs(state.distance - truth) < 0.02 && follows;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    snprintf(what, sizeof(what), "PredictTrack(now) within 20 mm of the target, slowest call %.1f us", worstUs);
+    check(follows, what);
+
+    // Hardware errors for a while: dropouts, the track coasts
+    SGSLrm_GetTrack(handle, &state);
+    unsigned long dropoutsBefore = state.dropouts;
+    errorCode = 16;
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    errorCode = 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    SGSLrm_StopContinuousMeasurement(handle);
+    SGSLrm_SetMeasurementCallbackEx(handle, NULL, NULL);
+    moving = false;
+    mover.join();
+
+    SGSLrm_GetTrack(handle, &state);
+    snprintf(what, sizeof(what), "%lu ERR frames counted as dropouts, track kept", state.dropouts - dropoutsBefore);
+    check(state.dropouts - dropoutsBefore >= 3 && fabs(state.velocity - 0.5) < 0.1, what);
+    snprintf(what, sizeof(what), "%d of %d callbacks tracked, %d consistent", (int)stream.tracked, (int)stream.received, (int)stream.sane);
+    check(stream.received > 40 && stream.tracked >= stream.received - 1 && stream.sane > stream.received / 2, what);
+
+    // Turning it off ends the track
+    SGSLrm_SetTracker(handle, NULL);
+    check(SGSLrm_PredictTrack(handle, 0, &state) == SGS_LRM_NO_TRACK, "tracker off: no prediction");
+    set_module(sim, 1.0, 0);
+    printf("\n");
+}
+
+int main()
+{
+    print_banner("Constant-velocity tracker");
+
+    test_convergence();
+    test_dropouts();
+    test_between_samples();
+
+    PtyModuleSimulator sim;
+    SGSLrmHandle handle;
+    if (!connect_simulated(sim, &handle)) {
+        return 1;
+    }
+
+    test_handle(sim, handle);
+
+    disconnect_simulated(sim, handle);
+
+    return report_results();
+}